@@ -0,0 +1,15 @@
+import QtQuick
+
+// Holds a dialog that is created the first time it is opened, so the first
+// frame does not pay for popups most sessions never show. `properties` are
+// assigned before the dialog opens.
+Loader {
+    active: false
+
+    function open(properties) {
+        active = true
+        for (const name in properties)
+            item[name] = properties[name]
+        item.open()
+    }
+}
@@ -0,0 +1,19 @@
+import QtQuick
+
+// A wizard page that is created when the wizard first reaches `step` instead
+// of with the window. Once `preload` is set (after the first frame) pages are
+// incubated in the background so Next rarely waits; a page that is needed
+// before it is ready finishes loading synchronously. A created page is kept,
+// so what was entered on it survives going back.
+Loader {
+    property int step: 0
+    property int currentStep: 0
+    property bool preload: false
+    property bool reached: false
+
+    active: reached || preload
+    asynchronous: currentStep !== step
+
+    onCurrentStepChanged: reached = reached || currentStep === step
+    Component.onCompleted: reached = reached || currentStep === step
+}
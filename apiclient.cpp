@@ -0,0 +1,260 @@
+#include "apiclient.h"
+#include "tracer.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QUrl>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+#include <memory>
+
+namespace {
+bool isTransientError(QNetworkReply::NetworkError error)
+{
+    switch (error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Failures where the server cannot have acted on the request, so even a
+// non-idempotent POST is safe to send again.
+bool wasNotProcessed(const ApiClient::Response &response)
+{
+    switch (response.error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+        return true;
+    default:
+        return response.httpStatus == 429 || response.httpStatus == 503;
+    }
+}
+
+bool shouldRetry(ApiClient::Method method, const ApiClient::Policy &policy, const ApiClient::Response &response)
+{
+    if (response.timedOut)
+        return false;
+    const bool idempotent = method != ApiClient::Method::Post || policy.idempotent;
+    if (!idempotent)
+        return wasNotProcessed(response);
+    return isTransientError(response.error) || response.httpStatus >= 500 || response.httpStatus == 429;
+}
+
+int backoffDelayMs(const ApiClient::Policy &policy, int attempt, const ApiClient::Response &response)
+{
+    // Full jitter keeps a fleet of boxes from retrying in lockstep
+    const qint64 ceiling = qMin<qint64>(policy.maxBackoffMs, qint64(policy.baseBackoffMs) << qMin(attempt - 1, 16));
+    int delay = int(QRandomGenerator::global()->bounded(ceiling + 1));
+    const int retryAfterSecs = response.headers.value("retry-after").toInt();
+    if (retryAfterSecs > 0)
+        delay = qMax(delay, retryAfterSecs * 1000);
+    return delay;
+}
+
+struct Call {
+    QString endpoint;
+    ApiClient::Method method = ApiClient::Method::Get;
+    QNetworkRequest request;
+    QByteArray body;
+    ApiClient::Policy policy;
+    std::function<void(const ApiClient::Response&)> done;
+    QElapsedTimer clock;
+    int attempts = 0;
+    quint64 traceId = 0;
+};
+} // namespace
+
+ApiClient::ApiClient(QObject *parent)
+    : QObject(parent)
+{}
+
+const QVector<int> &ApiClient::bucketBoundsMs()
+{
+    static const QVector<int> bounds = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000};
+    return bounds;
+}
+
+void ApiClient::prepare(QNetworkRequest &request) const
+{
+    if (!request.attribute(QNetworkRequest::Http2AllowedAttribute).isValid())
+        request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#if QT_CONFIG(ssl)
+    if (request.url().scheme() == "https") {
+        // Let reconnects resume the previous TLS session instead of a full handshake
+        QSslConfiguration ssl = request.sslConfiguration();
+        ssl.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        ssl.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+        request.setSslConfiguration(ssl);
+    }
+#endif
+}
+
+void ApiClient::warmUp(const QUrl &url)
+{
+    if (!url.isValid() || url.host().isEmpty())
+        return;
+#if QT_CONFIG(ssl)
+    if (url.scheme() == "https") {
+        QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+        ssl.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        ssl.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+        m_net.connectToHostEncrypted(url.host(), quint16(url.port(443)), ssl);
+        return;
+    }
+#endif
+    m_net.connectToHost(url.host(), quint16(url.port(80)));
+}
+
+void ApiClient::get(const QString &endpoint, QNetworkRequest request, const Policy &policy,
+                    std::function<void(const Response&)> done)
+{
+    send(endpoint, Method::Get, std::move(request), QByteArray(), policy, std::move(done));
+}
+
+void ApiClient::head(const QString &endpoint, QNetworkRequest request, const Policy &policy,
+                     std::function<void(const Response&)> done)
+{
+    send(endpoint, Method::Head, std::move(request), QByteArray(), policy, std::move(done));
+}
+
+void ApiClient::post(const QString &endpoint, QNetworkRequest request, const QByteArray &body, const Policy &policy,
+                     std::function<void(const Response&)> done)
+{
+    send(endpoint, Method::Post, std::move(request), body, policy, std::move(done));
+}
+
+void ApiClient::send(const QString &endpoint, Method method, QNetworkRequest request, const QByteArray &body,
+                     const Policy &policy, std::function<void(const Response&)> done)
+{
+    auto call = std::make_shared<Call>();
+    call->endpoint = endpoint;
+    call->method = method;
+    call->request = std::move(request);
+    call->body = body;
+    call->policy = policy;
+    call->done = std::move(done);
+    call->clock.start();
+    call->traceId = Tracer::beginAsync("network", endpoint.toUtf8());
+    prepare(call->request);
+
+    auto attempt = std::make_shared<std::function<void()>>();
+    *attempt = [this, call, attempt]() {
+        ++call->attempts;
+        QNetworkReply *reply = nullptr;
+        switch (call->method) {
+        case Method::Get: reply = m_net.get(call->request); break;
+        case Method::Head: reply = m_net.head(call->request); break;
+        case Method::Post: reply = m_net.post(call->request, call->body); break;
+        }
+
+        const qint64 remaining = qMax<qint64>(1, call->policy.deadlineMs - call->clock.elapsed());
+        auto timedOut = std::make_shared<bool>(false);
+        QTimer *deadline = new QTimer(reply);
+        deadline->setSingleShot(true);
+        connect(deadline, &QTimer::timeout, reply, [reply, timedOut]() {
+            *timedOut = true;
+            reply->abort();
+        });
+        deadline->start(int(remaining));
+
+        connect(reply, &QNetworkReply::finished, this, [this, call, attempt, reply, timedOut]() {
+            Response response;
+            response.error = reply->error();
+            response.errorString = *timedOut ? QStringLiteral("Request timed out.") : reply->errorString();
+            response.httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            response.body = reply->readAll();
+            for (const auto &header : reply->rawHeaderPairs())
+                response.headers.insert(header.first.toLower(), header.second);
+            response.timedOut = *timedOut;
+            reply->deleteLater();
+
+            const qint64 remaining = call->policy.deadlineMs - call->clock.elapsed();
+            if (call->attempts < call->policy.maxAttempts && shouldRetry(call->method, call->policy, response)) {
+                const int delay = backoffDelayMs(call->policy, call->attempts, response);
+                if (delay < remaining) {
+                    QJsonObject retryArgs;
+                    retryArgs.insert("attempt", call->attempts);
+                    retryArgs.insert("httpStatus", response.httpStatus);
+                    retryArgs.insert("delayMs", delay);
+                    Tracer::instant("network", "retry " + call->endpoint.toUtf8(), retryArgs);
+                    QTimer::singleShot(delay, this, [attempt]() { (*attempt)(); });
+                    return;
+                }
+            }
+
+            response.attempts = call->attempts;
+            response.elapsedMs = call->clock.elapsed();
+            const bool ok = response.error == QNetworkReply::NoError && response.httpStatus < 400;
+            recordLatency(call->endpoint, response.elapsedMs, ok);
+            QJsonObject traceArgs;
+            traceArgs.insert("httpStatus", response.httpStatus);
+            traceArgs.insert("attempts", response.attempts);
+            traceArgs.insert("timedOut", response.timedOut);
+            Tracer::endAsync("network", call->endpoint.toUtf8(), call->traceId, traceArgs);
+            // Break the self-reference so the call state is released
+            *attempt = nullptr;
+            if (call->done)
+                call->done(response);
+        });
+    };
+    (*attempt)();
+}
+
+void ApiClient::recordLatency(const QString &endpoint, qint64 elapsedMs, bool ok)
+{
+    const QVector<int> &bounds = bucketBoundsMs();
+    Histogram &histogram = m_histograms[endpoint];
+    if (histogram.counts.isEmpty())
+        histogram.counts.resize(bounds.size() + 1);
+    int bucket = 0;
+    while (bucket < bounds.size() && elapsedMs > bounds.at(bucket))
+        ++bucket;
+    ++histogram.counts[bucket];
+    if (!ok)
+        ++histogram.failures;
+    histogram.sumMs += double(elapsedMs);
+    histogram.maxMs = qMax(histogram.maxMs, double(elapsedMs));
+}
+
+QJsonObject ApiClient::latencySnapshot() const
+{
+    QJsonArray bounds;
+    for (int bound : bucketBoundsMs())
+        bounds.append(bound);
+
+    QJsonObject endpoints;
+    for (auto it = m_histograms.constBegin(); it != m_histograms.constEnd(); ++it) {
+        const Histogram &histogram = it.value();
+        quint64 total = 0;
+        QJsonArray counts;
+        for (quint64 count : histogram.counts) {
+            counts.append(double(count));
+            total += count;
+        }
+        QJsonObject obj;
+        obj.insert("counts", counts);
+        obj.insert("count", double(total));
+        obj.insert("failures", double(histogram.failures));
+        obj.insert("meanMs", total ? histogram.sumMs / double(total) : 0.0);
+        obj.insert("maxMs", histogram.maxMs);
+        endpoints.insert(it.key(), obj);
+    }
+
+    QJsonObject snapshot;
+    snapshot.insert("bucketsMs", bounds);
+    snapshot.insert("endpoints", endpoints);
+    return snapshot;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <functional>
+
+// One network stack for every admin API, registry and download request, so
+// TCP connections, TLS sessions and HTTP/2 streams are shared instead of each
+// caller paying for its own handshakes. Each call gets an overall deadline,
+// retries transient failures with jittered exponential backoff, and records
+// its latency in a per-endpoint histogram.
+class ApiClient : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Method { Get, Head, Post };
+
+    struct Policy {
+        int deadlineMs = 30000;     // across all attempts
+        int maxAttempts = 3;
+        int baseBackoffMs = 500;
+        int maxBackoffMs = 8000;
+        // POSTs are only retried when the request cannot have been processed
+        // (connection refused, DNS failure, 429/503) unless this is set.
+        bool idempotent = false;
+    };
+
+    struct Response {
+        QNetworkReply::NetworkError error = QNetworkReply::NoError;
+        QString errorString;
+        int httpStatus = 0;
+        QByteArray body;
+        QHash<QByteArray, QByteArray> headers;
+        int attempts = 0;
+        qint64 elapsedMs = 0;
+        bool timedOut = false;
+    };
+
+    struct Histogram {
+        QVector<quint64> counts;    // one per bucket, last one is overflow
+        quint64 failures = 0;
+        double sumMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    explicit ApiClient(QObject* parent = nullptr);
+
+    void get(const QString& endpoint, QNetworkRequest request, const Policy& policy,
+             std::function<void(const Response&)> done);
+    void head(const QString& endpoint, QNetworkRequest request, const Policy& policy,
+              std::function<void(const Response&)> done);
+    void post(const QString& endpoint, QNetworkRequest request, const QByteArray& body, const Policy& policy,
+              std::function<void(const Response&)> done);
+
+    // Opens (and TLS-handshakes) a connection ahead of the first request.
+    void warmUp(const QUrl& url);
+
+    // For streaming transfers that manage their own reads.
+    QNetworkAccessManager* network() { return &m_net; }
+    void prepare(QNetworkRequest& request) const;
+    void recordLatency(const QString& endpoint, qint64 elapsedMs, bool ok);
+
+    static const QVector<int>& bucketBoundsMs();
+    QHash<QString, Histogram> histograms() const { return m_histograms; }
+    QJsonObject latencySnapshot() const;
+
+private:
+    void send(const QString& endpoint, Method method, QNetworkRequest request, const QByteArray& body,
+              const Policy& policy, std::function<void(const Response&)> done);
+
+    QNetworkAccessManager m_net;
+    QHash<QString, Histogram> m_histograms;
+};
@@ -44,6 +44,21 @@ inline const QStringList ContainerVolumes = {
     "aibox_weapons:/app/downloads/models/weapons"
 };
 
+// Weapons model volume (synced from the image on upgrade)
+inline const QString WeaponsModelVolume = "aibox_weapons";
+inline const QString WeaponsModelPath = "/app/downloads/models/weapons";
+
+// Loopback ports of the rate-limited registry proxies. Fixed, so the names
+// the daemon records proxied pulls under stay the same from run to run.
+inline constexpr quint16 RegistryProxyPort = 5095;
+inline constexpr quint16 StagingProxyPort = 5096;
+
+// Number of image IDs that ran successfully to keep for rollback
+inline constexpr int KnownGoodImageCount = 2;
+
+// How often the background agent checks the registry for a new image
+inline constexpr int UpgradeCheckIntervalMs = 6 * 60 * 60 * 1000;
+
 // NVIDIA Driver Capabilities
 inline const QString NvidiaDriverCapabilities = "compute,utility,video";
 
@@ -1,5 +1,9 @@
 #include "appcontroller.h"
+#include "tracer.h"
+#include "metrics.h"
+#include "processrecorder.h"
 #include "appconstants.h"
+#include "startupprofile.h"
 #include <QClipboard>
 #include <QGuiApplication>
 #include <QDir>
@@ -19,9 +23,17 @@
 #include <QCoreApplication>
 #include <QThread>
 #include <algorithm>
+#include <memory>
 #include <unistd.h>
 
 namespace {
+bool isRegistryAuthError(const QString &output)
+{
+    return output.contains("unauthorized", Qt::CaseInsensitive)
+        || output.contains("authentication required", Qt::CaseInsensitive)
+        || output.contains("denied:", Qt::CaseInsensitive);
+}
+
 QString normalizeMacForApi(const QString &mac)
 {
     QString normalized = mac.trimmed();
@@ -29,21 +41,20 @@ QString normalizeMacForApi(const QString &mac)
     return normalized.toLower();
 }
 
-QString extractLayerId(const QString &line)
+QUrl adminApiUrl(const QUrl &baseUrl, const QString &endpoint)
 {
-    static const QRegularExpression layerRe("^([0-9a-f]{6,}):");
-    const QRegularExpressionMatch match = layerRe.match(line);
-    return match.hasMatch() ? match.captured(1) : QString();
+    QUrl url(baseUrl);
+    QString path = url.path();
+    if (path.endsWith('/'))
+        path.chop(1);
+    url.setPath(path + "/api/" + endpoint);
+    return url;
 }
 
-QString stripAnsiSequences(const QString &input)
+const char *provisionStepName(int step)
 {
-    QString output = input;
-    static const QRegularExpression oscRe("\x1B\\][^\u0007]*\u0007");
-    static const QRegularExpression csiRe("\x1B\\[[0-9;?]*[ -/]*[@-~]");
-    output.remove(oscRe);
-    output.remove(csiRe);
-    return output;
+    static const char *names[] = {"register", "relay", "tenant"};
+    return names[step];
 }
 
 } // namespace
@@ -52,12 +63,124 @@ AppController::AppController(QObject *parent)
     : QObject(parent)
 {
     m_relayUrl = AppConstants::DefaultRelayUrl;
+    // Lets a local mock admin API stand in for the real service
+    m_serviceBaseUrl = qEnvironmentVariable("SAFECORE_SERVICE_BASE_URL", AppConstants::ServiceBaseUrl);
+    m_registration.setApiClient(&m_api);
     connect(&m_registration, &RegistrationService::keyGenerated,
             this, &AppController::onKeyGenerated);
-    m_dockerWatchdog.setInterval(5000);
+    connect(this, &AppController::registrationResult, this,
+            [this](bool ok, const QString &, const QString &, const QString &message) {
+                onProvisionStepResult(ProvisionRegister, ok, message);
+            });
+    connect(this, &AppController::syncResult, this, [this](bool ok, const QString &message) {
+        onProvisionStepResult(ProvisionRelay, ok, message);
+    });
+    connect(this, &AppController::tenantResult, this, [this](bool ok, const QString &message) {
+        onProvisionStepResult(ProvisionTenant, ok, message);
+    });
+    m_pullLogParser.setLayerObserver([this](const QString &layerId, const QString &line) {
+        m_pullStallDetector.observe(layerId, line);
+        // Committed once per chunk by appendDockerPullLog()
+        if (line.contains("Pull complete") || line.contains("Already exists")) {
+            StateStore::InstallState state = m_stateStore.installState();
+            if (!state.pulledLayers.contains(layerId)) {
+                state.pulledLayers.append(layerId);
+                m_stateStore.setInstallState(state);
+            }
+        }
+    });
+    connect(this, &AppController::dockerPullFinished, this, [this](bool, const QString &) {
+        // Finished, failed or canceled; nothing is left to resume
+        StateStore::InstallState state = m_stateStore.installState();
+        state.pullInFlight = false;
+        state.pulledLayers.clear();
+        saveInstallState(state);
+    });
+    m_upgradeLogParser.setLayerObserver([this](const QString &layerId, const QString &line) {
+        qint64 currentBytes = 0;
+        if (!line.contains("Downloading") || !PullStallDetector::parseProgressBytes(line, &currentBytes, nullptr))
+            return;
+        const qint64 previousBytes = m_upgradeLayerBytes.value(layerId, 0);
+        if (currentBytes > previousBytes) {
+            if (!m_upgradePullProxied)
+                m_bandwidth.recordTransfer(currentBytes - previousBytes);
+            Metrics::global().pullBytes.add(quint64(currentBytes - previousBytes));
+        }
+        m_upgradeLayerBytes.insert(layerId, currentBytes);
+    });
+    m_dockerWatchdog.setInterval(1000);
     m_dockerWatchdog.setSingleShot(false);
     connect(&m_dockerWatchdog, &QTimer::timeout, this, &AppController::checkDockerPullStall);
+    m_cleanupPolicy.setKeepCount(AppConstants::KnownGoodImageCount);
+    connect(&m_bandwidth, &BandwidthScheduler::capChanged, this, &AppController::downloadCapChanged);
+    connect(&m_bandwidth, &BandwidthScheduler::overrideChanged, this, &AppController::downloadCapChanged);
+    // A lifted cap is for the pull it was lifted for
+    connect(this, &AppController::dockerPullFinished, this, [this]() {
+        if (!m_upgradeRunning)
+            m_bandwidth.setOverride(false);
+    });
+    connect(this, &AppController::upgradeFinished, this, [this]() {
+        if (!m_dockerPullActive)
+            m_bandwidth.setOverride(false);
+    });
+    connect(&m_bandwidth, &BandwidthScheduler::throughputChanged, this, &AppController::downloadThroughputChanged);
+    connect(&m_bandwidth, &BandwidthScheduler::throughputChanged, this, [](double bytesPerSecond) {
+        Metrics::global().pullThroughput.set(bytesPerSecond);
+    });
+    connect(this, &AppController::dockerOpsFinished, this, [this](bool ok, const QString &) {
+        finishOperation(m_opsOperation, ok);
+        if (m_reconcileClock.isValid()) {
+            setDockerOpsLog(m_dockerOpsLog + QString("Reconcile %1 %2 in %3 ms.\n")
+                                .arg(m_reconcileAction, ok ? "finished" : "failed")
+                                .arg(m_reconcileClock.elapsed()));
+            m_reconcileClock.invalidate();
+        }
+    });
+    connect(this, &AppController::dockerOpsStopped, this, [this](bool ok, const QString &) {
+        finishOperation(Metrics::OperationStop, ok);
+    });
+    m_bandwidth.load();
+    m_credentials.setRegistry(AppConstants::DockerRegistryHost,
+                              AppConstants::DockerRegistryUser,
+                              AppConstants::DockerRegistryPassword);
+    m_registryProxy.setUpstream(QUrl("https://" + AppConstants::DockerRegistryHost));
+    m_registryProxy.setCredentials(&m_credentials);
+    m_registryProxy.setBandwidthScheduler(&m_bandwidth);
+    m_upgradeAgent.setImage(AppConstants::DockerImage);
+    m_upgradeAgent.setCredentials(&m_credentials);
+    m_upgradeAgent.setApiClient(&m_api);
+    m_credentials.setApiClient(&m_api);
+    m_upgradeAgent.setBandwidthScheduler(&m_bandwidth);
+    m_upgradeAgent.setForegroundBusy([this]() {
+        return m_upgradeRunning || m_dockerPullActive || m_dockerRetryPending;
+    });
+    connect(&m_upgradeAgent, &UpgradeAgent::statusChanged, this, &AppController::upgradeAgentStatusChanged);
+    connect(&m_upgradeAgent, &UpgradeAgent::stagedChanged, this, [this]() {
+        // A staged image is untagged until applied; keep cleanup away from it
+        const QString imageId = m_upgradeAgent.stagedUpgrade().imageId;
+        m_cleanupPolicy.setPinnedImages(imageId.isEmpty() ? QStringList() : QStringList{imageId});
+        emit stagedUpgradeChanged();
+    });
+    connect(&m_upgradeAgent, &UpgradeAgent::logLine, this, [this](const QString &line) {
+        setDockerOpsLog(m_dockerOpsLog + line + "\n");
+    });
+    if (!m_upgradeAgent.stagedUpgrade().imageId.isEmpty())
+        m_cleanupPolicy.setPinnedImages({m_upgradeAgent.stagedUpgrade().imageId});
+    connect(&m_networkMonitor, &NetworkMonitor::defaultRouteLost, this, &AppController::onDefaultRouteLost);
+    connect(&m_networkMonitor, &NetworkMonitor::defaultRouteRestored, this, &AppController::onDefaultRouteRestored);
+    m_networkMonitor.start();
+    connect(&m_modelVolumeSync, &ModelVolumeSync::logLine, this, [this](const QString &line) {
+        setDockerOpsLog(m_dockerOpsLog + line + "\n");
+    });
+    connect(&m_modelVolumeSync, &ModelVolumeSync::finished, this, [this](bool, const QString &) {
+        // A failed sync leaves the volume as it was; the container still starts
+        // and fetches whatever models it is missing on its own.
+        setDockerOpsStarting(false);
+        startDockerOpsContainer();
+    });
     loadSetupState();
+    restoreInstallState();
+    StartupProfile::mark("state-load");
 
     QTimer::singleShot(0, this, [this]() {
         QProcess *inspectProcess = new QProcess(this);
@@ -65,6 +188,7 @@ AppController::AppController(QObject *parent)
                 [this, inspectProcess](int exitCode, QProcess::ExitStatus exitStatus) {
                     const QString output = QString::fromUtf8(inspectProcess->readAll()).trimmed();
                     inspectProcess->deleteLater();
+                    StartupProfile::mark("docker-inspect");
                     if (exitStatus == QProcess::NormalExit && exitCode == 0 && !output.isEmpty()) {
                         const QStringList parts = output.split(' ', Qt::SkipEmptyParts);
                         const QString fullId = parts.value(0);
@@ -82,6 +206,7 @@ AppController::AppController(QObject *parent)
                     setDockerOpsConflict(false);
                     setDockerOpsRunning(false);
                 });
+        Tracer::traceProcess(inspectProcess, "docker inspect (startup)");
         inspectProcess->start("bash", {"-lc",
             QString("sg docker -c \"docker inspect -f '{{.Id}} {{.State.Running}}' %1 2>/dev/null\"").arg(AppConstants::ContainerName)});
     });
@@ -90,6 +215,9 @@ AppController::AppController(QObject *parent)
 AppController::~AppController()
 {
     if (m_dockerProcess) {
+        // Quitting mid-pull is resumed on the next launch like a crash, so the
+        // termination must not be reported as a failed pull
+        disconnect(m_dockerProcess, nullptr, this, nullptr);
         if (m_dockerProcess->state() != QProcess::NotRunning) {
             m_dockerProcess->terminate();
             if (!m_dockerProcess->waitForFinished(2000)) {
@@ -252,10 +380,7 @@ void AppController::setDockerPullLog(const QString &log)
 
 void AppController::clearDockerPullLog()
 {
-    m_dockerPullLines.clear();
-    m_dockerPullLineIndex.clear();
-    m_dockerPullRemainder.clear();
-    m_dockerPullLastLayerId.clear();
+    m_pullLogParser.clearLog();
     setDockerPullLog(QString());
 }
 
@@ -302,6 +427,9 @@ void AppController::setInstallPrereqsDone(bool value)
         return;
     m_installPrereqsDone = value;
     emit installPrereqsDoneChanged();
+    StateStore::InstallState state = m_stateStore.installState();
+    state.prereqsDone = value;
+    saveInstallState(state);
 }
 
 void AppController::setDockerOpsLog(const QString &log)
@@ -331,6 +459,13 @@ void AppController::setDockerOpsRunning(bool value)
         return;
     m_dockerOpsRunning = value;
     emit dockerOpsRunningChanged();
+    Metrics &metrics = Metrics::global();
+    metrics.containerTransitions[value ? Metrics::StateRunning : Metrics::StateStopped].add();
+    metrics.containerRunning.set(value ? 1.0 : 0.0);
+    if (value && metrics.enabled())
+        m_portProbe.start();
+    else if (!value)
+        m_portProbe.stop();
 }
 
 void AppController::setDockerOpsStarting(bool value)
@@ -339,6 +474,8 @@ void AppController::setDockerOpsStarting(bool value)
         return;
     m_dockerOpsStarting = value;
     emit dockerOpsStartingChanged();
+    if (value)
+        Metrics::global().containerTransitions[Metrics::StateStarting].add();
 }
 
 void AppController::setDockerOpsStopping(bool value)
@@ -347,6 +484,8 @@ void AppController::setDockerOpsStopping(bool value)
         return;
     m_dockerOpsStopping = value;
     emit dockerOpsStoppingChanged();
+    if (value)
+        Metrics::global().containerTransitions[Metrics::StateStopping].add();
 }
 
 void AppController::setDockerOpsConflict(bool value)
@@ -377,332 +516,80 @@ void AppController::appendDockerPullLog(const QString &chunk)
 {
     if (chunk.isEmpty())
         return;
-    QString normalized = chunk;
-    normalized.replace("\r", "\n");
-    normalized = stripAnsiSequences(normalized);
-    const QStringList lines = normalized.split('\n');
-    for (const QString &rawLine : lines) {
-        QString line = rawLine;
-        const QString trimmedLine = rawLine.trimmed();
-        if (trimmedLine.isEmpty())
-            continue;
-        if (trimmedLine.contains("killing shell", Qt::CaseInsensitive)
-            || trimmedLine.contains("killed.", Qt::CaseInsensitive)) {
-            continue;
-        }
-        if (trimmedLine.startsWith("Status:") || trimmedLine.startsWith("Digest:"))
-            m_dockerPullSawStatus = true;
-        QString layerId = extractLayerId(trimmedLine);
-        const bool isProgressLine = trimmedLine.startsWith("Downloading")
-            || trimmedLine.startsWith("Extracting")
-            || trimmedLine.startsWith("Waiting")
-            || trimmedLine.startsWith("Pull complete")
-            || trimmedLine.startsWith("Download complete")
-            || trimmedLine.startsWith("Pulling fs layer");
-        if (layerId.isEmpty() && isProgressLine && !m_dockerPullLastLayerId.isEmpty()) {
-            layerId = m_dockerPullLastLayerId;
-            line = m_dockerPullLastLayerId + ": " + trimmedLine;
-        }
-        if (!layerId.isEmpty())
-            m_dockerPullLastLayerId = layerId;
-        
-        // Format line for better column alignment
-        if (!layerId.isEmpty() && isProgressLine) {
-            // Extract components: layerId: Status [progress] size
-            const int colonIdx = line.indexOf(':');
-            if (colonIdx >= 0) {
-                QString remainder = line.mid(colonIdx + 1).trimmed();
-                QString status, progress;
-                
-                const int bracketIdx = remainder.indexOf('[');
-                if (bracketIdx > 0) {
-                    status = remainder.left(bracketIdx).trimmed();
-                    progress = remainder.mid(bracketIdx);
-                } else {
-                    status = remainder;
-                }
-                
-                // Format with fixed widths: layerId (13 chars) : status (22 chars) progress
-                line = QString("%1: %-22s%3")
-                    .arg(layerId, 13)
-                    .arg(status.toUtf8().constData())
-                    .arg(progress);
-            }
-        }
-        
-        if (!layerId.isEmpty()) {
-            const int existingIndex = m_dockerPullLineIndex.value(layerId, -1);
-            if (existingIndex >= 0 && existingIndex < m_dockerPullLines.size()) {
-                m_dockerPullLines[existingIndex] = line;
-            } else {
-                m_dockerPullLineIndex.insert(layerId, m_dockerPullLines.size());
-                m_dockerPullLines.append(line);
-            }
-        } else {
-            if (isProgressLine)
-                continue;
-            m_dockerPullLines.append(line);
-        }
+    const int layersDone = m_pullLogParser.completedLayers();
+    m_pullLogParser.append(chunk);
+    setDockerPullLog(m_pullLogParser.text());
+    if (m_pullLogParser.completedLayers() != layersDone) {
+        QString error;
+        if (!m_stateStore.commit(&error))
+            qWarning().noquote() << "Could not checkpoint pulled layers:" << error;
     }
+    Metrics &metrics = Metrics::global();
+    metrics.logLines[Metrics::LogPull].add(quint64(chunk.count(QLatin1Char('\n'))));
+    metrics.pullLayers.set(m_pullLogParser.layerCount());
+    metrics.pullLayersDone.set(m_pullLogParser.completedLayers());
 
-    const int maxLines = 200;
-    if (m_dockerPullLines.size() > maxLines) {
-        m_dockerPullLines = m_dockerPullLines.mid(m_dockerPullLines.size() - maxLines);
-        m_dockerPullLineIndex.clear();
-        for (int i = 0; i < m_dockerPullLines.size(); ++i) {
-            const QString layerId = extractLayerId(m_dockerPullLines[i]);
-            if (!layerId.isEmpty())
-                m_dockerPullLineIndex.insert(layerId, i);
-        }
+    // The daemon paces its own transfers; account for them so the measured
+    // rate can be compared against the cap. A drop means a layer restarted.
+    const qint64 meteredBytes = m_pullStallDetector.downloadedBytes();
+    if (meteredBytes > m_dockerPullMeteredBytes) {
+        if (!m_dockerPullProxied)
+            m_bandwidth.recordTransfer(meteredBytes - m_dockerPullMeteredBytes);
+        metrics.pullBytes.add(quint64(meteredBytes - m_dockerPullMeteredBytes));
+    }
+    m_dockerPullMeteredBytes = meteredBytes;
+
+    QString resumedLayer;
+    qint64 stalledForMs = 0;
+    if (m_pullStallDetector.takeResumedLayer(&resumedLayer, &stalledForMs)) {
+        appendDockerPullEvent(QString("[stall] layer %1 resumed after %2 s")
+                                  .arg(resumedLayer)
+                                  .arg(double(stalledForMs) / 1000.0, 0, 'f', 1));
     }
-    setDockerPullLog(m_dockerPullLines.join("\n"));
-    updateDockerPullProgressFromChunk(normalized);
+
+    if (m_pullLogParser.layerCount() > 0)
+        setDockerPullProgress(m_pullLogParser.progress());
 }
 
-void AppController::resetDockerPullProgress()
+void AppController::appendDockerPullEvent(const QString &message)
 {
-    m_dockerPullRemainder.clear();
-    m_dockerPullLines.clear();
-    m_dockerPullLineIndex.clear();
-    m_dockerPullLayerState.clear();
-    m_dockerPullLastLayerId.clear();
-    m_dockerPullSawStatus = false;
-    setDockerPullProgress(0.0);
+    // Controller events bypass the progress parser so they never count as layers
+    m_pullLogParser.appendEvent(message);
+    setDockerPullLog(m_pullLogParser.text());
 }
 
-void AppController::updateDockerPullProgressFromChunk(const QString &chunk)
+void AppController::resetDockerPullProgress()
 {
-    QString data = m_dockerPullRemainder + chunk;
-    const bool endsWithNewline = data.endsWith('\n');
-    QStringList lines = data.split('\n');
-    if (!endsWithNewline) {
-        m_dockerPullRemainder = lines.takeLast();
-    } else {
-        m_dockerPullRemainder.clear();
-    }
-
-    bool changed = false;
-    QString lastLayerId = m_dockerPullLastLayerId;
-    for (const QString &line : lines) {
-        const QString trimmed = line.trimmed();
-        const int colonIdx = trimmed.indexOf(':');
-        QString layerId;
-        if (colonIdx > 0) {
-            layerId = trimmed.left(colonIdx);
-        } else {
-            const bool isProgressLine = trimmed.startsWith("Downloading")
-                || trimmed.startsWith("Extracting")
-                || trimmed.startsWith("Waiting")
-                || trimmed.startsWith("Pull complete")
-                || trimmed.startsWith("Download complete")
-                || trimmed.startsWith("Pulling fs layer");
-            if (isProgressLine && !lastLayerId.isEmpty())
-                layerId = lastLayerId;
-        }
-        if (layerId.isEmpty() || layerId.size() < 6)
-            continue;
-
-        lastLayerId = layerId;
-
-        int newState = -1;
-        if (trimmed.contains("Pull complete") || trimmed.contains("Already exists")
-            || trimmed.contains("Download complete")) {
-            newState = 2;
-        } else if (trimmed.contains("Downloading") || trimmed.contains("Extracting")
-                   || trimmed.contains("Pulling fs layer") || trimmed.contains("Verifying Checksum")
-                   ) {
-            newState = 1;
-        } else if (trimmed.contains("Waiting")) {
-            newState = 0;
-        }
-
-        if (newState >= 0) {
-            const int prevState = m_dockerPullLayerState.value(layerId, -1);
-            if (newState > prevState) {
-                m_dockerPullLayerState.insert(layerId, newState);
-                changed = true;
-            } else if (prevState < 0) {
-                m_dockerPullLayerState.insert(layerId, newState);
-                changed = true;
-            }
-        }
-    }
-
-    m_dockerPullLastLayerId = lastLayerId;
-    const int total = m_dockerPullLayerState.size();
-    if (total <= 0)
-        return;
-
-    int done = 0;
-    int inProgress = 0;
-    for (auto it = m_dockerPullLayerState.constBegin(); it != m_dockerPullLayerState.constEnd(); ++it) {
-        if (it.value() >= 2)
-            ++done;
-        else if (it.value() == 1)
-            ++inProgress;
-    }
-
-    const double weighted = static_cast<double>(done) + (static_cast<double>(inProgress) * 0.3);
-    const double ratio = weighted / static_cast<double>(total);
-    const double newProgress = qMin(0.98, ratio);
-    if (changed || !qFuzzyCompare(newProgress, m_dockerPullProgress)) {
-        setDockerPullProgress(newProgress);
-    }
+    m_pullLogParser.reset();
+    m_pullStallDetector.reset();
+    m_dockerPullMeteredBytes = 0;
+    setDockerPullProgress(0.0);
 }
 
 void AppController::appendUpgradeLog(const QString &chunk)
 {
     if (chunk.isEmpty())
         return;
-    QString normalized = chunk;
-    normalized.replace("\r", "\n");
-    normalized = stripAnsiSequences(normalized);
-    const QStringList lines = normalized.split('\n');
-    for (const QString &rawLine : lines) {
-        QString line = rawLine;
-        const QString trimmedLine = rawLine.trimmed();
-        if (trimmedLine.isEmpty())
-            continue;
-        if (trimmedLine.contains("killing shell", Qt::CaseInsensitive)
-            || trimmedLine.contains("killed.", Qt::CaseInsensitive)) {
-            continue;
-        }
-        if (trimmedLine.startsWith("Status:") || trimmedLine.startsWith("Digest:"))
-            m_upgradeSawStatus = true;
-        QString layerId = extractLayerId(trimmedLine);
-        const bool isProgressLine = trimmedLine.startsWith("Downloading")
-            || trimmedLine.startsWith("Extracting")
-            || trimmedLine.startsWith("Waiting")
-            || trimmedLine.startsWith("Pull complete")
-            || trimmedLine.startsWith("Download complete")
-            || trimmedLine.startsWith("Pulling fs layer");
-        if (layerId.isEmpty() && isProgressLine && !m_upgradeLastLayerId.isEmpty()) {
-            layerId = m_upgradeLastLayerId;
-            line = m_upgradeLastLayerId + ": " + trimmedLine;
-        }
-        if (!layerId.isEmpty())
-            m_upgradeLastLayerId = layerId;
-        if (!layerId.isEmpty()) {
-            const int existingIndex = m_upgradeLineIndex.value(layerId, -1);
-            if (existingIndex >= 0 && existingIndex < m_upgradeLines.size()) {
-                m_upgradeLines[existingIndex] = line;
-            } else {
-                m_upgradeLineIndex.insert(layerId, m_upgradeLines.size());
-                m_upgradeLines.append(line);
-            }
-        } else {
-            if (isProgressLine)
-                continue;
-            m_upgradeLines.append(line);
-        }
-    }
-
-    const int maxLines = 200;
-    if (m_upgradeLines.size() > maxLines) {
-        m_upgradeLines = m_upgradeLines.mid(m_upgradeLines.size() - maxLines);
-        m_upgradeLineIndex.clear();
-        for (int i = 0; i < m_upgradeLines.size(); ++i) {
-            const QString layerId = extractLayerId(m_upgradeLines[i]);
-            if (!layerId.isEmpty())
-                m_upgradeLineIndex.insert(layerId, i);
-        }
-    }
-    m_upgradeLog = m_upgradeLines.join("\n");
+    m_upgradeLogParser.append(chunk);
+    // The upgrade pull is the same kind of image pull, so it feeds the same
+    // layer gauges as the install pull
+    Metrics &metrics = Metrics::global();
+    metrics.logLines[Metrics::LogUpgrade].add(quint64(chunk.count(QLatin1Char('\n'))));
+    metrics.pullLayers.set(m_upgradeLogParser.layerCount());
+    metrics.pullLayersDone.set(m_upgradeLogParser.completedLayers());
+    m_upgradeLog = m_upgradeLogParser.text();
     emit upgradeLogChanged();
-    updateUpgradeProgressFromChunk(normalized);
+    if (m_upgradeLogParser.layerCount() > 0)
+        setUpgradeProgress(m_upgradeLogParser.progress());
 }
 
 void AppController::resetUpgradeProgress()
 {
-    m_upgradeRemainder.clear();
-    m_upgradeLines.clear();
-    m_upgradeLineIndex.clear();
-    m_upgradeLayerState.clear();
-    m_upgradeLastLayerId.clear();
-    m_upgradeSawStatus = false;
+    m_upgradeLogParser.reset();
+    m_upgradeLayerBytes.clear();
     setUpgradeProgress(0.0);
 }
 
-void AppController::updateUpgradeProgressFromChunk(const QString &chunk)
-{
-    QString data = m_upgradeRemainder + chunk;
-    const bool endsWithNewline = data.endsWith('\n');
-    QStringList lines = data.split('\n');
-    if (!endsWithNewline) {
-        m_upgradeRemainder = lines.takeLast();
-    } else {
-        m_upgradeRemainder.clear();
-    }
-
-    bool changed = false;
-    QString lastLayerId = m_upgradeLastLayerId;
-    for (const QString &line : lines) {
-        const QString trimmed = line.trimmed();
-        const int colonIdx = trimmed.indexOf(':');
-        QString layerId;
-        if (colonIdx > 0) {
-            layerId = trimmed.left(colonIdx);
-        } else {
-            const bool isProgressLine = trimmed.startsWith("Downloading")
-                || trimmed.startsWith("Extracting")
-                || trimmed.startsWith("Waiting")
-                || trimmed.startsWith("Pull complete")
-                || trimmed.startsWith("Download complete")
-                || trimmed.startsWith("Pulling fs layer");
-            if (isProgressLine && !lastLayerId.isEmpty())
-                layerId = lastLayerId;
-        }
-        if (layerId.isEmpty() || layerId.size() < 6)
-            continue;
-
-        lastLayerId = layerId;
-
-        int newState = -1;
-        if (trimmed.contains("Pull complete") || trimmed.contains("Already exists")
-            || trimmed.contains("Download complete")) {
-            newState = 2;
-        } else if (trimmed.contains("Downloading") || trimmed.contains("Extracting")
-                   || trimmed.contains("Pulling fs layer") || trimmed.contains("Verifying Checksum")
-                   ) {
-            newState = 1;
-        } else if (trimmed.contains("Waiting")) {
-            newState = 0;
-        }
-
-        if (newState >= 0) {
-            const int prevState = m_upgradeLayerState.value(layerId, -1);
-            if (newState > prevState) {
-                m_upgradeLayerState.insert(layerId, newState);
-                changed = true;
-            } else if (prevState < 0) {
-                m_upgradeLayerState.insert(layerId, newState);
-                changed = true;
-            }
-        }
-    }
-
-    m_upgradeLastLayerId = lastLayerId;
-    const int total = m_upgradeLayerState.size();
-    if (total <= 0)
-        return;
-
-    int done = 0;
-    int inProgress = 0;
-    for (auto it = m_upgradeLayerState.constBegin(); it != m_upgradeLayerState.constEnd(); ++it) {
-        if (it.value() >= 2)
-            ++done;
-        else if (it.value() == 1)
-            ++inProgress;
-    }
-
-    const double weighted = static_cast<double>(done) + (static_cast<double>(inProgress) * 0.3);
-    const double ratio = weighted / static_cast<double>(total);
-    const double newProgress = qMin(0.98, ratio);
-    if (changed || !qFuzzyCompare(newProgress, m_upgradeProgress)) {
-        setUpgradeProgress(newProgress);
-    }
-}
-
 void AppController::setUpgradeProgress(double value)
 {
     if (qFuzzyCompare(value, m_upgradeProgress))
@@ -713,19 +600,69 @@ void AppController::setUpgradeProgress(double value)
 
 void AppController::loadSetupState()
 {
-    const QString basePath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore";
-    QFile inFile(basePath + "/setup_state.json");
-    if (!inFile.open(QIODevice::ReadOnly))
-        return;
+    m_stateStore.load();
+    const StateStore::SetupState &state = m_stateStore.setupState();
+    m_registrationOk = state.registrationOk;
+    m_dockerPullOk = state.dockerPullOk;
+    m_setupComplete = state.setupComplete;
+}
+
+void AppController::restoreInstallState()
+{
+    const StateStore::InstallState &state = m_stateStore.installState();
+    if (m_setupComplete || state.step <= 0)
+        return;
+
+    // The checkpoint only counts for the registration it was made with; the
+    // recorded step inputs include the key, so a changed service URL or a
+    // newer key simply fails to match and that step runs again.
+    if (m_stateStore.hasRegistration() && m_stateStore.registration().isComplete()) {
+        const StateStore::Registration &registration = m_stateStore.registration();
+        m_macId = registration.macId;
+        m_tenantId = registration.tenantId;
+        m_registrationKey = registration.registrationKey;
+        m_registrationGeneratedOn = registration.generatedOn;
+        if (!state.relayUrl.isEmpty())
+            m_relayUrl = state.relayUrl;
+        m_tenantVertical = state.vertical;
+        for (int step = 0; step < ProvisionStepCount; ++step)
+            m_provisionCompleted[step] = state.provisioned.value(step);
+        m_keyValid = !m_registrationKey.isEmpty()
+            && m_provisionCompleted[ProvisionRegister] == provisionInputs(ProvisionRegister, QString());
+        m_registrationAttempted = m_keyValid;
+        m_tenantSuccess = m_keyValid && m_stateStore.hasTenant()
+            && m_provisionCompleted[ProvisionTenant] == provisionInputs(ProvisionTenant, m_tenantVertical);
+    }
+    m_installPrereqsDone = state.prereqsDone;
+
+    int step = state.step;
+    if (step > 1 && !m_tenantSuccess)
+        step = 1;
+    setStep(step);
+    Tracer::instant("controller", "resume step " + QByteArray::number(step));
+    if (state.pullInFlight)
+        qInfo().noquote() << "Resuming install; the last pull stopped with" << state.pulledLayers.size()
+                          << "layer(s) complete";
+}
 
-    const QJsonDocument doc = QJsonDocument::fromJson(inFile.readAll());
-    if (!doc.isObject())
-        return;
+void AppController::saveInstallState(const StateStore::InstallState &state)
+{
+    m_stateStore.setInstallState(state);
+    QString error;
+    if (!m_stateStore.commit(&error))
+        qWarning().noquote() << "Could not save install state:" << error;
+    emit installStateChanged();
+}
 
-    const QJsonObject obj = doc.object();
-    m_registrationOk = obj.value("registrationOk").toBool(false);
-    m_dockerPullOk = obj.value("dockerPullOk").toBool(false);
-    m_setupComplete = obj.value("setupComplete").toBool(false);
+bool AppController::relaySynced() const
+{
+    return m_keyValid && m_provisionCompleted[ProvisionRelay] == provisionInputs(ProvisionRelay, QString());
+}
+
+bool AppController::pullInterrupted() const
+{
+    return m_stateStore.installState().pullInFlight && m_installPrereqsDone && !m_dockerPullOk
+        && !m_dockerPullActive && !m_dockerProcess;
 }
 
 void AppController::resetLocalState()
@@ -734,6 +671,7 @@ void AppController::resetLocalState()
     QDir dir(basePath);
     if (dir.exists())
         dir.removeRecursively();
+    m_stateStore.clear();
 
     m_registrationOk = false;
     m_dockerPullOk = false;
@@ -746,6 +684,12 @@ void AppController::resetLocalState()
     m_relayError.clear();
     m_tenantMessage.clear();
     m_tenantSuccess = false;
+    m_tenantVertical.clear();
+    m_keyValid = false;
+    for (QString &inputs : m_provisionCompleted)
+        inputs.clear();
+    m_installPrereqsDone = false;
+    setStep(0);
     emit registrationAttemptedChanged();
     emit registrationErrorChanged();
     emit registrationMessageChanged();
@@ -754,24 +698,21 @@ void AppController::resetLocalState()
     emit relayErrorChanged();
     emit tenantMessageChanged();
     emit tenantSuccessChanged();
+    emit keyValidChanged();
+    emit installPrereqsDoneChanged();
+    emit installStateChanged();
 }
 
 void AppController::persistSetupState()
 {
-    const QString basePath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore";
-    QDir dir(basePath);
-    dir.mkpath(".");
-
-    QFile outFile(basePath + "/setup_state.json");
-    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
-        return;
-
-    QJsonObject obj;
-    obj.insert("setupComplete", m_setupComplete);
-    obj.insert("registrationOk", m_registrationOk);
-    obj.insert("dockerPullOk", m_dockerPullOk);
-    obj.insert("savedAt", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
-    outFile.write(QJsonDocument(obj).toJson(QJsonDocument::Indented));
+    StateStore::SetupState state = m_stateStore.setupState();
+    state.setupComplete = m_setupComplete;
+    state.registrationOk = m_registrationOk;
+    state.dockerPullOk = m_dockerPullOk;
+    m_stateStore.setSetupState(state);
+    QString error;
+    if (!m_stateStore.commit(&error))
+        qWarning().noquote() << "Could not save setup state:" << error;
 }
 
 void AppController::updateSetupComplete()
@@ -802,6 +743,15 @@ void AppController::setStep(int step)
     if (m_currentStep == step) return;
     m_currentStep = step;
     emit currentStepChanged();
+    if (m_stateStore.installState().step != step) {
+        StateStore::InstallState state = m_stateStore.installState();
+        state.step = step;
+        saveInstallState(state);
+    }
+    Tracer::instant("controller", "step " + QByteArray::number(step));
+    // The registration calls follow shortly; have the connection ready for them
+    if (step == 1)
+        m_api.warmUp(QUrl(m_serviceBaseUrl.trimmed()));
 }
 
 void AppController::setRegistrationError(const QString &message)
@@ -835,6 +785,7 @@ void AppController::setTenantMessage(const QString &message)
 
 void AppController::validateKey()
 {
+    TraceSpan span("controller", "validateKey");
     const QString mac = m_macId.trimmed();
     const QString tenant = m_tenantId.trimmed();
 
@@ -931,20 +882,14 @@ void AppController::onKeyGenerated(bool ok, const QString &message, const QStrin
         emit registrationGeneratedOnChanged();
     }
 
+    // Committed together with the setup state by updateSetupComplete() below
     if (ok && !m_registrationKey.isEmpty()) {
-        const QString basePath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore";
-        QDir dataDir(basePath);
-        dataDir.mkpath("data");
-        QFile outFile(dataDir.filePath("data/registration_data.json"));
-        if (outFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-            QJsonObject payload;
-            payload.insert("savedAt", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
-            payload.insert("macId", m_macId.trimmed());
-            payload.insert("tenantId", m_tenantId.trimmed());
-            payload.insert("registrationKey", m_registrationKey);
-            payload.insert("generatedOn", m_registrationGeneratedOn);
-            outFile.write(QJsonDocument(payload).toJson(QJsonDocument::Indented));
-        }
+        StateStore::Registration registration;
+        registration.macId = m_macId.trimmed();
+        registration.tenantId = m_tenantId.trimmed();
+        registration.registrationKey = m_registrationKey;
+        registration.generatedOn = m_registrationGeneratedOn;
+        m_stateStore.setRegistration(registration);
     }
 
     if (ok) {
@@ -964,6 +909,7 @@ void AppController::onKeyGenerated(bool ok, const QString &message, const QStrin
 
 void AppController::syncRelay()
 {
+    TraceSpan span("controller", "syncRelay");
     if (!m_keyValid) {
         setStatus("Register first before syncing.");
         emit syncResult(false, "Register first before syncing.");
@@ -1002,13 +948,7 @@ void AppController::syncRelay()
     setSyncBusy(true);
     setStatus("Syncing relay API...");
 
-    QUrl url(baseUrl);
-    QString path = url.path();
-    if (path.endsWith('/'))
-        path.chop(1);
-    url.setPath(path + "/api/registration/syncdevice");
-
-    QNetworkRequest request(url);
+    QNetworkRequest request(adminApiUrl(baseUrl, "registration/syncdevice"));
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
     request.setRawHeader("accept", "*/*");
 
@@ -1018,19 +958,22 @@ void AppController::syncRelay()
     payload.insert("tenantId", m_tenantId.trimmed());
     payload.insert("relayApi", relay);
 
-    QNetworkReply *reply = m_net.post(request, QJsonDocument(payload).toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        const QByteArray body = reply->readAll();
-        const QNetworkReply::NetworkError err = reply->error();
-        const QString errString = reply->errorString();
-        const int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        reply->deleteLater();
+    // Setting the relay is idempotent, so any transient failure is retried
+    ApiClient::Policy policy;
+    policy.deadlineMs = 30000;
+    policy.idempotent = true;
+
+    m_api.post("registration/syncdevice", request, QJsonDocument(payload).toJson(QJsonDocument::Compact), policy,
+               [this](const ApiClient::Response &response) {
+        const QNetworkReply::NetworkError err = response.error;
+        const QString errString = response.errorString;
+        const int httpStatus = response.httpStatus;
 
         bool ok = false;
         QString finalMessage;
 
         QJsonParseError parseError{};
-        const QJsonDocument doc = QJsonDocument::fromJson(body, &parseError);
+        const QJsonDocument doc = QJsonDocument::fromJson(response.body, &parseError);
         if (parseError.error == QJsonParseError::NoError && doc.isObject()) {
             const QJsonObject root = doc.object();
             const int statusCode = root.value("statusCode").toInt(httpStatus);
@@ -1057,12 +1000,14 @@ void AppController::syncRelay()
 
 void AppController::fetchTenantData(const QString &vertical)
 {
+    TraceSpan span("controller", "fetchTenantData");
     if (m_tenantBusy)
         return;
 
     setTenantSuccess(false);
     if (!m_keyValid) {
         setTenantMessage("Register first before fetching tenant data.");
+        emit tenantResult(false, m_tenantMessage);
         return;
     }
 
@@ -1072,31 +1017,29 @@ void AppController::fetchTenantData(const QString &vertical)
 
     if (mac.isEmpty() || tenant.isEmpty()) {
         setTenantMessage("MAC ID and Tenant ID are required.");
+        emit tenantResult(false, m_tenantMessage);
         return;
     }
 
     if (trimmedVertical.isEmpty()) {
         setTenantMessage("Vertical is required.");
+        emit tenantResult(false, m_tenantMessage);
         return;
     }
 
     QUrl baseUrl(m_serviceBaseUrl.trimmed());
     if (!baseUrl.isValid()) {
         setTenantMessage("Service URL is invalid.");
+        emit tenantResult(false, m_tenantMessage);
         return;
     }
 
     setTenantMessage(QString());
     setTenantBusy(true);
     setStatus("Fetching tenant data...");
+    m_tenantVertical = trimmedVertical;
 
-    QUrl url(baseUrl);
-    QString path = url.path();
-    if (path.endsWith('/'))
-        path.chop(1);
-    url.setPath(path + "/api/tenant/GetTenantDataById");
-
-    QNetworkRequest request(url);
+    QNetworkRequest request(adminApiUrl(baseUrl, "tenant/GetTenantDataById"));
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
     request.setRawHeader("accept", "*/*");
 
@@ -1106,19 +1049,22 @@ void AppController::fetchTenantData(const QString &vertical)
     payload.insert("accessKey", m_tenantAccessKey);
     payload.insert("macId", mac);
 
-    QNetworkReply *reply = m_net.post(request, QJsonDocument(payload).toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        const QByteArray body = reply->readAll();
-        const QNetworkReply::NetworkError err = reply->error();
-        const QString errString = reply->errorString();
-        const int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        reply->deleteLater();
+    // A read; safe to retry on any transient failure
+    ApiClient::Policy policy;
+    policy.deadlineMs = 30000;
+    policy.idempotent = true;
+
+    m_api.post("tenant/GetTenantDataById", request, QJsonDocument(payload).toJson(QJsonDocument::Compact), policy,
+               [this](const ApiClient::Response &response) {
+        const QNetworkReply::NetworkError err = response.error;
+        const QString errString = response.errorString;
+        const int httpStatus = response.httpStatus;
 
         bool ok = false;
         QString finalMessage;
 
         QJsonParseError parseError{};
-        const QJsonDocument doc = QJsonDocument::fromJson(body, &parseError);
+        const QJsonDocument doc = QJsonDocument::fromJson(response.body, &parseError);
         if (parseError.error == QJsonParseError::NoError && doc.isObject()) {
             const QJsonObject root = doc.object();
             const int statusCode = root.value("statusCode").toInt(httpStatus);
@@ -1132,16 +1078,11 @@ void AppController::fetchTenantData(const QString &vertical)
             if (ok) {
                 const QJsonObject data = root.value("data").toObject();
                 if (!data.isEmpty()) {
-                    const QString basePath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore";
-                    QDir dataDir(basePath);
-                    dataDir.mkpath("data");
-                    QFile outFile(dataDir.filePath("data/tenant_data.json"));
-                    if (outFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-                        QJsonObject payload;
-                        payload.insert("savedAt", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
-                        payload.insert("data", data);
-                        outFile.write(QJsonDocument(payload).toJson(QJsonDocument::Indented));
-                    }
+                    m_stateStore.setTenant(data);
+                    QString error;
+                    if (!m_stateStore.commit(&error))
+                        qWarning().noquote() << "Could not save tenant data:" << error;
+                    precreateDockerOpsContainer();
                 }
                 finalMessage = message.isEmpty() ? "Tenant data retrieved successfully." : message;
             } else {
@@ -1163,11 +1104,111 @@ void AppController::fetchTenantData(const QString &vertical)
         setTenantSuccess(ok);
         setTenantMessage(finalMessage);
         setStatus(finalMessage);
+        emit tenantResult(ok, finalMessage);
     });
 }
 
+void AppController::setProvisioning(bool value)
+{
+    if (m_provisioning == value) return;
+    m_provisioning = value;
+    emit provisioningChanged();
+}
+
+QString AppController::provisionInputs(int step, const QString &vertical) const
+{
+    QStringList inputs = {m_serviceBaseUrl.trimmed(), normalizeMacForApi(m_macId), m_tenantId.trimmed()};
+    if (step == ProvisionRelay)
+        inputs << m_registrationKey << m_relayUrl.trimmed();
+    else if (step == ProvisionTenant)
+        inputs << m_registrationKey << vertical.trimmed();
+    return inputs.join('|');
+}
+
+void AppController::provision(const QString &vertical)
+{
+    TraceSpan span("controller", "provision");
+    if (m_provisioning || m_busy || m_syncBusy || m_tenantBusy)
+        return;
+
+    m_provisionVertical = vertical.trimmed();
+    setProvisioning(true);
+    m_provisionClock.start();
+    m_provisionStep = ProvisionRegister;
+    runProvisionStep();
+}
+
+void AppController::runProvisionStep()
+{
+    // Skip what already succeeded; a new registration key invalidates the
+    // relay and tenant steps because it is part of their inputs.
+    while (m_provisionStep < ProvisionStepCount) {
+        const bool done = m_provisionCompleted[m_provisionStep] == provisionInputs(m_provisionStep, m_provisionVertical)
+            && (m_provisionStep != ProvisionRegister || m_keyValid);
+        if (!done)
+            break;
+        emit provisioningStep(provisionStepName(m_provisionStep), true, "Already done.", 0);
+        ++m_provisionStep;
+    }
+
+    if (m_provisionStep >= ProvisionStepCount) {
+        const qint64 elapsed = m_provisionClock.elapsed();
+        const QString message = QString("Provisioning completed in %1 ms.").arg(elapsed);
+        m_provisionStep = -1;
+        setProvisioning(false);
+        setStatus(message);
+        emit provisioningFinished(true, message, elapsed);
+        return;
+    }
+
+    m_provisionStepClock.start();
+    switch (m_provisionStep) {
+    case ProvisionRegister:
+        validateKey();
+        break;
+    case ProvisionRelay:
+        syncRelay();
+        // Relay URL problems are reported inline without a syncResult
+        if (m_provisioning && m_provisionStep == ProvisionRelay && !m_syncBusy)
+            onProvisionStepResult(ProvisionRelay, false, m_relayError.isEmpty() ? "Sync failed." : m_relayError);
+        break;
+    case ProvisionTenant:
+        fetchTenantData(m_provisionVertical);
+        break;
+    }
+}
+
+void AppController::onProvisionStepResult(int step, bool ok, const QString &message)
+{
+    // Results from manual clicks count too, so a later provision() skips them
+    const QString vertical = step == ProvisionTenant ? m_tenantVertical : m_provisionVertical;
+    m_provisionCompleted[step] = ok ? provisionInputs(step, vertical) : QString();
+    StateStore::InstallState state = m_stateStore.installState();
+    state.provisioned.clear();
+    for (const QString &inputs : m_provisionCompleted)
+        state.provisioned.append(inputs);
+    state.relayUrl = m_relayUrl.trimmed();
+    state.vertical = m_tenantVertical;
+    saveInstallState(state);
+    if (!m_provisioning || m_provisionStep != step)
+        return;
+
+    emit provisioningStep(provisionStepName(step), ok, message, m_provisionStepClock.elapsed());
+    if (ok) {
+        ++m_provisionStep;
+        runProvisionStep();
+        return;
+    }
+
+    const qint64 elapsed = m_provisionClock.elapsed();
+    m_provisionStep = -1;
+    setProvisioning(false);
+    emit provisioningFinished(false, message, elapsed);
+}
+
 void AppController::startInstall()
 {
+    TraceSpan span("controller", "startInstall");
     if (!m_keyValid) {
         setStatus("Key is not valid. Please validate first.");
         return;
@@ -1190,14 +1231,19 @@ void AppController::startInstall()
 
 void AppController::pullDockerImage()
 {
-    if (m_dockerProcess && m_dockerProcess->state() != QProcess::NotRunning)
+    TraceSpan span("controller", "pullDockerImage");
+    if ((m_dockerProcess && m_dockerProcess->state() != QProcess::NotRunning) || m_dockerRetryPending)
         return;
 
     resetDockerPullProgress();
     m_dockerPullCanceled = false;
     m_dockerAwaitingNetwork = false;
     m_dockerProbeActive = false;
+    m_dockerRetryPending = false;
     setDockerPullLog("");
+    StateStore::InstallState state = m_stateStore.installState();
+    state.pullInFlight = true;
+    saveInstallState(state);
     
     // Login to registry first, then pull
     performDockerLogin([this](bool loginOk) {
@@ -1217,8 +1263,20 @@ void AppController::pullDockerImage()
     });
 }
 
+void AppController::resumeDockerPull()
+{
+    if (!pullInterrupted())
+        return;
+    // No cleanup here: unlike a cancel, nothing of the interrupted pull is
+    // dangling, and removing anything would throw completed layers away
+    const int layers = m_stateStore.installState().pulledLayers.size();
+    pullDockerImage();
+    appendDockerPullEvent(QString("Resuming the interrupted pull; %1 layer(s) it completed are reused.").arg(layers));
+}
+
 void AppController::startInstallPrereqs()
 {
+    TraceSpan span("controller", "startInstallPrereqs");
     if (m_installPrereqsRunning)
         return;
 
@@ -1268,6 +1326,7 @@ void AppController::startInstallPrereqs()
 
     m_installPrereqsProcess = new QProcess(this);
     m_installPrereqsProcess->setProcessChannelMode(QProcess::MergedChannels);
+    Tracer::traceProcess(m_installPrereqsProcess, "pkexec install-prereqs");
     m_installPrereqsProcess->start("pkexec", {scriptPath});
 
     QPointer<QProcess> installProcess(m_installPrereqsProcess);
@@ -1275,7 +1334,7 @@ void AppController::startInstallPrereqs()
     connect(m_installPrereqsProcess, &QProcess::readyRead, this, [this, installProcess]() {
         if (!installProcess)
             return;
-        const QString chunk = stripAnsiSequences(QString::fromUtf8(installProcess->readAll()));
+        const QString chunk = PullLogParser::stripAnsiSequences(QString::fromUtf8(installProcess->readAll()));
         if (!chunk.isEmpty())
             setInstallPrereqsLog(m_installPrereqsLog + chunk);
     });
@@ -1292,7 +1351,7 @@ void AppController::startInstallPrereqs()
                         m_installPrereqsProcess = nullptr;
                     return;
                 }
-                const QString output = stripAnsiSequences(QString::fromUtf8(installProcess->readAll())).trimmed();
+                const QString output = PullLogParser::stripAnsiSequences(QString::fromUtf8(installProcess->readAll())).trimmed();
                 const bool ok = (exitStatus == QProcess::NormalExit && exitCode == 0);
                 setInstallPrereqsRunning(false);
                 setInstallPrereqsDone(ok);
@@ -1317,7 +1376,7 @@ void AppController::startInstallPrereqs()
                         m_installPrereqsProcess = nullptr;
                     return;
                 }
-                const QString output = stripAnsiSequences(QString::fromUtf8(installProcess->readAll())).trimmed();
+                const QString output = PullLogParser::stripAnsiSequences(QString::fromUtf8(installProcess->readAll())).trimmed();
                 setInstallPrereqsRunning(false);
                 setInstallPrereqsDone(false);
                 if (!output.isEmpty())
@@ -1331,6 +1390,7 @@ void AppController::startInstallPrereqs()
 
 void AppController::cancelInstallPrereqs()
 {
+    TraceSpan span("controller", "cancelInstallPrereqs");
     if (!m_installPrereqsProcess)
         return;
     m_installPrereqsCanceled = true;
@@ -1372,70 +1432,45 @@ void AppController::performDockerLogin(std::function<void(bool)> callback, int r
     } else {
         appendDockerPullLog(QString("Retry attempt %1 of %2...\n").arg(retryCount).arg(maxRetries - 1));
     }
-    
-    QProcess *loginProcess = new QProcess(this);
-    loginProcess->setProcessChannelMode(QProcess::MergedChannels);
-    
-    connect(loginProcess, &QProcess::finished, this,
-            [this, loginProcess, callback, retryCount, maxRetries, retryDelayMs](int exitCode, QProcess::ExitStatus exitStatus) {
-                const QString output = QString::fromUtf8(loginProcess->readAll()).trimmed();
-                const bool ok = (exitStatus == QProcess::NormalExit && exitCode == 0);
-                
-                loginProcess->deleteLater();
-                
-                if (ok) {
-                    // Docker outputs its own "Login Succeeded" message
-                    if (!output.isEmpty())
-                        appendDockerPullLog(output + "\n");
-                    if (callback)
-                        callback(true);
-                } else {
-                    // Check if we should retry
-                    if (retryCount < maxRetries - 1 && !m_dockerPullCanceled) {
-                        appendDockerPullLog(QString("Login failed, retrying in %1ms...\n").arg(retryDelayMs));
-                        QTimer::singleShot(retryDelayMs, this, [this, callback, retryCount]() {
-                            if (!m_dockerPullCanceled) {
-                                performDockerLogin(callback, retryCount + 1);
-                            } else if (callback) {
-                                callback(false);
-                            }
-                        });
-                    } else {
-                        appendDockerPullLog(QString("Login failed: %1\n").arg(output.isEmpty() ? "Unknown error" : output));
-                        if (callback)
-                            callback(false);
-                    }
-                }
-            });
-    
-    connect(loginProcess, &QProcess::errorOccurred, this,
-            [this, loginProcess, callback, retryCount, maxRetries, retryDelayMs](QProcess::ProcessError) {
-                loginProcess->deleteLater();
-                
-                // Check if we should retry
-                if (retryCount < maxRetries - 1 && !m_dockerPullCanceled) {
-                    appendDockerPullLog(QString("Login process failed, retrying in %1ms...\n").arg(retryDelayMs));
-                    QTimer::singleShot(retryDelayMs, this, [this, callback, retryCount]() {
-                        if (!m_dockerPullCanceled) {
-                            performDockerLogin(callback, retryCount + 1);
-                        } else if (callback) {
-                            callback(false);
-                        }
-                    });
-                } else {
-                    appendDockerPullLog("Login process failed to start.\n");
-                    if (callback)
-                        callback(false);
+
+    auto handleResult = [this, callback, retryCount, maxRetries, retryDelayMs](bool ok, const QString &output) {
+        if (ok) {
+            // Docker outputs its own "Login Succeeded" message
+            if (!output.isEmpty())
+                appendDockerPullLog(output + "\n");
+            if (callback)
+                callback(true);
+            return;
+        }
+        // Check if we should retry
+        if (retryCount < maxRetries - 1 && !m_dockerPullCanceled) {
+            appendDockerPullLog(QString("Login failed, retrying in %1ms...\n").arg(retryDelayMs));
+            QTimer::singleShot(retryDelayMs, this, [this, callback, retryCount]() {
+                if (!m_dockerPullCanceled) {
+                    performDockerLogin(callback, retryCount + 1);
+                } else if (callback) {
+                    callback(false);
                 }
             });
-    
-    // Use echo to pipe password to docker login via stdin
-    const QString loginCmd = QString("echo '%1' | sg docker -c 'docker login %2 -u %3 --password-stdin'")
-        .arg(AppConstants::DockerRegistryPassword)
-        .arg(AppConstants::DockerRegistryHost)
-        .arg(AppConstants::DockerRegistryUser);
-    
-    loginProcess->start("bash", {"-lc", loginCmd});
+        } else {
+            appendDockerPullLog(QString("Login failed: %1\n").arg(output.isEmpty() ? "Unknown error" : output));
+            if (callback)
+                callback(false);
+        }
+    };
+
+    if (retryCount > 0) {
+        m_credentials.login(handleResult);
+        return;
+    }
+    m_credentials.ensureLogin([this, handleResult](bool ok, bool performed, const QString &output) {
+        if (!performed) {
+            appendDockerPullLog(QString("Using cached registry credentials; login skipped (%1 skipped, %2 performed).\n")
+                                    .arg(m_credentials.loginsSkipped())
+                                    .arg(m_credentials.loginsPerformed()));
+        }
+        handleResult(ok, output);
+    });
 }
 
 void AppController::startDockerPullProcess(bool resetStatus)
@@ -1456,6 +1491,7 @@ void AppController::startDockerPullProcess(bool resetStatus)
     m_dockerProcess = new QProcess(this);
     QPointer<QProcess> process(m_dockerProcess);
     m_dockerProcess->setProcessChannelMode(QProcess::MergedChannels);
+    ProcessRecorder::attachIfEnabled(m_dockerProcess, "docker-pull");
     m_dockerLastOutput.restart();
     m_dockerWatchdog.start();
 
@@ -1489,12 +1525,17 @@ void AppController::startDockerPullProcess(bool resetStatus)
                 m_dockerWatchdog.stop();
 
                 bool ok = (!m_dockerPullCanceled && exitStatus == QProcess::NormalExit && exitCode == 0);
-                if (ok && !m_dockerPullSawStatus)
+                if (ok && !m_pullLogParser.sawStatus())
                     ok = false;
+                // A stale cached login; log in again on the next attempt
+                if (!ok && isRegistryAuthError(output))
+                    m_credentials.invalidate();
                 m_dockerPullOk = ok;
                 updateSetupComplete();
-                if (ok)
+                if (ok) {
                     setDockerPullProgress(1.0);
+                    precreateDockerOpsContainer();
+                }
                 const QString message = m_dockerPullCanceled
                     ? QStringLiteral("Docker image pull canceled.")
                     : (ok ? QStringLiteral("Docker image pulled successfully.")
@@ -1538,13 +1579,13 @@ void AppController::startDockerPullProcess(bool resetStatus)
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
     env.insert("TERM", "xterm-256color");
     env.insert("COLUMNS", "120");
+    Tracer::traceProcess(m_dockerProcess, "docker pull");
     m_dockerProcess->setProcessEnvironment(env);
+    const QString command = QString("sg docker -c '%1'").arg(dockerPullCommand(image, &m_dockerPullProxied));
     if (!scriptPath.isEmpty()) {
-        const QString command = QString("sg docker -c 'docker pull %1'").arg(image);
         m_dockerProcess->start(scriptPath, {"-q", "-e", "-c", command, "/dev/null"});
     } else {
         // Fallback: use sg docker -c via bash
-        const QString command = QString("sg docker -c 'docker pull %1'").arg(image);
         m_dockerProcess->start("bash", {"-c", command});
     }
 }
@@ -1552,30 +1593,63 @@ void AppController::startDockerPullProcess(bool resetStatus)
 void AppController::checkDockerPullStall()
 {
     if (!m_dockerProcess || m_dockerProcess->state() == QProcess::NotRunning) {
-        m_dockerWatchdog.stop();
+        if (!m_dockerRetryPending)
+            m_dockerWatchdog.stop();
         return;
     }
-    if (m_dockerLastOutput.isValid() && m_dockerLastOutput.elapsed() < 30000)
-        return;
     if (m_dockerProbeActive)
         return;
+
+    // While offline, keep probing at a relaxed pace instead of every tick.
+    // With the netlink monitor running, the route coming back resumes the pull.
+    if (m_dockerAwaitingNetwork) {
+        if (m_networkMonitor.isActive() && !m_networkMonitor.hasDefaultRoute())
+            return;
+        if (m_dockerLastProbe.isValid() && m_dockerLastProbe.elapsed() < 5000)
+            return;
+        m_dockerProbeActive = true;
+        probeDockerRegistry();
+        return;
+    }
+
+    PullStallDetector::Stall stall;
+    const qint64 outputSilenceMs = m_dockerLastOutput.isValid() ? m_dockerLastOutput.elapsed() : 0;
+    if (!m_pullStallDetector.detect(outputSilenceMs, &stall))
+        return;
+
+    const double pullSeconds = double(stall.pullElapsedMs) / 1000.0;
+    if (stall.layerId.isEmpty()) {
+        appendDockerPullEvent(QString("[stall] no output for %1 s at %2 s into the pull")
+                                  .arg(double(stall.silentMs) / 1000.0, 0, 'f', 1)
+                                  .arg(pullSeconds, 0, 'f', 1));
+    } else {
+        appendDockerPullEvent(QString("[stall] layer %1 (%2 %3 of %4 MB) idle for %5 s, threshold %6 s, last rate %7 MB/s, at %8 s into the pull")
+                                  .arg(stall.layerId,
+                                       PullStallDetector::phaseName(stall.phase).toLower())
+                                  .arg(double(stall.currentBytes) / 1e6, 0, 'f', 1)
+                                  .arg(double(stall.totalBytes) / 1e6, 0, 'f', 1)
+                                  .arg(double(stall.silentMs) / 1000.0, 0, 'f', 1)
+                                  .arg(double(stall.thresholdMs) / 1000.0, 0, 'f', 1)
+                                  .arg(stall.bytesPerSecond / 1e6, 0, 'f', 2)
+                                  .arg(pullSeconds, 0, 'f', 1));
+    }
     m_dockerProbeActive = true;
     probeDockerRegistry();
 }
 
 void AppController::probeDockerRegistry()
 {
+    m_dockerLastProbe.restart();
     QNetworkRequest request(QUrl(AppConstants::DockerRegistryUrl));
     request.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
-    QNetworkReply *reply = m_net.head(request);
-    QTimer *timeout = new QTimer(reply);
-    timeout->setSingleShot(true);
-    timeout->start(4000);
-    connect(timeout, &QTimer::timeout, reply, &QNetworkReply::abort);
-
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        const auto error = reply->error();
-        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // A single quick attempt; the watchdog decides when to probe again
+    ApiClient::Policy policy;
+    policy.deadlineMs = 4000;
+    policy.maxAttempts = 1;
+
+    m_api.head("registry/probe", request, policy, [this](const ApiClient::Response &response) {
+        const auto error = response.error;
+        const int status = response.httpStatus;
         bool networkUp = (error == QNetworkReply::NoError)
             || (status > 0 && status < 600)
             || (error == QNetworkReply::AuthenticationRequiredError);
@@ -1593,14 +1667,16 @@ void AppController::probeDockerRegistry()
             }
             m_dockerAwaitingNetwork = true;
         }
-        reply->deleteLater();
     });
 }
 
-void AppController::restartDockerPull()
+void AppController::restartDockerPull(bool immediate)
 {
     if (!m_dockerProcess || m_dockerProcess->state() == QProcess::NotRunning)
         return;
+
+    // Invalidate the running pull's callbacks so killing it is not reported as a failure
+    ++m_dockerPullGeneration;
     m_dockerProcess->terminate();
     if (!m_dockerProcess->waitForFinished(2000)) {
         m_dockerProcess->kill();
@@ -1610,25 +1686,103 @@ void AppController::restartDockerPull()
         m_dockerProcess->deleteLater();
         m_dockerProcess = nullptr;
     }
+
+    // Completed layers stay in the daemon's store, so the restarted pull only
+    // fetches the layers that were still in flight.
+    const qint64 delayMs = immediate ? 0 : m_pullStallDetector.nextRetryDelayMs();
+    appendDockerPullEvent(QString("[retry %1] restarting pull in %2 s; %3 of %4 layer(s) complete and kept")
+                              .arg(m_pullStallDetector.retryCount())
+                              .arg(double(delayMs) / 1000.0, 0, 'f', 1)
+                              .arg(m_pullStallDetector.completedLayers())
+                              .arg(m_pullStallDetector.layerCount()));
+    m_dockerRetryPending = true;
+    const int generation = m_dockerPullGeneration;
+    QTimer::singleShot(delayMs, this, [this, generation]() {
+        if (!m_dockerRetryPending || generation != m_dockerPullGeneration)
+            return;
+        // Went offline while backing off; the route coming back restarts it
+        if (m_dockerAwaitingNetwork && m_networkMonitor.isActive())
+            return;
+        m_dockerRetryPending = false;
+        m_dockerLastOutput.restart();
+        m_pullStallDetector.noteRestart();
+        startDockerPullProcess(false);
+    });
+}
+
+void AppController::onDefaultRouteLost()
+{
+    m_upgradeAgent.setNetworkAvailable(false);
+    pauseUpgradePull();
+
+    const bool processRunning = m_dockerProcess && m_dockerProcess->state() != QProcess::NotRunning;
+    if (!processRunning && !m_dockerRetryPending)
+        return;
+
+    m_dockerAwaitingNetwork = true;
+    setStatus("Network unavailable. Waiting to resume pull...");
+    appendDockerPullEvent(QString("[network] default route lost at %1 s into the pull; pull paused")
+                              .arg(double(m_pullStallDetector.elapsedMs()) / 1000.0, 0, 'f', 1));
+    if (!processRunning)
+        return;
+
+    // Stop the CLI before the daemon gives up on its own and fails the pull
+    ++m_dockerPullGeneration;
+    m_dockerProcess->terminate();
+    if (!m_dockerProcess->waitForFinished(2000)) {
+        m_dockerProcess->kill();
+        m_dockerProcess->waitForFinished(1000);
+    }
+    if (m_dockerProcess) {
+        m_dockerProcess->deleteLater();
+        m_dockerProcess = nullptr;
+    }
+    m_dockerRetryPending = true;
+}
+
+void AppController::onDefaultRouteRestored(qint64 offlineMs)
+{
+    m_upgradeAgent.setNetworkAvailable(true);
+    resumeUpgradePull();
+
+    if (!m_dockerAwaitingNetwork)
+        return;
+    m_dockerAwaitingNetwork = false;
+    appendDockerPullEvent(QString("[network] default route restored after %1 s; resuming pull")
+                              .arg(double(offlineMs) / 1000.0, 0, 'f', 1));
+
+    if (m_dockerProcess && m_dockerProcess->state() != QProcess::NotRunning) {
+        restartDockerPull(true);
+        return;
+    }
+    if (!m_dockerRetryPending)
+        return;
+    m_dockerRetryPending = false;
     m_dockerLastOutput.restart();
+    m_pullStallDetector.noteRestart();
     startDockerPullProcess(false);
 }
 
 void AppController::cancelDockerPull()
 {
-    if (!m_dockerProcess || m_dockerProcess->state() == QProcess::NotRunning)
+    TraceSpan span("controller", "cancelDockerPull");
+    const bool processRunning = m_dockerProcess && m_dockerProcess->state() != QProcess::NotRunning;
+    if (!processRunning && !m_dockerRetryPending)
         return;
     m_dockerPullCanceled = true;
+    m_dockerRetryPending = false;
     m_dockerWatchdog.stop();
     setStatus("Canceling Docker pull...");
     
     // Increment generation to invalidate any pending callbacks
     ++m_dockerPullGeneration;
     
-    m_dockerProcess->terminate();
-    if (!m_dockerProcess->waitForFinished(2000)) {
-        m_dockerProcess->kill();
-        m_dockerProcess->waitForFinished(1000);
+    if (processRunning) {
+        m_dockerProcess->terminate();
+        if (!m_dockerProcess->waitForFinished(2000)) {
+            m_dockerProcess->kill();
+            m_dockerProcess->waitForFinished(1000);
+        }
     }
     
     // Clean up process immediately
@@ -1637,9 +1791,11 @@ void AppController::cancelDockerPull()
         m_dockerProcess = nullptr;
     }
     
-    // Run Docker cleanup commands to ensure clean state for next pull
-    QProcess::startDetached("bash", {"-c", "sg docker -c 'docker system prune -af' >/dev/null 2>&1"});
-    QProcess::startDetached("bash", {"-c", "sg docker -c 'docker builder prune -af' >/dev/null 2>&1"});
+    // Remove only dangling artifacts of this pull; completed layers and
+    // known-good images stay so a retry resumes and rollback stays possible
+    m_cleanupPolicy.cleanupCanceledPull(AppConstants::DockerImage, [this](const DockerCleanupPolicy::Result &result) {
+        appendDockerPullLog(result.summary + "\n");
+    });
     
     // Ensure active flag is reset
     setDockerPullActive(false);
@@ -1648,6 +1804,7 @@ void AppController::cancelDockerPull()
 
 void AppController::runDockerContainer()
 {
+    TraceSpan span("controller", "runDockerContainer");
     const QString dockerCmd = QString("sg docker -c 'docker run --rm --stop-timeout=1 %1'").arg(AppConstants::DockerImage);
 
     if (!isatty(STDIN_FILENO)) {
@@ -1736,112 +1893,147 @@ void AppController::runDockerContainer()
 
     setStatus("Running Docker container...");
     const QString runCmd = QString("sg docker -c 'docker run --rm --stop-timeout=1 %1'").arg(AppConstants::DockerImage);
+    Tracer::traceProcess(m_runProcess, "docker run");
     m_runProcess->start("bash", {"-c", runCmd});
 }
 
 void AppController::runDockerOps(bool removeVolumes)
 {
-    if (m_dockerOpsStarting)
+    TraceSpan span("controller", "runDockerOps");
+    // Callers such as the headless provisioner wait for dockerOpsFinished, so
+    // every way out of here reports one
+    if (m_dockerOpsStarting) {
+        emit dockerOpsFinished(false, "A SafeCore container start is already in progress.");
         return;
+    }
 
     // Clear any previous log and reset state
     setDockerOpsLog(QString());
     setDockerOpsContainerId(QString());
     setDockerOpsConflict(false);
 
-    // Check if container exists (running or stopped) and remove it first
-    QProcess checkProcess;
-    checkProcess.start("bash", {"-lc",
-        QString("sg docker -c \"docker ps -a -q -f name=^%1$\"").arg(AppConstants::ContainerName)});
-    checkProcess.waitForFinished(5000);
-    const QString containerId = QString::fromUtf8(checkProcess.readAll()).trimmed();
-
-    if (!containerId.isEmpty()) {
-        // Container exists (running or stopped), force remove it silently
-        QProcess removeProcess;
-        removeProcess.start("bash", {"-lc",
-            QString("sg docker -c 'docker rm -f %1 2>/dev/null'").arg(AppConstants::ContainerName)});
-        removeProcess.waitForFinished(15000);
-    }
-
-    // Remove aibox_weapons volume only when upgrading (to get fresh models)
-    if (removeVolumes) {
-        QProcess removeVolumeProcess;
-        removeVolumeProcess.start("bash", {"-lc",
-            "sg docker -c 'docker volume rm aibox_weapons 2>/dev/null'"});
-        removeVolumeProcess.waitForFinished(10000);
-    }
-
-    auto readJsonFile = [](const QString &path, QJsonObject &outObj) -> bool {
-        QFile file(path);
-        if (!file.open(QIODevice::ReadOnly))
-            return false;
-        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-        if (!doc.isObject())
-            return false;
-        outObj = doc.object();
-        return true;
-    };
-
-    const QString basePath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore/data";
-    QJsonObject registrationObj;
-    QJsonObject tenantObj;
-    if (!readJsonFile(basePath + "/registration_data.json", registrationObj)) {
-        setDockerOpsLog("Missing registration data. Run registration first.\n");
-        return;
-    }
-    if (!readJsonFile(basePath + "/tenant_data.json", tenantObj)) {
-        setDockerOpsLog("Missing tenant data. Fetch tenant data first.\n");
+    ContainerSpec spec;
+    QString specError;
+    if (!ContainerSpec::resolve(m_stateStore, m_serviceBaseUrl, m_tenantAccessKey, &spec, &specError)) {
+        setDockerOpsLog(m_dockerOpsLog + specError + "\n");
+        emit dockerOpsFinished(false, specError);
         return;
     }
 
-    const QString tenantId = registrationObj.value("tenantId").toString().trimmed();
-    const QString macId = registrationObj.value("macId").toString().trimmed();
-    if (tenantId.isEmpty() || macId.isEmpty()) {
-        setDockerOpsLog("Registration data is incomplete.\n");
+    // A create still in flight would otherwise race the reconcile below; the
+    // run is picked up again once it is done instead of blocking the GUI thread
+    if (afterPrecreate([this, removeVolumes]() {
+            setDockerOpsStarting(false);
+            runDockerOps(removeVolumes);
+        })) {
+        setDockerOpsLog(m_dockerOpsLog + "Waiting for the container pre-create to finish...\n");
+        setDockerOpsStarting(true);
         return;
     }
 
-    const QJsonObject tenantData = tenantObj.value("data").toObject();
-    QString domain = tenantData.value("domain").toString().trimmed();
-    if (!domain.isEmpty())
-        domain = domain.toUpper();
-
-    QString safeCoreBoxId;
-    const QJsonArray safeCores = tenantData.value("safeCores").toArray();
-    const QString targetMac = macId.toLower();
-    for (const QJsonValue &value : safeCores) {
-        const QJsonObject obj = value.toObject();
-        const QString entryMac = obj.value("macId").toString().trimmed().toLower();
-        if (!entryMac.isEmpty() && entryMac == targetMac) {
-            safeCoreBoxId = obj.value("safeCoreBoxId").toString().trimmed();
-            break;
+    // Reconcile the existing container (running or stopped) with the spec
+    // instead of always rebuilding it, which would throw away its warm state
+    m_reconcileClock.start();
+    ContainerSpec::Plan plan;
+    if (!qEnvironmentVariableIsSet("SAFECORE_DEV_DOCKER_OPS")) {
+        // A failed inspect only means "no container" when the daemon answers
+        // a listing without it; anything else exits 2
+        const QString checkScript = QString(
+            "docker image inspect -f '{{.Id}}' '%1' 2>/dev/null\n"
+            "echo ---\n"
+            "docker inspect '%2' 2>/dev/null && exit 0\n"
+            "ids=$(docker container ls -aq --filter 'name=^/%2$') || exit 2\n"
+            "[ -z \"$ids\" ] || exit 2\n"
+            "exit 0\n").arg(spec.image, spec.name);
+        QProcess checkProcess;
+        Tracer::traceProcess(&checkProcess, "docker inspect (existing container)");
+        checkProcess.start("bash", {"-lc", "sg docker -c 'bash -s'"});
+        if (checkProcess.waitForStarted(3000)) {
+            checkProcess.write(checkScript.toUtf8());
+            checkProcess.closeWriteChannel();
+        }
+        const bool finished = checkProcess.waitForFinished(5000);
+        if (!finished && checkProcess.state() != QProcess::NotRunning) {
+            checkProcess.kill();
+            checkProcess.waitForFinished(1000);
+        }
+        const QByteArray output = checkProcess.readAllStandardOutput();
+        const int separator = output.indexOf("---\n");
+        if (!finished || checkProcess.exitStatus() != QProcess::NormalExit || checkProcess.exitCode() != 0
+            || separator < 0) {
+            // The container's state is unknown, so it may exist; a plain
+            // create would then conflict on the name
+            plan.action = ContainerSpec::Action::Recreate;
+            plan.reasons << "inspect failed";
+        } else {
+            const QString imageId = QString::fromUtf8(output.left(separator)).trimmed();
+            const QJsonArray inspected = QJsonDocument::fromJson(output.mid(separator + 4)).array();
+            plan = spec.plan(inspected.isEmpty() ? QJsonObject() : inspected.first().toObject(), imageId);
         }
     }
-    if (safeCoreBoxId.isEmpty() && !safeCores.isEmpty())
-        safeCoreBoxId = safeCores.first().toObject().value("safeCoreBoxId").toString().trimmed();
-
-    if (safeCoreBoxId.isEmpty() || domain.isEmpty()) {
-        setDockerOpsLog("Tenant data is missing SafeCoreBoxId or domain.\n");
+    m_reconcileAction = ContainerSpec::actionName(plan.action);
+    setDockerOpsLog(QString("Reconcile: %1%2\n")
+                        .arg(m_reconcileAction,
+                             plan.reasons.isEmpty() ? QString() : " (" + plan.reasons.join(", ") + ")"));
+
+    switch (plan.action) {
+    case ContainerSpec::Action::None:
+        m_opsOperation = Metrics::OperationRun;
+        m_operationClock[Metrics::OperationRun].start();
+        setDockerOpsContainerId(plan.containerId);
+        setDockerOpsLog(m_dockerOpsLog + QString("SafeCore container is already running with the current configuration.\n"
+                                                 "Container ID: %1\n").arg(plan.containerId));
+        setDockerOpsRunning(true);
+        setDockerOpsStopping(false);
+        setDockerOpsConflict(true);
+        emit dockerOpsFinished(true, "SafeCore container is up to date.");
+        return;
+    case ContainerSpec::Action::Start:
+    case ContainerSpec::Action::Restart:
+        if (plan.status == "created" && m_stateStore.setupState().containerCreateMs > 0) {
+            setDockerOpsLog(m_dockerOpsLog + QString("Container was pre-created after the pull; "
+                                                     "starting it skips %1 ms of create time.\n")
+                                .arg(m_stateStore.setupState().containerCreateMs));
+        }
+        m_opsOperation = Metrics::OperationRestart;
+        m_operationClock[Metrics::OperationRestart].start();
+        cycleDockerOpsContainer(plan.action == ContainerSpec::Action::Start);
         return;
+    case ContainerSpec::Action::Recreate: {
+        QProcess removeProcess;
+        Tracer::traceProcess(&removeProcess, "docker rm (existing container)");
+        removeProcess.start("bash", {"-lc",
+            QString("sg docker -c 'docker rm -f %1 2>/dev/null'").arg(AppConstants::ContainerName)});
+        removeProcess.waitForFinished(15000);
+        break;
+    }
+    case ContainerSpec::Action::Create:
+        break;
     }
 
-    const QString serviceUrl = m_serviceBaseUrl.trimmed();
-    QUrl baseUrl(serviceUrl);
-    if (!baseUrl.isValid() || baseUrl.scheme().isEmpty() || baseUrl.host().isEmpty()) {
-        setDockerOpsLog("Service URL is invalid.\n");
+    // On upgrade, bring aibox_weapons in line with the models shipped in the
+    // new image instead of removing the volume, so only changed models are copied
+    if (removeVolumes && !qEnvironmentVariableIsSet("SAFECORE_DEV_DOCKER_OPS")) {
+        setDockerOpsStarting(true);
+        m_modelVolumeSync.start(AppConstants::DockerImage,
+                                AppConstants::WeaponsModelVolume,
+                                AppConstants::WeaponsModelPath);
         return;
     }
-    const QString tenantEndpoint = AppConstants::TenantEndpoint;
-    QString apiUrl;
-    if (baseUrl.path().endsWith(tenantEndpoint)) {
-        apiUrl = baseUrl.toString(QUrl::None);
-    } else {
-        QString path = baseUrl.path();
-        if (path.endsWith('/'))
-            path.chop(1);
-        baseUrl.setPath(path + tenantEndpoint);
-        apiUrl = baseUrl.toString(QUrl::None);
+
+    startDockerOpsContainer();
+}
+
+void AppController::startDockerOpsContainer()
+{
+    m_opsOperation = Metrics::OperationRun;
+    m_operationClock[Metrics::OperationRun].start();
+    ContainerSpec spec;
+    QString specError;
+    if (!ContainerSpec::resolve(m_stateStore, m_serviceBaseUrl, m_tenantAccessKey, &spec, &specError)) {
+        setDockerOpsLog(m_dockerOpsLog + specError + "\n");
+        emit dockerOpsFinished(false, specError);
+        return;
     }
 
     setDockerOpsLog(m_dockerOpsLog + "Creating and starting SafeCore container...\n");
@@ -1892,6 +2084,7 @@ void AppController::runDockerOps(bool removeVolumes)
                     setDockerOpsContainerId(id);
                     const QString shownId = id.isEmpty() ? QStringLiteral("(no id returned)") : id;
                     setDockerOpsLog(m_dockerOpsLog + QString("Container started: %1\nSafeCore container is running.\n").arg(shownId));
+                    m_cleanupPolicy.recordKnownGood(AppConstants::DockerImage);
                     setDockerOpsRunning(true);
                     setDockerOpsStopping(false);
                     setDockerOpsConflict(true);
@@ -1919,57 +2112,121 @@ void AppController::runDockerOps(bool removeVolumes)
                 m_dockerOpsProcess = nullptr;
             });
 
-    // Helper to escape shell arguments for use within single quotes
-    auto escapeForShell = [](const QString &arg) -> QString {
-        QString escaped = arg;
-        // Escape single quotes by replacing ' with '\''
-        escaped.replace("'", "'\\''");
-        return "'" + escaped + "'";
-    };
+    // The command goes in on stdin, so it is quoted once, for the shell that
+    // runs it, and not again for the bash -c wrapping
+    const QByteArray script = ("exec " + ContainerSpec::shellCommand(spec.runArgs()) + "\n").toUtf8();
+    QPointer<QProcess> process(m_dockerOpsProcess);
+    connect(m_dockerOpsProcess, &QProcess::started, this, [process, script]() {
+        if (!process)
+            return;
+        process->write(script);
+        process->closeWriteChannel();
+    });
 
-    QStringList args;
-    args << "run" << "-d"
-        << "--name" << AppConstants::ContainerName
-        << "--gpus" << "all"
-        << "--restart" << "unless-stopped";
+    Tracer::traceProcess(m_dockerOpsProcess, "docker run (ops)");
+    m_dockerOpsProcess->start("bash", {"-lc", "sg docker -c 'bash -s'"});
+}
 
-    for (const QString &port : AppConstants::ContainerPorts)
-        args << "-p" << port;
+// Creates the container as soon as both the image and the spec are known, so
+// that unpacking the image into the container's filesystem and preparing its
+// mounts happen during setup, and the first launch is only `docker start`.
+void AppController::precreateDockerOpsContainer()
+{
+    if (!m_dockerPullOk || m_precreateProcess || qEnvironmentVariableIsSet("SAFECORE_DEV_DOCKER_OPS"))
+        return;
+    ContainerSpec spec;
+    QString specError;
+    // Until registration and tenant data exist; tried again when they arrive
+    if (!ContainerSpec::resolve(m_stateStore, m_serviceBaseUrl, m_tenantAccessKey, &spec, &specError))
+        return;
 
-    for (const QString &volume : AppConstants::ContainerVolumes)
-        args << "-v" << volume;
+    // An existing container is left for the reconcile at launch to judge
+    const QByteArray script = QString("docker inspect '%1' >/dev/null 2>&1 && exit 3\n"
+                                      "exec %2\n")
+                                  .arg(spec.name, ContainerSpec::shellCommand(spec.createArgs()))
+                                  .toUtf8();
 
-    // Add NVIDIA driver capabilities
-    args << "-e" << ("NVIDIA_DRIVER_CAPABILITIES=" + AppConstants::NvidiaDriverCapabilities);
+    auto *process = new QProcess(this);
+    m_precreateProcess = process;
+    connect(process, &QProcess::started, this, [process, script]() {
+        process->write(script);
+        process->closeWriteChannel();
+    });
+    connect(process, &QProcess::finished, this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+        process->deleteLater();
+        if (exitStatus != QProcess::NormalExit || exitCode != 0)
+            return;
+        const qint64 elapsedMs = m_precreateClock.elapsed();
+        Metrics::global().containerPrecreateSeconds.set(double(elapsedMs) / 1000.0);
+        StateStore::SetupState state = m_stateStore.setupState();
+        state.containerCreateMs = elapsedMs;
+        m_stateStore.setSetupState(state);
+        QString error;
+        if (!m_stateStore.commit(&error))
+            qWarning().noquote() << "Could not save setup state:" << error;
+        appendDockerPullEvent(QString("SafeCore container pre-created in %1 ms; the first launch only starts it.")
+                                  .arg(elapsedMs));
+    });
+    connect(process, &QProcess::errorOccurred, this, [process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            process->deleteLater();
+    });
 
-    // Properly escape environment variable values to prevent shell injection
-    args << "-e" << ("CONFIG_API_URL=" + escapeForShell(apiUrl))
-        << "-e" << ("CONFIG_API_ACCESS_KEY=" + escapeForShell(m_tenantAccessKey))
-        << "-e" << ("SafeCoreBoxId=" + escapeForShell(safeCoreBoxId))
-        << "-e" << ("TENANT_ID=" + escapeForShell(tenantId))
-        << "-e" << ("DOMAIN=" + escapeForShell(domain))
-        << AppConstants::DockerImage;
+    m_precreateClock.start();
+    Tracer::traceProcess(process, "docker create (precreate)");
+    process->start("bash", {"-lc", "sg docker -c 'bash -s'"});
+}
 
-    m_dockerOpsProcess->start("bash", {"-lc",
-        QString("sg docker -c \"docker %1\"").arg(args.join(" "))});
+// Runs `next` once an in-flight pre-create has finished, whichever way it
+// ended. Returns false when there is none and the caller can go ahead now.
+bool AppController::afterPrecreate(std::function<void()> next)
+{
+    if (!m_precreateProcess || m_precreateProcess->state() == QProcess::NotRunning)
+        return false;
+    // A crash reports both errorOccurred and finished; only the first one runs it
+    auto pending = std::make_shared<std::function<void()>>(std::move(next));
+    const auto resume = [pending]() {
+        if (!*pending)
+            return;
+        const std::function<void()> run = *pending;
+        *pending = nullptr;
+        run();
+    };
+    connect(m_precreateProcess.data(), &QProcess::finished, this, resume, Qt::QueuedConnection);
+    connect(m_precreateProcess.data(), &QProcess::errorOccurred, this, resume, Qt::QueuedConnection);
+    return true;
 }
 
 void AppController::restartDockerOps()
 {
+    TraceSpan span("controller", "restartDockerOps");
     if (m_dockerOpsStarting)
         return;
+    m_opsOperation = Metrics::OperationRestart;
+    m_operationClock[Metrics::OperationRestart].start();
+    m_reconcileClock.invalidate();
+    setDockerOpsLog(QString());
+    cycleDockerOpsContainer(false);
+}
+
+// `docker start` (startOnly) or `docker restart` of the existing container,
+// then checks that it is actually running
+void AppController::cycleDockerOpsContainer(bool startOnly)
+{
+    const QString verb = startOnly ? QStringLiteral("start") : QStringLiteral("restart");
+    const QString done = startOnly ? QStringLiteral("started") : QStringLiteral("restarted");
 
     const bool simulateRun = qEnvironmentVariableIsSet("SAFECORE_DEV_DOCKER_OPS");
     if (simulateRun) {
-        setDockerOpsLog("Starting SafeCore container...\n");
+        setDockerOpsLog(m_dockerOpsLog + "Starting SafeCore container...\n");
         setDockerOpsStarting(true);
-        QTimer::singleShot(800, this, [this]() {
-            setDockerOpsLog("SafeCore container Started. SafeCore container is running.\n");
+        QTimer::singleShot(800, this, [this, done]() {
+            setDockerOpsLog(m_dockerOpsLog + "SafeCore container Started. SafeCore container is running.\n");
             setDockerOpsStarting(false);
             setDockerOpsRunning(true);
             setDockerOpsStopping(false);
             setDockerOpsConflict(true);
-            emit dockerOpsFinished(true, "SafeCore container restarted.");
+            emit dockerOpsFinished(true, QString("SafeCore container %1.").arg(done));
         });
         return;
     }
@@ -1986,7 +2243,7 @@ void AppController::restartDockerOps()
         m_dockerOpsProcess = nullptr;
     }
 
-    setDockerOpsLog("Restarting SafeCore container...\n");
+    setDockerOpsLog(m_dockerOpsLog + (startOnly ? "Starting" : "Restarting") + " SafeCore container...\n");
     setDockerOpsStarting(true);
     setDockerOpsRunning(false);
     setDockerOpsStopping(false);
@@ -1995,7 +2252,7 @@ void AppController::restartDockerOps()
     m_dockerOpsProcess->setProcessChannelMode(QProcess::MergedChannels);
 
     connect(m_dockerOpsProcess, &QProcess::finished, this,
-            [this](int exitCode, QProcess::ExitStatus exitStatus) {
+            [this, verb, done](int exitCode, QProcess::ExitStatus exitStatus) {
                 const QString output = QString::fromUtf8(m_dockerOpsProcess->readAll()).trimmed();
                 const bool ok = (exitStatus == QProcess::NormalExit && exitCode == 0);
                 setDockerOpsStarting(false);
@@ -2005,6 +2262,7 @@ void AppController::restartDockerOps()
 
                     // Get full container ID and verify it's actually running
                     QProcess idProcess;
+                    Tracer::traceProcess(&idProcess, "docker ps (container id)");
                     idProcess.start("bash", {"-lc",
                         QString("sg docker -c \"docker ps --no-trunc -q -f name=^%1$\"").arg(AppConstants::ContainerName)});
                     idProcess.waitForFinished(5000);
@@ -2013,7 +2271,7 @@ void AppController::restartDockerOps()
                     if (!fullId.isEmpty()) {
                         // Container is actually running
                         setDockerOpsContainerId(fullId);
-                        setDockerOpsLog(m_dockerOpsLog + QString("Container restarted: %1\nSafeCore container is running.\n").arg(fullId));
+                        setDockerOpsLog(m_dockerOpsLog + QString("Container %1: %2\nSafeCore container is running.\n").arg(done, fullId));
                         setDockerOpsRunning(true);
                         setDockerOpsStopping(false);
                         setDockerOpsConflict(true);
@@ -2025,37 +2283,41 @@ void AppController::restartDockerOps()
                         setDockerOpsConflict(false);
                     }
                 } else {
-                    setDockerOpsLog(m_dockerOpsLog + QString("Failed to restart SafeCore container.\n%1\n").arg(output));
+                    setDockerOpsLog(m_dockerOpsLog + QString("Failed to %1 SafeCore container.\n%2\n").arg(verb, output));
                     setDockerOpsRunning(false);
                     setDockerOpsStopping(false);
                     setDockerOpsConflict(true);
                 }
-                emit dockerOpsFinished(ok, ok ? "SafeCore container restarted." : "Failed to restart SafeCore container.");
+                emit dockerOpsFinished(ok, ok ? QString("SafeCore container %1.").arg(done)
+                                             : QString("Failed to %1 SafeCore container.").arg(verb));
                 m_dockerOpsProcess->deleteLater();
                 m_dockerOpsProcess = nullptr;
             });
 
     connect(m_dockerOpsProcess, &QProcess::errorOccurred, this,
-            [this](QProcess::ProcessError) {
+            [this, verb](QProcess::ProcessError) {
                 const QString output = QString::fromUtf8(m_dockerOpsProcess->readAll()).trimmed();
-                setDockerOpsLog(QString("Failed to restart SafeCore container.\n%1\n").arg(output));
+                setDockerOpsLog(QString("Failed to %1 SafeCore container.\n%2\n").arg(verb, output));
                 setDockerOpsStarting(false);
                 setDockerOpsRunning(false);
                 setDockerOpsStopping(false);
                 setDockerOpsConflict(true);
-                emit dockerOpsFinished(false, "Failed to restart SafeCore container.");
+                emit dockerOpsFinished(false, QString("Failed to %1 SafeCore container.").arg(verb));
                 m_dockerOpsProcess->deleteLater();
                 m_dockerOpsProcess = nullptr;
             });
 
+    Tracer::traceProcess(m_dockerOpsProcess, startOnly ? "docker start" : "docker restart");
     m_dockerOpsProcess->start("bash", {"-lc",
-        QString("sg docker -c 'docker restart %1'").arg(AppConstants::ContainerName)});
+        QString("sg docker -c 'docker %1 %2'").arg(verb, AppConstants::ContainerName)});
 }
 
 void AppController::stopDockerOps()
 {
+    TraceSpan span("controller", "stopDockerOps");
     if (!m_dockerOpsRunning && !m_dockerOpsConflict)
         return;
+    m_operationClock[Metrics::OperationStop].start();
     stopDockerOpsLogs();
     setDockerOpsStarting(false);
     setDockerOpsStopping(true);
@@ -2124,14 +2386,17 @@ void AppController::stopDockerOps()
                 m_dockerOpsStopProcess = nullptr;
             });
 
+    Tracer::traceProcess(m_dockerOpsStopProcess, "docker stop");
     m_dockerOpsStopProcess->start("bash", {"-lc",
         QString("sg docker -c 'docker stop %1'").arg(AppConstants::ContainerName)});
 }
 
 void AppController::startUpgrade()
 {
+    TraceSpan span("controller", "startUpgrade");
     if (m_upgradeRunning)
         return;
+    m_operationClock[Metrics::OperationUpgrade].start();
 
     if (m_upgradeProcess) {
         if (m_upgradeProcess->state() != QProcess::NotRunning) {
@@ -2146,66 +2411,76 @@ void AppController::startUpgrade()
     }
 
     m_upgradeLog.clear();
+    m_upgradePullPending = false;
+    m_upgradeHoldReason.clear();
+    emit upgradeHoldReasonChanged();
     resetUpgradeProgress();
     emit upgradeLogChanged();
     m_upgradeRunning = true;
     m_upgradeCanceled = false;
     emit upgradeRunningChanged();
 
-    // Login to registry first, then pull
+    // Login to registry first (unless the cached login still works), then pull
     appendUpgradeLog("Authenticating with container registry...\n");
-    
-    QProcess *loginProcess = new QProcess(this);
-    loginProcess->setProcessChannelMode(QProcess::MergedChannels);
-    
-    connect(loginProcess, &QProcess::finished, this,
-            [this, loginProcess](int exitCode, QProcess::ExitStatus exitStatus) {
-                const QString output = QString::fromUtf8(loginProcess->readAll()).trimmed();
-                const bool loginOk = (exitStatus == QProcess::NormalExit && exitCode == 0);
-                loginProcess->deleteLater();
-                
-                if (m_upgradeCanceled) {
-                    m_upgradeRunning = false;
-                    emit upgradeRunningChanged();
-                    emit upgradeFinished(false, "Upgrade canceled.");
-                    return;
-                }
-                
-                if (!loginOk) {
-                    appendUpgradeLog(QString("Login failed: %1\n").arg(output.isEmpty() ? "Unknown error" : output));
-                    m_upgradeRunning = false;
-                    emit upgradeRunningChanged();
-                    emit upgradeFinished(false, "Failed to authenticate with container registry.");
-                    return;
-                }
-                
-                // Docker outputs its own "Login Succeeded" message
-                if (!output.isEmpty())
-                    appendUpgradeLog(output + "\n");
-                startUpgradePull();
-            });
-    
-    connect(loginProcess, &QProcess::errorOccurred, this,
-            [this, loginProcess](QProcess::ProcessError) {
-                appendUpgradeLog("Login process failed to start.\n");
-                loginProcess->deleteLater();
-                m_upgradeRunning = false;
-                emit upgradeRunningChanged();
-                emit upgradeFinished(false, "Failed to start login process.");
-            });
-    
-    const QString loginCmd = QString("echo '%1' | sg docker -c 'docker login %2 -u %3 --password-stdin'")
-        .arg(AppConstants::DockerRegistryPassword)
-        .arg(AppConstants::DockerRegistryHost)
-        .arg(AppConstants::DockerRegistryUser);
-    
-    loginProcess->start("bash", {"-lc", loginCmd});
+    m_credentials.ensureLogin([this](bool loginOk, bool performed, const QString &output) {
+        if (m_upgradeCanceled) {
+            m_upgradeRunning = false;
+            emit upgradeRunningChanged();
+            finishOperation(Metrics::OperationUpgrade, false);
+            emit upgradeFinished(false, "Upgrade canceled.");
+            return;
+        }
+
+        if (!loginOk) {
+            appendUpgradeLog(QString("Login failed: %1\n").arg(output.isEmpty() ? "Unknown error" : output));
+            m_upgradeRunning = false;
+            emit upgradeRunningChanged();
+            finishOperation(Metrics::OperationUpgrade, false);
+            emit upgradeFinished(false, "Failed to authenticate with container registry.");
+            return;
+        }
+
+        if (!performed) {
+            appendUpgradeLog(QString("Using cached registry credentials; login skipped (%1 skipped, %2 performed).\n")
+                                 .arg(m_credentials.loginsSkipped())
+                                 .arg(m_credentials.loginsPerformed()));
+        } else if (!output.isEmpty()) {
+            // Docker outputs its own "Login Succeeded" message
+            appendUpgradeLog(output + "\n");
+        }
+        m_upgradePullPending = true;
+        resumeUpgradePull();
+    });
+}
+
+void AppController::checkForUpgradeNow()
+{
+    TraceSpan span("controller", "checkForUpgradeNow");
+    m_upgradeAgent.checkNow(true);
+}
+
+void AppController::applyStagedUpgrade()
+{
+    TraceSpan span("controller", "applyStagedUpgrade");
+    if (m_dockerOpsStarting || m_upgradeRunning)
+        return;
+    setDockerOpsLog(QString());
+    m_upgradeAgent.apply([this](bool ok, const QString &message) {
+        if (!ok) {
+            setDockerOpsLog(message + "\n");
+            return;
+        }
+        // Same restart as a foreground upgrade, minus the download
+        runDockerOps(true);
+        setDockerOpsLog(message + "\n" + m_dockerOpsLog);
+    });
 }
 
 void AppController::startUpgradePull()
 {
     m_upgradeProcess = new QProcess(this);
     m_upgradeProcess->setProcessChannelMode(QProcess::MergedChannels);
+    ProcessRecorder::attachIfEnabled(m_upgradeProcess, "upgrade-pull");
 
     connect(m_upgradeProcess, &QProcess::readyRead, this, [this]() {
         const QString chunk = QString::fromUtf8(m_upgradeProcess->readAll());
@@ -2241,8 +2516,11 @@ void AppController::startUpgradePull()
                 } else {
                     message = "Failed to check for upgrades.";
                     hasUpdate = false;
+                    if (isRegistryAuthError(m_upgradeLog))
+                        m_credentials.invalidate();
                 }
 
+                finishOperation(Metrics::OperationUpgrade, ok);
                 m_upgradeCanceled = false;
                 emit upgradeFinished(hasUpdate, message);
                 m_upgradeProcess->deleteLater();
@@ -2253,6 +2531,7 @@ void AppController::startUpgradePull()
             [this](QProcess::ProcessError) {
                 m_upgradeRunning = false;
                 emit upgradeRunningChanged();
+                finishOperation(Metrics::OperationUpgrade, false);
                 emit upgradeFinished(false, "Failed to start upgrade process.");
                 m_upgradeProcess->deleteLater();
                 m_upgradeProcess = nullptr;
@@ -2263,20 +2542,124 @@ void AppController::startUpgradePull()
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
     env.insert("TERM", "xterm-256color");
     env.insert("COLUMNS", "120");
+    Tracer::traceProcess(m_upgradeProcess, "docker pull (upgrade)");
     m_upgradeProcess->setProcessEnvironment(env);
 
     const QString image = AppConstants::DockerImage;
+    const QString command = QString("sg docker -c '%1'").arg(dockerPullCommand(image, &m_upgradePullProxied));
     if (!scriptPath.isEmpty()) {
-        const QString command = QString("sg docker -c 'docker pull %1'").arg(image);
         m_upgradeProcess->start(scriptPath, {"-q", "-e", "-c", command, "/dev/null"});
     } else {
-        m_upgradeProcess->start("bash", {"-lc",
-            QString("sg docker -c 'docker pull %1'").arg(image)});
+        m_upgradeProcess->start("bash", {"-lc", command});
+    }
+}
+
+QString AppController::dockerPullCommand(const QString &image, bool *proxied)
+{
+    *proxied = false;
+    if (!m_bandwidth.isLimited())
+        return QString("docker pull %1").arg(image);
+    if (!m_registryProxy.isListening() && !m_registryProxy.listen(AppConstants::RegistryProxyPort)
+        && !m_registryProxy.listen()) {
+        qWarning().noquote() << "Registry proxy cannot listen; pulling without the bandwidth cap.";
+        return QString("docker pull %1").arg(image);
+    }
+    *proxied = true;
+
+    // The daemon stores the pull under the proxy's name, which is then
+    // tagged with the real one. The first pull under that name always looks
+    // new to the daemon, so whether the image changed is told by its ID.
+    const QString local = m_registryProxy.localReference(image);
+    return QString("before=$(docker image inspect -f {{.Id}} %1 2>/dev/null); "
+                   "docker pull %2 || exit 1; "
+                   "after=$(docker image inspect -f {{.Id}} %2) && docker tag %2 %1 || exit 1; "
+                   "[ \"$before\" != \"$after\" ] || echo \"Status: Image is up to date for %1\"")
+        .arg(image, local);
+}
+
+QString AppController::upgradePullHoldReason() const
+{
+    if (m_networkMonitor.isActive() && !m_networkMonitor.hasDefaultRoute())
+        return "waiting for the network";
+    return QString();
+}
+
+void AppController::setUpgradeHoldReason(const QString &reason)
+{
+    if (reason == m_upgradeHoldReason)
+        return;
+    m_upgradeHoldReason = reason;
+    appendUpgradeLog(reason.isEmpty() ? QString("Upgrade pull starting.\n")
+                                      : QString("Upgrade pull on hold, %1.\n").arg(reason));
+    emit upgradeHoldReasonChanged();
+}
+
+void AppController::pauseUpgradePull()
+{
+    if (!m_upgradeProcess || m_upgradeProcess->state() == QProcess::NotRunning)
+        return;
+
+    // Same as the install pull: stop the CLI before the daemon fails the pull.
+    // The upgrade stays running; it is not finished, only waiting.
+    m_upgradePullPending = true;
+    disconnect(m_upgradeProcess, nullptr, this, nullptr);
+    m_upgradeProcess->terminate();
+    if (!m_upgradeProcess->waitForFinished(2000)) {
+        m_upgradeProcess->kill();
+        m_upgradeProcess->waitForFinished(1000);
     }
+    m_upgradeProcess->deleteLater();
+    m_upgradeProcess = nullptr;
+    setUpgradeHoldReason(upgradePullHoldReason());
+}
+
+void AppController::resumeUpgradePull()
+{
+    if (!m_upgradePullPending)
+        return;
+    const QString reason = upgradePullHoldReason();
+    setUpgradeHoldReason(reason);
+    if (!reason.isEmpty())
+        return;
+    m_upgradePullPending = false;
+    // Completed layers are still in the daemon's store; the byte counts of
+    // the partial ones start over
+    m_upgradeLayerBytes.clear();
+    startUpgradePull();
+}
+
+void AppController::startUpgradeAgent()
+{
+    if (!qEnvironmentVariableIsSet("SAFECORE_DEV_DOCKER_OPS"))
+        m_upgradeAgent.start(AppConstants::UpgradeCheckIntervalMs);
+}
+
+void AppController::pullAtFullSpeed()
+{
+    TraceSpan span("controller", "pullAtFullSpeed");
+    if (m_bandwidth.isOverridden() || (!m_upgradeRunning && !m_dockerPullActive))
+        return;
+    m_bandwidth.setOverride(true);
+    const QString line = "Bandwidth cap lifted for this pull at the operator's request.";
+    if (m_upgradeRunning)
+        appendUpgradeLog(line + "\n");
+    if (m_dockerPullActive)
+        appendDockerPullEvent(line);
 }
 
 void AppController::cancelUpgrade()
 {
+    TraceSpan span("controller", "cancelUpgrade");
+    if (m_upgradePullPending) {
+        m_upgradePullPending = false;
+        m_upgradeHoldReason.clear();
+        emit upgradeHoldReasonChanged();
+        m_upgradeRunning = false;
+        emit upgradeRunningChanged();
+        finishOperation(Metrics::OperationUpgrade, false);
+        emit upgradeFinished(false, "Upgrade canceled. You can retry the upgrade anytime from the menu.");
+        return;
+    }
     if (!m_upgradeProcess || m_upgradeProcess->state() == QProcess::NotRunning)
         return;
 
@@ -2294,12 +2677,14 @@ void AppController::cancelUpgrade()
         m_upgradeProcess = nullptr;
     }
 
-    // Run Docker cleanup commands to ensure clean state for next pull
-    QProcess::startDetached("bash", {"-c", "sg docker -c 'docker system prune -af' >/dev/null 2>&1"});
-    QProcess::startDetached("bash", {"-c", "sg docker -c 'docker builder prune -af' >/dev/null 2>&1"});
+    // Keep completed layers and the previous image for rollback
+    m_cleanupPolicy.cleanupCanceledPull(AppConstants::DockerImage, [this](const DockerCleanupPolicy::Result &result) {
+        appendUpgradeLog(result.summary + "\n");
+    });
 
     m_upgradeRunning = false;
     emit upgradeRunningChanged();
+    finishOperation(Metrics::OperationUpgrade, false);
     emit upgradeFinished(false, "Upgrade canceled. You can retry the upgrade anytime from the menu.");
 }
 
@@ -2322,7 +2707,9 @@ void AppController::startDockerOpsLogs()
     connect(m_dockerOpsLogsProcess, &QProcess::readyRead, this, [this, proc]() {
         if (!proc)
             return;
-        setDockerOpsFollowLog(m_dockerOpsFollowLog + QString::fromUtf8(proc->readAll()));
+        const QByteArray data = proc->readAll();
+        Metrics::global().logLines[Metrics::LogContainer].add(quint64(data.count('\n')));
+        setDockerOpsFollowLog(m_dockerOpsFollowLog + QString::fromUtf8(data));
     });
 
     connect(m_dockerOpsLogsProcess, &QProcess::finished, this,
@@ -2346,6 +2733,7 @@ void AppController::startDockerOpsLogs()
             });
 
     const QString logsCmd = QString("sg docker -c 'docker logs -f %1'").arg(AppConstants::ContainerName);
+    Tracer::traceProcess(m_dockerOpsLogsProcess, "docker logs");
     m_dockerOpsLogsProcess->start("bash", {"-c", logsCmd});
 }
 
@@ -2376,92 +2764,17 @@ void AppController::stopDockerOpsLogs()
 
 bool AppController::installDockerService(bool startNow)
 {
+    TraceSpan span("controller", "installDockerService");
     const QString dockerPath = QStandardPaths::findExecutable("docker");
     if (dockerPath.isEmpty()) {
         setStatus("Docker not found in PATH.");
         return false;
     }
 
-    // Read registration and tenant data for environment variables
-    auto readJsonFile = [](const QString &path, QJsonObject &outObj) -> bool {
-        QFile file(path);
-        if (!file.open(QIODevice::ReadOnly))
-            return false;
-        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-        if (!doc.isObject())
-            return false;
-        outObj = doc.object();
-        return true;
-    };
-
-    const QString basePath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore/data";
-    QJsonObject registrationObj;
-    QJsonObject tenantObj;
-    
-    if (!readJsonFile(basePath + "/registration_data.json", registrationObj)) {
-        setStatus("Missing registration data. Run registration first.");
-        return false;
-    }
-    if (!readJsonFile(basePath + "/tenant_data.json", tenantObj)) {
-        setStatus("Missing tenant data. Run registration first.");
-        return false;
-    }
-
-    // Extract registration data
-    const QString tenantId = registrationObj.value("tenantId").toString().trimmed();
-    const QString macId = registrationObj.value("macId").toString().trimmed();
-    if (tenantId.isEmpty() || macId.isEmpty()) {
-        setStatus("Registration data is incomplete.");
-        return false;
-    }
-
-    // Extract tenant data (nested under "data" key)
-    const QJsonObject tenantData = tenantObj.value("data").toObject();
-    QString domain = tenantData.value("domain").toString().trimmed();
-    if (!domain.isEmpty())
-        domain = domain.toUpper();
-
-    // Find safeCoreBoxId by matching MAC in safeCores array
-    QString safeCoreBoxId;
-    const QJsonArray safeCores = tenantData.value("safeCores").toArray();
-    const QString targetMac = macId.toLower();
-    for (const QJsonValue &value : safeCores) {
-        const QJsonObject obj = value.toObject();
-        const QString entryMac = obj.value("macId").toString().trimmed().toLower();
-        if (!entryMac.isEmpty() && entryMac == targetMac) {
-            safeCoreBoxId = obj.value("safeCoreBoxId").toString().trimmed();
-            break;
-        }
-    }
-    if (safeCoreBoxId.isEmpty() && !safeCores.isEmpty())
-        safeCoreBoxId = safeCores.first().toObject().value("safeCoreBoxId").toString().trimmed();
-
-    if (safeCoreBoxId.isEmpty() || domain.isEmpty()) {
-        setStatus("Tenant data is missing SafeCoreBoxId or domain.");
-        return false;
-    }
-
-    // Build API URL from service base URL
-    const QString serviceUrl = m_serviceBaseUrl.trimmed();
-    QUrl baseUrl(serviceUrl);
-    if (!baseUrl.isValid() || baseUrl.scheme().isEmpty() || baseUrl.host().isEmpty()) {
-        setStatus("Service URL is invalid.");
-        return false;
-    }
-    const QString tenantEndpoint = AppConstants::TenantEndpoint;
-    QString apiUrl;
-    if (baseUrl.path().endsWith(tenantEndpoint)) {
-        apiUrl = baseUrl.toString(QUrl::None);
-    } else {
-        QString path = baseUrl.path();
-        if (path.endsWith('/'))
-            path.chop(1);
-        baseUrl.setPath(path + tenantEndpoint);
-        apiUrl = baseUrl.toString(QUrl::None);
-    }
-
-    if (m_tenantAccessKey.isEmpty()) {
-        setStatus("Missing tenant access key.");
+    ContainerSpec spec;
+    QString specError;
+    if (!ContainerSpec::resolve(m_stateStore, m_serviceBaseUrl, m_tenantAccessKey, &spec, &specError)) {
+        setStatus(specError);
         return false;
     }
 
@@ -2473,9 +2786,8 @@ bool AppController::installDockerService(bool startNow)
     }
 
     const QString serviceName = AppConstants::ServiceName;
-    const QString image = AppConstants::DockerImage;
-    const QString containerName = AppConstants::ContainerName;
-    
+    const QString containerName = spec.name;
+
     // Create temporary service file
     const QString tempServicePath = QString("/tmp/%1").arg(serviceName);
     QFile serviceFile(tempServicePath);
@@ -2484,38 +2796,8 @@ bool AppController::installDockerService(bool startNow)
         return false;
     }
 
-    // Build the full docker run command with all parameters
-    QString dockerRunCmd = dockerPath;
-    dockerRunCmd += " run -d --name " + containerName;
-    dockerRunCmd += " --restart unless-stopped";
-    dockerRunCmd += " --gpus all";
-    
-    // Add ports
-    for (const QString &port : AppConstants::ContainerPorts)
-        dockerRunCmd += " -p " + port;
-    
-    // Add volumes
-    for (const QString &volume : AppConstants::ContainerVolumes)
-        dockerRunCmd += " -v " + volume;
-    
-    // Add NVIDIA driver capabilities
-    dockerRunCmd += " -e NVIDIA_DRIVER_CAPABILITIES=" + AppConstants::NvidiaDriverCapabilities;
-    
-    // Add environment variables (properly escaped for systemd)
-    auto escapeForSystemd = [](const QString &val) -> QString {
-        QString escaped = val;
-        escaped.replace("\"", "\\\"");
-        escaped.replace("$", "\\$");
-        return escaped;
-    };
-    
-    dockerRunCmd += " -e \"CONFIG_API_URL=" + escapeForSystemd(apiUrl) + "\"";
-    dockerRunCmd += " -e \"CONFIG_API_ACCESS_KEY=" + escapeForSystemd(m_tenantAccessKey) + "\"";
-    dockerRunCmd += " -e \"SafeCoreBoxId=" + escapeForSystemd(safeCoreBoxId) + "\"";
-    dockerRunCmd += " -e \"TENANT_ID=" + escapeForSystemd(tenantId) + "\"";
-    dockerRunCmd += " -e \"DOMAIN=" + escapeForSystemd(domain) + "\"";
-    
-    dockerRunCmd += " " + image;
+    // Same arguments as the direct run, escaped for systemd
+    const QString dockerRunCmd = spec.systemdCommand(dockerPath);
 
     QTextStream out(&serviceFile);
     out << "[Unit]\n";
@@ -2540,6 +2822,7 @@ bool AppController::installDockerService(bool startNow)
     const QString systemServicePath = "/etc/systemd/system/" + serviceName;
     
     QProcess copyProcess;
+    Tracer::traceProcess(&copyProcess, "pkexec cp service");
     copyProcess.start("pkexec", {"cp", tempServicePath, systemServicePath});
     if (!copyProcess.waitForStarted(3000) || !copyProcess.waitForFinished(10000) || copyProcess.exitCode() != 0) {
         setStatus("Failed to copy service file to system directory.");
@@ -2549,6 +2832,7 @@ bool AppController::installDockerService(bool startNow)
 
     // Set proper permissions
     QProcess chmodProcess;
+    Tracer::traceProcess(&chmodProcess, "pkexec chmod service");
     chmodProcess.start("pkexec", {"chmod", "644", systemServicePath});
     chmodProcess.waitForFinished(5000);
 
@@ -2558,6 +2842,7 @@ bool AppController::installDockerService(bool startNow)
     auto runSystemctl = [](const QStringList &args, QString *errorOut) -> bool {
         QProcess proc;
         proc.setProcessChannelMode(QProcess::MergedChannels);
+        Tracer::traceProcess(&proc, "pkexec systemctl");
         proc.start("pkexec", QStringList() << "systemctl" << args);
         if (!proc.waitForStarted(3000)) {
             if (errorOut) *errorOut = "Failed to start systemctl.";
@@ -2596,6 +2881,7 @@ bool AppController::installDockerService(bool startNow)
 
 bool AppController::launchDockerOpsApp(bool autoRun)
 {
+    TraceSpan span("controller", "launchDockerOpsApp");
     const QString appPath = QCoreApplication::applicationFilePath();
     if (appPath.isEmpty()) {
         setStatus("Unable to locate application executable.");
@@ -2604,7 +2890,22 @@ bool AppController::launchDockerOpsApp(bool autoRun)
     QStringList args{"--docker-ops"};
     if (autoRun)
         args << "--auto-run";
-    const bool ok = QProcess::startDetached(appPath, args);
+
+    // The ops app reconciles right away, which would race a create still in
+    // flight here, and the installer quitting would kill that create halfway
+    if (afterPrecreate([this, args]() { emit dockerOpsAppLaunched(startDockerOpsApp(args)); })) {
+        setStatus("Finishing the SafeCore container setup...");
+        return true;
+    }
+    const bool ok = startDockerOpsApp(args);
+    emit dockerOpsAppLaunched(ok);
+    return ok;
+}
+
+bool AppController::startDockerOpsApp(const QStringList &args)
+{
+    emit dockerOpsAppLaunching();
+    const bool ok = QProcess::startDetached(QCoreApplication::applicationFilePath(), args);
     if (!ok)
         setStatus("Failed to launch Docker operations app.");
     return ok;
@@ -2625,6 +2926,7 @@ void AppController::handleSigInt()
 
 void AppController::cancel()
 {
+    TraceSpan span("controller", "cancel");
     if (m_task) {
         m_task->cancel();
         setStatus("Cancelled.");
@@ -2640,6 +2942,31 @@ void AppController::copyInstallPath()
     }
 }
 
+void AppController::finishOperation(Metrics::Operation operation, bool ok)
+{
+    QElapsedTimer &clock = m_operationClock[operation];
+    if (!clock.isValid())
+        return;
+    Metrics &metrics = Metrics::global();
+    metrics.operationDuration[operation].observe(double(clock.elapsed()) / 1000.0);
+    if (!ok)
+        metrics.operationFailures[operation].add();
+    clock.invalidate();
+}
+
+QString AppController::exportTrace()
+{
+    const QString path = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+        + "/SafeCore/traces/install-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".json";
+    QString error;
+    if (!Tracer::writeChromeTrace(path, &error)) {
+        setStatus("Could not save the install trace: " + error);
+        return QString();
+    }
+    setStatus("Install trace saved to " + path);
+    return path;
+}
+
 void AppController::goToStep(int step)
 {
     if (m_busy)
@@ -2664,6 +2991,8 @@ void AppController::runStep1_Docker()
 {
     delete m_task;
     m_task = new DownloadTask(this);
+    m_task->setBandwidthScheduler(&m_bandwidth);
+    m_task->setApiClient(&m_api);
 
     connect(m_task, &DownloadTask::progress, this, &AppController::onTaskProgress);
     connect(m_task, &DownloadTask::finished, this, &AppController::onTaskFinished);
@@ -2682,6 +3011,8 @@ void AppController::runStep2_Env()
 {
     delete m_task;
     m_task = new DownloadTask(this);
+    m_task->setBandwidthScheduler(&m_bandwidth);
+    m_task->setApiClient(&m_api);
 
     connect(m_task, &DownloadTask::progress, this, &AppController::onTaskProgress);
     connect(m_task, &DownloadTask::finished, this, &AppController::onTaskFinished);
@@ -2696,6 +3027,8 @@ void AppController::runStep3_Model()
 {
     delete m_task;
     m_task = new DownloadTask(this);
+    m_task->setBandwidthScheduler(&m_bandwidth);
+    m_task->setApiClient(&m_api);
 
     connect(m_task, &DownloadTask::progress, this, &AppController::onTaskProgress);
     connect(m_task, &DownloadTask::finished, this, &AppController::onTaskFinished);
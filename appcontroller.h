@@ -15,6 +15,20 @@
 
 #include "registrationservice.h"
 #include "downloadtask.h"
+#include "modelvolumesync.h"
+#include "dockercleanuppolicy.h"
+#include "pullstalldetector.h"
+#include "pulllogparser.h"
+#include "metrics.h"
+#include "portreadinessprobe.h"
+#include "networkmonitor.h"
+#include "bandwidthscheduler.h"
+#include "registryproxy.h"
+#include "upgradeagent.h"
+#include "registrycredentials.h"
+#include "apiclient.h"
+#include "statestore.h"
+#include "containerspec.h"
 #include "appconstants.h"
 
 class AppController : public QObject
@@ -36,12 +50,16 @@ class AppController : public QObject
     Q_PROPERTY(bool tenantBusy READ tenantBusy NOTIFY tenantBusyChanged)
     Q_PROPERTY(QString tenantMessage READ tenantMessage NOTIFY tenantMessageChanged)
     Q_PROPERTY(bool tenantSuccess READ tenantSuccess NOTIFY tenantSuccessChanged)
+    Q_PROPERTY(bool provisioning READ provisioning NOTIFY provisioningChanged)
     Q_PROPERTY(QString dockerPullLog READ dockerPullLog NOTIFY dockerPullLogChanged)
     Q_PROPERTY(double dockerPullProgress READ dockerPullProgress NOTIFY dockerPullProgressChanged)
     Q_PROPERTY(bool dockerPullActive READ dockerPullActive NOTIFY dockerPullActiveChanged)
     Q_PROPERTY(QString installPrereqsLog READ installPrereqsLog NOTIFY installPrereqsLogChanged)
     Q_PROPERTY(bool installPrereqsRunning READ installPrereqsRunning NOTIFY installPrereqsRunningChanged)
     Q_PROPERTY(bool installPrereqsDone READ installPrereqsDone NOTIFY installPrereqsDoneChanged)
+    Q_PROPERTY(bool relaySynced READ relaySynced NOTIFY installStateChanged)
+    Q_PROPERTY(bool dockerPullOk READ dockerPullOk NOTIFY installStateChanged)
+    Q_PROPERTY(bool pullInterrupted READ pullInterrupted NOTIFY installStateChanged)
     Q_PROPERTY(QString dockerOpsLog READ dockerOpsLog NOTIFY dockerOpsLogChanged)
     Q_PROPERTY(QString dockerOpsFollowLog READ dockerOpsFollowLog NOTIFY dockerOpsFollowLogChanged)
     Q_PROPERTY(QString dockerImage READ dockerImage CONSTANT)
@@ -55,6 +73,13 @@ class AppController : public QObject
     Q_PROPERTY(QString upgradeLog READ upgradeLog NOTIFY upgradeLogChanged)
     Q_PROPERTY(bool upgradeRunning READ upgradeRunning NOTIFY upgradeRunningChanged)
     Q_PROPERTY(double upgradeProgress READ upgradeProgress NOTIFY upgradeProgressChanged)
+    Q_PROPERTY(bool stagedUpgradeReady READ stagedUpgradeReady NOTIFY stagedUpgradeChanged)
+    Q_PROPERTY(QString stagedUpgradeDigest READ stagedUpgradeDigest NOTIFY stagedUpgradeChanged)
+    Q_PROPERTY(QString upgradeAgentStatus READ upgradeAgentStatus NOTIFY upgradeAgentStatusChanged)
+    Q_PROPERTY(double downloadBytesPerSecond READ downloadBytesPerSecond NOTIFY downloadThroughputChanged)
+    Q_PROPERTY(qint64 downloadCapBytesPerSecond READ downloadCapBytesPerSecond NOTIFY downloadCapChanged)
+    Q_PROPERTY(bool bandwidthOverride READ bandwidthOverride NOTIFY downloadCapChanged)
+    Q_PROPERTY(QString upgradeHoldReason READ upgradeHoldReason NOTIFY upgradeHoldReasonChanged)
 
     Q_PROPERTY(int currentStep READ currentStep NOTIFY currentStepChanged)          // 0..3
     Q_PROPERTY(double stepProgress READ stepProgress NOTIFY stepProgressChanged)   // 0..1
@@ -67,6 +92,10 @@ public:
     explicit AppController(QObject *parent = nullptr);
     ~AppController() override;
 
+    // Background upgrade checks and staging. Only the GUI starts them, so a
+    // headless provisioning run never has a staging pull beside its own.
+    void startUpgradeAgent();
+
     QString installPath() const { return m_installPath; }
     void setInstallPath(const QString& p);
 
@@ -85,17 +114,23 @@ public:
     QString registrationError() const { return m_registrationError; }
     QString registrationMessage() const { return m_registrationMessage; }
     QString relayUrl() const { return m_relayUrl; }
+    void setRelayUrl(const QString& relayUrl);
     QString relayError() const { return m_relayError; }
     bool syncBusy() const { return m_syncBusy; }
     bool tenantBusy() const { return m_tenantBusy; }
     QString tenantMessage() const { return m_tenantMessage; }
     bool tenantSuccess() const { return m_tenantSuccess; }
+    bool provisioning() const { return m_provisioning; }
     QString dockerPullLog() const { return m_dockerPullLog; }
     double dockerPullProgress() const { return m_dockerPullProgress; }
     bool dockerPullActive() const { return m_dockerPullActive; }
     QString installPrereqsLog() const { return m_installPrereqsLog; }
     bool installPrereqsRunning() const { return m_installPrereqsRunning; }
     bool installPrereqsDone() const { return m_installPrereqsDone; }
+    bool relaySynced() const;
+    bool dockerPullOk() const { return m_dockerPullOk; }
+    // The last run stopped in the middle of a pull; see resumeDockerPull()
+    bool pullInterrupted() const;
     QString dockerOpsLog() const { return m_dockerOpsLog; }
     QString dockerOpsFollowLog() const { return m_dockerOpsFollowLog; }
     QString dockerImage() const;
@@ -110,6 +145,13 @@ public:
     QString upgradeLog() const { return m_upgradeLog; }
     bool upgradeRunning() const { return m_upgradeRunning; }
     double upgradeProgress() const { return m_upgradeProgress; }
+    bool stagedUpgradeReady() const { return m_upgradeAgent.hasStagedUpgrade(); }
+    QString stagedUpgradeDigest() const { return m_upgradeAgent.stagedUpgrade().digest; }
+    QString upgradeAgentStatus() const { return m_upgradeAgent.status(); }
+    QString upgradeHoldReason() const { return m_upgradeHoldReason; }
+    double downloadBytesPerSecond() const { return m_bandwidth.measuredBytesPerSecond(); }
+    qint64 downloadCapBytesPerSecond() const { return m_bandwidth.currentCap(); }
+    bool bandwidthOverride() const { return m_bandwidth.isOverridden(); }
 
     int currentStep() const { return m_currentStep; }
     double stepProgress() const { return m_stepProgress; }
@@ -121,7 +163,14 @@ public:
     Q_INVOKABLE void populateMacId();
     Q_INVOKABLE void syncRelay();
     Q_INVOKABLE void fetchTenantData(const QString& vertical);
+    // Registers, syncs the relay and fetches tenant data back to back. Steps
+    // that already succeeded with the same inputs are not repeated, so calling
+    // this again after a failure resumes at the failed step.
+    Q_INVOKABLE void provision(const QString& vertical);
     Q_INVOKABLE void pullDockerImage();
+    // Restarts a pull the last run did not finish. Layers it completed are
+    // still in the daemon's store, so only the missing ones are downloaded.
+    Q_INVOKABLE void resumeDockerPull();
     Q_INVOKABLE void cancelDockerPull();
     Q_INVOKABLE void clearDockerPullLog();
     Q_INVOKABLE void startInstallPrereqs();
@@ -140,10 +189,17 @@ public:
     Q_INVOKABLE void startInstall();
     Q_INVOKABLE void cancel();
     Q_INVOKABLE void copyInstallPath();
+    // Writes the install timeline as a Chrome trace for a support ticket and
+    // returns its path, or an empty string if it could not be written.
+    Q_INVOKABLE QString exportTrace();
     Q_INVOKABLE void goToStep(int step);
     Q_INVOKABLE void forceStep(int step);
     Q_INVOKABLE void startUpgrade();
+    Q_INVOKABLE void checkForUpgradeNow();
+    Q_INVOKABLE void applyStagedUpgrade();
     Q_INVOKABLE void cancelUpgrade();
+    // Lifts the bandwidth cap until the running pull or upgrade is over
+    Q_INVOKABLE void pullAtFullSpeed();
 
 signals:
     void installPathChanged();
@@ -163,12 +219,17 @@ signals:
     void tenantBusyChanged();
     void tenantMessageChanged();
     void tenantSuccessChanged();
+    void tenantResult(bool ok, const QString& message);
+    void provisioningChanged();
+    void provisioningStep(const QString& step, bool ok, const QString& message, qint64 elapsedMs);
+    void provisioningFinished(bool ok, const QString& message, qint64 elapsedMs);
     void dockerPullLogChanged();
     void dockerPullProgressChanged();
     void dockerPullActiveChanged();
     void installPrereqsLogChanged();
     void installPrereqsRunningChanged();
     void installPrereqsDoneChanged();
+    void installStateChanged();
     void dockerPullStarted();
     void dockerPullFinished(bool ok, const QString& message);
     void dockerRunFinished(bool ok);
@@ -180,10 +241,19 @@ signals:
     void dockerOpsConflictChanged();
     void dockerOpsContainerIdChanged();
     void dockerOpsAutoRunChanged();
+    // Right before launchDockerOpsApp() starts the new process
+    void dockerOpsAppLaunching();
+    // Once it has been started, or failed to; may come after launchDockerOpsApp() returns
+    void dockerOpsAppLaunched(bool ok);
     void dockerOpsFinished(bool ok, const QString& message);
     void dockerOpsStopped(bool ok, const QString& message);
 
     void upgradeLogChanged();
+    void stagedUpgradeChanged();
+    void upgradeAgentStatusChanged();
+    void downloadThroughputChanged();
+    void downloadCapChanged();
+    void upgradeHoldReasonChanged();
     void upgradeRunningChanged();
     void upgradeProgressChanged();
     void upgradeFinished(bool hasUpdate, const QString& message);
@@ -217,13 +287,21 @@ private:
     void setInstallPrereqsRunning(bool value);
     void setInstallPrereqsDone(bool value);
     void appendDockerPullLog(const QString& chunk);
+    void appendDockerPullEvent(const QString& message);
     void resetDockerPullProgress();
-    void updateDockerPullProgressFromChunk(const QString& chunk);
     void appendUpgradeLog(const QString& chunk);
     void resetUpgradeProgress();
-    void updateUpgradeProgressFromChunk(const QString& chunk);
     void setUpgradeProgress(double value);
+    void finishOperation(Metrics::Operation operation, bool ok);
     void startUpgradePull();
+    // `docker pull` of `image` for sg's -c; through m_registryProxy when a
+    // cap can apply, which *proxied reports
+    QString dockerPullCommand(const QString& image, bool* proxied);
+    // Why the upgrade pull may not run right now; empty when it may
+    QString upgradePullHoldReason() const;
+    void setUpgradeHoldReason(const QString& reason);
+    void pauseUpgradePull();
+    void resumeUpgradePull();
     void setDockerOpsLog(const QString& log);
     void setDockerOpsFollowLog(const QString& log);
     void setDockerOpsRunning(bool value);
@@ -231,12 +309,21 @@ private:
     void setDockerOpsStopping(bool value);
     void setDockerOpsConflict(bool value);
     void setDockerOpsContainerId(const QString& id);
+    void startDockerOpsContainer();
+    void cycleDockerOpsContainer(bool startOnly);
+    void precreateDockerOpsContainer();
+    bool afterPrecreate(std::function<void()> next);
+    bool startDockerOpsApp(const QStringList& args);
     void startDockerPullProcess(bool resetStatus);
     void performDockerLogin(std::function<void(bool)> callback, int retryCount = 0);
     void checkDockerPullStall();
     void probeDockerRegistry();
-    void restartDockerPull();
+    void restartDockerPull(bool immediate = false);
+    void onDefaultRouteLost();
+    void onDefaultRouteRestored(qint64 offlineMs);
     void loadSetupState();
+    void restoreInstallState();
+    void saveInstallState(const StateStore::InstallState& state);
     void persistSetupState();
     void updateSetupComplete();
     void setStatus(const QString& s);
@@ -244,11 +331,15 @@ private:
     void setStep(int step);
     void setRegistrationError(const QString& message);
     void setRegistrationMessage(const QString& message);
-    void setRelayUrl(const QString& relayUrl);
     void setRelayError(const QString& message);
     void setTenantMessage(const QString& message);
+    void setProvisioning(bool value);
+    QString provisionInputs(int step, const QString& vertical) const;
+    void runProvisionStep();
+    void onProvisionStepResult(int step, bool ok, const QString& message);
 
 private:
+    enum ProvisionStep { ProvisionRegister, ProvisionRelay, ProvisionTenant, ProvisionStepCount };
     QString m_installPath = AppConstants::DefaultInstallPath;
     QString m_serviceBaseUrl = AppConstants::ServiceBaseUrl;
     QString m_macId;
@@ -264,16 +355,23 @@ private:
     bool m_tenantBusy = false;
     QString m_tenantMessage;
     bool m_tenantSuccess = false;
+    QString m_tenantVertical;
+    bool m_provisioning = false;
+    int m_provisionStep = -1;
+    QString m_provisionVertical;
+    // Inputs each step last succeeded with; empty until it has succeeded
+    QString m_provisionCompleted[ProvisionStepCount];
+    QElapsedTimer m_provisionClock;
+    QElapsedTimer m_provisionStepClock;
+    StateStore m_stateStore;
     QString m_dockerPullLog;
-    QString m_dockerPullRemainder;
-    QStringList m_dockerPullLines;
-    QHash<QString, int> m_dockerPullLineIndex;
-    QHash<QString, int> m_dockerPullLayerState;
-    QString m_dockerPullLastLayerId;
-    bool m_dockerPullSawStatus = false;
+    PullLogParser m_pullLogParser{true};
     double m_dockerPullProgress = 0.0;
     bool m_dockerPullActive = false;
     bool m_dockerPullCanceled = false;
+    // Pulled through m_registryProxy, which already meters the bytes
+    bool m_dockerPullProxied = false;
+    bool m_upgradePullProxied = false;
     QString m_installPrereqsLog;
     bool m_installPrereqsRunning = false;
     bool m_installPrereqsDone = false;
@@ -283,6 +381,19 @@ private:
     QTimer m_dockerWatchdog;
     bool m_dockerAwaitingNetwork = false;
     bool m_dockerProbeActive = false;
+    bool m_dockerRetryPending = false;
+    QElapsedTimer m_dockerLastProbe;
+    PullStallDetector m_pullStallDetector;
+    PortReadinessProbe m_portProbe;
+    QElapsedTimer m_operationClock[Metrics::OperationCount];
+    Metrics::Operation m_opsOperation = Metrics::OperationRun;
+    // Set while a runDockerOps reconcile is in flight
+    QElapsedTimer m_reconcileClock;
+    QString m_reconcileAction;
+    QPointer<QProcess> m_precreateProcess;
+    QElapsedTimer m_precreateClock;
+    qint64 m_dockerPullMeteredBytes = 0;
+    NetworkMonitor m_networkMonitor;
     QString m_dockerOpsLog;
     QString m_dockerOpsFollowLog;
     bool m_dockerOpsRunning = false;
@@ -298,15 +409,14 @@ private:
     QString m_tenantAccessKey = AppConstants::TenantAccessKey;
 
     QString m_upgradeLog;
-    QString m_upgradeRemainder;
-    QStringList m_upgradeLines;
-    QHash<QString, int> m_upgradeLineIndex;
-    QHash<QString, int> m_upgradeLayerState;
-    QString m_upgradeLastLayerId;
-    bool m_upgradeSawStatus = false;
+    PullLogParser m_upgradeLogParser;
+    QHash<QString, qint64> m_upgradeLayerBytes;
     double m_upgradeProgress = 0.0;
     bool m_upgradeRunning = false;
     bool m_upgradeCanceled = false;
+    // The upgrade pull is due but stopped or not started, see m_upgradeHoldReason
+    bool m_upgradePullPending = false;
+    QString m_upgradeHoldReason;
     QProcess* m_upgradeProcess = nullptr;
 
     int m_currentStep = 0;
@@ -320,9 +430,15 @@ private:
     bool m_dockerPullOk = false;
     bool m_setupComplete = false;
 
+    ApiClient m_api;
     RegistrationService m_registration;
+    ModelVolumeSync m_modelVolumeSync;
+    DockerCleanupPolicy m_cleanupPolicy;
+    BandwidthScheduler m_bandwidth;
+    RegistryCredentials m_credentials;
+    RegistryProxy m_registryProxy;
+    UpgradeAgent m_upgradeAgent;
     DownloadTask* m_task = nullptr; // current step task
-    QNetworkAccessManager m_net;
     QProcess* m_dockerProcess = nullptr;
     QProcess* m_runProcess = nullptr;
     QProcess* m_dockerOpsProcess = nullptr;
@@ -0,0 +1,237 @@
+#include "bandwidthscheduler.h"
+#include "statestore.h"
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStandardPaths>
+#include <cmath>
+
+namespace {
+// Burst allowance: a quarter second of the cap, but never below one read
+constexpr qint64 MinBucketBytes = 16 * 1024;
+constexpr int SampleIntervalMs = 1000;
+constexpr int MinWaitMs = 10;
+constexpr qint64 DefaultStagingBytesPerSecond = 1000000;
+constexpr double SmoothingFactor = 0.5;
+constexpr int MsPerDay = 24 * 60 * 60 * 1000;
+// Lands just past a boundary so capAt() already sees the new window
+constexpr int BoundarySlackMs = 500;
+
+// Milliseconds from `from` forward to `to`, wrapping past midnight
+int msForward(const QTime &from, const QTime &to)
+{
+    const int ms = from.msecsTo(to);
+    return ms < 0 ? ms + MsPerDay : ms;
+}
+
+QString schedulePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore/bandwidth.json";
+}
+
+bool windowContains(const BandwidthScheduler::Window &window, const QTime &time)
+{
+    if (!window.start.isValid() || !window.end.isValid())
+        return false;
+    if (window.start <= window.end)
+        return time >= window.start && time < window.end;
+    // Wraps past midnight
+    return time >= window.start || time < window.end;
+}
+} // namespace
+
+BandwidthScheduler::BandwidthScheduler(QObject *parent)
+    : QObject(parent)
+    , m_stagingCap(DefaultStagingBytesPerSecond)
+{
+    m_sampleTimer.setInterval(SampleIntervalMs);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &BandwidthScheduler::sample);
+    // Window boundaries change the cap even when nothing is transferring
+    m_boundaryTimer.setSingleShot(true);
+    connect(&m_boundaryTimer, &QTimer::timeout, this, &BandwidthScheduler::updateCap);
+    m_refillClock.start();
+}
+
+void BandwidthScheduler::load()
+{
+    QFile inFile(schedulePath());
+    if (!inFile.open(QIODevice::ReadOnly))
+        return;
+    const QJsonDocument doc = QJsonDocument::fromJson(inFile.readAll());
+    if (!doc.isObject())
+        return;
+
+    const QJsonObject obj = doc.object();
+    QList<Window> windows;
+    const QJsonArray windowArray = obj.value("windows").toArray();
+    for (const QJsonValue &value : windowArray) {
+        const QJsonObject windowObj = value.toObject();
+        Window window;
+        window.start = QTime::fromString(windowObj.value("start").toString(), "HH:mm");
+        window.end = QTime::fromString(windowObj.value("end").toString(), "HH:mm");
+        window.bytesPerSecond = qMax<qint64>(0, windowObj.value("bytesPerSecond").toInteger());
+        if (window.start.isValid() && window.end.isValid())
+            windows.append(window);
+    }
+    m_defaultCap = qMax<qint64>(0, obj.value("defaultBytesPerSecond").toInteger());
+    m_windows = windows;
+    m_stagingCap = qMax<qint64>(0, obj.value("stagingBytesPerSecond").toInteger(DefaultStagingBytesPerSecond));
+    updateCap();
+}
+
+void BandwidthScheduler::save() const
+{
+    QJsonArray windowArray;
+    for (const Window &window : m_windows) {
+        QJsonObject windowObj;
+        windowObj.insert("start", window.start.toString("HH:mm"));
+        windowObj.insert("end", window.end.toString("HH:mm"));
+        windowObj.insert("bytesPerSecond", window.bytesPerSecond);
+        windowArray.append(windowObj);
+    }
+    QJsonObject obj;
+    obj.insert("defaultBytesPerSecond", m_defaultCap);
+    obj.insert("windows", windowArray);
+    obj.insert("stagingBytesPerSecond", m_stagingCap);
+    QString error;
+    if (!StateStore::writeFile(schedulePath(), QJsonDocument(obj).toJson(QJsonDocument::Indented), &error))
+        qWarning().noquote() << "Cannot save bandwidth schedule:" << error;
+}
+
+void BandwidthScheduler::setDefaultCap(qint64 bytesPerSecond)
+{
+    m_defaultCap = qMax<qint64>(0, bytesPerSecond);
+    updateCap();
+}
+
+void BandwidthScheduler::setWindows(const QList<Window> &windows)
+{
+    m_windows = windows;
+    updateCap();
+}
+
+qint64 BandwidthScheduler::capAt(const QTime &time) const
+{
+    for (const Window &window : m_windows) {
+        if (windowContains(window, time))
+            return window.bytesPerSecond;
+    }
+    return m_defaultCap;
+}
+
+bool BandwidthScheduler::isLimited() const
+{
+    if (m_defaultCap > 0)
+        return true;
+    for (const Window &window : m_windows) {
+        if (window.bytesPerSecond > 0)
+            return true;
+    }
+    return false;
+}
+
+void BandwidthScheduler::setOverride(bool enabled)
+{
+    if (m_override == enabled)
+        return;
+    m_override = enabled;
+    emit overrideChanged(m_override);
+    updateCap();
+}
+
+void BandwidthScheduler::scheduleBoundary()
+{
+    const QTime now = QTime::currentTime();
+    int nextMs = -1;
+    for (const Window &window : m_windows) {
+        for (const QTime &edge : {window.start, window.end}) {
+            const int ms = edge.isValid() ? msForward(now, edge) : -1;
+            if (ms > 0 && (nextMs < 0 || ms < nextMs))
+                nextMs = ms;
+        }
+    }
+    if (nextMs < 0)
+        m_boundaryTimer.stop();
+    else
+        m_boundaryTimer.start(nextMs + BoundarySlackMs);
+}
+
+void BandwidthScheduler::updateCap()
+{
+    scheduleBoundary();
+    const qint64 cap = m_override ? 0 : capAt(QTime::currentTime());
+    if (cap == m_currentCap)
+        return;
+    refill();
+    m_currentCap = cap;
+    m_tokens = qMin(m_tokens, double(bucketSize()));
+    emit capChanged(m_currentCap);
+}
+
+qint64 BandwidthScheduler::bucketSize() const
+{
+    return qMax(MinBucketBytes, m_currentCap / 4);
+}
+
+void BandwidthScheduler::refill()
+{
+    const qint64 elapsed = m_refillClock.restart();
+    if (m_currentCap <= 0)
+        return;
+    m_tokens = qMin(double(bucketSize()), m_tokens + double(m_currentCap) * double(elapsed) / 1000.0);
+}
+
+qint64 BandwidthScheduler::acquire(qint64 wanted)
+{
+    if (wanted <= 0)
+        return 0;
+    refill();
+    qint64 granted = wanted;
+    if (m_currentCap > 0) {
+        granted = qMin(wanted, qint64(m_tokens));
+        m_tokens -= double(granted);
+    }
+    recordTransfer(granted);
+    return granted;
+}
+
+int BandwidthScheduler::msUntilAvailable(qint64 bytes)
+{
+    if (m_currentCap <= 0)
+        return 0;
+    refill();
+    const double needed = double(qMin(bytes, bucketSize())) - m_tokens;
+    if (needed <= 0.0)
+        return 0;
+    return qMax(MinWaitMs, int(std::ceil(needed * 1000.0 / double(m_currentCap))));
+}
+
+void BandwidthScheduler::recordTransfer(qint64 bytes)
+{
+    if (bytes <= 0)
+        return;
+    m_sampleBytes += bytes;
+    m_idleSamples = 0;
+    if (!m_sampleTimer.isActive()) {
+        m_sampleClock.start();
+        m_sampleTimer.start();
+    }
+}
+
+void BandwidthScheduler::sample()
+{
+    // Also picks up window boundaries while a transfer is running
+    updateCap();
+
+    const qint64 elapsed = qMax<qint64>(1, m_sampleClock.restart());
+    const double rate = double(m_sampleBytes) * 1000.0 / double(elapsed);
+    m_sampleBytes = 0;
+    m_measured = m_measured <= 0.0 ? rate : m_measured + SmoothingFactor * (rate - m_measured);
+    if (rate <= 0.0 && ++m_idleSamples >= 2) {
+        m_measured = 0.0;
+        m_sampleTimer.stop();
+    }
+    emit throughputChanged(m_measured);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <QObject>
+#include <QList>
+#include <QTime>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// Shares one download budget between everything the installer fetches.
+// The cap comes from time-of-day windows (e.g. unlimited 01:00-05:00,
+// 2 MB/s otherwise) and is enforced with a token bucket that readers draw
+// from before consuming bytes. Image pulls draw from it too: the daemon
+// pulls through RegistryProxy, which hands each body on as tokens come in.
+// setOverride() lifts the cap for a pull the operator wants now.
+//
+// The schedule is read from SafeCore/bandwidth.json:
+//   { "defaultBytesPerSecond": 2000000,
+//     "windows": [ { "start": "01:00", "end": "05:00", "bytesPerSecond": 0 } ],
+//     "stagingBytesPerSecond": 1000000 }
+// A rate of 0 means unlimited. Windows may wrap past midnight. Background
+// upgrade staging keeps to stagingBytesPerSecond on top of the schedule.
+// It defaults to 1 MB/s, also without a file, so staging only takes the
+// whole line when set to 0.
+class BandwidthScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    struct Window {
+        QTime start;
+        QTime end;
+        qint64 bytesPerSecond = 0;
+    };
+
+    explicit BandwidthScheduler(QObject* parent = nullptr);
+
+    void load();
+    void save() const;
+
+    void setDefaultCap(qint64 bytesPerSecond);
+    qint64 defaultCap() const { return m_defaultCap; }
+    void setWindows(const QList<Window>& windows);
+    QList<Window> windows() const { return m_windows; }
+    void setStagingCap(qint64 bytesPerSecond) { m_stagingCap = qMax<qint64>(0, bytesPerSecond); }
+    qint64 stagingCap() const { return m_stagingCap; }
+
+    qint64 capAt(const QTime& time) const;
+    // True when some time of day is capped, whether or not it is now
+    bool isLimited() const;
+    qint64 currentCap() const { return m_currentCap; }
+    // While set the cap is lifted, until cleared again
+    void setOverride(bool enabled);
+    bool isOverridden() const { return m_override; }
+    double measuredBytesPerSecond() const { return m_measured; }
+
+    // Grants up to `wanted` bytes from the bucket and records them.
+    qint64 acquire(qint64 wanted);
+    // Time until `bytes` (bounded by the bucket size) can be granted.
+    int msUntilAvailable(qint64 bytes);
+    // Records bytes moved outside the bucket, for measurement only.
+    void recordTransfer(qint64 bytes);
+
+signals:
+    void capChanged(qint64 bytesPerSecond);
+    void overrideChanged(bool enabled);
+    void throughputChanged(double bytesPerSecond);
+
+private:
+    void refill();
+    void updateCap();
+    void scheduleBoundary();
+    void sample();
+    qint64 bucketSize() const;
+
+    qint64 m_defaultCap = 0;
+    QList<Window> m_windows;
+    qint64 m_stagingCap;
+    qint64 m_currentCap = 0;
+    bool m_override = false;
+
+    double m_tokens = 0.0;
+    QElapsedTimer m_refillClock;
+
+    QTimer m_boundaryTimer;
+    QTimer m_sampleTimer;
+    QElapsedTimer m_sampleClock;
+    qint64 m_sampleBytes = 0;
+    int m_idleSamples = 0;
+    double m_measured = 0.0;
+};
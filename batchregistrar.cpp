@@ -0,0 +1,188 @@
+#include "batchregistrar.h"
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+qint64 percentile(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0;
+    const int index = qBound(0, int(std::ceil(p * sorted.size())) - 1, int(sorted.size()) - 1);
+    return sorted.at(index);
+}
+
+QString deviceDirName(const QString &macId)
+{
+    QString name = macId.trimmed().toLower();
+    name.replace(':', '-');
+    return name;
+}
+} // namespace
+
+BatchRegistrar::BatchRegistrar(QObject *parent)
+    : QObject(parent)
+{
+    m_registration.setApiClient(&m_api);
+    m_rateTimer.setSingleShot(true);
+    connect(&m_rateTimer, &QTimer::timeout, this, &BatchRegistrar::launchMore);
+    m_out.open(stdout, QIODevice::WriteOnly);
+}
+
+bool BatchRegistrar::readCsv(const QString &path, QVector<Device> *devices, QString *error)
+{
+    QFile inFile(path);
+    if (!inFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "Cannot read " + path;
+        return false;
+    }
+
+    static const QRegularExpression macRegex(R"(^([0-9A-Fa-f]{2}[:-]){5}[0-9A-Fa-f]{2}$)");
+    QTextStream in(&inFile);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        const QStringList fields = line.split(',');
+        const QString mac = fields.value(0).trimmed().remove('"');
+        const QString tenant = fields.value(1).trimmed().remove('"');
+        if (!macRegex.match(mac).hasMatch()) {
+            if (lineNumber == 1)
+                continue;   // header
+            *error = QString("Line %1: invalid MAC ID \"%2\".").arg(lineNumber).arg(mac);
+            return false;
+        }
+        if (tenant.isEmpty()) {
+            *error = QString("Line %1: tenant ID is missing.").arg(lineNumber);
+            return false;
+        }
+        devices->append({mac, tenant});
+    }
+    return true;
+}
+
+void BatchRegistrar::start(const QVector<Device> &devices)
+{
+    m_devices = devices;
+    m_latenciesMs.clear();
+    m_latenciesMs.reserve(devices.size());
+    m_next = 0;
+    m_inFlight = 0;
+    m_failures = 0;
+    m_nextStartMs = 0;
+    m_clock.start();
+
+    if (m_devices.isEmpty()) {
+        writeSummary();
+        emit finished(0);
+        return;
+    }
+    m_api.warmUp(QUrl(m_serviceBaseUrl.trimmed()));
+    launchMore();
+}
+
+void BatchRegistrar::launchMore()
+{
+    const qint64 spacingMs = m_ratePerSecond > 0.0 ? qint64(1000.0 / m_ratePerSecond) : 0;
+    while (m_inFlight < m_maxInFlight && m_next < m_devices.size()) {
+        const qint64 now = m_clock.elapsed();
+        if (spacingMs > 0 && now < m_nextStartMs) {
+            if (!m_rateTimer.isActive())
+                m_rateTimer.start(int(m_nextStartMs - now));
+            return;
+        }
+        m_nextStartMs = qMax(m_nextStartMs, now) + spacingMs;
+
+        const int index = m_next++;
+        const Device &device = m_devices.at(index);
+        ++m_inFlight;
+        m_registration.generateKey(m_serviceBaseUrl, m_accessKey, device.macId.toLower().replace('-', ':'),
+                                   device.tenantId, [this, index](const RegistrationService::Result &result) {
+                                       onResult(index, result);
+                                   });
+    }
+}
+
+void BatchRegistrar::onResult(int index, const RegistrationService::Result &result)
+{
+    --m_inFlight;
+    const Device &device = m_devices.at(index);
+    m_latenciesMs.append(result.elapsedMs);
+    if (!result.ok)
+        ++m_failures;
+    writeDeviceFile(device, result);
+
+    QJsonObject line;
+    line.insert("event", "device");
+    line.insert("macId", device.macId);
+    line.insert("tenantId", device.tenantId);
+    line.insert("ok", result.ok);
+    line.insert("message", result.message);
+    line.insert("elapsedMs", double(result.elapsedMs));
+    writeLine(line);
+
+    if (m_next >= m_devices.size() && m_inFlight == 0) {
+        writeSummary();
+        emit finished(m_failures);
+        return;
+    }
+    // Validation failures complete synchronously; keep launching from the
+    // event loop so a bad batch cannot recurse deeply.
+    QMetaObject::invokeMethod(this, &BatchRegistrar::launchMore, Qt::QueuedConnection);
+}
+
+void BatchRegistrar::writeDeviceFile(const Device &device, const RegistrationService::Result &result)
+{
+    QDir dir(m_outputDir);
+    const QString name = deviceDirName(device.macId);
+    if (!dir.mkpath(name))
+        return;
+    QFile outFile(dir.filePath(name + "/registration_data.json"));
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+    QJsonObject payload;
+    payload.insert("savedAt", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    payload.insert("macId", device.macId);
+    payload.insert("tenantId", device.tenantId);
+    payload.insert("registrationKey", result.registrationKey);
+    payload.insert("generatedOn", result.generatedOn);
+    payload.insert("ok", result.ok);
+    payload.insert("message", result.message);
+    outFile.write(QJsonDocument(payload).toJson(QJsonDocument::Indented));
+}
+
+void BatchRegistrar::writeSummary()
+{
+    QVector<qint64> sorted = m_latenciesMs;
+    std::sort(sorted.begin(), sorted.end());
+    const qint64 wallMs = m_clock.elapsed();
+
+    QJsonObject line;
+    line.insert("event", "summary");
+    line.insert("devices", m_devices.size());
+    line.insert("succeeded", int(m_devices.size()) - m_failures);
+    line.insert("failed", m_failures);
+    line.insert("wallMs", double(wallMs));
+    line.insert("devicesPerSecond", wallMs > 0 ? m_devices.size() * 1000.0 / double(wallMs) : 0.0);
+    line.insert("p50Ms", double(percentile(sorted, 0.50)));
+    line.insert("p90Ms", double(percentile(sorted, 0.90)));
+    line.insert("p99Ms", double(percentile(sorted, 0.99)));
+    line.insert("maxMs", double(sorted.isEmpty() ? 0 : sorted.last()));
+    line.insert("maxInFlight", m_maxInFlight);
+    line.insert("ratePerSecond", m_ratePerSecond);
+    writeLine(line);
+}
+
+void BatchRegistrar::writeLine(const QJsonObject &obj)
+{
+    m_out.write(QJsonDocument(obj).toJson(QJsonDocument::Compact) + '\n');
+    m_out.flush();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+#include "apiclient.h"
+#include "registrationservice.h"
+
+// Registers a list of devices against the admin API, several at a time.
+// At most maxInFlight registrations are outstanding and new ones start no
+// faster than ratePerSecond (0 for no rate limit). Each device's result is
+// written to <outputDir>/<mac>/registration_data.json in the same layout the
+// installer keeps for the local device, and every result plus a final
+// throughput/latency summary is printed to stdout as JSON lines.
+class BatchRegistrar : public QObject
+{
+    Q_OBJECT
+public:
+    struct Device {
+        QString macId;
+        QString tenantId;
+    };
+
+    explicit BatchRegistrar(QObject* parent = nullptr);
+
+    // Reads "mac,tenant" rows; a header row and blank or # lines are skipped.
+    static bool readCsv(const QString& path, QVector<Device>* devices, QString* error);
+
+    void setServiceBaseUrl(const QString& url) { m_serviceBaseUrl = url; }
+    void setAccessKey(const QString& key) { m_accessKey = key; }
+    void setOutputDir(const QString& dir) { m_outputDir = dir; }
+    void setMaxInFlight(int count) { m_maxInFlight = qMax(1, count); }
+    void setRatePerSecond(double rate) { m_ratePerSecond = qMax(0.0, rate); }
+
+    void start(const QVector<Device>& devices);
+
+signals:
+    void finished(int failures);
+
+private:
+    void launchMore();
+    void onResult(int index, const RegistrationService::Result& result);
+    void writeDeviceFile(const Device& device, const RegistrationService::Result& result);
+    void writeSummary();
+    void writeLine(const QJsonObject& obj);
+
+    ApiClient m_api;
+    RegistrationService m_registration;
+    QString m_serviceBaseUrl;
+    QString m_accessKey;
+    QString m_outputDir;
+    int m_maxInFlight = 8;
+    double m_ratePerSecond = 0.0;
+
+    QVector<Device> m_devices;
+    QVector<qint64> m_latenciesMs;
+    int m_next = 0;
+    int m_inFlight = 0;
+    int m_failures = 0;
+    qint64 m_nextStartMs = 0;
+    QElapsedTimer m_clock;
+    QTimer m_rateTimer;
+    QFile m_out;
+};
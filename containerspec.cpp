@@ -0,0 +1,296 @@
+#include "containerspec.h"
+#include "appconstants.h"
+#include "statestore.h"
+#include <QCryptographicHash>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QSet>
+#include <QUrl>
+
+const QString ContainerSpec::HashLabel = QStringLiteral("com.safecore.spec-hash");
+
+namespace {
+QString shellQuote(const QString &arg)
+{
+    static const QRegularExpression safe(QStringLiteral("^[A-Za-z0-9_@%+=:,./-]+$"));
+    if (safe.match(arg).hasMatch())
+        return arg;
+    QString quoted = arg;
+    quoted.replace('\'', QLatin1String("'\\''"));
+    return '\'' + quoted + '\'';
+}
+
+// systemd expands $VAR and %-specifiers even inside quotes, so both are
+// doubled; quotes and backslashes use C-style escapes
+QString systemdQuote(const QString &arg)
+{
+    QString escaped = arg;
+    escaped.replace('%', QLatin1String("%%"));
+    escaped.replace('$', QLatin1String("$$"));
+    static const QRegularExpression special(QStringLiteral("[\\s\"'\\\\;]"));
+    if (!special.match(escaped).hasMatch() && !escaped.isEmpty())
+        return escaped;
+    escaped.replace('\\', QLatin1String("\\\\"));
+    escaped.replace('"', QLatin1String("\\\""));
+    return '"' + escaped + '"';
+}
+
+// Everything after `docker run -d` / `docker create`
+QStringList containerArgs(const ContainerSpec &spec)
+{
+    QStringList args;
+    args << "--name" << spec.name;
+    if (spec.allGpus)
+        args << "--gpus" << "all";
+    args << "--restart" << spec.restartPolicy
+         << "--label" << (ContainerSpec::HashLabel + '=' + spec.hash());
+    for (const QString &port : spec.ports)
+        args << "-p" << port;
+    for (const QString &volume : spec.volumes)
+        args << "-v" << volume;
+    for (const auto &entry : spec.env)
+        args << "-e" << (entry.first + '=' + entry.second);
+    args << spec.image;
+    return args;
+}
+
+QJsonObject containerConfig(const ContainerSpec &spec)
+{
+    QJsonArray env;
+    for (const auto &entry : spec.env)
+        env.append(entry.first + '=' + entry.second);
+
+    QJsonObject exposedPorts;
+    QJsonObject portBindings;
+    for (const QString &port : spec.ports) {
+        const QString hostPort = port.section(':', 0, 0);
+        const QString containerPort = port.section(':', 1) + "/tcp";
+        exposedPorts.insert(containerPort, QJsonObject());
+        QJsonArray bindings = portBindings.value(containerPort).toArray();
+        bindings.append(QJsonObject{{"HostPort", hostPort}});
+        portBindings.insert(containerPort, bindings);
+    }
+
+    QJsonObject hostConfig;
+    hostConfig.insert("PortBindings", portBindings);
+    hostConfig.insert("Binds", QJsonArray::fromStringList(spec.volumes));
+    hostConfig.insert("RestartPolicy", QJsonObject{{"Name", spec.restartPolicy}});
+    if (spec.allGpus) {
+        // --gpus all
+        QJsonArray capabilities;
+        capabilities.append(QJsonArray{"gpu"});
+        hostConfig.insert("DeviceRequests", QJsonArray{QJsonObject{
+            {"Driver", ""}, {"Count", -1}, {"Capabilities", capabilities}}});
+    }
+
+    QJsonObject config;
+    config.insert("Image", spec.image);
+    config.insert("Env", env);
+    config.insert("ExposedPorts", exposedPorts);
+    config.insert("HostConfig", hostConfig);
+    return config;
+}
+} // namespace
+
+bool ContainerSpec::resolve(const StateStore &store, const QString &serviceBaseUrl, const QString &accessKey,
+                            ContainerSpec *spec, QString *error)
+{
+    if (!store.hasRegistration()) {
+        *error = "Missing registration data. Run registration first.";
+        return false;
+    }
+    if (!store.hasTenant()) {
+        *error = "Missing tenant data. Fetch tenant data first.";
+        return false;
+    }
+    const StateStore::Registration &registration = store.registration();
+    if (!registration.isComplete()) {
+        *error = "Registration data is incomplete.";
+        return false;
+    }
+
+    const StateStore::Tenant &tenant = store.tenant();
+    const QString safeCoreBoxId = tenant.safeCoreBoxId(registration.macId);
+    if (safeCoreBoxId.isEmpty() || tenant.domain.isEmpty()) {
+        *error = "Tenant data is missing SafeCoreBoxId or domain.";
+        return false;
+    }
+
+    QUrl baseUrl(serviceBaseUrl.trimmed());
+    if (!baseUrl.isValid() || baseUrl.scheme().isEmpty() || baseUrl.host().isEmpty()) {
+        *error = "Service URL is invalid.";
+        return false;
+    }
+    const QString tenantEndpoint = AppConstants::TenantEndpoint;
+    if (!baseUrl.path().endsWith(tenantEndpoint)) {
+        QString path = baseUrl.path();
+        if (path.endsWith('/'))
+            path.chop(1);
+        baseUrl.setPath(path + tenantEndpoint);
+    }
+    const QString apiUrl = baseUrl.toString(QUrl::None);
+
+    if (accessKey.isEmpty()) {
+        *error = "Missing tenant access key.";
+        return false;
+    }
+
+    spec->name = AppConstants::ContainerName;
+    spec->image = AppConstants::DockerImage;
+    spec->restartPolicy = "unless-stopped";
+    spec->allGpus = true;
+    spec->ports = AppConstants::ContainerPorts;
+    spec->volumes = AppConstants::ContainerVolumes;
+    spec->env = {
+        {"NVIDIA_DRIVER_CAPABILITIES", AppConstants::NvidiaDriverCapabilities},
+        {"CONFIG_API_URL", apiUrl},
+        {"CONFIG_API_ACCESS_KEY", accessKey},
+        {"SafeCoreBoxId", safeCoreBoxId},
+        {"TENANT_ID", registration.tenantId},
+        {"DOMAIN", tenant.domain},
+    };
+    return true;
+}
+
+QString ContainerSpec::hash() const
+{
+    // QJsonObject keeps its keys sorted, so the compact form is canonical
+    QJsonObject config = containerConfig(*this);
+    config.insert("Name", name);
+    const QByteArray canonical = QJsonDocument(config).toJson(QJsonDocument::Compact);
+    return QString::fromLatin1(QCryptographicHash::hash(canonical, QCryptographicHash::Sha256).toHex());
+}
+
+QStringList ContainerSpec::runArgs() const
+{
+    return QStringList{"run", "-d"} + containerArgs(*this);
+}
+
+QStringList ContainerSpec::createArgs() const
+{
+    return QStringList{"create"} + containerArgs(*this);
+}
+
+QString ContainerSpec::shellCommand(const QStringList &args)
+{
+    QStringList quoted{"docker"};
+    for (const QString &arg : args)
+        quoted << shellQuote(arg);
+    return quoted.join(' ');
+}
+
+QString ContainerSpec::systemdCommand(const QString &docker) const
+{
+    QStringList quoted{systemdQuote(docker)};
+    for (const QString &arg : runArgs())
+        quoted << systemdQuote(arg);
+    return quoted.join(' ');
+}
+
+QJsonObject ContainerSpec::engineCreateBody() const
+{
+    QJsonObject body = containerConfig(*this);
+    body.insert("Labels", QJsonObject{{HashLabel, hash()}});
+    return body;
+}
+
+ContainerSpec::Plan ContainerSpec::plan(const QJsonObject &inspected, const QString &imageId) const
+{
+    Plan plan;
+    plan.containerId = inspected.value("Id").toString();
+    if (plan.containerId.isEmpty()) {
+        plan.action = Action::Create;
+        plan.reasons << "no container";
+        return plan;
+    }
+
+    const QJsonObject config = inspected.value("Config").toObject();
+    const QJsonObject hostConfig = inspected.value("HostConfig").toObject();
+    const QJsonObject state = inspected.value("State").toObject();
+
+    // The image ID changes when the tag has been moved to a new image
+    if (imageId.isEmpty() || inspected.value("Image").toString() != imageId)
+        plan.reasons << "image";
+
+    // A container created from this spec carries its hash; with the image
+    // unchanged that settles it and only the state below is left to check.
+    // Containers created by older versions have no label and get the diff.
+    const QString label = config.value("Labels").toObject().value(HashLabel).toString();
+    if (plan.reasons.isEmpty() && !label.isEmpty() && label == hash())
+        return planForState(plan, state);
+
+    // The image adds variables of its own; only the spec's have to match.
+    // Values are not logged, some of them are secrets.
+    QHash<QString, QString> actualEnv;
+    for (const QJsonValue &value : config.value("Env").toArray()) {
+        const QString entry = value.toString();
+        actualEnv.insert(entry.section('=', 0, 0), entry.section('=', 1));
+    }
+    for (const auto &entry : env) {
+        const auto it = actualEnv.constFind(entry.first);
+        if (it == actualEnv.constEnd() || it.value() != entry.second)
+            plan.reasons << "env " + entry.first;
+    }
+
+    QSet<QString> actualPorts;
+    const QJsonObject bindings = hostConfig.value("PortBindings").toObject();
+    for (auto it = bindings.begin(); it != bindings.end(); ++it) {
+        const QString containerPort = it.key().section('/', 0, 0);
+        for (const QJsonValue &binding : it.value().toArray())
+            actualPorts.insert(binding.toObject().value("HostPort").toString() + ':' + containerPort);
+    }
+    if (actualPorts != QSet<QString>(ports.begin(), ports.end()))
+        plan.reasons << "ports";
+
+    QSet<QString> actualBinds;
+    for (const QJsonValue &value : hostConfig.value("Binds").toArray())
+        actualBinds.insert(value.toString());
+    if (actualBinds != QSet<QString>(volumes.begin(), volumes.end()))
+        plan.reasons << "mounts";
+
+    if (hostConfig.value("RestartPolicy").toObject().value("Name").toString() != restartPolicy)
+        plan.reasons << "restart policy";
+
+    bool hasGpus = false;
+    for (const QJsonValue &value : hostConfig.value("DeviceRequests").toArray())
+        hasGpus = hasGpus || value.toObject().value("Count").toInt() == -1;
+    if (hasGpus != allGpus)
+        plan.reasons << "gpus";
+
+    return planForState(plan, state);
+}
+
+ContainerSpec::Plan ContainerSpec::planForState(Plan plan, const QJsonObject &state)
+{
+    const QString status = state.value("Status").toString();
+    plan.status = status;
+    if (!plan.reasons.isEmpty() || status == "dead" || status == "removing") {
+        if (plan.reasons.isEmpty())
+            plan.reasons << "container " + status;
+        plan.action = Action::Recreate;
+    } else if (!state.value("Running").toBool()) {
+        plan.action = Action::Start;
+        plan.reasons << "container " + (status.isEmpty() ? QStringLiteral("stopped") : status);
+    } else if (state.value("Health").toObject().value("Status").toString() == "unhealthy"
+               || state.value("Restarting").toBool()) {
+        plan.action = Action::Restart;
+        plan.reasons << "container unhealthy";
+    } else {
+        plan.action = Action::None;
+    }
+    return plan;
+}
+
+QString ContainerSpec::actionName(Action action)
+{
+    switch (action) {
+    case Action::Create: return "create";
+    case Action::Recreate: return "recreate";
+    case Action::Start: return "start";
+    case Action::Restart: return "restart";
+    case Action::None: return "keep";
+    }
+    return QString();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+class StateStore;
+
+// Everything that defines the SafeCore container, resolved once from the
+// cached registration and tenant data. The direct `docker run`, the systemd
+// unit and an Engine API create call are all rendered from the same spec, so
+// they cannot drift apart.
+//
+// hash() covers every field and is stamped on the container as HashLabel.
+// plan() takes a matching label and image ID as proof that the container is
+// up to date, and otherwise compares it with the spec field by field, so a
+// container that already matches is started or restarted instead of being
+// recreated.
+struct ContainerSpec {
+    static const QString HashLabel;
+
+    enum class Action { Create, Recreate, Start, Restart, None };
+
+    struct Plan {
+        Action action = Action::Create;
+        QString containerId;
+        QString status;         // State.Status, e.g. "created" for a never started container
+        QStringList reasons;    // what differs, or why a start/restart is needed
+    };
+
+    QString name;
+    QString image;
+    QString restartPolicy;
+    bool allGpus = true;
+    QStringList ports;      // host:container
+    QStringList volumes;    // source:target
+    QList<QPair<QString, QString>> env;
+
+    // Fills the spec from the cached state. On failure returns false with a
+    // message for the user.
+    static bool resolve(const StateStore& store, const QString& serviceBaseUrl, const QString& accessKey,
+                        ContainerSpec* spec, QString* error);
+
+    QString hash() const;
+
+    // `docker run -d` arguments, one per element, including the hash label
+    QStringList runArgs() const;
+    // `docker create` arguments for the same container
+    QStringList createArgs() const;
+    // `docker <args>` quoted for a POSIX shell
+    static QString shellCommand(const QStringList& args);
+    // `<docker> <runArgs>` quoted for a systemd ExecStart= line
+    QString systemdCommand(const QString& docker) const;
+    // Body for POST /containers/create?name=<name>
+    QJsonObject engineCreateBody() const;
+
+    // `inspected` is one element of `docker inspect <name>`, empty when there
+    // is no such container; `imageId` is the current ID of `image`
+    Plan plan(const QJsonObject& inspected, const QString& imageId) const;
+    static QString actionName(Action action);
+
+private:
+    // Settles `plan` from the container state once the config has been compared
+    static Plan planForState(Plan plan, const QJsonObject& state);
+};
@@ -0,0 +1,181 @@
+#include "dockercleanuppolicy.h"
+#include "dockerscript.h"
+#include "statestore.h"
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QStandardPaths>
+
+namespace {
+QString knownGoodPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore/known_good_images.json";
+}
+
+QString repositoryOf(const QString &image)
+{
+    QString repo = image;
+    const int digestIdx = repo.indexOf('@');
+    if (digestIdx >= 0)
+        repo = repo.left(digestIdx);
+    const int tagIdx = repo.lastIndexOf(':');
+    if (tagIdx > repo.lastIndexOf('/'))
+        repo = repo.left(tagIdx);
+    return repo;
+}
+
+bool belongsToRepository(const QStringList &refs, const QString &repo)
+{
+    for (const QString &ref : refs) {
+        if (ref.startsWith(repo + ":") || ref.startsWith(repo + "@"))
+            return true;
+    }
+    return false;
+}
+} // namespace
+
+DockerCleanupPolicy::DockerCleanupPolicy(QObject *parent)
+    : QObject(parent)
+{
+    loadKnownGood();
+}
+
+void DockerCleanupPolicy::setKeepCount(int count)
+{
+    m_keepCount = qMax(1, count);
+    if (m_knownGood.size() > m_keepCount) {
+        m_knownGood = m_knownGood.mid(0, m_keepCount);
+        saveKnownGood();
+    }
+}
+
+void DockerCleanupPolicy::recordKnownGood(const QString &image)
+{
+    const QString script = QString("docker image inspect -f '{{.Id}}' '%1'\n").arg(image);
+    runDockerScript(script.toUtf8(), [this](bool ok, const QString &output) {
+        const QString id = output.trimmed();
+        if (!ok || !id.startsWith("sha256:"))
+            return;
+        m_knownGood.removeAll(id);
+        m_knownGood.prepend(id);
+        if (m_knownGood.size() > m_keepCount)
+            m_knownGood = m_knownGood.mid(0, m_keepCount);
+        saveKnownGood();
+    });
+}
+
+void DockerCleanupPolicy::cleanupCanceledPull(const QString &image, std::function<void(const Result&)> done)
+{
+    const QString repo = repositoryOf(image);
+    const QString listScript =
+        "ids=$(docker image ls -q --no-trunc | sort -u)\n"
+        "[ -n \"$ids\" ] || exit 0\n"
+        "docker image inspect -f '{{.Id}}|{{.Size}}|{{join .RepoTags \",\"}}|{{join .RepoDigests \",\"}}' $ids\n";
+
+    runDockerScript(listScript.toUtf8(), [this, repo, done](bool ok, const QString &output) {
+        Result result;
+        if (!ok) {
+            result.summary = "Cleanup skipped: unable to list images.";
+            if (done)
+                done(result);
+            return;
+        }
+
+        QHash<QString, qint64> removeSizes;
+        const QStringList lines = output.split('\n', Qt::SkipEmptyParts);
+        for (const QString &line : lines) {
+            const QStringList parts = line.trimmed().split('|');
+            if (parts.size() < 4)
+                continue;
+            const QString id = parts.at(0);
+            const qint64 size = parts.at(1).toLongLong();
+            const QStringList tags = parts.at(2).split(',', Qt::SkipEmptyParts);
+            const QStringList digests = parts.at(3).split(',', Qt::SkipEmptyParts);
+            if (!belongsToRepository(tags + digests, repo))
+                continue;
+            const bool dangling = tags.isEmpty();
+            if (!dangling || m_knownGood.contains(id) || m_pinned.contains(id)) {
+                ++result.kept;
+                result.keptBytes += size;
+                continue;
+            }
+            removeSizes.insert(id, size);
+        }
+
+        if (removeSizes.isEmpty()) {
+            result.ok = true;
+            result.summary = QString("Cleanup: nothing to remove; kept %1 image(s) (%2) and all completed layers.")
+                                 .arg(result.kept)
+                                 .arg(DockerScript::formatBytes(result.keptBytes));
+            if (done)
+                done(result);
+            return;
+        }
+
+        // An image still referenced by a container refuses to go; that is fine,
+        // it simply stays in the kept set.
+        QString removeScript;
+        for (auto it = removeSizes.constBegin(); it != removeSizes.constEnd(); ++it)
+            removeScript += QString("docker image rm '%1' >/dev/null 2>&1 && echo '%1'\n").arg(it.key());
+        removeScript += "exit 0\n";
+
+        runDockerScript(removeScript.toUtf8(), [result, removeSizes, done](bool, const QString &removedOutput) mutable {
+            const QStringList removed = removedOutput.split('\n', Qt::SkipEmptyParts);
+            for (auto it = removeSizes.constBegin(); it != removeSizes.constEnd(); ++it) {
+                if (removed.contains(it.key())) {
+                    ++result.removed;
+                    result.reclaimedBytes += it.value();
+                } else {
+                    ++result.kept;
+                    result.keptBytes += it.value();
+                }
+            }
+            result.ok = true;
+            result.summary = QString("Cleanup: removed %1 dangling image(s), reclaimed up to %2; kept %3 image(s) (%4) and all completed layers.")
+                                 .arg(result.removed)
+                                 .arg(DockerScript::formatBytes(result.reclaimedBytes))
+                                 .arg(result.kept)
+                                 .arg(DockerScript::formatBytes(result.keptBytes));
+            if (done)
+                done(result);
+        });
+    });
+}
+
+void DockerCleanupPolicy::runDockerScript(const QByteArray &script, std::function<void(bool, const QString&)> done)
+{
+    DockerScript::run(this, "docker cleanup", script, [done](bool ok, const QByteArray &output, const QString &) {
+        if (done)
+            done(ok, QString::fromUtf8(output));
+    });
+}
+
+void DockerCleanupPolicy::loadKnownGood()
+{
+    QFile inFile(knownGoodPath());
+    if (!inFile.open(QIODevice::ReadOnly))
+        return;
+    const QJsonDocument doc = QJsonDocument::fromJson(inFile.readAll());
+    if (!doc.isObject())
+        return;
+    const QJsonArray images = doc.object().value("images").toArray();
+    for (const QJsonValue &value : images) {
+        const QString id = value.toString().trimmed();
+        if (!id.isEmpty() && !m_knownGood.contains(id))
+            m_knownGood.append(id);
+    }
+}
+
+void DockerCleanupPolicy::saveKnownGood() const
+{
+    QJsonObject obj;
+    obj.insert("images", QJsonArray::fromStringList(m_knownGood));
+    obj.insert("savedAt", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    QString error;
+    if (!StateStore::writeFile(knownGoodPath(), QJsonDocument(obj).toJson(QJsonDocument::Indented), &error))
+        qWarning().noquote() << "Cannot save known-good images:" << error;
+}
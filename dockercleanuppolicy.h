@@ -0,0 +1,44 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+// Decides what may be removed after a canceled pull. Only dangling images of
+// our own repository are candidates; tagged images and the last few image IDs
+// that ran successfully are kept for rollback, and completed layers are never
+// pruned so a retried pull resumes instead of starting from zero.
+class DockerCleanupPolicy : public QObject
+{
+    Q_OBJECT
+public:
+    struct Result {
+        bool ok = false;
+        int removed = 0;
+        int kept = 0;
+        qint64 reclaimedBytes = 0;
+        qint64 keptBytes = 0;
+        QString summary;
+    };
+
+    explicit DockerCleanupPolicy(QObject* parent = nullptr);
+
+    int keepCount() const { return m_keepCount; }
+    void setKeepCount(int count);
+    QStringList knownGoodImages() const { return m_knownGood; }
+    // Image IDs that must survive cleanup, e.g. a staged upgrade.
+    void setPinnedImages(const QStringList& imageIds) { m_pinned = imageIds; }
+
+    // Remembers the image ID currently behind `image` as known-good.
+    void recordKnownGood(const QString& image);
+    void cleanupCanceledPull(const QString& image, std::function<void(const Result&)> done);
+
+private:
+    void runDockerScript(const QByteArray& script, std::function<void(bool, const QString&)> done);
+    void loadKnownGood();
+    void saveKnownGood() const;
+
+    int m_keepCount = 2;
+    QStringList m_knownGood;
+    QStringList m_pinned;
+};
@@ -0,0 +1,53 @@
+#include "dockerscript.h"
+#include "tracer.h"
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+
+QProcess *DockerScript::run(QObject *owner, const char *traceName, const QByteArray &script, Callback done,
+                            const QString &command)
+{
+    QProcess *process = new QProcess(owner);
+    QPointer<QProcess> guard(process);
+
+    QObject::connect(process, &QProcess::started, owner, [guard, script]() {
+        if (!guard)
+            return;
+        guard->write(script);
+        guard->closeWriteChannel();
+    });
+
+    QObject::connect(process, &QProcess::finished, owner,
+                     [guard, done](int exitCode, QProcess::ExitStatus exitStatus) {
+                         if (!guard)
+                             return;
+                         const QByteArray output = guard->readAllStandardOutput();
+                         const QString errors = QString::fromUtf8(guard->readAllStandardError()).trimmed();
+                         guard->deleteLater();
+                         if (done)
+                             done(exitStatus == QProcess::NormalExit && exitCode == 0, output, errors);
+                     });
+
+    QObject::connect(process, &QProcess::errorOccurred, owner,
+                     [guard, done](QProcess::ProcessError error) {
+                         if (!guard || error != QProcess::FailedToStart)
+                             return;
+                         const QString errors = guard->errorString();
+                         guard->deleteLater();
+                         if (done)
+                             done(false, QByteArray(), errors);
+                     });
+
+    Tracer::traceProcess(process, traceName);
+    process->start("bash", {"-lc", QString("sg docker -c '%1'").arg(command)});
+    return guard && guard->state() != QProcess::NotRunning ? process : nullptr;
+}
+
+QString DockerScript::formatBytes(qint64 bytes)
+{
+    if (bytes >= 1024LL * 1024 * 1024)
+        return QString::number(double(bytes) / (1024.0 * 1024.0 * 1024.0), 'f', 2) + " GB";
+    if (bytes >= 1024LL * 1024)
+        return QString::number(double(bytes) / (1024.0 * 1024.0), 'f', 1) + " MB";
+    return QString::number(bytes / 1024) + " KB";
+}
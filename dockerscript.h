@@ -0,0 +1,28 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+class QObject;
+class QProcess;
+
+// Runs a shell script as a member of the docker group, the way every docker
+// helper of the installer does: `bash -lc "sg docker -c '<command>'"` with
+// the script written to its stdin. The process is a child of `owner` and its
+// signals are bound to it, so `process->disconnect(owner)` drops the
+// callback and deleting the owner stops it from ever being called.
+class DockerScript
+{
+public:
+    // ok is a normal exit with status 0; errors is the trimmed stderr
+    using Callback = std::function<void(bool ok, const QByteArray& output, const QString& errors)>;
+
+    // `command` reads the script from stdin; by default bash runs it.
+    // Returns the running process, for callers that need to stop it, or
+    // nullptr when it failed to start and `done` has already been called.
+    static QProcess* run(QObject* owner, const char* traceName, const QByteArray& script, Callback done,
+                         const QString& command = QStringLiteral("bash -s"));
+
+    // Image, layer and volume sizes as they are logged: KB, MB or GB
+    static QString formatBytes(qint64 bytes);
+};
@@ -1,4 +1,7 @@
 #include "downloadtask.h"
+#include "tracer.h"
+#include "apiclient.h"
+#include "bandwidthscheduler.h"
 #include <QDir>
 #include <QFile>
 #include <QNetworkRequest>
@@ -15,6 +18,19 @@ static bool isDemoUrl(const QUrl& url)
 {
     return url.host() == "example.com";
 }
+
+// Points the artifact downloads at another server, e.g. a local throttled
+// stand-in (scripts/throttled_http_server.py) when testing rate caps.
+static QUrl artifactUrl(const QString& fileName)
+{
+    const QString base = qEnvironmentVariable("SAFECORE_ARTIFACT_BASE_URL", "https://example.com/artifacts");
+    return QUrl(base + "/" + fileName);
+}
+
+// Unread reply data is capped at this size so the socket stops being drained
+// (and TCP flow control slows the sender) while the bandwidth budget is spent.
+static constexpr qint64 ThrottledReadBufferBytes = 64 * 1024;
+static constexpr int DownloadInactivityTimeoutMs = 60000;
 
 DownloadTask::DownloadTask(QObject *parent)
     : QObject(parent)
@@ -49,7 +65,7 @@ void DownloadTask::start()
         const QString tarPath  = QDir(cacheDir).filePath("ai_box_image.tar");
 
         // TODO: replace with your real URL
-        const QUrl url("https://example.com/artifacts/ai_box_image.tar");
+        const QUrl url = artifactUrl("ai_box_image.tar");
         if (isDemoUrl(url)) {
             simulateDemoInstall("Docker image installed (demo). Configure real URL in downloadtask.cpp.");
             return;
@@ -63,7 +79,7 @@ void DownloadTask::start()
         const QString shPath   = QDir(cacheDir).filePath("env_setup.sh");
 
         // TODO: replace with your real URL
-        const QUrl url("https://example.com/artifacts/env_setup.sh");
+        const QUrl url = artifactUrl("env_setup.sh");
         if (isDemoUrl(url)) {
             simulateDemoInstall("Environment installed (demo). Configure real URL in downloadtask.cpp.");
             return;
@@ -77,7 +93,7 @@ void DownloadTask::start()
         const QString modelPath = QDir(modelDir).filePath("model.bin");
 
         // TODO: replace with your real URL
-        const QUrl url("https://example.com/artifacts/model.bin");
+        const QUrl url = artifactUrl("model.bin");
         if (isDemoUrl(url)) {
             simulateDemoInstall("Model downloaded (demo). Configure real URL in downloadtask.cpp.");
             return;
@@ -111,7 +127,18 @@ void DownloadTask::stepDownloadFile(const QUrl &url, const QString &outFile)
     if (m_cancelled) return emitFail("Cancelled.");
 
     QNetworkRequest req(url);
-    m_reply = m_net.get(req);
+    // Artifacts can take many minutes, so an overall deadline does not fit;
+    // a stalled transfer is aborted after a minute without data instead.
+    req.setTransferTimeout(DownloadInactivityTimeoutMs);
+    QNetworkAccessManager *net = &m_net;
+    if (m_api) {
+        m_api->prepare(req);
+        net = m_api->network();
+    }
+    m_downloadClock.start();
+    m_reply = net->get(req);
+    if (m_bandwidth)
+        m_reply->setReadBufferSize(ThrottledReadBufferBytes);
 
     QFile* file = new QFile(outFile);
     if (!file->open(QIODevice::WriteOnly)) {
@@ -121,10 +148,9 @@ void DownloadTask::stepDownloadFile(const QUrl &url, const QString &outFile)
         delete file;
         return emitFail("Cannot write file: " + outFile);
     }
+    m_outFile = file;
 
-    connect(m_reply, &QNetworkReply::readyRead, this, [this, file]() {
-        file->write(m_reply->readAll());
-    });
+    connect(m_reply, &QNetworkReply::readyRead, this, &DownloadTask::drainReply);
 
     connect(m_reply, &QNetworkReply::downloadProgress, this, [this](qint64 rec, qint64 total) {
         if (total <= 0) return;
@@ -133,7 +159,16 @@ void DownloadTask::stepDownloadFile(const QUrl &url, const QString &outFile)
         emit progress(p);
     });
 
-    connect(m_reply, &QNetworkReply::finished, this, [this, file, outFile]() {
+    connect(m_reply, &QNetworkReply::finished, this, [this, file, url, outFile]() {
+        // What is left is already buffered; it no longer costs bandwidth
+        const QByteArray rest = m_reply->readAll();
+        if (m_bandwidth)
+            m_bandwidth->recordTransfer(rest.size());
+        if (m_api)
+            m_api->recordLatency("download/" + url.fileName(), m_downloadClock.elapsed(),
+                                 m_reply->error() == QNetworkReply::NoError);
+        file->write(rest);
+        m_outFile = nullptr;
         file->flush();
         file->close();
         file->deleteLater();
@@ -185,6 +220,35 @@ void DownloadTask::stepDownloadFile(const QUrl &url, const QString &outFile)
     });
 }
 
+void DownloadTask::drainReply()
+{
+    if (!m_reply || !m_outFile)
+        return;
+    if (!m_bandwidth) {
+        m_outFile->write(m_reply->readAll());
+        return;
+    }
+
+    qint64 available = m_reply->bytesAvailable();
+    while (available > 0) {
+        const qint64 granted = m_bandwidth->acquire(available);
+        if (granted <= 0)
+            break;
+        m_outFile->write(m_reply->read(granted));
+        available -= granted;
+    }
+    if (available <= 0 || m_drainScheduled)
+        return;
+
+    // Budget spent: come back when enough tokens have accumulated. readyRead
+    // will not fire again while the buffer is full.
+    m_drainScheduled = true;
+    QTimer::singleShot(m_bandwidth->msUntilAvailable(available), this, [this]() {
+        m_drainScheduled = false;
+        drainReply();
+    });
+}
+
 void DownloadTask::stepRunCommand(const QString &program, const QStringList &args, const QString &workDir)
 {
     if (m_cancelled) return emitFail("Cancelled.");
@@ -233,6 +297,7 @@ void DownloadTask::stepRunCommand(const QString &program, const QStringList &arg
             });
 
     emit progress(0.85);
+    Tracer::traceProcess(m_proc, "download task");
     m_proc->start(program, args);
 }
 
@@ -4,6 +4,11 @@
 #include <QProcess>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QElapsedTimer>
+
+class QFile;
+class ApiClient;
+class BandwidthScheduler;
 
 class DownloadTask : public QObject
 {
@@ -16,6 +21,8 @@ public:
 
     void setMode(Mode m) { m_mode = m; }
     void setInstallPath(const QString& p) { m_installPath = p; }
+    void setBandwidthScheduler(BandwidthScheduler* scheduler) { m_bandwidth = scheduler; }
+    void setApiClient(ApiClient* client) { m_api = client; }
 
     void start();
     void cancel();
@@ -29,6 +36,7 @@ private:
     void emitOk(const QString& msg);
 
     void stepDownloadFile(const QUrl& url, const QString& outFile);
+    void drainReply();
     void stepRunCommand(const QString& program, const QStringList& args, const QString& workDir = QString());
     void simulateDemoInstall(const QString& successMessage);
 
@@ -39,7 +47,12 @@ private:
     bool m_cancelled = false;
 
     QNetworkAccessManager m_net;
+    ApiClient* m_api = nullptr;
     QNetworkReply* m_reply = nullptr;
+    QElapsedTimer m_downloadClock;
+    QFile* m_outFile = nullptr;
+    BandwidthScheduler* m_bandwidth = nullptr;
+    bool m_drainScheduled = false;
 
     QProcess* m_proc = nullptr;
 };
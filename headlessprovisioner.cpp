@@ -0,0 +1,231 @@
+#include "headlessprovisioner.h"
+#include "appcontroller.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <cstdio>
+
+namespace {
+// Seconds; generous enough for a slow link, short enough that a hung step
+// does not keep a fleet script waiting forever
+int defaultStepTimeoutSec(const QString &step)
+{
+    if (step == "prereqs")
+        return 1800;
+    if (step == "pull")
+        return 7200;
+    if (step == "run")
+        return 600;
+    return 300;
+}
+} // namespace
+
+HeadlessProvisioner::HeadlessProvisioner(AppController *controller, QObject *parent)
+    : QObject(parent)
+    , m_controller(controller)
+{
+    m_out.open(stdout, QIODevice::WriteOnly);
+    m_stepTimer.setSingleShot(true);
+    connect(&m_stepTimer, &QTimer::timeout, this, &HeadlessProvisioner::stepTimedOut);
+
+    connect(m_controller, &AppController::provisioningStep, this,
+            [this](const QString &step, bool ok, const QString &message, qint64 elapsedMs) {
+                QJsonObject fields;
+                fields.insert("step", step);
+                fields.insert("ok", ok);
+                fields.insert("message", message);
+                fields.insert("elapsedMs", double(elapsedMs));
+                writeEvent("step", fields);
+            });
+    connect(m_controller, &AppController::provisioningFinished, this,
+            [this](bool ok, const QString &message, qint64) {
+                if (m_step == "provision")
+                    finishStep(m_step, ok, message);
+            });
+    connect(m_controller, &AppController::installPrereqsRunningChanged, this, [this]() {
+        if (m_step == "prereqs" && !m_controller->installPrereqsRunning())
+            finishStep(m_step, m_controller->installPrereqsDone(),
+                       m_controller->installPrereqsDone() ? "Prerequisites installed." : "Install prerequisites failed.");
+    });
+    connect(m_controller, &AppController::dockerPullProgressChanged, this, [this]() {
+        if (m_step != "pull")
+            return;
+        const int percent = int(m_controller->dockerPullProgress() * 100.0);
+        if (percent == m_lastPercent)
+            return;
+        m_lastPercent = percent;
+        QJsonObject fields;
+        fields.insert("step", m_step);
+        fields.insert("percent", percent);
+        writeEvent("progress", fields);
+    });
+    connect(m_controller, &AppController::dockerPullFinished, this, [this](bool ok, const QString &message) {
+        if (m_step == "pull")
+            finishStep(m_step, ok, message);
+    });
+    connect(m_controller, &AppController::dockerOpsFinished, this, [this](bool ok, const QString &message) {
+        if (m_step == "run")
+            finishStep(m_step, ok, message);
+    });
+}
+
+bool HeadlessProvisioner::loadConfig(const QString &path)
+{
+    m_clock.start();
+    QFile inFile(path);
+    if (!inFile.open(QIODevice::ReadOnly)) {
+        finish(false, "Cannot read provisioning file: " + path);
+        return false;
+    }
+    QJsonParseError parseError{};
+    const QJsonDocument doc = QJsonDocument::fromJson(inFile.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        finish(false, "Invalid provisioning file: " + parseError.errorString());
+        return false;
+    }
+    m_config = doc.object();
+
+    if (m_config.value("tenantId").toString().trimmed().isEmpty()) {
+        finish(false, "tenantId is required.");
+        return false;
+    }
+    if (m_config.value("vertical").toString().trimmed().isEmpty()) {
+        finish(false, "vertical is required.");
+        return false;
+    }
+
+    m_steps = QStringList{"provision"};
+    if (m_config.value("installPrereqs").toBool(false))
+        m_steps << "prereqs";
+    if (m_config.value("pull").toBool(true))
+        m_steps << "pull";
+    if (m_config.value("run").toBool(true))
+        m_steps << "run";
+    if (m_config.value("installService").toBool(true))
+        m_steps << "service";
+    return true;
+}
+
+void HeadlessProvisioner::start()
+{
+    m_clock.start();
+
+    const QString baseUrl = m_config.value("serviceBaseUrl").toString().trimmed();
+    if (!baseUrl.isEmpty())
+        m_controller->setServiceBaseUrl(baseUrl);
+    const QString relayUrl = m_config.value("relayUrl").toString().trimmed();
+    if (!relayUrl.isEmpty())
+        m_controller->setRelayUrl(relayUrl);
+    m_controller->setTenantId(m_config.value("tenantId").toString().trimmed());
+    const QString macId = m_config.value("macId").toString().trimmed();
+    if (macId.isEmpty() || macId.compare("auto", Qt::CaseInsensitive) == 0)
+        m_controller->populateMacId();
+    else
+        m_controller->setMacId(macId);
+
+    QJsonObject fields;
+    fields.insert("macId", m_controller->macId());
+    fields.insert("tenantId", m_controller->tenantId());
+    fields.insert("steps", QJsonArray::fromStringList(m_steps));
+    writeEvent("start", fields);
+    nextStep();
+}
+
+void HeadlessProvisioner::abort()
+{
+    if (m_done)
+        return;
+    if (m_step == "pull")
+        m_controller->cancelDockerPull();
+    finish(false, "Interrupted.");
+}
+
+void HeadlessProvisioner::nextStep()
+{
+    if (m_done)
+        return;
+    if (m_steps.isEmpty()) {
+        finish(true, QString("Provisioning completed in %1 ms.").arg(m_clock.elapsed()));
+        return;
+    }
+
+    m_step = m_steps.takeFirst();
+    m_stepClock.start();
+    m_lastPercent = -1;
+    QJsonObject fields;
+    fields.insert("step", m_step);
+    writeEvent("begin", fields);
+    m_stepTimer.start(stepTimeoutSec(m_step) * 1000);
+
+    if (m_step == "provision") {
+        m_controller->provision(m_config.value("vertical").toString());
+    } else if (m_step == "prereqs") {
+        m_controller->startInstallPrereqs();
+    } else if (m_step == "pull") {
+        m_controller->pullDockerImage();
+    } else if (m_step == "run") {
+        m_controller->runDockerOps();
+    } else if (m_step == "service") {
+        const bool ok = m_controller->installDockerService(m_config.value("startService").toBool(true));
+        finishStep(m_step, ok, ok ? "Service installed." : m_controller->statusText());
+    }
+}
+
+void HeadlessProvisioner::finishStep(const QString &step, bool ok, const QString &message)
+{
+    if (m_done || step != m_step)
+        return;
+    m_stepTimer.stop();
+    QJsonObject fields;
+    fields.insert("step", step);
+    fields.insert("ok", ok);
+    fields.insert("message", message);
+    fields.insert("elapsedMs", double(m_stepClock.elapsed()));
+    writeEvent("end", fields);
+    m_step.clear();
+
+    if (!ok) {
+        finish(false, message);
+        return;
+    }
+    // Let the controller finish its own bookkeeping for this step first
+    QMetaObject::invokeMethod(this, &HeadlessProvisioner::nextStep, Qt::QueuedConnection);
+}
+
+void HeadlessProvisioner::stepTimedOut()
+{
+    if (m_done || m_step.isEmpty())
+        return;
+    if (m_step == "pull")
+        m_controller->cancelDockerPull();
+    finishStep(m_step, false, QString("Step %1 timed out after %2 s.").arg(m_step).arg(stepTimeoutSec(m_step)));
+}
+
+int HeadlessProvisioner::stepTimeoutSec(const QString &step) const
+{
+    const int configured = m_config.value("timeouts").toObject().value(step).toInt(0);
+    return configured > 0 ? qMin(configured, 7 * 24 * 3600) : defaultStepTimeoutSec(step);
+}
+
+void HeadlessProvisioner::finish(bool ok, const QString &message)
+{
+    if (m_done)
+        return;
+    m_done = true;
+    m_stepTimer.stop();
+    QJsonObject fields;
+    fields.insert("ok", ok);
+    fields.insert("message", message);
+    fields.insert("elapsedMs", double(m_clock.elapsed()));
+    writeEvent("done", fields);
+    emit finished(ok ? 0 : 1);
+}
+
+void HeadlessProvisioner::writeEvent(const QString &event, QJsonObject fields)
+{
+    fields.insert("event", event);
+    fields.insert("time", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+    m_out.write(QJsonDocument(fields).toJson(QJsonDocument::Compact) + '\n');
+    m_out.flush();
+}
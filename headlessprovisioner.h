@@ -0,0 +1,67 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+
+class AppController;
+
+// Drives AppController through a full provisioning run without the QML
+// front end: register, sync relay, fetch tenant data, optionally install the
+// prerequisites, pull the image, start the container and install the systemd
+// service. Settings come from a JSON file, for example
+//
+//   {
+//     "serviceBaseUrl": "https://admin.example.com",
+//     "macId": "auto",
+//     "tenantId": "8c1d2f0e-0000-4000-8000-000000000000",
+//     "relayUrl": "https://relay.example.com",
+//     "vertical": "Retail",
+//     "installPrereqs": false,
+//     "pull": true,
+//     "run": true,
+//     "installService": true,
+//     "startService": true,
+//     "timeouts": { "pull": 3600 }
+//   }
+//
+// Every step has a deadline in seconds, and "timeouts" overrides the
+// defaults per step; a step that runs past it fails the run. Progress is
+// written to stdout as one JSON object per line, so a fleet script can
+// follow it with jq or any line reader.
+class HeadlessProvisioner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HeadlessProvisioner(AppController* controller, QObject* parent = nullptr);
+
+    // Reports a "done" failure event itself when the file is unusable.
+    bool loadConfig(const QString& path);
+    void start();
+    void abort();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    void nextStep();
+    void finishStep(const QString& step, bool ok, const QString& message);
+    void stepTimedOut();
+    int stepTimeoutSec(const QString& step) const;
+    void finish(bool ok, const QString& message);
+    void writeEvent(const QString& event, QJsonObject fields = QJsonObject());
+
+    AppController* m_controller = nullptr;
+    QJsonObject m_config;
+    QStringList m_steps;
+    QString m_step;
+    QElapsedTimer m_clock;
+    QElapsedTimer m_stepClock;
+    QTimer m_stepTimer;
+    int m_lastPercent = -1;
+    bool m_done = false;
+    QFile m_out;
+};
@@ -2,19 +2,29 @@
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QIcon>
+#include <QJsonDocument>
+#include <QQuickWindow>
+#include <QTimer>
 #include <QSocketNotifier>
-#include <QLocalServer>
-#include <QLocalSocket>
 #include <QWindow>
+#include <QStandardPaths>
 #include <QString>
 #include <csignal>
+#include <cstdio>
+#include <memory>
 #include <unistd.h>
 #include "appcontroller.h"
 #include "appconstants.h"
+#include "headlessprovisioner.h"
+#include "batchregistrar.h"
+#include "tracer.h"
+#include "metricsserver.h"
+#include "startupprofile.h"
+#include "singleinstance.h"
 
 namespace {
 int sigintFd[2];
-const QString SOCKET_NAME = "SafeCoreInstallerInstance";
+const QString INSTANCE_KEY = "SafeCoreInstaller";
 
 void signalHandler(int)
 {
@@ -22,6 +32,146 @@ void signalHandler(int)
     ::write(sigintFd[0], &ch, sizeof(ch));
 }
 
+bool installSignalPipe()
+{
+    if (::pipe(sigintFd) != 0)
+        return false;
+    struct sigaction sa {};
+    sa.sa_handler = signalHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    return true;
+}
+
+// `--headless <file>` provisions from a JSON file with no QML engine and no
+// display connection; progress goes to stdout as JSON lines.
+QString headlessConfigPath(int argc, char *argv[], bool *headless)
+{
+    *headless = false;
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "--headless") {
+            *headless = true;
+            return i + 1 < argc ? QString::fromLocal8Bit(argv[i + 1]) : QString();
+        }
+        if (arg.startsWith("--headless=")) {
+            *headless = true;
+            return arg.mid(int(qstrlen("--headless=")));
+        }
+    }
+    return QString();
+}
+
+int runHeadless(int argc, char *argv[], const QString &configPath)
+{
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName("SafeCore");
+    app.setApplicationName("SafeCore");
+
+    AppController controller;
+    HeadlessProvisioner provisioner(&controller);
+    if (!provisioner.loadConfig(configPath))
+        return 2;
+    QObject::connect(&provisioner, &HeadlessProvisioner::finished, &app, [](int exitCode) {
+        QCoreApplication::exit(exitCode);
+    });
+
+    if (installSignalPipe()) {
+        auto *notifier = new QSocketNotifier(sigintFd[1], QSocketNotifier::Read, &app);
+        QObject::connect(notifier, &QSocketNotifier::activated, &app, [&provisioner](int) {
+            char tmp;
+            ::read(sigintFd[1], &tmp, sizeof(tmp));
+            provisioner.abort();
+        });
+    }
+
+    QMetaObject::invokeMethod(&provisioner, &HeadlessProvisioner::start, Qt::QueuedConnection);
+    return app.exec();
+}
+
+// `--trace <file>` writes the Chrome trace of the whole run on exit, in any
+// mode. Recording itself is always on unless SAFECORE_TRACE=0.
+QString traceOutputPath(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "--trace")
+            return i + 1 < argc ? QString::fromLocal8Bit(argv[i + 1]) : QString();
+        if (arg.startsWith("--trace="))
+            return arg.mid(int(qstrlen("--trace=")));
+    }
+    return QString();
+}
+
+// Declared first in main() so it runs after everything else has shut down
+struct TraceExport {
+    QString path;
+    ~TraceExport()
+    {
+        QString error;
+        if (!path.isEmpty() && !Tracer::writeChromeTrace(path, &error))
+            qWarning().noquote() << "Could not write trace" << path << ":" << error;
+    }
+};
+
+// `--startup-report` prints the startup phases as one `startup-report <json>`
+// line once the first frame is up and the initial docker inspect is back, or
+// after StartupReportTimeoutMs with whatever was reached. With
+// `--exit-after-first-frame` the first frame is printed as `first-frame <ms>`
+// and the app quits after the report; tools/safecore_startup_bench drives both.
+constexpr int StartupReportTimeoutMs = 10000;
+
+void printStartupReport()
+{
+    const QByteArray json = QJsonDocument(StartupProfile::report()).toJson(QJsonDocument::Compact);
+    std::printf("startup-report %s\n", json.constData());
+    std::fflush(stdout);
+}
+
+void watchStartup(QQmlApplicationEngine *engine, bool report, bool exitAfterFrame)
+{
+    const auto rootObjects = engine->rootObjects();
+    QQuickWindow *window = rootObjects.isEmpty() ? nullptr : qobject_cast<QQuickWindow*>(rootObjects.first());
+    if (!window) {
+        if (exitAfterFrame)
+            QCoreApplication::exit(1);
+        return;
+    }
+    // Emitted on the render thread; queued so the mark is taken on this one,
+    // and frames already queued are skipped
+    auto frameConnection = std::make_shared<QMetaObject::Connection>();
+    *frameConnection = QObject::connect(window, &QQuickWindow::frameSwapped, qApp, [frameConnection, exitAfterFrame]() {
+        if (StartupProfile::has("first-frame"))
+            return;
+        QObject::disconnect(*frameConnection);
+        StartupProfile::mark("first-frame");
+        if (exitAfterFrame) {
+            std::printf("first-frame %.3f\n", StartupProfile::elapsedMs("first-frame"));
+            std::fflush(stdout);
+        }
+    }, Qt::QueuedConnection);
+
+    if (!report && !exitAfterFrame)
+        return;
+    auto done = std::make_shared<bool>(false);
+    auto finish = [done, report, exitAfterFrame]() {
+        if (*done)
+            return;
+        *done = true;
+        if (report)
+            printStartupReport();
+        if (exitAfterFrame)
+            QCoreApplication::exit(0);
+    };
+    if (report)
+        StartupProfile::whenMarked({"first-frame", "docker-inspect"}, finish);
+    else
+        StartupProfile::whenMarked({"first-frame"}, finish);
+    QTimer::singleShot(StartupReportTimeoutMs, qApp, finish);
+}
+
 // Bring window to front
 void raiseWindow(QQmlApplicationEngine* engine)
 {
@@ -37,10 +187,76 @@ void raiseWindow(QQmlApplicationEngine* engine)
         }
     }
 }
+
+// `--register-batch <csv> [--concurrency N] [--rate PER_SEC] [--out DIR]
+// [--service-url URL]` registers every device in the CSV and exits.
+int runBatchRegistration(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName("SafeCore");
+    app.setApplicationName("SafeCore");
+
+    QString csvPath;
+    QString outputDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore/batch";
+    QString serviceUrl = qEnvironmentVariable("SAFECORE_SERVICE_BASE_URL", AppConstants::ServiceBaseUrl);
+    int concurrency = 8;
+    double rate = 0.0;
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        const QString value = args.value(i + 1);
+        if (args.at(i) == "--register-batch") {
+            csvPath = value;
+            ++i;
+        } else if (args.at(i) == "--concurrency") {
+            concurrency = value.toInt();
+            ++i;
+        } else if (args.at(i) == "--rate") {
+            rate = value.toDouble();
+            ++i;
+        } else if (args.at(i) == "--out") {
+            outputDir = value;
+            ++i;
+        } else if (args.at(i) == "--service-url") {
+            serviceUrl = value;
+            ++i;
+        }
+    }
+
+    QVector<BatchRegistrar::Device> devices;
+    QString error;
+    if (csvPath.isEmpty() || !BatchRegistrar::readCsv(csvPath, &devices, &error)) {
+        qCritical().noquote() << (csvPath.isEmpty() ? QString("--register-batch needs a CSV file.") : error);
+        return 2;
+    }
+
+    BatchRegistrar registrar;
+    registrar.setServiceBaseUrl(serviceUrl);
+    registrar.setAccessKey(AppConstants::TenantAccessKey);
+    registrar.setOutputDir(outputDir);
+    registrar.setMaxInFlight(concurrency);
+    registrar.setRatePerSecond(rate);
+    QObject::connect(&registrar, &BatchRegistrar::finished, &app, [](int failures) {
+        QCoreApplication::exit(failures == 0 ? 0 : 1);
+    });
+    QMetaObject::invokeMethod(&registrar, [&registrar, devices]() { registrar.start(devices); }, Qt::QueuedConnection);
+    return app.exec();
+}
 }
 
 int main(int argc, char *argv[])
 {
+    StartupProfile::start();
+    const TraceExport traceExport{traceOutputPath(argc, argv)};
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--register-batch") == 0)
+            return runBatchRegistration(argc, argv);
+    }
+
+    bool headless = false;
+    const QString headlessConfig = headlessConfigPath(argc, argv, &headless);
+    if (headless)
+        return runHeadless(argc, argv, headlessConfig);
+
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 #endif
@@ -49,35 +265,40 @@ int main(int argc, char *argv[])
     if (qEnvironmentVariableIsEmpty("QT_QUICK_CONTROLS_STYLE"))
         qputenv("QT_QUICK_CONTROLS_STYLE", "Basic");
     QGuiApplication app(argc, argv);
+    StartupProfile::mark("application");
 
     app.setOrganizationName("SafeCore");
     app.setApplicationName("SafeCore");
     QGuiApplication::setDesktopFileName("safespace-global");
     app.setWindowIcon(QIcon("qrc:/images/launch/Safespace.png"));
 
-    // Single instance check - try to connect to existing instance
-    {
-        QLocalSocket socket;
-        socket.connectToServer(SOCKET_NAME);
-        if (socket.waitForConnected(500)) {
-            // Another instance exists - send activate signal and exit
-            socket.write("activate");
-            socket.waitForBytesWritten(1000);
-            socket.disconnectFromServer();
-            qInfo() << "SafeCore is already running. Activating existing window.";
-            return 0;
-        }
+    // A second launch hands its command line to the running instance
+    SingleInstance instance(INSTANCE_KEY);
+    switch (instance.claim(app.arguments().mid(1))) {
+    case SingleInstance::Primary:
+        break;
+    case SingleInstance::Forwarded:
+        qInfo() << "SafeCore is already running. Passed the launch on to it.";
+        return 0;
+    case SingleInstance::Unreachable:
+        qWarning() << "SafeCore is already running but does not answer.";
+        return 1;
     }
-
-    // Remove stale socket file if exists
-    QLocalServer::removeServer(SOCKET_NAME);
+    StartupProfile::mark("instance-probe");
 
     bool dockerOpsMode = false;
     bool forceInstaller = false;
     bool resetState = false;
     bool autoRunDockerOps = false;
+    bool exitAfterFrame = false;
+    bool startupReport = false;
+    int metricsPort = 0;
     for (int i = 1; i < argc; ++i) {
         const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "--metrics-port" && i + 1 < argc) {
+            metricsPort = QString::fromLocal8Bit(argv[++i]).toInt();
+            continue;
+        }
         if (arg == "--docker-ops") {
             dockerOpsMode = true;
             continue;
@@ -92,11 +313,19 @@ int main(int argc, char *argv[])
         if (arg == "--auto-run") {
             autoRunDockerOps = true;
         }
+        if (arg == "--exit-after-first-frame") {
+            exitAfterFrame = true;
+        }
+        if (arg == "--startup-report") {
+            startupReport = true;
+        }
     }
     AppController controller;
+    StartupProfile::mark("controller");
     if (resetState)
         controller.resetLocalState();
     controller.setDockerOpsAutoRun(autoRunDockerOps);
+    controller.startUpgradeAgent();
     QQmlApplicationEngine engine;
     AppConstantsProvider appConstants;
     engine.rootContext()->setContextProperty("AppConstants", &appConstants);
@@ -107,7 +336,12 @@ int main(int argc, char *argv[])
         dockerOpsMode = true;
     if (dockerOpsMode)
         app.setApplicationName("SafeCore");
-    const char *qmlPath = dockerOpsMode ? "qrc:/safecore_ops.qml" : "qrc:/main.qml";
+
+    // `--metrics-port N` serves Prometheus metrics on localhost in ops mode
+    MetricsServer metricsServer;
+    if (dockerOpsMode && metricsPort > 0 && !metricsServer.listen(QHostAddress::LocalHost, quint16(metricsPort)))
+        qWarning().noquote() << "Metrics endpoint disabled:" << metricsServer.errorString();
+    const char *qmlPath = dockerOpsMode ? "qrc:/qt/qml/SafeCore/safecore_ops.qml" : "qrc:/qt/qml/SafeCore/main.qml";
     const QUrl url(QString::fromLatin1(qmlPath));
     QObject::connect(
         &engine,
@@ -119,14 +353,7 @@ int main(int argc, char *argv[])
         },
         Qt::QueuedConnection);
 
-    if (::pipe(sigintFd) == 0) {
-        struct sigaction sa {};
-        sa.sa_handler = signalHandler;
-        sigemptyset(&sa.sa_mask);
-        sa.sa_flags = SA_RESTART;
-        sigaction(SIGINT, &sa, nullptr);
-        sigaction(SIGTERM, &sa, nullptr);
-
+    if (installSignalPipe()) {
         QSocketNotifier notifier(sigintFd[1], QSocketNotifier::Read);
         QObject::connect(&notifier, &QSocketNotifier::activated, &app, [&](int) {
             char tmp;
@@ -135,24 +362,40 @@ int main(int argc, char *argv[])
         });
     }
 
-    engine.load(url);
-
-    // Start local server for single instance detection
-    QLocalServer localServer;
-    if (localServer.listen(SOCKET_NAME)) {
-        QObject::connect(&localServer, &QLocalServer::newConnection, [&]() {
-            QLocalSocket* clientSocket = localServer.nextPendingConnection();
-            if (clientSocket) {
-                clientSocket->waitForReadyRead(1000);
-                QByteArray message = clientSocket->readAll();
-                if (message == "activate") {
-                    raiseWindow(&engine);
-                }
-                clientSocket->disconnectFromServer();
-                clientSocket->deleteLater();
-            }
-        });
+    {
+        TraceSpan span("startup", "load QML");
+        engine.load(url);
     }
+    StartupProfile::mark("qml-load");
+    watchStartup(&engine, startupReport, exitAfterFrame);
+
+    // The ops app started by the installer has to become the running
+    // instance itself instead of handing over to the installer that is quitting
+    QObject::connect(&controller, &AppController::dockerOpsAppLaunching, &instance, &SingleInstance::release);
+    QObject::connect(&instance, &SingleInstance::argumentsReceived, &app,
+                     [&](const QStringList &arguments, qint64 latencyMs) {
+        qInfo().noquote() << "Launch passed on after" << latencyMs << "ms:" << arguments.join(' ');
+        if (arguments.contains("--auto-run"))
+            controller.setDockerOpsAutoRun(true);
+        if (arguments.contains("--docker-ops") && !dockerOpsMode && controller.setupComplete()) {
+            // Setup is done, so the installer window gives way to the ops one;
+            // the ops window picks up --auto-run itself when it is created
+            const auto installerWindows = engine.rootObjects();
+            dockerOpsMode = true;
+            engine.load(QUrl(QStringLiteral("qrc:/qt/qml/SafeCore/safecore_ops.qml")));
+            for (QObject *obj : installerWindows) {
+                obj->setProperty("allowClose", true);
+                if (QWindow *window = qobject_cast<QWindow*>(obj))
+                    window->close();
+                obj->deleteLater();
+            }
+            return;
+        }
+        if (dockerOpsMode && arguments.contains("--auto-run") && !controller.dockerOpsRunning()
+            && !controller.dockerOpsStarting())
+            controller.runDockerOps();
+        raiseWindow(&engine);
+    });
 
     return app.exec();
 }
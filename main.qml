@@ -53,11 +53,17 @@ Window {
     property bool devSyncSuccess: false
     property bool devFinishStart: false
     property bool runDockerAndQuit: false
+    // Mirrors of controls on pages that are created on demand
+    property string selectedVertical: "SNL"
+    property bool launchAfterInstall: true
+    // Set by the first frame; the other wizard pages are preloaded after it
+    property bool firstFrameShown: false
+    property string provisioningText: "Registering..."
     property string tipText: {
         if (AppController.currentStep === 0)
             return "Review the steps and click Next when you're ready.";
         if (AppController.currentStep === 1)
-            return "Use valid MAC/Tenant IDs, then sync the relay URL.";
+            return "Use valid MAC/Tenant IDs and relay URL, then click Register.";
         if (AppController.currentStep === 2)
             return "Run Docker install, then fetch env variables and models.";
         if (AppController.currentStep === 3)
@@ -77,12 +83,154 @@ Window {
         }
         if (devFinishStart)
             AppController.forceStep(3)
+        if (!devInstallStart && !devSyncSuccess && !devTenantStart && !devFinishStart)
+            resumeInstall()
     }
+
+    // The controller restores the step and completed sub-steps from the last
+    // run; mirror the ones this page tracks and pick up an interrupted pull
+    function resumeInstall() {
+        if (AppController.relaySynced) {
+            rightStack.syncSuccess = true
+            rightStack.syncMessage = "Sync API registration completed successfully."
+        }
+        if (AppController.dockerPullOk) {
+            installState.installDone = true
+            installState.progress = 1.0
+            installState.statusText = "Docker image pulled successfully."
+            root.installationComplete = true
+        } else if (AppController.pullInterrupted) {
+            installState.reset()
+            installState.showLogs = true
+            installState.statusText = "Resuming the interrupted pull..."
+            installState.awaitingAuth = true
+            AppController.resumeDockerPull()
+        }
+    }
+
+    // Install progress for the footer buttons and the install page; it lives
+    // here because the page itself is only created when first needed
+    QtObject {
+        id: installState
+        property bool started: false
+        property bool installDone: false
+        property bool awaitingAuth: false
+        property bool showLogs: false
+        property bool useLogProgress: false
+        property bool cancelPending: false
+        property bool installFailed: false
+        property int elapsedMs: 0
+        property int progressWindowMs: 180000
+        property real maxProgress: 0.95
+        property real progress: 0.0
+        property string statusText: "Ready to Install."
+        property string pullErrorMessage: ""
+
+        function reset() {
+            elapsedMs = 0;
+            progress = 0.0;
+            statusText = "Ready to Install.";
+            installDone = false;
+            started = false;
+            awaitingAuth = false;
+            installFailed = false;
+            showLogs = false;
+            useLogProgress = false;
+            cancelPending = false;
+            pullErrorMessage = "";
+            root.installationComplete = false;
+        }
+    }
+
+    Timer {
+        id: installTimer
+        interval: 100
+        repeat: true
+        onTriggered: {
+            if (installState.useLogProgress)
+                return;
+            installState.elapsedMs = Math.min(installState.progressWindowMs, installState.elapsedMs + interval);
+            var t = installState.elapsedMs / 45000.0;
+            var eased = installState.maxProgress * (1 - Math.exp(-t));
+            installState.progress = Math.min(installState.maxProgress, eased);
+            installState.statusText = "Pulling Docker image...";
+        }
+    }
+
+    Connections {
+        target: AppController
+        function onCurrentStepChanged() {
+            if (AppController.currentStep !== 2) {
+                installTimer.stop();
+            }
+        }
+        function onDockerPullStarted() {
+            if (installState.awaitingAuth) {
+                installState.awaitingAuth = false
+                installState.started = true
+                installState.statusText = "Pulling Docker image..."
+                installState.useLogProgress = true
+                installState.cancelPending = false
+                installState.pullErrorMessage = ""
+                installTimer.start()
+            }
+        }
+        function onDockerPullProgressChanged() {
+            if (AppController.dockerPullProgress > 0) {
+                installState.useLogProgress = true
+                installState.progress = AppController.dockerPullProgress
+            }
+        }
+        function onDockerPullFinished(ok, message) {
+            if (installState.cancelPending) {
+                installTimer.stop()
+                AppController.clearDockerPullLog()
+                installState.reset()
+                installState.statusText = "Ready to Pull."
+                return
+            }
+            installTimer.stop()
+            installState.awaitingAuth = false
+            installState.started = false
+            installState.progress = ok ? 1.0 : installState.progress
+            installState.statusText = ok ? message : "Failed to pull docker image."
+            installState.installDone = ok
+            installState.pullErrorMessage = ok ? "" : message
+            root.installationComplete = ok
+        }
+        function onInstallPrereqsRunningChanged() {
+            if (AppController.installPrereqsRunning) {
+                installState.showLogs = true
+                installState.installFailed = false
+                installState.statusText = "Installing Docker and NVIDIA Container Toolkit..."
+            } else if (!AppController.installPrereqsDone && !installState.started) {
+                // Install finished but not done = failed
+                installState.installFailed = true
+                installState.showLogs = true  // Keep logs visible to show error
+                installState.statusText = "Installation failed. Check the log for details."
+            }
+        }
+        function onInstallPrereqsDoneChanged() {
+            if (AppController.installPrereqsDone) {
+                installState.installFailed = false
+                installState.statusText = "Ready to Pull."
+            }
+        }
+    }
+
+    Connections {
+        target: root
+        enabled: !root.firstFrameShown
+        function onFrameSwapped() {
+            root.firstFrameShown = true
+        }
+    }
+
     onClosing: function(close) {
         if (allowClose)
             return;
         close.accepted = false;
-        quitDialog.open();
+        quitDialogLoader.open();
     }
 
     // background gradient
@@ -341,32 +489,12 @@ Window {
                                 visible: AppController.currentStep === 1 || AppController.currentStep === 2
 
                                 AppButton {
-                                    text: "Register"
-                                    visible: AppController.currentStep === 1
-                                    enabled: !AppController.busy && !AppController.keyValid
-                                    loading: AppController.busy && AppController.currentStep === 1 && !AppController.keyValid
-                                    loadingText: "Registering..."
-                                    onClicked: AppController.validateKey()
-                                    accent: root.accent
-                                    implicitHeight: 44
-                                }
-                                AppButton {
-                                    text: "Sync Device"
-                                    visible: AppController.currentStep === 1
-                                    enabled: AppController.keyValid && !AppController.syncBusy && !rightStack.syncSuccess
-                                    loading: AppController.syncBusy
-                                    loadingText: "Syncing..."
-                                    onClicked: AppController.syncRelay()
-                                    accent: root.accent
-                                    implicitHeight: 44
-                                }
-                                AppButton {
-                                    text: "Setup Tenant"
+                                    text: AppController.tenantSuccess ? "Registered" : "Register"
                                     visible: AppController.currentStep === 1
-                                    enabled: rightStack.syncSuccess && !AppController.tenantBusy && !AppController.tenantSuccess
-                                    loading: AppController.tenantBusy
-                                    loadingText: "Setting up..."
-                                    onClicked: AppController.fetchTenantData(tenantSelect.currentText)
+                                    enabled: !AppController.provisioning && !AppController.busy && !AppController.tenantSuccess
+                                    loading: AppController.provisioning
+                                    loadingText: root.provisioningText
+                                    onClicked: AppController.provision(root.selectedVertical)
                                     accent: root.accent
                                     implicitHeight: 44
                                 }
@@ -406,7 +534,7 @@ Window {
                                     text: "Cancel"
                                     visible: AppController.currentStep === 2
                                     enabled: AppController.dockerPullActive
-                                    onClicked: cancelDialog.open()
+                                    onClicked: cancelDialogLoader.open()
                                     accent: root.accentError
                                     implicitHeight: 44
                                 }
@@ -424,7 +552,7 @@ Window {
                                     if (AppController.currentStep === 2)
                                         return installState.installDone;
                                     if (AppController.currentStep === 3)
-                                        return launchCheck.checked;
+                                        return root.launchAfterInstall;
                                     return true;
                                 }
                                 onClicked: {
@@ -432,16 +560,11 @@ Window {
                                         // Skip service installation - Docker's --restart unless-stopped
                                         // combined with systemctl enable docker handles auto-start on boot
 
-                                        if (launchCheck.checked) {
+                                        if (root.launchAfterInstall) {
+                                            // Quits from onDockerOpsAppLaunched, which waits
+                                            // for a container pre-create still in flight
                                             console.log("Launching Docker Ops app with auto-run...")
-                                            const ok = AppController.launchDockerOpsApp(true)
-                                            if (ok) {
-                                                console.log("Docker Ops launched, closing installer")
-                                                root.allowClose = true
-                                                Qt.quit()
-                                            } else {
-                                                console.log("Failed to launch Docker Ops:", AppController.status)
-                                            }
+                                            AppController.launchDockerOpsApp(true)
                                             return
                                         }
                                         console.log("Checkbox not checked, just quitting")
@@ -598,957 +721,902 @@ Window {
                         }
 
                         // Registration
-                        Flickable {
-                            id: registrationScroll
-                            Layout.fillWidth: true
-                            Layout.fillHeight: true
-                            clip: true
-                            contentWidth: width
-                            contentHeight: registrationContent.implicitHeight
-                            boundsBehavior: Flickable.StopAtBounds
-
-                            ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
-                            property bool syncScrollPending: false
-                            function scheduleScrollToBottom() {
-                                syncScrollPending = true
-                                syncScrollTimer.restart()
-                            }
-                            onContentHeightChanged: {
-                                if (syncScrollPending) {
-                                    syncScrollPending = false
-                                    registrationScroll.contentY = Math.max(0, registrationScroll.contentHeight - registrationScroll.height)
-                                }
-                            }
-                            Timer {
-                                id: syncScrollTimer
-                                interval: 30
-                                repeat: false
-                                onTriggered: {
-                                    registrationScroll.contentY = Math.max(0, registrationScroll.contentHeight - registrationScroll.height)
-                                    Qt.callLater(function() {
-                                        registrationScroll.contentY = Math.max(0, registrationScroll.contentHeight - registrationScroll.height)
-                                    })
-                                }
-                            }
-
-                            ColumnLayout {
-                                id: registrationContent
-                                width: parent.width
-                                spacing: 14
-
-                                AppCard {
+                        PageLoader {
+                            id: registrationPage
+                            step: 1
+                            currentStep: AppController.currentStep
+                            preload: root.firstFrameShown
+                            sourceComponent: Component {
+                                Flickable {
+                                    id: registrationScroll
                                     Layout.fillWidth: true
-                                    title: "Registration"
-                                    subtitle: "Provide MAC ID and Tenant ID to generate a key."
-                                    contentItem: ColumnLayout {
-                                        spacing: 12
-
-                                        RowLayout {
-                                            Layout.fillWidth: true
-                                            spacing: 8
-
-                                            TextField {
-                                                id: macField
-                                                Layout.fillWidth: true
-                                                leftPadding: 12
-                                                rightPadding: 12
-                                                topPadding: 8
-                                                bottomPadding: 8
-                                            placeholderText: "MAC ID (ex: 00:14:22:01:23:45)"
-                                                font.pixelSize: 13
-                                                color: macField.enabled ? root.textPrimary : root.textMuted
-                                                placeholderTextColor: root.textPlaceholder
-                                                text: AppController.macId
-                                                onTextEdited: {
-                                                    var hex = text.replace(/[^0-9a-fA-F]/g, "").toUpperCase()
-                                                    if (hex.length > 12)
-                                                        hex = hex.slice(0, 12)
-                                                    var parts = []
-                                                    for (var i = 0; i < hex.length; i += 2)
-                                                        parts.push(hex.slice(i, i + 2))
-                                                var formatted = parts.join(":")
-                                                AppController.macId = formatted
-                                                cursorPosition = formatted.length
-                                                }
-                                                inputMethodHints: Qt.ImhPreferUppercase | Qt.ImhNoPredictiveText
-                                                enabled: !AppController.busy && !AppController.keyValid
-                                                background: Rectangle {
-                                                    radius: 4
-                                                    color: macField.enabled ? root.bgInput : root.bgInputDisabled
-                                                    border.color: macField.activeFocus ? root.accent : root.borderPrimary
-                                                    border.width: 1
-                                                }
-                                            }
-
-                                            AppButton {
-                                                text: "Get"
-                                                enabled: !AppController.busy && !AppController.keyValid && AppController.macId.length === 0
-                                                onClicked: AppController.populateMacId()
-                                                accent: root.accent
-                                                implicitWidth: 70
-                                                implicitHeight: 36
-                                            }
+                                    Layout.fillHeight: true
+                                    clip: true
+                                    contentWidth: width
+                                    contentHeight: registrationContent.implicitHeight
+                                    boundsBehavior: Flickable.StopAtBounds
+
+                                    ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
+                                    property bool syncScrollPending: false
+                                    function scheduleScrollToBottom() {
+                                        syncScrollPending = true
+                                        syncScrollTimer.restart()
+                                    }
+                                    onContentHeightChanged: {
+                                        if (syncScrollPending) {
+                                            syncScrollPending = false
+                                            registrationScroll.contentY = Math.max(0, registrationScroll.contentHeight - registrationScroll.height)
                                         }
-
-                                        TextField {
-                                            id: tenantField
-                                            Layout.fillWidth: true
-                                            leftPadding: 12
-                                            rightPadding: 12
-                                            topPadding: 8
-                                            bottomPadding: 8
-                                            placeholderText: "Tenant ID (ex: 28C30B1F-FF4B-48DB-804F-4A1CB57990E6)"
-                                            font.pixelSize: 13
-                                            color: tenantField.enabled ? root.textPrimary : root.textMuted
-                                            placeholderTextColor: root.textPlaceholder
-                                            text: AppController.tenantId
-                                            onTextEdited: {
-                                                var hex = text.replace(/[^0-9a-fA-F]/g, "").toUpperCase()
-                                                if (hex.length > 32)
-                                                    hex = hex.slice(0, 32)
-                                                var parts = []
-                                                var sizes = [8, 4, 4, 4, 12]
-                                                var index = 0
-                                                for (var i = 0; i < sizes.length; i++) {
-                                                    var size = sizes[i]
-                                                    if (index >= hex.length)
-                                                        break
-                                                    parts.push(hex.slice(index, index + size))
-                                                    index += size
-                                                }
-                                                var formatted = parts.join("-")
-                                                AppController.tenantId = formatted
-                                                cursorPosition = formatted.length
-                                            }
-                                            inputMethodHints: Qt.ImhPreferUppercase | Qt.ImhNoPredictiveText
-                                            enabled: !AppController.busy && !AppController.keyValid
-                                            background: Rectangle {
-                                                radius: 4
-                                                color: tenantField.enabled ? root.bgInput : root.bgInputDisabled
-                                                border.color: tenantField.activeFocus ? root.accent : root.borderPrimary
-                                                border.width: 1
-                                            }
+                                    }
+                                    Timer {
+                                        id: syncScrollTimer
+                                        interval: 30
+                                        repeat: false
+                                        onTriggered: {
+                                            registrationScroll.contentY = Math.max(0, registrationScroll.contentHeight - registrationScroll.height)
+                                            Qt.callLater(function() {
+                                                registrationScroll.contentY = Math.max(0, registrationScroll.contentHeight - registrationScroll.height)
+                                            })
                                         }
+                                    }
 
-                                    RowLayout {
-                                        Layout.fillWidth: true
-                                        visible: AppController.registrationMessage.length > 0
-                                        spacing: 8
-                                        Rectangle {
-                                            width: 18
-                                            height: 18
-                                            radius: width / 2
-                                            color: AppController.keyValid ? root.accentSuccess : root.accentWarning
-                                            border.color: AppController.keyValid ? root.accentSuccessDark : root.accentWarningDark
-                                            border.width: 1
-                                            Text {
-                                                anchors.centerIn: parent
-                                                text: AppController.keyValid ? "\u2713" : "\u2715"
-                                                color: AppController.keyValid ? root.textSuccessDark : root.textErrorDark
-                                                font.pixelSize: 12
-                                                font.bold: true
-                                            }
-                                        }
-                                        Text {
+                                    ColumnLayout {
+                                        id: registrationContent
+                                        width: parent.width
+                                        spacing: 14
+
+                                        AppCard {
                                             Layout.fillWidth: true
-                                            wrapMode: Text.WordWrap
-                                            color: AppController.keyValid ? root.textSuccess : root.textError
-                                            font.pixelSize: 12
-                                            text: AppController.registrationMessage
-                                        }
-                                    }
+                                            title: "Registration"
+                                            subtitle: "Provide MAC ID and Tenant ID to generate a key."
+                                            contentItem: ColumnLayout {
+                                                spacing: 12
 
-                                    Item { height: 3 }
-                                }
-                            }
+                                                RowLayout {
+                                                    Layout.fillWidth: true
+                                                    spacing: 8
 
-                                AppCard {
-                                    Layout.fillWidth: true
-                                    visible: AppController.keyValid || devSyncSuccess
-                                title: "Sync"
-                                subtitle: "Relay URL"
-                                contentItem: ColumnLayout {
-                                    spacing: 12
+                                                    TextField {
+                                                        id: macField
+                                                        Layout.fillWidth: true
+                                                        leftPadding: 12
+                                                        rightPadding: 12
+                                                        topPadding: 8
+                                                        bottomPadding: 8
+                                                    placeholderText: "MAC ID (ex: 00:14:22:01:23:45)"
+                                                        font.pixelSize: 13
+                                                        color: macField.enabled ? root.textPrimary : root.textMuted
+                                                        placeholderTextColor: root.textPlaceholder
+                                                        text: AppController.macId
+                                                        onTextEdited: {
+                                                            var hex = text.replace(/[^0-9a-fA-F]/g, "").toUpperCase()
+                                                            if (hex.length > 12)
+                                                                hex = hex.slice(0, 12)
+                                                            var parts = []
+                                                            for (var i = 0; i < hex.length; i += 2)
+                                                                parts.push(hex.slice(i, i + 2))
+                                                        var formatted = parts.join(":")
+                                                        AppController.macId = formatted
+                                                        cursorPosition = formatted.length
+                                                        }
+                                                        inputMethodHints: Qt.ImhPreferUppercase | Qt.ImhNoPredictiveText
+                                                        enabled: !AppController.provisioning && !AppController.busy && !AppController.keyValid
+                                                        background: Rectangle {
+                                                            radius: 4
+                                                            color: macField.enabled ? root.bgInput : root.bgInputDisabled
+                                                            border.color: macField.activeFocus ? root.accent : root.borderPrimary
+                                                            border.width: 1
+                                                        }
+                                                    }
 
-                                        TextField {
-                                            id: relayField
-                                            Layout.fillWidth: true
-                                            leftPadding: 12
-                                            rightPadding: 12
-                                            topPadding: 8
-                                            bottomPadding: 8
-                                            placeholderText: "ex: https://relay.example.com/api/v1/relay"
-                                            font.pixelSize: 13
-                                            color: relayField.enabled ? root.textPrimary : root.textMuted
-                                            placeholderTextColor: root.textPlaceholder
-                                            text: AppController.relayUrl
-                                            onTextChanged: AppController.relayUrl = text
-                                            background: Rectangle {
-                                                radius: 4
-                                                color: relayField.enabled ? root.bgInput : root.bgInputDisabled
-                                                border.color: relayField.activeFocus ? root.accent : root.borderPrimary
-                                                border.width: 1
-                                            }
-                                        }
+                                                    AppButton {
+                                                        text: "Get"
+                                                        enabled: !AppController.provisioning && !AppController.busy && !AppController.keyValid && AppController.macId.length === 0
+                                                        onClicked: AppController.populateMacId()
+                                                        accent: root.accent
+                                                        implicitWidth: 70
+                                                        implicitHeight: 36
+                                                    }
+                                                }
 
-                                        Text {
-                                            Layout.fillWidth: true
-                                            visible: AppController.relayError.length > 0
-                                            wrapMode: Text.WordWrap
-                                            color: root.textError
-                                            font.pixelSize: 12
-                                            text: AppController.relayError
-                                        }
+                                                TextField {
+                                                    id: tenantField
+                                                    Layout.fillWidth: true
+                                                    leftPadding: 12
+                                                    rightPadding: 12
+                                                    topPadding: 8
+                                                    bottomPadding: 8
+                                                    placeholderText: "Tenant ID (ex: 28C30B1F-FF4B-48DB-804F-4A1CB57990E6)"
+                                                    font.pixelSize: 13
+                                                    color: tenantField.enabled ? root.textPrimary : root.textMuted
+                                                    placeholderTextColor: root.textPlaceholder
+                                                    text: AppController.tenantId
+                                                    onTextEdited: {
+                                                        var hex = text.replace(/[^0-9a-fA-F]/g, "").toUpperCase()
+                                                        if (hex.length > 32)
+                                                            hex = hex.slice(0, 32)
+                                                        var parts = []
+                                                        var sizes = [8, 4, 4, 4, 12]
+                                                        var index = 0
+                                                        for (var i = 0; i < sizes.length; i++) {
+                                                            var size = sizes[i]
+                                                            if (index >= hex.length)
+                                                                break
+                                                            parts.push(hex.slice(index, index + size))
+                                                            index += size
+                                                        }
+                                                        var formatted = parts.join("-")
+                                                        AppController.tenantId = formatted
+                                                        cursorPosition = formatted.length
+                                                    }
+                                                    inputMethodHints: Qt.ImhPreferUppercase | Qt.ImhNoPredictiveText
+                                                    enabled: !AppController.provisioning && !AppController.busy && !AppController.keyValid
+                                                    background: Rectangle {
+                                                        radius: 4
+                                                        color: tenantField.enabled ? root.bgInput : root.bgInputDisabled
+                                                        border.color: tenantField.activeFocus ? root.accent : root.borderPrimary
+                                                        border.width: 1
+                                                    }
+                                                }
 
-                                        RowLayout {
-                                            Layout.fillWidth: true
-                                            Layout.topMargin: 6
-                                            spacing: 10
-                                            Rectangle {
-                                                visible: rightStack.syncSuccess
-                                                width: 18
-                                                height: 18
-                                                radius: width / 2
-                                                color: root.accentSuccess
-                                                border.color: root.accentSuccessDark
-                                                border.width: 1
+                                            RowLayout {
+                                                Layout.fillWidth: true
+                                                visible: AppController.registrationMessage.length > 0
+                                                spacing: 8
+                                                Rectangle {
+                                                    width: 18
+                                                    height: 18
+                                                    radius: width / 2
+                                                    color: AppController.keyValid ? root.accentSuccess : root.accentWarning
+                                                    border.color: AppController.keyValid ? root.accentSuccessDark : root.accentWarningDark
+                                                    border.width: 1
+                                                    Text {
+                                                        anchors.centerIn: parent
+                                                        text: AppController.keyValid ? "\u2713" : "\u2715"
+                                                        color: AppController.keyValid ? root.textSuccessDark : root.textErrorDark
+                                                        font.pixelSize: 12
+                                                        font.bold: true
+                                                    }
+                                                }
                                                 Text {
-                                                    anchors.centerIn: parent
-                                                    text: "\u2713"
-                                                    color: root.textSuccessDark
+                                                    Layout.fillWidth: true
+                                                    wrapMode: Text.WordWrap
+                                                    color: AppController.keyValid ? root.textSuccess : root.textError
                                                     font.pixelSize: 12
-                                                    font.bold: true
+                                                    text: AppController.registrationMessage
                                                 }
                                             }
-                                            Text {
-                                                wrapMode: Text.WordWrap
-                                                color: rightStack.syncSuccess ? root.textSuccess : root.textError
-                                                text: rightStack.syncMessage.length
-                                                    ? rightStack.syncMessage
-                                                    : (rightStack.syncSuccess ? "Sync API registration completed successfully." : "")
-                                                visible: rightStack.syncMessage.length > 0
-                                                horizontalAlignment: Text.AlignRight
-                                                font.pixelSize: 12
-                                            }
-                                        }
 
-                                        Item { height: 3 }
+                                            Item { height: 3 }
+                                        }
                                     }
-                                }
 
-                                AppCard {
-                                    Layout.fillWidth: true
-                                    visible: rightStack.syncSuccess
-                                    title: "Tenant"
-                                    subtitle: "Setup the tenant data"
-                                    contentItem: ColumnLayout {
-                                        spacing: 10
-                                        Text {
+                                        AppCard {
                                             Layout.fillWidth: true
-                                            color: "white"
-                                            font.pixelSize: 12
-                                            text: "Vertical"
-                                        }
-                                        ComboBox {
-                                            id: tenantSelect
-                                            Layout.fillWidth: true
-                                            implicitHeight: 30
-                                            model: ["SNL", "Schools", "Prison"]
-                                            font.pixelSize: 13
-                                            contentItem: Text {
-                                                text: tenantSelect.displayText
-                                                color: root.textPrimary
-                                                verticalAlignment: Text.AlignVCenter
-                                                leftPadding: 10
-                                            }
-                                            indicator: Text {
-                                                text: "\u25BC"
-                                                color: root.textMuted
-                                                anchors.verticalCenter: parent.verticalCenter
-                                                anchors.right: parent.right
-                                                anchors.rightMargin: 10
-                                                font.pixelSize: 10
-                                            }
-                                            background: Rectangle {
-                                                radius: 8
-                                                color: root.bgInput
-                                                border.color: tenantSelect.activeFocus ? root.accent : root.borderPrimary
-                                                border.width: 1
-                                            }
-                                            popup: Popup {
-                                                y: tenantSelect.height + 4
-                                                width: tenantSelect.width
-                                                implicitHeight: contentItem.implicitHeight
-                                                padding: 0
-                                                background: Rectangle {
-                                                    radius: 5
-                                                    color: root.bgLog
-                                                    border.color: root.borderPrimary
-                                                    border.width: 1
-                                                }
-                                                contentItem: ListView {
-                                                    implicitHeight: contentHeight
-                                                    model: tenantSelect.popup.visible ? tenantSelect.delegateModel : null
-                                                    clip: true
+                                        title: "Sync"
+                                        subtitle: "Relay URL"
+                                        contentItem: ColumnLayout {
+                                            spacing: 12
+
+                                                TextField {
+                                                    id: relayField
+                                                    Layout.fillWidth: true
+                                                    leftPadding: 12
+                                                    rightPadding: 12
+                                                    topPadding: 8
+                                                    bottomPadding: 8
+                                                    placeholderText: "ex: https://relay.example.com/api/v1/relay"
+                                                    font.pixelSize: 13
+                                                    color: relayField.enabled ? root.textPrimary : root.textMuted
+                                                    placeholderTextColor: root.textPlaceholder
+                                                    text: AppController.relayUrl
+                                                    onTextChanged: AppController.relayUrl = text
+                                                    enabled: !AppController.provisioning && !rightStack.syncSuccess
+                                                    background: Rectangle {
+                                                        radius: 4
+                                                        color: relayField.enabled ? root.bgInput : root.bgInputDisabled
+                                                        border.color: relayField.activeFocus ? root.accent : root.borderPrimary
+                                                        border.width: 1
+                                                    }
                                                 }
-                                            }
-                                            delegate: ItemDelegate {
-                                                width: tenantSelect.width
-                                                height: 36
-                                                text: modelData
-                                                font.pixelSize: 13
-                                                hoverEnabled: true
-                                                readonly property bool isFirst: index === 0
-                                                readonly property bool isLast: index === (tenantSelect.model.length - 1)
-                                                contentItem: Text {
-                                                    text: modelData
-                                                    color: root.textPrimary
-                                                    verticalAlignment: Text.AlignVCenter
-                                                    leftPadding: 10
+
+                                                Text {
+                                                    Layout.fillWidth: true
+                                                    visible: AppController.relayError.length > 0
+                                                    wrapMode: Text.WordWrap
+                                                    color: root.textError
+                                                    font.pixelSize: 12
+                                                    text: AppController.relayError
                                                 }
-                                                background: Rectangle {
-                                                    color: highlighted || hovered ? root.bgSecondary : root.bgLog
-                                                    radius: isLast ? 8 : 0
+
+                                                RowLayout {
+                                                    Layout.fillWidth: true
+                                                    Layout.topMargin: 6
+                                                    spacing: 10
+                                                    Rectangle {
+                                                        visible: rightStack.syncSuccess
+                                                        width: 18
+                                                        height: 18
+                                                        radius: width / 2
+                                                        color: root.accentSuccess
+                                                        border.color: root.accentSuccessDark
+                                                        border.width: 1
+                                                        Text {
+                                                            anchors.centerIn: parent
+                                                            text: "\u2713"
+                                                            color: root.textSuccessDark
+                                                            font.pixelSize: 12
+                                                            font.bold: true
+                                                        }
+                                                    }
+                                                    Text {
+                                                        wrapMode: Text.WordWrap
+                                                        color: rightStack.syncSuccess ? root.textSuccess : root.textError
+                                                        text: rightStack.syncMessage.length
+                                                            ? rightStack.syncMessage
+                                                            : (rightStack.syncSuccess ? "Sync API registration completed successfully." : "")
+                                                        visible: rightStack.syncMessage.length > 0
+                                                        horizontalAlignment: Text.AlignRight
+                                                        font.pixelSize: 12
+                                                    }
                                                 }
+
+                                                Item { height: 3 }
                                             }
                                         }
-                                        RowLayout {
+
+                                        AppCard {
                                             Layout.fillWidth: true
-                                            visible: AppController.tenantMessage.length > 0
-                                            spacing: 8
-                                            Rectangle {
-                                                width: 18
-                                                height: 18
-                                                radius: width / 2
-                                                color: AppController.tenantSuccess ? root.accentSuccess : root.accentWarning
-                                                border.color: AppController.tenantSuccess ? root.accentSuccessDark : root.accentWarningDark
-                                                border.width: 1
+                                            title: "Tenant"
+                                            subtitle: "Setup the tenant data"
+                                            contentItem: ColumnLayout {
+                                                spacing: 10
                                                 Text {
-                                                    anchors.centerIn: parent
-                                                    text: AppController.tenantSuccess ? "\u2713" : "\u2715"
-                                                    color: AppController.tenantSuccess ? root.textSuccessDark : root.textErrorDark
+                                                    Layout.fillWidth: true
+                                                    color: "white"
                                                     font.pixelSize: 12
-                                                    font.bold: true
+                                                    text: "Vertical"
                                                 }
-                                            }
-                                            Text {
-                                                Layout.fillWidth: true
-                                                wrapMode: Text.WordWrap
-                                                font.pixelSize: 12
-                                                color: AppController.tenantSuccess ? root.textSuccess : root.textError
-                                                text: AppController.tenantMessage
+                                                ComboBox {
+                                                    id: tenantSelect
+                                                    Layout.fillWidth: true
+                                                    implicitHeight: 30
+                                                    model: ["SNL", "Schools", "Prison"]
+                                                    onCurrentTextChanged: root.selectedVertical = currentText
+                                                    enabled: !AppController.provisioning && !AppController.tenantSuccess
+                                                    font.pixelSize: 13
+                                                    contentItem: Text {
+                                                        text: tenantSelect.displayText
+                                                        color: root.textPrimary
+                                                        verticalAlignment: Text.AlignVCenter
+                                                        leftPadding: 10
+                                                    }
+                                                    indicator: Text {
+                                                        text: "\u25BC"
+                                                        color: root.textMuted
+                                                        anchors.verticalCenter: parent.verticalCenter
+                                                        anchors.right: parent.right
+                                                        anchors.rightMargin: 10
+                                                        font.pixelSize: 10
+                                                    }
+                                                    background: Rectangle {
+                                                        radius: 8
+                                                        color: root.bgInput
+                                                        border.color: tenantSelect.activeFocus ? root.accent : root.borderPrimary
+                                                        border.width: 1
+                                                    }
+                                                    popup: Popup {
+                                                        y: tenantSelect.height + 4
+                                                        width: tenantSelect.width
+                                                        implicitHeight: contentItem.implicitHeight
+                                                        padding: 0
+                                                        background: Rectangle {
+                                                            radius: 5
+                                                            color: root.bgLog
+                                                            border.color: root.borderPrimary
+                                                            border.width: 1
+                                                        }
+                                                        contentItem: ListView {
+                                                            implicitHeight: contentHeight
+                                                            model: tenantSelect.popup.visible ? tenantSelect.delegateModel : null
+                                                            clip: true
+                                                        }
+                                                    }
+                                                    delegate: ItemDelegate {
+                                                        width: tenantSelect.width
+                                                        height: 36
+                                                        text: modelData
+                                                        font.pixelSize: 13
+                                                        hoverEnabled: true
+                                                        readonly property bool isFirst: index === 0
+                                                        readonly property bool isLast: index === (tenantSelect.model.length - 1)
+                                                        contentItem: Text {
+                                                            text: modelData
+                                                            color: root.textPrimary
+                                                            verticalAlignment: Text.AlignVCenter
+                                                            leftPadding: 10
+                                                        }
+                                                        background: Rectangle {
+                                                            color: highlighted || hovered ? root.bgSecondary : root.bgLog
+                                                            radius: isLast ? 8 : 0
+                                                        }
+                                                    }
+                                                }
+                                                RowLayout {
+                                                    Layout.fillWidth: true
+                                                    visible: AppController.tenantMessage.length > 0
+                                                    spacing: 8
+                                                    Rectangle {
+                                                        width: 18
+                                                        height: 18
+                                                        radius: width / 2
+                                                        color: AppController.tenantSuccess ? root.accentSuccess : root.accentWarning
+                                                        border.color: AppController.tenantSuccess ? root.accentSuccessDark : root.accentWarningDark
+                                                        border.width: 1
+                                                        Text {
+                                                            anchors.centerIn: parent
+                                                            text: AppController.tenantSuccess ? "\u2713" : "\u2715"
+                                                            color: AppController.tenantSuccess ? root.textSuccessDark : root.textErrorDark
+                                                            font.pixelSize: 12
+                                                            font.bold: true
+                                                        }
+                                                    }
+                                                    Text {
+                                                        Layout.fillWidth: true
+                                                        wrapMode: Text.WordWrap
+                                                        font.pixelSize: 12
+                                                        color: AppController.tenantSuccess ? root.textSuccess : root.textError
+                                                        text: AppController.tenantMessage
+                                                    }
+                                                }
+                                                Item { height: 3 }
                                             }
                                         }
-                                        Item { height: 3 }
+
+                                        Item { Layout.fillHeight: true }
                                     }
                                 }
-
-                                Item { Layout.fillHeight: true }
                             }
                         }
 
                         // Installation
-                        ColumnLayout {
-                            id: installPage
-                            spacing: 14
-                            Layout.fillWidth: true
-                            Layout.fillHeight: true
-
-                            QtObject {
-                                id: installState
-                                property bool started: false
-                                property bool installDone: false
-                                property bool awaitingAuth: false
-                                property bool showLogs: false
-                                property bool useLogProgress: false
-                                property bool cancelPending: false
-                                property bool installFailed: false
-                                property int elapsedMs: 0
-                                property int progressWindowMs: 180000
-                                property real maxProgress: 0.95
-                                property real progress: 0.0
-                                property string statusText: "Ready to Install."
-                                property string pullErrorMessage: ""
-
-                                function reset() {
-                                    elapsedMs = 0;
-                                    progress = 0.0;
-                                    statusText = "Ready to Install.";
-                                    installDone = false;
-                                    started = false;
-                                    awaitingAuth = false;
-                                    installFailed = false;
-                                    showLogs = false;
-                                    useLogProgress = false;
-                                    cancelPending = false;
-                                    pullErrorMessage = "";
-                                    root.installationComplete = false;
-                                }
-                            }
-
-                            Timer {
-                                id: installTimer
-                                interval: 100
-                                repeat: true
-                                onTriggered: {
-                                    if (installState.useLogProgress)
-                                        return;
-                                    installState.elapsedMs = Math.min(installState.progressWindowMs, installState.elapsedMs + interval);
-                                    var t = installState.elapsedMs / 45000.0;
-                                    var eased = installState.maxProgress * (1 - Math.exp(-t));
-                                    installState.progress = Math.min(installState.maxProgress, eased);
-                                    installState.statusText = "Pulling Docker image...";
-                                }
-                            }
-
-                            Connections {
-                                target: AppController
-                                function onCurrentStepChanged() {
-                                    if (AppController.currentStep !== 2) {
-                                        installTimer.stop();
-                                    }
-                                }
-                                function onDockerPullStarted() {
-                                    if (installState.awaitingAuth) {
-                                        installState.awaitingAuth = false
-                                        installState.started = true
-                                        installState.statusText = "Pulling Docker image..."
-                                        installState.useLogProgress = true
-                                        installState.cancelPending = false
-                                        installState.pullErrorMessage = ""
-                                        installTimer.start()
-                                    }
-                                }
-                                function onDockerPullProgressChanged() {
-                                    if (AppController.dockerPullProgress > 0) {
-                                        installState.useLogProgress = true
-                                        installState.progress = AppController.dockerPullProgress
-                                    }
-                                }
-                                function onDockerPullFinished(ok, message) {
-                                    if (installState.cancelPending) {
-                                        installTimer.stop()
-                                        AppController.clearDockerPullLog()
-                                        installState.reset()
-                                        installState.statusText = "Ready to Pull."
-                                        return
-                                    }
-                                    installTimer.stop()
-                                    installState.awaitingAuth = false
-                                    installState.started = false
-                                    installState.progress = ok ? 1.0 : installState.progress
-                                    installState.statusText = ok ? message : "Failed to pull docker image."
-                                    installState.installDone = ok
-                                    installState.pullErrorMessage = ok ? "" : message
-                                    root.installationComplete = ok
-                                }
-                                function onInstallPrereqsRunningChanged() {
-                                    if (AppController.installPrereqsRunning) {
-                                        installState.showLogs = true
-                                        installState.installFailed = false
-                                        installState.statusText = "Installing Docker and NVIDIA Container Toolkit..."
-                                    } else if (!AppController.installPrereqsDone && !installState.started) {
-                                        // Install finished but not done = failed
-                                        installState.installFailed = true
-                                        installState.showLogs = true  // Keep logs visible to show error
-                                        installState.statusText = "Installation failed. Check the log for details."
-                                    }
-                                }
-                                function onInstallPrereqsDoneChanged() {
-                                    if (AppController.installPrereqsDone) {
-                                        installState.installFailed = false
-                                        installState.statusText = "Ready to Pull."
-                                    }
-                                }
-                            }
-
-                            AppCard {
-                                Layout.fillWidth: true
-                                title: "Installation"
-                                subtitle: AppController.installPrereqsDone
-                                    ? (installState.started || installState.awaitingAuth
-                                        ? "Pulling docker image for installation."
-                                        : (installState.installDone
-                                            ? "Docker image pulled successfully."
-                                            : "Docker and NVIDIA Container Toolkit installed."))
-                                    : (installState.installFailed
-                                        ? "Installation failed. Check the log and try again."
-                                        : "Install Docker and NVIDIA Container Toolkit")
-                                contentItem: ColumnLayout {
-                                    spacing: 12
+                        PageLoader {
+                            step: 2
+                            currentStep: AppController.currentStep
+                            preload: root.firstFrameShown
+                            sourceComponent: Component {
+                                ColumnLayout {
+                                    id: installPage
+                                    spacing: 14
+                                    Layout.fillWidth: true
+                                    Layout.fillHeight: true
 
-                                    RowLayout {
+                                    AppCard {
                                         Layout.fillWidth: true
-                                        Text {
-                                            Layout.fillWidth: true
-                                            wrapMode: Text.WordWrap
-                                            maximumLineCount: 2
-                                            elide: Text.ElideRight
-                                            color: root.textSecondary
-                                            text: installState.statusText
-                                        }
-                                        RowLayout {
-                                            spacing: 6
-                                            Text {
-                                                color: root.textInfo
-                                                text: Math.round(installState.progress * 100) + "%"
-                                            }
-                                            Rectangle {
-                                                visible: installState.installDone
-                                                width: 18
-                                                height: 18
-                                                radius: width / 2
-                                                color: root.accentSuccess
-                                                border.color: root.accentSuccessDark
-                                                border.width: 1
+                                        title: "Installation"
+                                        subtitle: AppController.installPrereqsDone
+                                            ? (installState.started || installState.awaitingAuth
+                                                ? "Pulling docker image for installation."
+                                                : (installState.installDone
+                                                    ? "Docker image pulled successfully."
+                                                    : "Docker and NVIDIA Container Toolkit installed."))
+                                            : (installState.installFailed
+                                                ? "Installation failed. Check the log and try again."
+                                                : "Install Docker and NVIDIA Container Toolkit")
+                                        contentItem: ColumnLayout {
+                                            spacing: 12
+
+                                            RowLayout {
+                                                Layout.fillWidth: true
                                                 Text {
-                                                    anchors.centerIn: parent
-                                                    text: "\u2713"
-                                                    color: root.textSuccessDark
-                                                    font.pixelSize: 12
-                                                    font.bold: true
+                                                    Layout.fillWidth: true
+                                                    wrapMode: Text.WordWrap
+                                                    maximumLineCount: 2
+                                                    elide: Text.ElideRight
+                                                    color: root.textSecondary
+                                                    text: installState.statusText
+                                                }
+                                                RowLayout {
+                                                    spacing: 6
+                                                    Text {
+                                                        color: root.textInfo
+                                                        text: Math.round(installState.progress * 100) + "%"
+                                                    }
+                                                    Rectangle {
+                                                        visible: installState.installDone
+                                                        width: 18
+                                                        height: 18
+                                                        radius: width / 2
+                                                        color: root.accentSuccess
+                                                        border.color: root.accentSuccessDark
+                                                        border.width: 1
+                                                        Text {
+                                                            anchors.centerIn: parent
+                                                            text: "\u2713"
+                                                            color: root.textSuccessDark
+                                                            font.pixelSize: 12
+                                                            font.bold: true
+                                                        }
+                                                    }
                                                 }
                                             }
-                                        }
-                                    }
-
-                                    RowLayout {
-                                        Layout.fillWidth: true
-                                        spacing: 8
-                                        ModernProgressBar {
-                                            Layout.fillWidth: true
-                                            value: installState.progress
-                                            busy: installTimer.running
-                                        }
-                                    }
 
-                                    Text {
-                                        Layout.fillWidth: true
-                                        visible: installState.pullErrorMessage.length > 0
-                                        wrapMode: Text.WordWrap
-                                        color: root.accentError
-                                        text: installState.pullErrorMessage
-                                    }
-
-                                    Item {
-                                        id: pullSwap
-                                        Layout.fillWidth: true
-                                        Layout.preferredHeight: 300
-                                        implicitHeight: 300
-                                        Layout.bottomMargin: 8
-                                        visible: installState.pullErrorMessage.length === 0
-                                            && (installState.started
-                                                || installState.awaitingAuth
-                                                || AppController.installPrereqsRunning
-                                                || AppController.installPrereqsDone
-                                                || installState.installFailed)
-
-                                        Rectangle {
-                                            id: dockerLogPanel
-                                            anchors.fill: parent
-                                            radius: 12
-                                            color: "#050811"
-                                            border.color: "#2D3B5F"
-                                            border.width: 1
-                                            clip: true
-                                            property bool stickToBottom: true
-                                            function updateStickState() {
-                                                if (!dockerLogFlickable)
-                                                    return;
-                                                var maxY = Math.max(0, dockerLogFlickable.contentHeight - dockerLogFlickable.height);
-                                                stickToBottom = dockerLogFlickable.contentY >= maxY - 4;
-                                            }
-                                            function scrollToBottom() {
-                                                if (!dockerLogFlickable)
-                                                    return;
-                                                dockerLogFlickable.contentY = Math.max(0, dockerLogFlickable.contentHeight - dockerLogFlickable.height);
+                                            RowLayout {
+                                                Layout.fillWidth: true
+                                                spacing: 8
+                                                ModernProgressBar {
+                                                    Layout.fillWidth: true
+                                                    value: installState.progress
+                                                    busy: installTimer.running
+                                                }
                                             }
 
-                                            // Subtle gradient overlay
-                                            Rectangle {
-                                                anchors.fill: parent
-                                                radius: parent.radius
-                                                gradient: Gradient {
-                                                    GradientStop { position: 0.0; color: "#0A101800" }
-                                                    GradientStop { position: 1.0; color: "#0A101820" }
-                                                }
+                                            Text {
+                                                Layout.fillWidth: true
+                                                visible: installState.pullErrorMessage.length > 0
+                                                wrapMode: Text.WordWrap
+                                                color: root.accentError
+                                                text: installState.pullErrorMessage
                                             }
 
-                                            // Header bar with label
-                                            Rectangle {
-                                                anchors.top: parent.top
-                                                anchors.left: parent.left
-                                                anchors.right: parent.right
-                                                height: 32
-                                                color: "#0F1623"
-                                                radius: 12
-                                                Rectangle {
-                                                    anchors.bottom: parent.bottom
-                                                    anchors.left: parent.left
-                                                    anchors.right: parent.right
-                                                    height: parent.radius
-                                                    color: parent.color
-                                                }
+                                            Item {
+                                                id: pullSwap
+                                                Layout.fillWidth: true
+                                                Layout.preferredHeight: 300
+                                                implicitHeight: 300
+                                                Layout.bottomMargin: 8
+                                                visible: installState.pullErrorMessage.length === 0
+                                                    && (installState.started
+                                                        || installState.awaitingAuth
+                                                        || AppController.installPrereqsRunning
+                                                        || AppController.installPrereqsDone
+                                                        || installState.installFailed)
 
-                                                RowLayout {
+                                                Rectangle {
+                                                    id: dockerLogPanel
                                                     anchors.fill: parent
-                                                    anchors.leftMargin: 12
-                                                    anchors.rightMargin: 12
-                                                    spacing: 8
-
-                                                    Text {
-                                                        text: (installState.started || installState.awaitingAuth || installState.installDone) ? "🐳" : "⚙"
-                                                        color: "#6EE7FF"
-                                                        font.pixelSize: 14
+                                                    radius: 12
+                                                    color: "#050811"
+                                                    border.color: "#2D3B5F"
+                                                    border.width: 1
+                                                    clip: true
+                                                    property bool stickToBottom: true
+                                                    function updateStickState() {
+                                                        if (!dockerLogFlickable)
+                                                            return;
+                                                        var maxY = Math.max(0, dockerLogFlickable.contentHeight - dockerLogFlickable.height);
+                                                        stickToBottom = dockerLogFlickable.contentY >= maxY - 4;
                                                     }
-
-                                                    Text {
-                                                        text: (installState.started || installState.awaitingAuth || installState.installDone) ? "Docker Pull Log" : "Installation Log"
-                                                        color: "#93C5FD"
-                                                        font.pixelSize: 11
-                                                        font.weight: Font.Medium
+                                                    function scrollToBottom() {
+                                                        if (!dockerLogFlickable)
+                                                            return;
+                                                        dockerLogFlickable.contentY = Math.max(0, dockerLogFlickable.contentHeight - dockerLogFlickable.height);
                                                     }
 
-                                                    Item { Layout.fillWidth: true }
-
+                                                    // Subtle gradient overlay
                                                     Rectangle {
-                                                        width: 6
-                                                        height: 6
-                                                        radius: 3
-                                                        color: "#22C55E"
-                                                        opacity: 0.8
-                                                        visible: installTimer.running || AppController.installPrereqsRunning
-
-                                                        SequentialAnimation on opacity {
-                                                            running: installTimer.running || AppController.installPrereqsRunning
-                                                            loops: Animation.Infinite
-                                                            NumberAnimation { from: 0.3; to: 1.0; duration: 600 }
-                                                            NumberAnimation { from: 1.0; to: 0.3; duration: 600 }
+                                                        anchors.fill: parent
+                                                        radius: parent.radius
+                                                        gradient: Gradient {
+                                                            GradientStop { position: 0.0; color: "#0A101800" }
+                                                            GradientStop { position: 1.0; color: "#0A101820" }
                                                         }
                                                     }
 
-                                                    Text {
-                                                        text: (installTimer.running || AppController.installPrereqsRunning) ? "ACTIVE" : "IDLE"
-                                                        color: (installTimer.running || AppController.installPrereqsRunning) ? "#22C55E" : "#64748B"
-                                                        font.pixelSize: 10
-                                                        font.weight: Font.Bold
-                                                        font.letterSpacing: 0.5
+                                                    // Header bar with label
+                                                    Rectangle {
+                                                        anchors.top: parent.top
+                                                        anchors.left: parent.left
+                                                        anchors.right: parent.right
+                                                        height: 32
+                                                        color: "#0F1623"
+                                                        radius: 12
+                                                        Rectangle {
+                                                            anchors.bottom: parent.bottom
+                                                            anchors.left: parent.left
+                                                            anchors.right: parent.right
+                                                            height: parent.radius
+                                                            color: parent.color
+                                                        }
+
+                                                        RowLayout {
+                                                            anchors.fill: parent
+                                                            anchors.leftMargin: 12
+                                                            anchors.rightMargin: 12
+                                                            spacing: 8
+
+                                                            Text {
+                                                                text: (installState.started || installState.awaitingAuth || installState.installDone) ? "🐳" : "⚙"
+                                                                color: "#6EE7FF"
+                                                                font.pixelSize: 14
+                                                            }
+
+                                                            Text {
+                                                                text: (installState.started || installState.awaitingAuth || installState.installDone) ? "Docker Pull Log" : "Installation Log"
+                                                                color: "#93C5FD"
+                                                                font.pixelSize: 11
+                                                                font.weight: Font.Medium
+                                                            }
+
+                                                            Item { Layout.fillWidth: true }
+
+                                                            Rectangle {
+                                                                width: 6
+                                                                height: 6
+                                                                radius: 3
+                                                                color: "#22C55E"
+                                                                opacity: 0.8
+                                                                visible: installTimer.running || AppController.installPrereqsRunning
+
+                                                                SequentialAnimation on opacity {
+                                                                    running: installTimer.running || AppController.installPrereqsRunning
+                                                                    loops: Animation.Infinite
+                                                                    NumberAnimation { from: 0.3; to: 1.0; duration: 600 }
+                                                                    NumberAnimation { from: 1.0; to: 0.3; duration: 600 }
+                                                                }
+                                                            }
+
+                                                            Text {
+                                                                text: (installTimer.running || AppController.installPrereqsRunning) ? "ACTIVE" : "IDLE"
+                                                                color: (installTimer.running || AppController.installPrereqsRunning) ? "#22C55E" : "#64748B"
+                                                                font.pixelSize: 10
+                                                                font.weight: Font.Bold
+                                                                font.letterSpacing: 0.5
+                                                            }
+                                                        }
                                                     }
-                                                }
-                                            }
 
-                                            Flickable {
-                                                id: dockerLogFlickable
-                                                anchors.fill: parent
-                                                anchors.topMargin: 42
-                                                anchors.leftMargin: 12
-                                                anchors.rightMargin: 12
-                                                anchors.bottomMargin: 12
-                                                clip: true
-                                                contentWidth: dockerLogText.implicitWidth
-                                                contentHeight: dockerLogText.implicitHeight
-                                                boundsBehavior: Flickable.StopAtBounds
-                                                ScrollBar.horizontal: ScrollBar { policy: ScrollBar.AsNeeded }
-                                                ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
-                                                onContentYChanged: dockerLogPanel.updateStickState()
-                                                onContentHeightChanged: {
-                                                    if (dockerLogPanel.stickToBottom)
-                                                        dockerLogPanel.scrollToBottom();
-                                                }
+                                                    Flickable {
+                                                        id: dockerLogFlickable
+                                                        anchors.fill: parent
+                                                        anchors.topMargin: 42
+                                                        anchors.leftMargin: 12
+                                                        anchors.rightMargin: 12
+                                                        anchors.bottomMargin: 12
+                                                        clip: true
+                                                        contentWidth: dockerLogText.implicitWidth
+                                                        contentHeight: dockerLogText.implicitHeight
+                                                        boundsBehavior: Flickable.StopAtBounds
+                                                        ScrollBar.horizontal: ScrollBar { policy: ScrollBar.AsNeeded }
+                                                        ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
+                                                        onContentYChanged: dockerLogPanel.updateStickState()
+                                                        onContentHeightChanged: {
+                                                            if (dockerLogPanel.stickToBottom)
+                                                                dockerLogPanel.scrollToBottom();
+                                                        }
 
-                                                TextArea {
-                                                    id: dockerLogText
-                                                    text: (installState.started || installState.awaitingAuth || installState.installDone)
-                                                        ? (AppController.dockerPullLog.length ? AppController.dockerPullLog : "Waiting for docker output...")
-                                                        : (AppController.installPrereqsLog.length
-                                                            ? AppController.installPrereqsLog
-                                                            : (AppController.installPrereqsRunning || AppController.installPrereqsDone
-                                                                ? ""
-                                                                : "Waiting for install output..."))
-                                                    readOnly: true
-                                                    textFormat: TextEdit.PlainText
-                                                    wrapMode: TextEdit.NoWrap
-                                                    font.family: "JetBrains Mono, Consolas, Monaco, Monospace"
-                                                    font.pixelSize: 12
-                                                    color: (AppController.dockerPullLog.length || AppController.installPrereqsLog.length) ? "#E0E7FF" : "#64748B"
-                                                    background: null
-                                                    width: implicitWidth
-                                                    height: implicitHeight
-                                                    bottomPadding: 10
-                                                    rightPadding: 10
-                                                    onTextChanged: {
-                                                        if (dockerLogPanel.stickToBottom)
-                                                            dockerLogPanel.scrollToBottom();
+                                                        TextArea {
+                                                            id: dockerLogText
+                                                            text: (installState.started || installState.awaitingAuth || installState.installDone)
+                                                                ? (AppController.dockerPullLog.length ? AppController.dockerPullLog : "Waiting for docker output...")
+                                                                : (AppController.installPrereqsLog.length
+                                                                    ? AppController.installPrereqsLog
+                                                                    : (AppController.installPrereqsRunning || AppController.installPrereqsDone
+                                                                        ? ""
+                                                                        : "Waiting for install output..."))
+                                                            readOnly: true
+                                                            textFormat: TextEdit.PlainText
+                                                            wrapMode: TextEdit.NoWrap
+                                                            font.family: "JetBrains Mono, Consolas, Monaco, Monospace"
+                                                            font.pixelSize: 12
+                                                            color: (AppController.dockerPullLog.length || AppController.installPrereqsLog.length) ? "#E0E7FF" : "#64748B"
+                                                            background: null
+                                                            width: implicitWidth
+                                                            height: implicitHeight
+                                                            bottomPadding: 10
+                                                            rightPadding: 10
+                                                            onTextChanged: {
+                                                                if (dockerLogPanel.stickToBottom)
+                                                                    dockerLogPanel.scrollToBottom();
+                                                            }
+                                                        }
                                                     }
+                                                    Component.onCompleted: scrollToBottom()
                                                 }
                                             }
-                                            Component.onCompleted: scrollToBottom()
                                         }
                                     }
+
                                 }
                             }
-
                         }
 
                     // Finish
-                    ColumnLayout {
-                        spacing: 14
-                        Layout.fillWidth: true
-                        Layout.fillHeight: true
-
-                            AppCard {
+                    PageLoader {
+                        step: 3
+                        currentStep: AppController.currentStep
+                        preload: root.firstFrameShown
+                        sourceComponent: Component {
+                            ColumnLayout {
+                                spacing: 14
                                 Layout.fillWidth: true
-                                title: "Run"
-                                subtitle: "Installation completed"
-                                cardSpacing: 6
-                                contentItem: ColumnLayout {
-                                    spacing: 10
-                                    Text {
+                                Layout.fillHeight: true
+
+                                    AppCard {
                                         Layout.fillWidth: true
-                                        Layout.topMargin: 1
-                                        wrapMode: Text.WordWrap
-                                        color: root.textInfo
-                                        text: "Safecore has been installed successfully on your device."
-                                    }
-                                    Item { height: 50 }
-                                    CheckBox {
-                                        id: launchCheck
-                                        text: "Run Safecore"
-                                        checked: true
-                                        spacing: 10
-                                        indicator: null
-                                        contentItem: Row {
+                                        title: "Run"
+                                        subtitle: "Installation completed"
+                                        cardSpacing: 6
+                                        contentItem: ColumnLayout {
                                             spacing: 10
-                                            Rectangle {
-                                                width: 20
-                                                height: 20
-                                                radius: 4
-                                                color: launchCheck.checked ? root.accent : root.bgLog
-                                                border.color: launchCheck.checked ? root.textInfo : root.borderPrimary
-                                                border.width: 1
-                                                Text {
-                                                    anchors.centerIn: parent
-                                                    text: launchCheck.checked ? "\u2713" : ""
-                                                    color: root.bgPrimary
-                                                    font.pixelSize: 13
-                                                    font.bold: true
+                                            Text {
+                                                Layout.fillWidth: true
+                                                Layout.topMargin: 1
+                                                wrapMode: Text.WordWrap
+                                                color: root.textInfo
+                                                text: "Safecore has been installed successfully on your device."
+                                            }
+                                            Item { height: 50 }
+                                            CheckBox {
+                                                id: launchCheck
+                                                text: "Run Safecore"
+                                                checked: root.launchAfterInstall
+                                                onToggled: root.launchAfterInstall = checked
+                                                spacing: 10
+                                                indicator: null
+                                                contentItem: Row {
+                                                    spacing: 10
+                                                    Rectangle {
+                                                        width: 20
+                                                        height: 20
+                                                        radius: 4
+                                                        color: launchCheck.checked ? root.accent : root.bgLog
+                                                        border.color: launchCheck.checked ? root.textInfo : root.borderPrimary
+                                                        border.width: 1
+                                                        Text {
+                                                            anchors.centerIn: parent
+                                                            text: launchCheck.checked ? "\u2713" : ""
+                                                            color: root.bgPrimary
+                                                            font.pixelSize: 13
+                                                            font.bold: true
+                                                        }
+                                                    }
+                                                    Text {
+                                                        text: launchCheck.text
+                                                        color: root.textPrimary
+                                                        font.pixelSize: 15
+                                                        verticalAlignment: Text.AlignVCenter
+                                                    }
                                                 }
                                             }
+                                            Item { Layout.fillHeight: true }
                                             Text {
-                                                text: launchCheck.text
-                                                color: root.textPrimary
-                                                font.pixelSize: 15
-                                                verticalAlignment: Text.AlignVCenter
+                                                Layout.fillWidth: true
+                                                Layout.topMargin: 6
+                                                wrapMode: Text.WordWrap
+                                                color: root.textSecondary
+                                                text: "Click Run to Start the SafeCore."
+                                                font.pixelSize: 13
                                             }
+                                            Item { height: 6 }
                                         }
                                     }
+
                                     Item { Layout.fillHeight: true }
+                            }
+                        }
+                    }
+
+                DialogLoader {
+                    id: quitDialogLoader
+                    sourceComponent: Component {
+                        Dialog {
+                            id: quitDialog
+                            modal: true
+                            parent: root.contentItem
+                            closePolicy: Popup.NoAutoClose
+                            title: "Quit Installer"
+                            anchors.centerIn: parent
+                            implicitWidth: 650
+                            implicitHeight: header.height + contentItem.implicitHeight + 24
+                            header: Rectangle {
+                                height: 44
+                                color: root.bgPopup
+                                border.color: root.borderPrimary
+                                border.width: 1
+                                Row {
+                                    anchors.verticalCenter: parent.verticalCenter
+                                    anchors.left: parent.left
+                                    anchors.leftMargin: 18
+                                    spacing: 8
+                                    Image {
+                                        anchors.verticalCenter: parent.verticalCenter
+                                        source: "qrc:/images/icons/quit_icon.png"
+                                        width: 18
+                                        height: 18
+                                        fillMode: Image.PreserveAspectFit
+                                        smooth: true
+                                        sourceSize.width: 18
+                                        sourceSize.height: 18
+                                    }
                                     Text {
-                                        Layout.fillWidth: true
-                                        Layout.topMargin: 6
-                                        wrapMode: Text.WordWrap
-                                        color: root.textSecondary
-                                        text: "Click Run to Start the SafeCore."
-                                        font.pixelSize: 13
+                                        anchors.verticalCenter: parent.verticalCenter
+                                        text: quitDialog.title
+                                        color: root.textPrimary
+                                        font.pixelSize: 16
+                                        font.bold: true
                                     }
-                                    Item { height: 6 }
                                 }
                             }
-
-                            Item { Layout.fillHeight: true }
-                }
-
-                Dialog {
-                    id: quitDialog
-                    modal: true
-                    parent: root.contentItem
-                    closePolicy: Popup.NoAutoClose
-                    title: "Quit Installer"
-                    anchors.centerIn: parent
-                    implicitWidth: 650
-                    implicitHeight: header.height + contentItem.implicitHeight + 24
-                    header: Rectangle {
-                        height: 44
-                        color: root.bgPopup
-                        border.color: root.borderPrimary
-                        border.width: 1
-                        Row {
-                            anchors.verticalCenter: parent.verticalCenter
-                            anchors.left: parent.left
-                            anchors.leftMargin: 18
-                            spacing: 8
-                            Image {
-                                anchors.verticalCenter: parent.verticalCenter
-                                source: "qrc:/images/icons/quit_icon.png"
-                                width: 18
-                                height: 18
-                                fillMode: Image.PreserveAspectFit
-                                smooth: true
-                                sourceSize.width: 18
-                                sourceSize.height: 18
-                            }
-                            Text {
-                                anchors.verticalCenter: parent.verticalCenter
-                                text: quitDialog.title
-                                color: root.textPrimary
-                                font.pixelSize: 16
-                                font.bold: true
+                            background: Rectangle {
+                                radius: 14
+                                color: root.bgPopup
+                                border.color: root.borderPrimary
+                                border.width: 1
                             }
-                        }
-                    }
-                    background: Rectangle {
-                        radius: 14
-                        color: root.bgPopup
-                        border.color: root.borderPrimary
-                        border.width: 1
-                    }
 
-                    property string messageText: "Do you want to quit the installer application?"
-                    contentItem: Item {
-                        implicitHeight: bodyLayout.implicitHeight
-                        implicitWidth: bodyLayout.implicitWidth
-                        ColumnLayout {
-                            id: bodyLayout
-                            anchors.fill: parent
-                            anchors.margins: 18
-                            spacing: 12
+                            property string messageText: "Do you want to quit the installer application?"
+                            contentItem: Item {
+                                implicitHeight: bodyLayout.implicitHeight
+                                implicitWidth: bodyLayout.implicitWidth
+                                ColumnLayout {
+                                    id: bodyLayout
+                                    anchors.fill: parent
+                                    anchors.margins: 18
+                                    spacing: 12
 
-                        Text {
-                            Layout.fillWidth: true
-                            wrapMode: Text.WordWrap
-                            color: root.textSecondary
-                            text: quitDialog.messageText
-                        }
+                                Text {
+                                    Layout.fillWidth: true
+                                    wrapMode: Text.WordWrap
+                                    color: root.textSecondary
+                                    text: quitDialog.messageText
+                                }
 
-                        Item { Layout.fillHeight: true }
+                                Item { Layout.fillHeight: true }
 
-                            RowLayout {
-                                Layout.fillWidth: true
-                                spacing: 10
-                                Item { Layout.fillWidth: true }
-                                AppButton {
-                                    text: "No"
-                                    enabled: true
-                                    accent: root.buttonSecondary
-                                    implicitWidth: 120
-                                    implicitHeight: 44
-                                    onClicked: quitDialog.close()
-                                }
-                                AppButton {
-                                    text: "Yes"
-                                    enabled: true
-                                    accent: root.accent
-                                    implicitWidth: 120
-                                    implicitHeight: 44
-                                    onClicked: {
-                                        quitDialog.close()
-                                        root.allowClose = true
-                                        root.close()
+                                    RowLayout {
+                                        Layout.fillWidth: true
+                                        spacing: 10
+                                        Item { Layout.fillWidth: true }
+                                        AppButton {
+                                            text: "No"
+                                            enabled: true
+                                            accent: root.buttonSecondary
+                                            implicitWidth: 120
+                                            implicitHeight: 44
+                                            onClicked: quitDialog.close()
+                                        }
+                                        AppButton {
+                                            text: "Yes"
+                                            enabled: true
+                                            accent: root.accent
+                                            implicitWidth: 120
+                                            implicitHeight: 44
+                                            onClicked: {
+                                                quitDialog.close()
+                                                root.allowClose = true
+                                                root.close()
+                                            }
+                                        }
                                     }
+                                    Item { height: 4 }
                                 }
                             }
-                            Item { height: 4 }
                         }
                     }
                 }
 
-                Dialog {
-                    id: cancelDialog
-                    modal: true
-                    parent: root.contentItem
-                    closePolicy: Popup.NoAutoClose
-                    title: "Cancel Operation"
-                    anchors.centerIn: parent
-                    implicitWidth: 650
-                    implicitHeight: header.height + contentItem.implicitHeight + 24
-                    header: Rectangle {
-                        height: 44
-                        color: root.bgPopup
-                        border.color: root.borderPrimary
-                        border.width: 1
-                        Text {
-                            anchors.verticalCenter: parent.verticalCenter
-                            anchors.left: parent.left
-                            anchors.leftMargin: 18
-                            text: cancelDialog.title
-                            color: root.textPrimary
-                            font.pixelSize: 16
-                            font.bold: true
-                        }
-                    }
-                    background: Rectangle {
-                        radius: 14
-                        color: root.bgPopup
-                        border.color: root.borderPrimary
-                        border.width: 1
-                    }
-                    contentItem: Item {
-                        implicitHeight: cancelBody.implicitHeight
-                        implicitWidth: cancelBody.implicitWidth
-                        ColumnLayout {
-                            id: cancelBody
-                            anchors.fill: parent
-                            anchors.margins: 18
-                            spacing: 12
-
-                            Text {
-                                Layout.fillWidth: true
-                                wrapMode: Text.WordWrap
-                                color: root.textSecondary
-                                text: "Do you want to cancel pulling the docker image?"
+                DialogLoader {
+                    id: cancelDialogLoader
+                    sourceComponent: Component {
+                        Dialog {
+                            id: cancelDialog
+                            modal: true
+                            parent: root.contentItem
+                            closePolicy: Popup.NoAutoClose
+                            title: "Cancel Operation"
+                            anchors.centerIn: parent
+                            implicitWidth: 650
+                            implicitHeight: header.height + contentItem.implicitHeight + 24
+                            header: Rectangle {
+                                height: 44
+                                color: root.bgPopup
+                                border.color: root.borderPrimary
+                                border.width: 1
+                                Text {
+                                    anchors.verticalCenter: parent.verticalCenter
+                                    anchors.left: parent.left
+                                    anchors.leftMargin: 18
+                                    text: cancelDialog.title
+                                    color: root.textPrimary
+                                    font.pixelSize: 16
+                                    font.bold: true
+                                }
                             }
+                            background: Rectangle {
+                                radius: 14
+                                color: root.bgPopup
+                                border.color: root.borderPrimary
+                                border.width: 1
+                            }
+                            contentItem: Item {
+                                implicitHeight: cancelBody.implicitHeight
+                                implicitWidth: cancelBody.implicitWidth
+                                ColumnLayout {
+                                    id: cancelBody
+                                    anchors.fill: parent
+                                    anchors.margins: 18
+                                    spacing: 12
 
-                            Item { Layout.fillHeight: true }
+                                    Text {
+                                        Layout.fillWidth: true
+                                        wrapMode: Text.WordWrap
+                                        color: root.textSecondary
+                                        text: "Do you want to cancel pulling the docker image?"
+                                    }
 
-                            RowLayout {
-                                Layout.fillWidth: true
-                                spacing: 10
-                                Item { Layout.fillWidth: true }
-                                AppButton {
-                                    text: "No"
-                                    enabled: true
-                                    accent: root.buttonSecondary
-                                    implicitWidth: 120
-                                    implicitHeight: 44
-                                    onClicked: cancelDialog.close()
-                                }
-                                    AppButton {
-                                        text: "Yes"
-                                        enabled: true
-                                        accent: root.accentError
-                                        implicitWidth: 120
-                                        implicitHeight: 44
-                                        onClicked: {
-                                            cancelDialog.close()
-                                            if (AppController.installPrereqsRunning) {
-                                                AppController.cancelInstallPrereqs()
-                                                AppController.clearInstallPrereqsLog()
-                                                installState.showLogs = false
-                                                installState.statusText = "Ready to Install."
-                                                installState.pullErrorMessage = "Docker installation canceled."
-                                                return
+                                    Item { Layout.fillHeight: true }
+
+                                    RowLayout {
+                                        Layout.fillWidth: true
+                                        spacing: 10
+                                        Item { Layout.fillWidth: true }
+                                        AppButton {
+                                            text: "No"
+                                            enabled: true
+                                            accent: root.buttonSecondary
+                                            implicitWidth: 120
+                                            implicitHeight: 44
+                                            onClicked: cancelDialog.close()
+                                        }
+                                            AppButton {
+                                                text: "Yes"
+                                                enabled: true
+                                                accent: root.accentError
+                                                implicitWidth: 120
+                                                implicitHeight: 44
+                                                onClicked: {
+                                                    cancelDialog.close()
+                                                    if (AppController.installPrereqsRunning) {
+                                                        AppController.cancelInstallPrereqs()
+                                                        AppController.clearInstallPrereqsLog()
+                                                        installState.showLogs = false
+                                                        installState.statusText = "Ready to Install."
+                                                        installState.pullErrorMessage = "Docker installation canceled."
+                                                        return
+                                                    }
+                                                    // Set cancelPending first, then cancel - let onDockerPullFinished handle the reset
+                                                    installState.cancelPending = true
+                                                    installState.statusText = "Canceling..."
+                                                    AppController.cancelDockerPull()
                                             }
-                                            // Set cancelPending first, then cancel - let onDockerPullFinished handle the reset
-                                            installState.cancelPending = true
-                                            installState.statusText = "Canceling..."
-                                            AppController.cancelDockerPull()
+                                        }
                                     }
+                                    Item { height: 4 }
                                 }
                             }
-                            Item { height: 4 }
                         }
                     }
                 }
 
                 Connections {
                     target: AppController
+                    // One Register click runs register, relay sync and tenant
+                    // setup; the button names the step that is running
+                    function onProvisioningChanged() {
+                        if (AppController.provisioning)
+                            root.provisioningText = "Registering..."
+                    }
+                    function onProvisioningStep(step, ok, message, elapsedMs) {
+                        if (!ok)
+                            return
+                        if (step === "register")
+                            root.provisioningText = "Syncing..."
+                        else if (step === "relay")
+                            root.provisioningText = "Setting up..."
+                    }
+                    function onProvisioningFinished(ok, message, elapsedMs) {
+                        if (registrationPage.item)
+                            registrationPage.item.scheduleScrollToBottom()
+                    }
                     function onSyncResult(ok, message) {
                         rightStack.syncSuccess = ok
                         rightStack.syncMessage = message.length
                             ? message
                             : (ok ? "Sync API registration completed successfully." : "Sync API registration failed.")
                         if (ok) {
-                            registrationScroll.scheduleScrollToBottom()
+                            if (registrationPage.item)
+                                registrationPage.item.scheduleScrollToBottom()
                         }
                     }
                     function onDockerRunFinished(ok) {
@@ -1557,6 +1625,15 @@ Window {
                             Qt.quit()
                         }
                     }
+                    function onDockerOpsAppLaunched(ok) {
+                        if (!ok) {
+                            console.log("Failed to launch Docker Ops:", AppController.statusText)
+                            return
+                        }
+                        console.log("Docker Ops launched, closing installer")
+                        root.allowClose = true
+                        Qt.quit()
+                    }
                     function onDockerOpsFinished(ok, message) {
                         if (root.runDockerAndQuit) {
                             root.allowClose = true
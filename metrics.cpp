@@ -0,0 +1,170 @@
+#include "metrics.h"
+#include "appconstants.h"
+
+namespace {
+const char *operationName(int operation)
+{
+    static const char *names[] = {"run", "restart", "stop", "upgrade"};
+    return names[operation];
+}
+
+const char *stateName(int state)
+{
+    static const char *names[] = {"starting", "running", "stopping", "stopped"};
+    return names[state];
+}
+
+const char *streamName(int stream)
+{
+    static const char *names[] = {"pull", "upgrade", "container"};
+    return names[stream];
+}
+
+QByteArray number(double value)
+{
+    return QByteArray::number(value, 'g', 12);
+}
+
+void header(QByteArray &out, const char *name, const char *type, const char *help)
+{
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void sample(QByteArray &out, const char *name, const QByteArray &labels, double value)
+{
+    out += name;
+    if (!labels.isEmpty())
+        out += '{' + labels + '}';
+    out += ' ';
+    out += number(value);
+    out += '\n';
+}
+
+void histogram(QByteArray &out, const char *name, const QByteArray &labels, const Metrics::Histogram &h)
+{
+    const QByteArray prefix = labels.isEmpty() ? QByteArray() : labels + ',';
+    const QByteArray bucketName = QByteArray(name) + "_bucket";
+    quint64 cumulative = 0;
+    for (int i = 0; i < Metrics::Histogram::BucketCount; ++i) {
+        cumulative += h.bucket(i);
+        sample(out, bucketName.constData(), prefix + "le=\"" + number(Metrics::Histogram::bounds()[i]) + '"',
+               double(cumulative));
+    }
+    cumulative += h.bucket(Metrics::Histogram::BucketCount);
+    sample(out, bucketName.constData(), prefix + "le=\"+Inf\"", double(cumulative));
+    sample(out, (QByteArray(name) + "_sum").constData(), labels, h.sum());
+    sample(out, (QByteArray(name) + "_count").constData(), labels, double(h.count()));
+}
+} // namespace
+
+const double *Metrics::Histogram::bounds()
+{
+    static const double values[BucketCount] = {0.1, 0.5, 1, 2.5, 5, 10, 30, 60, 300, 1800};
+    return values;
+}
+
+void Metrics::Histogram::observe(double seconds)
+{
+    int bucket = 0;
+    while (bucket < BucketCount && seconds > bounds()[bucket])
+        ++bucket;
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumMicros.fetch_add(quint64(qMax(0.0, seconds) * 1e6), std::memory_order_relaxed);
+}
+
+double Metrics::Histogram::sum() const
+{
+    return double(m_sumMicros.load(std::memory_order_relaxed)) / 1e6;
+}
+
+Metrics::Metrics()
+{
+    for (const QString &mapping : AppConstants::ContainerPorts)
+        m_ports.append(mapping.section(':', 0, 0));
+    m_portReadySeconds.reset(new Gauge[m_ports.size()]);
+    m_portUp.reset(new Gauge[m_ports.size()]);
+}
+
+Metrics &Metrics::global()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+QByteArray Metrics::render() const
+{
+    QByteArray out;
+    out.reserve(8192);
+
+    header(out, "safecore_pull_bytes_total", "counter", "Bytes downloaded by docker pulls.");
+    sample(out, "safecore_pull_bytes_total", QByteArray(), double(pullBytes.value()));
+    header(out, "safecore_pull_throughput_bytes_per_second", "gauge", "Measured download rate.");
+    sample(out, "safecore_pull_throughput_bytes_per_second", QByteArray(), pullThroughput.value());
+    header(out, "safecore_pull_layers", "gauge", "Layers in the current or last pull.");
+    sample(out, "safecore_pull_layers", QByteArray(), pullLayers.value());
+    header(out, "safecore_pull_layers_done", "gauge", "Layers finished in the current or last pull.");
+    sample(out, "safecore_pull_layers_done", QByteArray(), pullLayersDone.value());
+
+    header(out, "safecore_registry_login_duration_seconds", "histogram", "Time taken by docker login.");
+    histogram(out, "safecore_registry_login_duration_seconds", QByteArray(), loginDuration);
+    header(out, "safecore_registry_login_failures_total", "counter", "Failed docker logins.");
+    sample(out, "safecore_registry_login_failures_total", QByteArray(), double(loginFailures.value()));
+
+    header(out, "safecore_operation_duration_seconds", "histogram", "Duration of container operations.");
+    for (int i = 0; i < OperationCount; ++i) {
+        histogram(out, "safecore_operation_duration_seconds",
+                  QByteArray("operation=\"") + operationName(i) + '"', operationDuration[i]);
+    }
+    header(out, "safecore_operation_failures_total", "counter", "Container operations that failed.");
+    for (int i = 0; i < OperationCount; ++i) {
+        sample(out, "safecore_operation_failures_total", QByteArray("operation=\"") + operationName(i) + '"',
+               double(operationFailures[i].value()));
+    }
+
+    header(out, "safecore_container_transitions_total", "counter", "Container state changes, by new state.");
+    for (int i = 0; i < ContainerStateCount; ++i) {
+        sample(out, "safecore_container_transitions_total", QByteArray("state=\"") + stateName(i) + '"',
+               double(containerTransitions[i].value()));
+    }
+    header(out, "safecore_container_running", "gauge", "1 while the SafeCore container is running.");
+    sample(out, "safecore_container_running", QByteArray(), containerRunning.value());
+    header(out, "safecore_container_precreate_seconds", "gauge",
+           "Time taken to create the container right after the pull, off the first start's path.");
+    sample(out, "safecore_container_precreate_seconds", QByteArray(), containerPrecreateSeconds.value());
+
+    header(out, "safecore_port_ready_seconds", "gauge",
+           "Seconds from container start until the port accepted a connection.");
+    for (int i = 0; i < m_ports.size(); ++i) {
+        sample(out, "safecore_port_ready_seconds", "port=\"" + m_ports.at(i).toLatin1() + '"',
+               m_portReadySeconds[i].value());
+    }
+    header(out, "safecore_port_up", "gauge", "1 once the port has accepted a connection since the last start.");
+    for (int i = 0; i < m_ports.size(); ++i)
+        sample(out, "safecore_port_up", "port=\"" + m_ports.at(i).toLatin1() + '"', m_portUp[i].value());
+
+    header(out, "safecore_log_lines_total", "counter", "Log lines received, by stream.");
+    for (int i = 0; i < LogStreamCount; ++i) {
+        sample(out, "safecore_log_lines_total", QByteArray("stream=\"") + streamName(i) + '"',
+               double(logLines[i].value()));
+    }
+
+    header(out, "safecore_state_load_seconds", "gauge", "Time taken to load the persisted installer state.");
+    sample(out, "safecore_state_load_seconds", QByteArray(), stateLoadSeconds.value());
+    header(out, "safecore_state_commit_seconds", "gauge", "Time taken by the last durable state write.");
+    sample(out, "safecore_state_commit_seconds", QByteArray(), stateCommitSeconds.value());
+    header(out, "safecore_state_commits_total", "counter", "Durable writes of the installer state.");
+    sample(out, "safecore_state_commits_total", QByteArray(), double(stateCommits.value()));
+    header(out, "safecore_state_journal_replays_total", "counter",
+           "Interrupted state writes completed from the journal at startup.");
+    sample(out, "safecore_state_journal_replays_total", QByteArray(), double(stateJournalReplays.value()));
+    return out;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+// Telemetry for the installer and container operations, rendered in the
+// Prometheus text format by MetricsServer. Every value is a relaxed atomic,
+// so instrumenting a hot path costs one uncontended atomic add and never
+// takes a lock. The label sets are fixed, so a metric is a plain member and
+// not a lookup.
+class Metrics
+{
+public:
+    enum Operation { OperationRun, OperationRestart, OperationStop, OperationUpgrade, OperationCount };
+    enum ContainerState { StateStarting, StateRunning, StateStopping, StateStopped, ContainerStateCount };
+    enum LogStream { LogPull, LogUpgrade, LogContainer, LogStreamCount };
+
+    class Counter
+    {
+    public:
+        void add(quint64 value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+        quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<quint64> m_value{0};
+    };
+
+    class Gauge
+    {
+    public:
+        void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+        double value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> m_value{0.0};
+    };
+
+    // Cumulative buckets in seconds, like a Prometheus histogram
+    class Histogram
+    {
+    public:
+        static constexpr int BucketCount = 10;
+        static const double* bounds();
+
+        void observe(double seconds);
+        quint64 bucket(int index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+        quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+        double sum() const;
+
+    private:
+        std::atomic<quint64> m_buckets[BucketCount + 1] = {};   // last one is +Inf
+        std::atomic<quint64> m_count{0};
+        std::atomic<quint64> m_sumMicros{0};
+    };
+
+    static Metrics& global();
+
+    // Set when an endpoint is serving; instrumentation that needs work of
+    // its own (port probing) only runs while this is on.
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+
+    QByteArray render() const;
+
+    Counter pullBytes;
+    Gauge pullThroughput;
+    Gauge pullLayers;
+    Gauge pullLayersDone;
+    Histogram loginDuration;
+    Counter loginFailures;
+    Histogram operationDuration[OperationCount];
+    Counter operationFailures[OperationCount];
+    Counter containerTransitions[ContainerStateCount];
+    Gauge containerRunning;
+    Gauge containerPrecreateSeconds;
+    Counter logLines[LogStreamCount];
+    Gauge stateLoadSeconds;
+    Gauge stateCommitSeconds;
+    Counter stateCommits;
+    Counter stateJournalReplays;
+
+    // One entry per host port in AppConstants::ContainerPorts
+    const QStringList& ports() const { return m_ports; }
+    Gauge& portReadySeconds(int index) { return m_portReadySeconds[index]; }
+    Gauge& portUp(int index) { return m_portUp[index]; }
+
+private:
+    Metrics();
+
+    std::atomic<bool> m_enabled{false};
+    QStringList m_ports;
+    std::unique_ptr<Gauge[]> m_portReadySeconds;
+    std::unique_ptr<Gauge[]> m_portUp;
+};
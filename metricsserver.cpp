@@ -0,0 +1,85 @@
+#include "metricsserver.h"
+#include "metrics.h"
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace {
+// A scrape request is a few hundred bytes; anything past this is not one
+constexpr int MaxRequestBytes = 16 * 1024;
+constexpr int IdleTimeoutMs = 5000;
+
+QByteArray response(int status, const QByteArray &reason, const QByteArray &contentType, const QByteArray &body)
+{
+    QByteArray out = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason + "\r\n";
+    out += "Content-Type: " + contentType + "\r\n";
+    out += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    out += "Connection: close\r\n\r\n";
+    out += body;
+    return out;
+}
+} // namespace
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+MetricsServer::~MetricsServer()
+{
+    Metrics::global().setEnabled(false);
+}
+
+bool MetricsServer::listen(const QHostAddress &address, quint16 port)
+{
+    if (!m_server.listen(address, port))
+        return false;
+    Metrics::global().setEnabled(true);
+    return true;
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        m_buffers.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+        // Drop clients that connect and never finish a request
+        QTimer::singleShot(IdleTimeoutMs, socket, [socket]() { socket->abort(); });
+    }
+}
+
+void MetricsServer::onReadyRead(QTcpSocket *socket)
+{
+    auto it = m_buffers.find(socket);
+    if (it == m_buffers.end())
+        return;
+    it->append(socket->readAll());
+    if (it->size() > MaxRequestBytes) {
+        socket->abort();
+        return;
+    }
+    if (!it->contains("\r\n\r\n"))
+        return;
+
+    const QList<QByteArray> requestLine = it->left(it->indexOf("\r\n")).split(' ');
+    const QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+    const int query = path.indexOf('?');
+    if (query >= 0)
+        path.truncate(query);
+    m_buffers.erase(it);
+
+    if ((method == "GET" || method == "HEAD") && path == "/metrics") {
+        QByteArray reply = response(200, "OK", "text/plain; version=0.0.4; charset=utf-8", Metrics::global().render());
+        if (method == "HEAD")
+            reply.truncate(reply.indexOf("\r\n\r\n") + 4);
+        socket->write(reply);
+    } else {
+        socket->write(response(404, "Not Found", "text/plain", "Not found. Metrics are at /metrics.\n"));
+    }
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+// Serves Metrics::global() at GET /metrics for a local Prometheus scraper.
+// One request per connection; anything else gets a 404.
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsServer(QObject* parent = nullptr);
+    ~MetricsServer() override;
+
+    bool listen(const QHostAddress& address, quint16 port);
+    QString errorString() const { return m_server.errorString(); }
+
+private:
+    void onNewConnection();
+    void onReadyRead(QTcpSocket* socket);
+
+    QTcpServer m_server;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+};
@@ -0,0 +1,239 @@
+#include "modelvolumesync.h"
+#include "dockerscript.h"
+#include <QThread>
+#include <algorithm>
+
+namespace {
+const QString ManifestFileName = ".safecore_manifest";
+
+int copyParallelism()
+{
+    return std::clamp(QThread::idealThreadCount(), 2, 4);
+}
+
+QString normalizeManifestPath(QString path)
+{
+    if (path.startsWith("./"))
+        path.remove(0, 2);
+    return path;
+}
+} // namespace
+
+ModelVolumeSync::ModelVolumeSync(QObject *parent)
+    : QObject(parent)
+{}
+
+ModelVolumeSync::~ModelVolumeSync()
+{
+    if (m_process) {
+        m_process->disconnect(this);
+        if (m_process->state() != QProcess::NotRunning) {
+            m_process->kill();
+            m_process->waitForFinished(1000);
+        }
+        m_process->deleteLater();
+        m_process = nullptr;
+    }
+}
+
+void ModelVolumeSync::start(const QString &image, const QString &volume, const QString &modelPath)
+{
+    if (m_process)
+        return;
+
+    m_image = image;
+    m_volume = volume;
+    m_modelPath = modelPath;
+    m_imageManifest.clear();
+    m_copyBytes = 0;
+    m_canceled = false;
+    m_timer.start();
+
+    emit logLine(QString("Comparing models in %1 with volume %2...").arg(m_image, m_volume));
+
+    // Every line is tagged so both manifests come back in a single pass:
+    //   S <side> <size> <path>   file size
+    //   H <side> <hash> <path>   sha256 of the file
+    //   C <path> <size> <hash>   cached volume entry from the last sync
+    // The volume side trusts its cached hashes and only re-lists sizes, so a
+    // sync over an unchanged volume does not re-read gigabytes of models.
+    const QString jobs = QString::number(copyParallelism());
+    QString script;
+    script += "side() {\n";
+    script += "  cd \"$2\" 2>/dev/null || return 0\n";
+    script += QString("  find . -type f ! -name %1 -print0 | xargs -0 -r stat -c \"S\t$1\t%s\t%n\"\n").arg(ManifestFileName);
+    script += QString("  find . -type f ! -name %1 -print0 | xargs -0 -r -n 8 -P %2 sha256sum"
+                      " | sed \"s/^\\([0-9a-f]*\\)  /H\t$1\t\\1\t/\"\n").arg(ManifestFileName, jobs);
+    script += "}\n";
+    script += QString("side image '%1'\n").arg(m_modelPath);
+    script += QString("if [ -f /vol/%1 ]; then\n").arg(ManifestFileName);
+    script += QString("  sed 's/^/C\t/' /vol/%1\n").arg(ManifestFileName);
+    script += QString("  cd /vol && find . -type f ! -name %1 -print0 | xargs -0 -r stat -c \"S\tvolume\t%s\t%n\"\n").arg(ManifestFileName);
+    script += "else\n";
+    script += "  side volume /vol\n";
+    script += "fi\n";
+
+    runHelper(script.toUtf8(), [this](bool ok, const QByteArray &output) {
+        if (m_canceled)
+            return;
+        if (!ok) {
+            finish(false, "Model sync failed: unable to read model manifests.");
+            return;
+        }
+
+        Manifest volumeManifest;
+        parseManifests(output, &m_imageManifest, &volumeManifest);
+        if (m_imageManifest.isEmpty()) {
+            finish(true, "No models shipped in the new image; volume left unchanged.");
+            return;
+        }
+
+        const QStringList changed = changedFiles(m_imageManifest, volumeManifest);
+        emit logLine(QString("Model manifest: %1 file(s) in image, %2 up to date, %3 to copy.")
+                         .arg(m_imageManifest.size())
+                         .arg(m_imageManifest.size() - changed.size())
+                         .arg(changed.size()));
+        copyChanged(changed);
+    });
+}
+
+void ModelVolumeSync::cancel()
+{
+    if (!m_process)
+        return;
+    m_canceled = true;
+    QProcess *process = m_process;
+    m_process = nullptr;
+    process->disconnect(this);
+    if (process->state() != QProcess::NotRunning) {
+        process->terminate();
+        if (!process->waitForFinished(2000)) {
+            process->kill();
+            process->waitForFinished(1000);
+        }
+    }
+    process->deleteLater();
+}
+
+void ModelVolumeSync::parseManifests(const QByteArray &output, Manifest *image, Manifest *volume)
+{
+    Manifest cached;
+    const QList<QByteArray> lines = output.split('\n');
+    for (const QByteArray &rawLine : lines) {
+        const QString line = QString::fromUtf8(rawLine);
+        const QStringList parts = line.split('\t');
+        if (parts.size() < 4)
+            continue;
+        const QString tag = parts.at(0);
+        if (tag == "C") {
+            Entry &entry = cached[normalizeManifestPath(parts.at(1))];
+            entry.size = parts.at(2).toLongLong();
+            entry.hash = parts.at(3).trimmed();
+            continue;
+        }
+        Manifest *target = parts.at(1) == "image" ? image : (parts.at(1) == "volume" ? volume : nullptr);
+        if (!target)
+            continue;
+        const QString path = normalizeManifestPath(parts.mid(3).join('\t'));
+        if (tag == "S")
+            (*target)[path].size = parts.at(2).toLongLong();
+        else if (tag == "H")
+            (*target)[path].hash = parts.at(2);
+    }
+
+    // Cached hashes only count while the file on the volume still has the
+    // size recorded at the last sync.
+    for (auto it = volume->begin(); it != volume->end(); ++it) {
+        if (!it.value().hash.isEmpty())
+            continue;
+        const auto cachedIt = cached.constFind(it.key());
+        if (cachedIt != cached.constEnd() && cachedIt.value().size == it.value().size)
+            it.value().hash = cachedIt.value().hash;
+    }
+}
+
+QStringList ModelVolumeSync::changedFiles(const Manifest &image, const Manifest &volume)
+{
+    QStringList changed;
+    for (auto it = image.constBegin(); it != image.constEnd(); ++it) {
+        const auto current = volume.constFind(it.key());
+        if (current == volume.constEnd()
+            || current.value().size != it.value().size
+            || current.value().hash.isEmpty()
+            || current.value().hash != it.value().hash) {
+            changed.append(it.key());
+        }
+    }
+    std::sort(changed.begin(), changed.end());
+    return changed;
+}
+
+void ModelVolumeSync::copyChanged(const QStringList &files)
+{
+    QString manifest;
+    for (auto it = m_imageManifest.constBegin(); it != m_imageManifest.constEnd(); ++it)
+        manifest += QString("%1\t%2\t%3\n").arg(it.key()).arg(it.value().size).arg(it.value().hash);
+
+    for (const QString &file : files)
+        m_copyBytes += qMax<qint64>(0, m_imageManifest.value(file).size);
+
+    // Copies go to a temporary name first so an interrupted sync never leaves
+    // a truncated model behind under its real name.
+    QString script;
+    script += QString("cd '%1' || exit 1\n").arg(m_modelPath);
+    if (!files.isEmpty()) {
+        script += QString("tr '\\n' '\\0' <<'SAFECORE_FILES' | xargs -0 -r -P %1 -I{} sh -c "
+                          "'mkdir -p \"/vol/$(dirname \"$1\")\" && cp -p \"$1\" \"/vol/$1.safecore-tmp\""
+                          " && mv -f \"/vol/$1.safecore-tmp\" \"/vol/$1\"' _ {} || exit 1\n")
+                      .arg(copyParallelism());
+        script += files.join('\n') + "\nSAFECORE_FILES\n";
+    }
+    script += QString("cat > /vol/%1.tmp <<'SAFECORE_MANIFEST'\n").arg(ManifestFileName);
+    script += manifest;
+    script += "SAFECORE_MANIFEST\n";
+    script += QString("mv -f /vol/%1.tmp /vol/%1\n").arg(ManifestFileName);
+
+    if (!files.isEmpty())
+        emit logLine(QString("Copying %1 model file(s) (%2)...").arg(files.size()).arg(DockerScript::formatBytes(m_copyBytes)));
+
+    const int copied = files.size();
+    runHelper(script.toUtf8(), [this, copied](bool ok, const QByteArray &) {
+        if (m_canceled)
+            return;
+        if (!ok) {
+            finish(false, "Model sync failed while copying changed models.");
+            return;
+        }
+        const double seconds = double(m_timer.elapsed()) / 1000.0;
+        if (copied == 0) {
+            finish(true, QString("Weapons models already up to date (%1 file(s) checked in %2 s).")
+                             .arg(m_imageManifest.size())
+                             .arg(seconds, 0, 'f', 1));
+            return;
+        }
+        finish(true, QString("Synced %1 of %2 weapons model file(s), %3 copied in %4 s.")
+                         .arg(copied)
+                         .arg(m_imageManifest.size())
+                         .arg(DockerScript::formatBytes(m_copyBytes))
+                         .arg(seconds, 0, 'f', 1));
+    });
+}
+
+void ModelVolumeSync::runHelper(const QByteArray &script, std::function<void(bool, const QByteArray&)> done)
+{
+    const QString command = QString("docker run --rm -i -v %1:/vol --entrypoint sh %2 -s").arg(m_volume, m_image);
+    m_process = DockerScript::run(this, "model volume sync", script,
+                                  [this, done](bool ok, const QByteArray &output, const QString &errors) {
+                                      m_process = nullptr;
+                                      if (!ok && !errors.isEmpty())
+                                          emit logLine(errors);
+                                      done(ok, output);
+                                  },
+                                  command);
+}
+
+void ModelVolumeSync::finish(bool ok, const QString &summary)
+{
+    emit logLine(summary);
+    emit finished(ok, summary);
+}
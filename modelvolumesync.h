@@ -0,0 +1,54 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <functional>
+
+// Brings the weapons model volume in line with the models shipped in a new
+// image without throwing the volume away. A helper container mounts the
+// volume next to the image's model directory, both sides are listed as
+// (name, size, sha256) manifests, and only files whose size or hash differ
+// are copied across in parallel. Files that only exist in the volume are
+// left in place.
+class ModelVolumeSync : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry {
+        qint64 size = -1;
+        QString hash;
+    };
+    using Manifest = QHash<QString, Entry>;
+
+    explicit ModelVolumeSync(QObject* parent = nullptr);
+    ~ModelVolumeSync() override;
+
+    void start(const QString& image, const QString& volume, const QString& modelPath);
+    void cancel();
+    bool isRunning() const { return m_process != nullptr; }
+
+    // Parses the tagged manifest stream produced by the helper container.
+    static void parseManifests(const QByteArray& output, Manifest* image, Manifest* volume);
+    static QStringList changedFiles(const Manifest& image, const Manifest& volume);
+
+signals:
+    void logLine(const QString& line);
+    void finished(bool ok, const QString& summary);
+
+private:
+    void runHelper(const QByteArray& script, std::function<void(bool, const QByteArray&)> done);
+    void copyChanged(const QStringList& files);
+    void finish(bool ok, const QString& summary);
+
+    QString m_image;
+    QString m_volume;
+    QString m_modelPath;
+    Manifest m_imageManifest;
+    qint64 m_copyBytes = 0;
+    QProcess* m_process = nullptr;
+    QElapsedTimer m_timer;
+    bool m_canceled = false;
+};
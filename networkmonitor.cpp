@@ -0,0 +1,186 @@
+#include "networkmonitor.h"
+#include <QSocketNotifier>
+#include <QFile>
+#include <QStringList>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace {
+bool interfaceIsUp(const QString &iface)
+{
+    QFile operState("/sys/class/net/" + iface + "/operstate");
+    if (!operState.open(QIODevice::ReadOnly))
+        return true;
+    const QByteArray state = operState.readAll().trimmed();
+    // Tunnels and some USB modems never report "up"
+    return state == "up" || state == "unknown";
+}
+
+bool hasIpv4DefaultRoute()
+{
+    QFile routes("/proc/net/route");
+    if (!routes.open(QIODevice::ReadOnly))
+        return false;
+    routes.readLine(); // header
+    while (!routes.atEnd()) {
+        const QList<QByteArray> fields = routes.readLine().simplified().split(' ');
+        if (fields.size() < 4)
+            continue;
+        const bool isDefault = fields.at(1) == "00000000";
+        const bool isUp = fields.at(3).toUInt(nullptr, 16) & 0x1;
+        if (isDefault && isUp && interfaceIsUp(QString::fromLatin1(fields.at(0))))
+            return true;
+    }
+    return false;
+}
+
+bool hasIpv6DefaultRoute()
+{
+    QFile routes("/proc/net/ipv6_route");
+    if (!routes.open(QIODevice::ReadOnly))
+        return false;
+    while (!routes.atEnd()) {
+        const QList<QByteArray> fields = routes.readLine().simplified().split(' ');
+        if (fields.size() < 10)
+            continue;
+        const QString iface = QString::fromLatin1(fields.at(9));
+        if (iface == "lo")
+            continue;
+        const bool isDefault = fields.at(0) == "00000000000000000000000000000000" && fields.at(1) == "00";
+        const bool isUp = fields.at(8).toUInt(nullptr, 16) & 0x1;
+        if (isDefault && isUp && interfaceIsUp(iface))
+            return true;
+    }
+    return false;
+}
+} // namespace
+
+NetworkMonitor::NetworkMonitor(QObject *parent)
+    : QObject(parent)
+{}
+
+NetworkMonitor::~NetworkMonitor()
+{
+    stop();
+}
+
+bool NetworkMonitor::probeDefaultRoute()
+{
+    return hasIpv4DefaultRoute() || hasIpv6DefaultRoute();
+}
+
+bool NetworkMonitor::start()
+{
+    const int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (fd < 0)
+        return false;
+
+    sockaddr_nl addr {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    return attach(fd, true);
+}
+
+bool NetworkMonitor::attach(int fd, bool isNetlink)
+{
+    stop();
+    if (fd < 0)
+        return false;
+    m_fd = fd;
+    m_isNetlink = isNetlink;
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &NetworkMonitor::readEvents);
+    m_hasDefaultRoute = m_routeProbe ? m_routeProbe() : probeDefaultRoute();
+    if (!m_hasDefaultRoute)
+        m_offlineTimer.start();
+    return true;
+}
+
+void NetworkMonitor::stop()
+{
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void NetworkMonitor::setRouteProbe(std::function<bool()> probe)
+{
+    m_routeProbe = std::move(probe);
+}
+
+void NetworkMonitor::readEvents()
+{
+    bool linkEvent = false;
+    bool routeEvent = !m_isNetlink;
+    char buffer[8192];
+    for (;;) {
+        const ssize_t len = ::recv(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (len < 0 && errno == EINTR)
+            continue;
+        if (len < 0 && errno == ENOBUFS) {
+            // The kernel dropped events; the /proc re-read below covers it
+            routeEvent = true;
+            continue;
+        }
+        if (len <= 0)
+            break;
+        if (!m_isNetlink)
+            continue;
+
+        int remaining = int(len);
+        for (auto *header = reinterpret_cast<nlmsghdr *>(buffer);
+             NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            switch (header->nlmsg_type) {
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+                linkEvent = true;
+                routeEvent = true;
+                break;
+            case RTM_NEWROUTE:
+            case RTM_DELROUTE: {
+                const auto *route = static_cast<const rtmsg *>(NLMSG_DATA(header));
+                if (route->rtm_dst_len == 0)
+                    routeEvent = true;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    if (linkEvent)
+        emit linkChanged();
+    if (routeEvent)
+        refresh();
+}
+
+void NetworkMonitor::refresh()
+{
+    const bool hasRoute = m_routeProbe ? m_routeProbe() : probeDefaultRoute();
+    if (hasRoute == m_hasDefaultRoute)
+        return;
+    m_hasDefaultRoute = hasRoute;
+    if (!hasRoute) {
+        m_offlineTimer.start();
+        emit defaultRouteLost();
+        return;
+    }
+    const qint64 offlineMs = m_offlineTimer.isValid() ? m_offlineTimer.elapsed() : 0;
+    m_offlineTimer.invalidate();
+    emit defaultRouteRestored(offlineMs);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <QObject>
+#include <QElapsedTimer>
+#include <functional>
+
+class QSocketNotifier;
+
+// Watches rtnetlink link and route notifications and reports when the
+// default route disappears or comes back. Events are only used as a trigger;
+// the actual state is re-read from /proc after each burst, so coalesced or
+// dropped notifications cannot leave the monitor out of sync.
+//
+// For tests, attach() accepts any readable descriptor (a socketpair end, or a
+// netlink socket opened inside a veth/netns sandbox) and setRouteProbe()
+// replaces the /proc lookup.
+class NetworkMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit NetworkMonitor(QObject* parent = nullptr);
+    ~NetworkMonitor() override;
+
+    bool start();
+    bool attach(int fd, bool isNetlink = false);
+    void stop();
+    bool isActive() const { return m_notifier != nullptr; }
+
+    bool hasDefaultRoute() const { return m_hasDefaultRoute; }
+    void setRouteProbe(std::function<bool()> probe);
+    // Re-evaluates connectivity as if a netlink event had arrived.
+    void refresh();
+
+    static bool probeDefaultRoute();
+
+signals:
+    void defaultRouteLost();
+    void defaultRouteRestored(qint64 offlineMs);
+    void linkChanged();
+
+private:
+    void readEvents();
+
+    int m_fd = -1;
+    bool m_isNetlink = false;
+    QSocketNotifier* m_notifier = nullptr;
+    std::function<bool()> m_routeProbe;
+    bool m_hasDefaultRoute = true;
+    QElapsedTimer m_offlineTimer;
+};
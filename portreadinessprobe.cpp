@@ -0,0 +1,99 @@
+#include "portreadinessprobe.h"
+#include "metrics.h"
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <utility>
+
+namespace {
+constexpr int ProbeIntervalMs = 1000;
+// Model services can take several minutes to come up on first start
+constexpr qint64 GiveUpAfterMs = 15 * 60 * 1000;
+} // namespace
+
+PortReadinessProbe::PortReadinessProbe(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setInterval(ProbeIntervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &PortReadinessProbe::probe);
+}
+
+void PortReadinessProbe::start()
+{
+    stop();
+    Metrics &metrics = Metrics::global();
+    const int count = metrics.ports().size();
+    m_ready = QList<bool>(count, false);
+    m_sockets = QList<QTcpSocket*>(count, nullptr);
+    for (int i = 0; i < count; ++i) {
+        metrics.portUp(i).set(0.0);
+        metrics.portReadySeconds(i).set(0.0);
+    }
+    m_clock.start();
+    m_timer.start();
+    probe();
+}
+
+void PortReadinessProbe::stop()
+{
+    m_timer.stop();
+    const QList<QTcpSocket*> sockets = std::exchange(m_sockets, {});
+    for (QTcpSocket *socket : sockets) {
+        if (socket) {
+            socket->abort();
+            socket->deleteLater();
+        }
+    }
+    Metrics &metrics = Metrics::global();
+    for (int i = 0; i < metrics.ports().size(); ++i)
+        metrics.portUp(i).set(0.0);
+}
+
+void PortReadinessProbe::probe()
+{
+    if (m_clock.elapsed() > GiveUpAfterMs) {
+        m_timer.stop();
+        return;
+    }
+
+    Metrics &metrics = Metrics::global();
+    bool pending = false;
+    for (int i = 0; i < m_ready.size(); ++i) {
+        if (m_ready.at(i))
+            continue;
+        pending = true;
+        // One attempt in flight per port; a refused or hung attempt is
+        // simply retried on a later tick
+        if (m_sockets.at(i))
+            continue;
+
+        auto *socket = new QTcpSocket(this);
+        m_sockets[i] = socket;
+        connect(socket, &QTcpSocket::connected, this, [this, socket, i]() {
+            if (m_sockets.value(i) != socket)
+                return;
+            const qint64 elapsedMs = m_clock.elapsed();
+            m_ready[i] = true;
+            m_sockets[i] = nullptr;
+            Metrics::global().portReadySeconds(i).set(double(elapsedMs) / 1000.0);
+            Metrics::global().portUp(i).set(1.0);
+            emit portReady(Metrics::global().ports().at(i), elapsedMs);
+            socket->abort();
+            socket->deleteLater();
+        });
+        connect(socket, &QTcpSocket::errorOccurred, this, [this, socket, i](QAbstractSocket::SocketError) {
+            if (m_sockets.value(i) == socket)
+                m_sockets[i] = nullptr;
+            socket->deleteLater();
+        });
+        // Give up on an attempt that neither connects nor fails in time
+        QTimer::singleShot(ProbeIntervalMs * 2, socket, [this, socket, i]() {
+            if (m_sockets.value(i) == socket)
+                m_sockets[i] = nullptr;
+            socket->abort();
+            socket->deleteLater();
+        });
+        socket->connectToHost(QHostAddress::LocalHost, quint16(metrics.ports().at(i).toUInt()));
+    }
+    if (!pending)
+        m_timer.stop();
+}
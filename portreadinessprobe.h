@@ -0,0 +1,31 @@
+#pragma once
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QTimer>
+
+class QTcpSocket;
+
+// After the container starts, polls each published port on localhost until
+// it accepts a connection and records how long that took in Metrics.
+class PortReadinessProbe : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PortReadinessProbe(QObject* parent = nullptr);
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_timer.isActive(); }
+
+signals:
+    void portReady(const QString& port, qint64 elapsedMs);
+
+private:
+    void probe();
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QList<bool> m_ready;
+    QList<QTcpSocket*> m_sockets;
+};
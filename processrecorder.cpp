@@ -0,0 +1,204 @@
+#include "processrecorder.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QProcess>
+
+namespace {
+const char Magic[] = {'S', 'C', 'P', 'R'};
+constexpr quint8 FormatVersion = 1;
+constexpr quint8 KindOutput = 0;
+constexpr quint8 KindExit = 1;
+
+class Reader
+{
+public:
+    explicit Reader(const QByteArray &data) : m_data(data) {}
+
+    bool atEnd() const { return m_pos >= m_data.size(); }
+
+    bool byte(quint8 *value)
+    {
+        if (m_pos >= m_data.size())
+            return false;
+        *value = quint8(m_data.at(m_pos++));
+        return true;
+    }
+
+    bool varint(quint64 *value)
+    {
+        *value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            quint8 b = 0;
+            if (!byte(&b))
+                return false;
+            *value |= quint64(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool bytes(quint64 length, QByteArray *out)
+    {
+        if (length > quint64(m_data.size() - m_pos))
+            return false;
+        *out = m_data.mid(m_pos, int(length));
+        m_pos += int(length);
+        return true;
+    }
+
+private:
+    const QByteArray &m_data;
+    int m_pos = 0;
+};
+} // namespace
+
+bool ProcessRecording::load(const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < 5 || !data.startsWith(QByteArray(Magic, sizeof(Magic)))) {
+        *error = "not a process recording";
+        return false;
+    }
+    if (quint8(data.at(4)) != FormatVersion) {
+        *error = QString("unsupported recording version %1").arg(quint8(data.at(4)));
+        return false;
+    }
+
+    Reader reader(data);
+    QByteArray skipped;
+    reader.bytes(5, &skipped);
+    quint64 labelLength = 0;
+    QByteArray labelBytes;
+    if (!reader.varint(&labelLength) || !reader.bytes(labelLength, &labelBytes)) {
+        *error = "truncated header";
+        return false;
+    }
+    label = QString::fromUtf8(labelBytes);
+    chunks.clear();
+
+    qint64 offsetUs = 0;
+    while (!reader.atEnd()) {
+        quint8 kind = 0;
+        quint64 deltaUs = 0;
+        if (!reader.byte(&kind) || !reader.varint(&deltaUs)) {
+            *error = "truncated record";
+            return false;
+        }
+        offsetUs += qint64(deltaUs);
+        if (kind == KindOutput) {
+            quint64 length = 0;
+            Chunk chunk;
+            chunk.offsetUs = offsetUs;
+            if (!reader.varint(&length) || !reader.bytes(length, &chunk.data)) {
+                *error = "truncated output record";
+                return false;
+            }
+            chunks.append(chunk);
+        } else if (kind == KindExit) {
+            quint64 code = 0;
+            quint8 crashedFlag = 0;
+            if (!reader.varint(&code) || !reader.byte(&crashedFlag)) {
+                *error = "truncated exit record";
+                return false;
+            }
+            exitCode = int(code);
+            crashed = crashedFlag != 0;
+        } else {
+            *error = QString("unknown record kind %1").arg(kind);
+            return false;
+        }
+    }
+    // A recording cut short by a crash still replays; it just has no exit
+    durationUs = offsetUs;
+    return true;
+}
+
+qint64 ProcessRecording::totalBytes() const
+{
+    qint64 total = 0;
+    for (const Chunk &chunk : chunks)
+        total += chunk.data.size();
+    return total;
+}
+
+void ProcessRecorder::attachIfEnabled(QProcess *process, const QString &label)
+{
+    const QString dir = qEnvironmentVariable("SAFECORE_RECORD_DIR");
+    if (!process || dir.isEmpty())
+        return;
+    QDir().mkpath(dir);
+    const QString path = dir + "/" + label + "-"
+        + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz") + ".screc";
+    new ProcessRecorder(process, label, path);
+}
+
+ProcessRecorder::ProcessRecorder(QProcess *process, const QString &label, const QString &path)
+    : QObject(process)
+    , m_process(process)
+    , m_file(path)
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning().noquote() << "Cannot record" << label << "to" << path << ":" << m_file.errorString();
+        return;
+    }
+    const QByteArray labelBytes = label.toUtf8();
+    m_file.write(Magic, sizeof(Magic));
+    m_file.putChar(char(FormatVersion));
+    writeVarint(quint64(labelBytes.size()));
+    m_file.write(labelBytes);
+
+    connect(process, &QProcess::started, this, [this]() { m_clock.start(); });
+    connect(process, &QProcess::readyRead, this, &ProcessRecorder::capture);
+    connect(process, &QProcess::finished, this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+        // Output that arrived with the exit is read by the finished handlers
+        capture();
+        writeRecord(KindExit);
+        writeVarint(quint64(qMax(0, exitCode)));
+        m_file.putChar(exitStatus == QProcess::CrashExit ? 1 : 0);
+        m_file.close();
+    });
+}
+
+void ProcessRecorder::capture()
+{
+    if (!m_file.isOpen())
+        return;
+    const QByteArray data = m_process->peek(m_process->bytesAvailable());
+    if (data.isEmpty())
+        return;
+    writeRecord(KindOutput);
+    writeVarint(quint64(data.size()));
+    m_file.write(data);
+    m_file.flush();
+}
+
+void ProcessRecorder::writeRecord(quint8 kind)
+{
+    if (!m_clock.isValid())
+        m_clock.start();
+    const qint64 nowUs = m_clock.nsecsElapsed() / 1000;
+    m_file.putChar(char(kind));
+    writeVarint(quint64(qMax<qint64>(0, nowUs - m_lastUs)));
+    m_lastUs = nowUs;
+}
+
+void ProcessRecorder::writeVarint(quint64 value)
+{
+    char buffer[10];
+    int size = 0;
+    do {
+        quint8 b = quint8(value & 0x7f);
+        value >>= 7;
+        if (value)
+            b |= 0x80;
+        buffer[size++] = char(b);
+    } while (value);
+    m_file.write(buffer, size);
+}
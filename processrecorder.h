@@ -0,0 +1,57 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+class QProcess;
+
+// A captured byte stream of one child process, exactly as QProcess handed it
+// over, with the time each chunk arrived.
+//
+// File layout (integers are unsigned LEB128 varints):
+//   "SCPR" u8 version, varint label length, label (UTF-8)
+//   then records: u8 kind, varint microseconds since the previous record,
+//   kind 0 (output): varint length, bytes
+//   kind 1 (exit):   varint exit code, u8 crashed
+struct ProcessRecording {
+    struct Chunk {
+        qint64 offsetUs = 0;    // since the process started
+        QByteArray data;
+    };
+
+    QString label;
+    QVector<Chunk> chunks;
+    qint64 durationUs = 0;
+    int exitCode = -1;
+    bool crashed = false;
+
+    bool load(const QString& path, QString* error);
+    qint64 totalBytes() const;
+};
+
+// Tees a process's output into a recording without consuming it. Attach
+// before connecting any readyRead/finished handlers, so the recorder peeks
+// at every chunk before the controller reads it. The handlers must drain
+// the buffer on each readyRead, as all of the controller's do.
+class ProcessRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    // Records into $SAFECORE_RECORD_DIR when that is set; otherwise a no-op.
+    static void attachIfEnabled(QProcess* process, const QString& label);
+
+    ProcessRecorder(QProcess* process, const QString& label, const QString& path);
+
+private:
+    void capture();
+    void writeRecord(quint8 kind);
+    void writeVarint(quint64 value);
+
+    QProcess* m_process;
+    QFile m_file;
+    QElapsedTimer m_clock;
+    qint64 m_lastUs = 0;
+};
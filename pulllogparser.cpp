@@ -0,0 +1,239 @@
+#include "pulllogparser.h"
+#include <QRegularExpression>
+
+namespace {
+constexpr int MaxLogLines = 200;
+constexpr int LayerIdWidth = 13;
+constexpr int StatusWidth = 22;
+
+bool isLayerIdChar(QChar c)
+{
+    const ushort u = c.unicode();
+    return (u >= '0' && u <= '9') || (u >= 'a' && u <= 'f');
+}
+
+int layerStateFor(const QString &trimmed)
+{
+    if (trimmed.contains(QLatin1String("Pull complete")) || trimmed.contains(QLatin1String("Already exists"))
+        || trimmed.contains(QLatin1String("Download complete"))) {
+        return 2;
+    }
+    if (trimmed.contains(QLatin1String("Downloading")) || trimmed.contains(QLatin1String("Extracting"))
+        || trimmed.contains(QLatin1String("Pulling fs layer")) || trimmed.contains(QLatin1String("Verifying Checksum"))) {
+        return 1;
+    }
+    if (trimmed.contains(QLatin1String("Waiting")))
+        return 0;
+    return -1;
+}
+} // namespace
+
+PullLogParser::PullLogParser(bool alignColumns)
+    : m_alignColumns(alignColumns)
+{}
+
+void PullLogParser::setLayerObserver(std::function<void(const QString&, const QString&)> observer)
+{
+    m_observer = std::move(observer);
+}
+
+QString PullLogParser::stripAnsiSequences(const QString &input)
+{
+    // Most chunks carry no escapes at all; skip the regex passes for them
+    if (!input.contains(QChar(0x1B)))
+        return input;
+    QString output = input;
+    static const QRegularExpression oscRe("\x1B\\][^\u0007]*\u0007");
+    static const QRegularExpression csiRe("\x1B\\[[0-9;?]*[ -/]*[@-~]");
+    output.remove(oscRe);
+    output.remove(csiRe);
+    return output;
+}
+
+QString PullLogParser::extractLayerId(const QString &line)
+{
+    // Equivalent to ^([0-9a-f]{6,}): without a regex match per line
+    int length = 0;
+    while (length < line.size() && isLayerIdChar(line.at(length)))
+        ++length;
+    if (length < 6 || length >= line.size() || line.at(length) != QLatin1Char(':'))
+        return QString();
+    return line.left(length);
+}
+
+bool PullLogParser::isProgressLine(const QString &trimmedLine)
+{
+    return trimmedLine.startsWith(QLatin1String("Downloading"))
+        || trimmedLine.startsWith(QLatin1String("Extracting"))
+        || trimmedLine.startsWith(QLatin1String("Waiting"))
+        || trimmedLine.startsWith(QLatin1String("Pull complete"))
+        || trimmedLine.startsWith(QLatin1String("Download complete"))
+        || trimmedLine.startsWith(QLatin1String("Pulling fs layer"));
+}
+
+QString PullLogParser::normalize(const QString &chunk)
+{
+    QString normalized = chunk;
+    normalized.replace(QLatin1Char('\r'), QLatin1Char('\n'));
+    return stripAnsiSequences(normalized);
+}
+
+void PullLogParser::append(const QString &chunk)
+{
+    if (chunk.isEmpty())
+        return;
+    const QString normalized = normalize(chunk);
+    renderLines(normalized);
+    updateProgress(normalized);
+}
+
+void PullLogParser::renderLines(const QString &normalized)
+{
+    const QStringList lines = normalized.split(QLatin1Char('\n'));
+    for (const QString &rawLine : lines) {
+        const QString trimmedLine = rawLine.trimmed();
+        if (trimmedLine.isEmpty())
+            continue;
+        if (trimmedLine.contains(QLatin1String("killing shell"), Qt::CaseInsensitive)
+            || trimmedLine.contains(QLatin1String("killed."), Qt::CaseInsensitive)) {
+            continue;
+        }
+        if (trimmedLine.startsWith(QLatin1String("Status:")) || trimmedLine.startsWith(QLatin1String("Digest:")))
+            m_sawStatus = true;
+
+        QString line = rawLine;
+        QString layerId = extractLayerId(trimmedLine);
+        const bool progressLine = isProgressLine(trimmedLine);
+        if (layerId.isEmpty() && progressLine && !m_lastLayerId.isEmpty()) {
+            layerId = m_lastLayerId;
+            line = m_lastLayerId + QLatin1String(": ") + trimmedLine;
+        }
+        if (!layerId.isEmpty())
+            m_lastLayerId = layerId;
+
+        if (m_alignColumns && !layerId.isEmpty() && progressLine) {
+            // layerId (13 chars) : status (22 chars) [progress] size
+            const int colonIdx = line.indexOf(QLatin1Char(':'));
+            if (colonIdx >= 0) {
+                const QString remainder = line.mid(colonIdx + 1).trimmed();
+                const int bracketIdx = remainder.indexOf(QLatin1Char('['));
+                const QString status = bracketIdx > 0 ? remainder.left(bracketIdx).trimmed() : remainder;
+                const QString progress = bracketIdx > 0 ? remainder.mid(bracketIdx) : QString();
+                line = layerId.rightJustified(LayerIdWidth) + QLatin1String(": ")
+                    + status.leftJustified(StatusWidth) + progress;
+            }
+        }
+
+        if (!layerId.isEmpty()) {
+            const int existingIndex = m_lineIndex.value(layerId, -1);
+            if (existingIndex >= 0 && existingIndex < m_lines.size()) {
+                m_lines[existingIndex] = line;
+            } else {
+                m_lineIndex.insert(layerId, m_lines.size());
+                m_lines.append(line);
+            }
+        } else {
+            if (progressLine)
+                continue;
+            m_lines.append(line);
+        }
+    }
+
+    trimLines();
+    m_text = m_lines.join(QLatin1Char('\n'));
+}
+
+void PullLogParser::updateProgress(const QString &normalized)
+{
+    QString data = m_remainder + normalized;
+    const bool endsWithNewline = data.endsWith(QLatin1Char('\n'));
+    QStringList lines = data.split(QLatin1Char('\n'));
+    if (!endsWithNewline)
+        m_remainder = lines.takeLast();
+    else
+        m_remainder.clear();
+
+    QString lastLayerId = m_lastLayerId;
+    for (const QString &line : lines) {
+        const QString trimmed = line.trimmed();
+        const int colonIdx = trimmed.indexOf(QLatin1Char(':'));
+        QString layerId;
+        if (colonIdx > 0)
+            layerId = trimmed.left(colonIdx);
+        else if (isProgressLine(trimmed) && !lastLayerId.isEmpty())
+            layerId = lastLayerId;
+        if (layerId.size() < 6)
+            continue;
+
+        lastLayerId = layerId;
+        if (m_observer)
+            m_observer(layerId, trimmed);
+
+        const int newState = layerStateFor(trimmed);
+        if (newState < 0)
+            continue;
+        auto it = m_layerState.find(layerId);
+        const int prevState = it == m_layerState.end() ? -1 : it.value();
+        if (newState <= prevState)
+            continue;
+        if (prevState == 1)
+            --m_layersActive;
+        if (newState == 1)
+            ++m_layersActive;
+        else if (newState == 2)
+            ++m_layersDone;
+        if (it == m_layerState.end())
+            m_layerState.insert(layerId, newState);
+        else
+            it.value() = newState;
+    }
+
+    m_lastLayerId = lastLayerId;
+}
+
+double PullLogParser::progress() const
+{
+    const int total = m_layerState.size();
+    if (total <= 0)
+        return 0.0;
+    const double weighted = double(m_layersDone) + double(m_layersActive) * 0.3;
+    return qMin(0.98, weighted / double(total));
+}
+
+void PullLogParser::appendEvent(const QString &message)
+{
+    m_lines.append(message);
+    m_text = m_lines.join(QLatin1Char('\n'));
+}
+
+void PullLogParser::trimLines()
+{
+    if (m_lines.size() <= MaxLogLines)
+        return;
+    m_lines = m_lines.mid(m_lines.size() - MaxLogLines);
+    m_lineIndex.clear();
+    for (int i = 0; i < m_lines.size(); ++i) {
+        // Aligned lines are right-justified, so look past the padding
+        const QString layerId = extractLayerId(m_lines.at(i).trimmed());
+        if (!layerId.isEmpty())
+            m_lineIndex.insert(layerId, i);
+    }
+}
+
+void PullLogParser::clearLog()
+{
+    m_lines.clear();
+    m_lineIndex.clear();
+    m_remainder.clear();
+    m_lastLayerId.clear();
+    m_text.clear();
+}
+
+void PullLogParser::reset()
+{
+    clearLog();
+    m_layerState.clear();
+    m_layersDone = 0;
+    m_layersActive = 0;
+    m_sawStatus = false;
+}
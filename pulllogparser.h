@@ -0,0 +1,60 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <functional>
+
+// Turns raw `docker pull` output into the condensed log shown in the UI and
+// an overall progress estimate. Docker redraws one line per layer with
+// carriage returns and cursor escapes; every update for a layer replaces
+// that layer's line instead of piling up, and the log is capped at the last
+// 200 lines. The image pull and the upgrade pull share this parser; the pull
+// view additionally aligns the layer columns.
+class PullLogParser
+{
+public:
+    explicit PullLogParser(bool alignColumns = false);
+
+    // Called once per progress line with its resolved layer ID, e.g. to feed
+    // a stall detector or meter transferred bytes.
+    void setLayerObserver(std::function<void(const QString& layerId, const QString& line)> observer);
+
+    // Feeds a chunk of process output; both the log and progress update.
+    void append(const QString& chunk);
+    // Adds a line that is not docker output and never counts as a layer.
+    void appendEvent(const QString& message);
+    // Clears the log but keeps the layer progress.
+    void clearLog();
+    void reset();
+
+    const QString& text() const { return m_text; }
+    bool sawStatus() const { return m_sawStatus; }
+    int layerCount() const { return m_layerState.size(); }
+    int completedLayers() const { return m_layersDone; }
+    double progress() const;
+
+    // The two passes append() runs, exposed for benchmarking. Both expect
+    // output that has already been through normalize().
+    void renderLines(const QString& normalized);
+    void updateProgress(const QString& normalized);
+
+    static QString normalize(const QString& chunk);
+    static QString stripAnsiSequences(const QString& input);
+    static QString extractLayerId(const QString& line);
+    static bool isProgressLine(const QString& trimmedLine);
+
+private:
+    void trimLines();
+
+    bool m_alignColumns = false;
+    std::function<void(const QString&, const QString&)> m_observer;
+    QStringList m_lines;
+    QHash<QString, int> m_lineIndex;
+    QHash<QString, int> m_layerState;   // 0 waiting, 1 active, 2 done
+    int m_layersDone = 0;
+    int m_layersActive = 0;
+    QString m_remainder;
+    QString m_lastLayerId;
+    QString m_text;
+    bool m_sawStatus = false;
+};
@@ -0,0 +1,273 @@
+#include "pullstalldetector.h"
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace {
+// Thresholds for declaring a layer stalled
+constexpr qint64 MinStallThresholdMs = 5000;
+constexpr qint64 MaxStallThresholdMs = 30000;
+constexpr qint64 InitialStallThresholdMs = 15000;
+constexpr double StallIntervalFactor = 8.0;
+constexpr qint64 OutputSilenceThresholdMs = 30000;
+
+// Retry backoff
+constexpr qint64 BaseRetryDelayMs = 1000;
+constexpr qint64 MaxRetryDelayMs = 60000;
+
+constexpr double SmoothingFactor = 0.2;
+
+qint64 toBytes(double value, const QString &unit)
+{
+    const QString u = unit.toLower();
+    if (u == "kb")
+        return qint64(value * 1000.0);
+    if (u == "mb")
+        return qint64(value * 1000.0 * 1000.0);
+    if (u == "gb")
+        return qint64(value * 1000.0 * 1000.0 * 1000.0);
+    return qint64(value);
+}
+
+bool isActive(PullStallDetector::Phase phase)
+{
+    return phase == PullStallDetector::Phase::Downloading
+        || phase == PullStallDetector::Phase::Extracting;
+}
+} // namespace
+
+void PullStallDetector::reset()
+{
+    m_layers.clear();
+    m_retryCount = 0;
+    m_resumedLayer.clear();
+    m_resumedAfterMs = 0;
+    m_clock.restart();
+}
+
+bool PullStallDetector::parseProgressBytes(const QString &line, qint64 *current, qint64 *total)
+{
+    static const QRegularExpression bytesRe(R"(([0-9]+(?:\.[0-9]+)?)\s*([kKMG]?B)\s*/\s*([0-9]+(?:\.[0-9]+)?)\s*([kKMG]?B))");
+    const QRegularExpressionMatch match = bytesRe.match(line);
+    if (!match.hasMatch())
+        return false;
+    if (current)
+        *current = toBytes(match.captured(1).toDouble(), match.captured(2));
+    if (total)
+        *total = toBytes(match.captured(3).toDouble(), match.captured(4));
+    return true;
+}
+
+QString PullStallDetector::phaseName(Phase phase)
+{
+    switch (phase) {
+    case Phase::Waiting: return "Waiting";
+    case Phase::Downloading: return "Downloading";
+    case Phase::Verifying: return "Verifying";
+    case Phase::Extracting: return "Extracting";
+    case Phase::Complete: return "Complete";
+    }
+    return QString();
+}
+
+void PullStallDetector::observe(const QString &layerId, const QString &line)
+{
+    if (!m_clock.isValid())
+        m_clock.start();
+    if (layerId.isEmpty())
+        return;
+
+    Phase phase;
+    if (line.contains("Pull complete") || line.contains("Already exists"))
+        phase = Phase::Complete;
+    else if (line.contains("Extracting"))
+        phase = Phase::Extracting;
+    else if (line.contains("Download complete") || line.contains("Verifying Checksum"))
+        phase = Phase::Verifying;
+    else if (line.contains("Downloading"))
+        phase = Phase::Downloading;
+    else if (line.contains("Waiting") || line.contains("Pulling fs layer"))
+        phase = Phase::Waiting;
+    else
+        return;
+
+    const qint64 now = m_clock.elapsed();
+    const bool isNew = !m_layers.contains(layerId);
+    Layer &layer = m_layers[layerId];
+    if (isNew)
+        layer.lastProgressMs = now;
+
+    bool progressed = false;
+    if (phase != layer.phase) {
+        // Extraction restarts the byte counter from zero
+        if (phase == Phase::Extracting && layer.phase != Phase::Extracting) {
+            layer.currentBytes = 0;
+            layer.intervalMs = 0.0;
+        }
+        layer.phase = phase;
+        progressed = true;
+    }
+
+    qint64 current = 0;
+    qint64 total = 0;
+    if (isActive(phase) && parseProgressBytes(line, &current, &total)) {
+        if (current > layer.currentBytes) {
+            const qint64 interval = qMax<qint64>(1, now - layer.lastProgressMs);
+            const double rate = double(current - layer.currentBytes) * 1000.0 / double(interval);
+            layer.intervalMs = layer.intervalMs <= 0.0
+                ? double(interval)
+                : layer.intervalMs + SmoothingFactor * (double(interval) - layer.intervalMs);
+            layer.bytesPerSecond = layer.bytesPerSecond <= 0.0
+                ? rate
+                : layer.bytesPerSecond + SmoothingFactor * (rate - layer.bytesPerSecond);
+            layer.currentBytes = current;
+            progressed = true;
+        } else if (current < layer.currentBytes) {
+            // The daemon restarted this layer's transfer
+            layer.currentBytes = current;
+            progressed = true;
+        }
+        // Extraction reports uncompressed sizes; keep the download size
+        if (phase == Phase::Downloading)
+            layer.totalBytes = total;
+    }
+
+    if (!progressed)
+        return;
+
+    if (layer.stalledAtMs >= 0) {
+        m_resumedLayer = layerId;
+        m_resumedAfterMs = now - layer.stalledAtMs;
+        layer.stalledAtMs = -1;
+        m_retryCount = 0;
+    }
+    layer.stallReported = false;
+    layer.lastProgressMs = now;
+}
+
+qint64 PullStallDetector::thresholdFor(const Layer &layer) const
+{
+    if (layer.intervalMs <= 0.0)
+        return InitialStallThresholdMs;
+    const qint64 adaptive = qint64(layer.intervalMs * StallIntervalFactor);
+    return std::clamp(adaptive, MinStallThresholdMs, MaxStallThresholdMs);
+}
+
+bool PullStallDetector::detect(qint64 outputSilenceMs, Stall *stall)
+{
+    const qint64 now = elapsedMs();
+    bool anyActive = false;
+    const Layer *worst = nullptr;
+    QString worstId;
+    qint64 worstSilent = 0;
+    qint64 worstThreshold = 0;
+
+    for (auto it = m_layers.cbegin(); it != m_layers.cend(); ++it) {
+        const Layer &layer = it.value();
+        if (!isActive(layer.phase))
+            continue;
+        anyActive = true;
+        if (layer.stallReported)
+            continue;
+        const qint64 silent = now - layer.lastProgressMs;
+        const qint64 threshold = thresholdFor(layer);
+        if (silent > threshold && (!worst || silent - threshold > worstSilent - worstThreshold)) {
+            worst = &layer;
+            worstId = it.key();
+            worstSilent = silent;
+            worstThreshold = threshold;
+        }
+    }
+
+    if (worst) {
+        Layer &layer = m_layers[worstId];
+        layer.stallReported = true;
+        if (layer.stalledAtMs < 0)
+            layer.stalledAtMs = now;
+        if (stall) {
+            stall->layerId = worstId;
+            stall->phase = layer.phase;
+            stall->silentMs = worstSilent;
+            stall->thresholdMs = worstThreshold;
+            stall->currentBytes = layer.currentBytes;
+            stall->totalBytes = layer.totalBytes;
+            stall->bytesPerSecond = layer.bytesPerSecond;
+            stall->pullElapsedMs = now;
+        }
+        return true;
+    }
+
+    // Nothing is moving and nothing is printed: the pull is stuck before or
+    // between layers (manifest fetch, registry auth, dropped connection).
+    if (!anyActive && outputSilenceMs > OutputSilenceThresholdMs) {
+        if (stall) {
+            *stall = Stall();
+            stall->silentMs = outputSilenceMs;
+            stall->thresholdMs = OutputSilenceThresholdMs;
+            stall->pullElapsedMs = now;
+        }
+        return true;
+    }
+    return false;
+}
+
+void PullStallDetector::noteRestart()
+{
+    const qint64 now = elapsedMs();
+    for (auto it = m_layers.begin(); it != m_layers.end(); ++it) {
+        it.value().lastProgressMs = now;
+        it.value().stallReported = false;
+    }
+}
+
+qint64 PullStallDetector::nextRetryDelayMs()
+{
+    const qint64 delay = qMin(MaxRetryDelayMs, BaseRetryDelayMs << qMin(m_retryCount, 6));
+    ++m_retryCount;
+    return delay;
+}
+
+bool PullStallDetector::takeResumedLayer(QString *layerId, qint64 *stalledForMs)
+{
+    if (m_resumedLayer.isEmpty())
+        return false;
+    if (layerId)
+        *layerId = m_resumedLayer;
+    if (stalledForMs)
+        *stalledForMs = m_resumedAfterMs;
+    m_resumedLayer.clear();
+    m_resumedAfterMs = 0;
+    return true;
+}
+
+int PullStallDetector::completedLayers() const
+{
+    int done = 0;
+    for (auto it = m_layers.cbegin(); it != m_layers.cend(); ++it) {
+        if (it.value().phase == Phase::Complete)
+            ++done;
+    }
+    return done;
+}
+
+qint64 PullStallDetector::downloadedBytes() const
+{
+    qint64 bytes = 0;
+    for (auto it = m_layers.cbegin(); it != m_layers.cend(); ++it) {
+        const Layer &layer = it.value();
+        if (layer.phase == Phase::Downloading)
+            bytes += layer.currentBytes;
+        else if (layer.phase != Phase::Waiting)
+            bytes += layer.totalBytes;
+    }
+    return bytes;
+}
+
+double PullStallDetector::bytesPerSecond() const
+{
+    double rate = 0.0;
+    for (auto it = m_layers.cbegin(); it != m_layers.cend(); ++it) {
+        if (it.value().phase == Phase::Downloading)
+            rate += it.value().bytesPerSecond;
+    }
+    return rate;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <QString>
+#include <QHash>
+#include <QElapsedTimer>
+
+// Tracks per-layer byte progress of a docker pull and decides when a layer
+// has stopped moving. Each layer learns its own update cadence, so a slow but
+// steadily progressing layer is not mistaken for a hang while a layer that
+// normally reports every few hundred milliseconds is flagged within seconds.
+class PullStallDetector
+{
+public:
+    enum class Phase { Waiting, Downloading, Verifying, Extracting, Complete };
+
+    struct Stall {
+        QString layerId;
+        Phase phase = Phase::Waiting;
+        qint64 silentMs = 0;
+        qint64 thresholdMs = 0;
+        qint64 currentBytes = 0;
+        qint64 totalBytes = 0;
+        double bytesPerSecond = 0.0;
+        qint64 pullElapsedMs = 0;
+    };
+
+    void reset();
+    // Feeds one progress line whose layer ID has already been resolved.
+    void observe(const QString& layerId, const QString& line);
+    // Reports the worst stalled layer, or a whole-pull stall when nothing has
+    // been printed for `outputSilenceMs` and no layer is actively moving.
+    bool detect(qint64 outputSilenceMs, Stall* stall);
+    // Restarts the silence clocks after the pull process was restarted.
+    void noteRestart();
+    qint64 nextRetryDelayMs();
+    int retryCount() const { return m_retryCount; }
+    bool takeResumedLayer(QString* layerId, qint64* stalledForMs);
+
+    int layerCount() const { return m_layers.size(); }
+    int completedLayers() const;
+    qint64 downloadedBytes() const;
+    double bytesPerSecond() const;
+    qint64 elapsedMs() const { return m_clock.isValid() ? m_clock.elapsed() : 0; }
+
+    static bool parseProgressBytes(const QString& line, qint64* current, qint64* total);
+    static QString phaseName(Phase phase);
+
+private:
+    struct Layer {
+        Phase phase = Phase::Waiting;
+        qint64 currentBytes = 0;
+        qint64 totalBytes = 0;
+        qint64 lastProgressMs = 0;
+        double intervalMs = 0.0;      // smoothed time between byte updates
+        double bytesPerSecond = 0.0;  // smoothed throughput
+        bool stallReported = false;
+        qint64 stalledAtMs = -1;      // first stall of the current episode
+    };
+
+    qint64 thresholdFor(const Layer& layer) const;
+
+    QHash<QString, Layer> m_layers;
+    QElapsedTimer m_clock;
+    int m_retryCount = 0;
+    QString m_resumedLayer;
+    qint64 m_resumedAfterMs = 0;
+};
@@ -1,10 +1,10 @@
 #include "registrationservice.h"
+#include "apiclient.h"
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QUrl>
-#include <QTimer>
 
 namespace {
 QUrl buildEndpointUrl(const QUrl &baseUrl, const QString &endpoint)
@@ -25,37 +25,57 @@ RegistrationService::RegistrationService(QObject *parent)
 {}
 
 void RegistrationService::generateKey(const QString &baseUrl, const QString &accessKey, const QString &macId, const QString &tenantId)
+{
+    generateKey(baseUrl, accessKey, macId, tenantId, [this](const Result &result) {
+        emit keyGenerated(result.ok, result.message, result.registrationKey, result.generatedOn);
+    });
+}
+
+void RegistrationService::generateKey(const QString &baseUrl, const QString &accessKey, const QString &macId, const QString &tenantId,
+                                      std::function<void(const Result&)> done)
 {
     const QString trimmedBase = baseUrl.trimmed();
     const QString trimmedAccessKey = accessKey.trimmed();
     const QString trimmedMac = macId.trimmed();
     const QString trimmedTenant = tenantId.trimmed();
 
+    auto fail = [&done](const QString &message) {
+        Result result;
+        result.message = message;
+        done(result);
+    };
+
     if (trimmedMac.isEmpty() || trimmedTenant.isEmpty()) {
-        emit keyGenerated(false, "MAC ID and Tenant ID are required.", QString(), QString());
+        fail("MAC ID and Tenant ID are required.");
         return;
     }
 
     if (trimmedAccessKey.isEmpty()) {
-        emit keyGenerated(false, "Access key is not configured.", QString(), QString());
+        fail("Access key is not configured.");
         return;
     }
 
     if (trimmedBase.isEmpty()) {
-        emit keyGenerated(false, "Service base URL is not configured.", QString(), QString());
+        fail("Service base URL is not configured.");
+        return;
+    }
+
+    if (!m_api) {
+        fail("Network client is not configured.");
         return;
     }
 
     QUrl baseUrlUrl(trimmedBase);
     if (!baseUrlUrl.isValid()) {
-        emit keyGenerated(false, "Service URL is invalid.", QString(), QString());
+        fail("Service URL is invalid.");
         return;
     }
 
-    postRegistration(baseUrlUrl, trimmedAccessKey, trimmedMac, trimmedTenant);
+    postRegistration(baseUrlUrl, trimmedAccessKey, trimmedMac, trimmedTenant, std::move(done));
 }
 
-void RegistrationService::postRegistration(const QUrl &baseUrl, const QString &accessKey, const QString &macId, const QString &tenantId)
+void RegistrationService::postRegistration(const QUrl &baseUrl, const QString &accessKey, const QString &macId, const QString &tenantId,
+                                           std::function<void(const Result&)> done)
 {
     const QUrl url = buildEndpointUrl(baseUrl, "/api/registration/generate");
 
@@ -68,24 +88,19 @@ void RegistrationService::postRegistration(const QUrl &baseUrl, const QString &a
     payload.insert("macId", macId);
     payload.insert("tenantId", tenantId);
 
-    QNetworkReply *reply = m_net.post(request, QJsonDocument(payload).toJson(QJsonDocument::Compact));
+    // 30 seconds overall, retried only when the server never saw the request
+    ApiClient::Policy policy;
+    policy.deadlineMs = 30000;
 
-    // Set a timeout for the request (30 seconds)
-    QTimer *timeout = new QTimer(reply);
-    timeout->setSingleShot(true);
-    timeout->setInterval(30000);
-    connect(timeout, &QTimer::timeout, reply, [reply]() {
-        reply->abort();
-    });
-    timeout->start();
+    m_api->post("registration/generate", request, QJsonDocument(payload).toJson(QJsonDocument::Compact), policy,
+                [done](const ApiClient::Response &response) {
+        const QByteArray &body = response.body;
+        const QNetworkReply::NetworkError err = response.error;
+        const QString errString = response.errorString;
+        const int httpStatus = response.httpStatus;
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, timeout]() {
-        timeout->stop();
-        const QByteArray body = reply->readAll();
-        const QNetworkReply::NetworkError err = reply->error();
-        const QString errString = reply->errorString();
-        const int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        reply->deleteLater();
+        Result result;
+        result.elapsedMs = response.elapsedMs;
 
         QJsonParseError parseError{};
         const QJsonDocument doc = QJsonDocument::fromJson(body, &parseError);
@@ -93,15 +108,14 @@ void RegistrationService::postRegistration(const QUrl &baseUrl, const QString &a
             || errString.contains("Internal Server Error", Qt::CaseInsensitive);
 
         if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-            QString fallback;
             if (isServerError) {
-                fallback = "Registration Failed: Internal Server Error.";
+                result.message = "Registration Failed: Internal Server Error.";
             } else if (err == QNetworkReply::NoError && httpStatus >= 200 && httpStatus < 300) {
-                fallback = "Registration Failed: Invalid response.";
+                result.message = "Registration Failed: Invalid response.";
             } else {
-                fallback = "Registration Failed: " + errString;
+                result.message = "Registration Failed: " + errString;
             }
-            emit keyGenerated(false, fallback, QString(), QString());
+            done(result);
             return;
         }
 
@@ -111,31 +125,27 @@ void RegistrationService::postRegistration(const QUrl &baseUrl, const QString &a
         const QString message = root.value("message").toString();
         const QJsonObject data = root.value("data").toObject();
 
-        const QString registrationKey = data.value("registrationKey").toString();
-        const QString generatedOn = data.value("generatedOn").toString();
+        result.registrationKey = data.value("registrationKey").toString();
+        result.generatedOn = data.value("generatedOn").toString();
 
         bool ok = statusCode >= 200 && statusCode < 300;
         if (!ok && !status.isEmpty())
             ok = status.compare("Success", Qt::CaseInsensitive) == 0;
-        if (ok && registrationKey.isEmpty())
+        if (ok && result.registrationKey.isEmpty())
             ok = false;
 
-        QString finalMessage;
         if (ok) {
-            finalMessage = message.isEmpty() ? "Registration Succeeded." : message;
+            result.message = message.isEmpty() ? "Registration Succeeded." : message;
         } else if (message == "DEVICE_NOT_AVAILABLE") {
-            finalMessage = "Registration Failed: DEVICE_NOT_AVAILABLE";
+            result.message = "Registration Failed: DEVICE_NOT_AVAILABLE";
         } else if (message == "TENANT_NOT_FOUND_OR_INACTIVE") {
-            finalMessage = "Registration Failed: TENANT_NOT_FOUND_OR_INACTIVE";
+            result.message = "Registration Failed: TENANT_NOT_FOUND_OR_INACTIVE";
         } else if (statusCode >= 500 || message.contains("Internal Server Error", Qt::CaseInsensitive) || isServerError) {
-            finalMessage = "Registration Failed: Internal Server Error.";
+            result.message = "Registration Failed: Internal Server Error.";
         } else {
-            finalMessage = message.isEmpty() ? "Registration failed." : message;
+            result.message = message.isEmpty() ? "Registration failed." : message;
         }
-
-        emit keyGenerated(ok,
-                          finalMessage,
-                          registrationKey,
-                          generatedOn);
+        result.ok = ok;
+        done(result);
     });
 }
@@ -1,6 +1,9 @@
 #pragma once
 #include <QObject>
-#include <QNetworkAccessManager>
+#include <QUrl>
+#include <functional>
+
+class ApiClient;
 
 class RegistrationService : public QObject
 {
@@ -8,12 +11,27 @@ class RegistrationService : public QObject
 public:
     explicit RegistrationService(QObject* parent = nullptr);
 
+    struct Result {
+        bool ok = false;
+        QString message;
+        QString registrationKey;
+        QString generatedOn;
+        qint64 elapsedMs = 0;
+    };
+
+    void setApiClient(ApiClient* client) { m_api = client; }
+
     void generateKey(const QString& baseUrl, const QString& accessKey, const QString& macId, const QString& tenantId);
+    // Same request, but the result goes to the callback instead of
+    // keyGenerated, so several registrations can be in flight at once.
+    void generateKey(const QString& baseUrl, const QString& accessKey, const QString& macId, const QString& tenantId,
+                     std::function<void(const Result&)> done);
 
 signals:
     void keyGenerated(bool ok, const QString& message, const QString& registrationKey, const QString& generatedOn);
 
 private:
-    void postRegistration(const QUrl& baseUrl, const QString& accessKey, const QString& macId, const QString& tenantId);
-    QNetworkAccessManager m_net;
+    void postRegistration(const QUrl& baseUrl, const QString& accessKey, const QString& macId, const QString& tenantId,
+                          std::function<void(const Result&)> done);
+    ApiClient* m_api = nullptr;
 };
@@ -0,0 +1,198 @@
+#include "registrycredentials.h"
+#include "tracer.h"
+#include "metrics.h"
+#include "apiclient.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QProcess>
+#include <QStringList>
+#include <QRegularExpression>
+#include <QUrl>
+#include <QUrlQuery>
+
+namespace {
+// Registries that omit expires_in issue tokens valid for at least 60 s
+constexpr int DefaultTokenLifetimeSecs = 60;
+constexpr int TokenExpiryMarginSecs = 10;
+
+QString challengeParam(const QString &challenge, const QString &name)
+{
+    const QRegularExpression re(name + "=\"([^\"]*)\"");
+    return re.match(challenge).captured(1);
+}
+
+bool findAuthEntry(const QJsonObject &auths, const QString &host, QJsonObject *entry)
+{
+    const QStringList keys = {host, "https://" + host, "https://" + host + "/v2/", "http://" + host};
+    for (const QString &key : keys) {
+        if (auths.contains(key)) {
+            *entry = auths.value(key).toObject();
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+RegistryCredentials::RegistryCredentials(QObject *parent)
+    : QObject(parent)
+{}
+
+void RegistryCredentials::setRegistry(const QString &host, const QString &user, const QString &password)
+{
+    m_host = host;
+    m_user = user;
+    m_password = password;
+    m_tokens.clear();
+}
+
+QString RegistryCredentials::configPath()
+{
+    const QString configDir = qEnvironmentVariable("DOCKER_CONFIG", QDir::homePath() + "/.docker");
+    return configDir + "/config.json";
+}
+
+bool RegistryCredentials::hasCachedLogin() const
+{
+    if (m_forceLogin)
+        return false;
+
+    QFile inFile(configPath());
+    if (!inFile.open(QIODevice::ReadOnly))
+        return false;
+    const QJsonObject config = QJsonDocument::fromJson(inFile.readAll()).object();
+    QJsonObject entry;
+    if (!findAuthEntry(config.value("auths").toObject(), m_host, &entry))
+        return false;
+
+    const QString auth = entry.value("auth").toString();
+    if (!auth.isEmpty()) {
+        const QString decoded = QString::fromUtf8(QByteArray::fromBase64(auth.toLatin1()));
+        return decoded == m_user + ":" + m_password;
+    }
+
+    // The secret lives in a credential helper; the entry only records that a
+    // login for this host succeeded.
+    const bool helper = !config.value("credsStore").toString().isEmpty()
+        || !config.value("credHelpers").toObject().value(m_host).toString().isEmpty();
+    return helper;
+}
+
+void RegistryCredentials::ensureLogin(std::function<void(bool, bool, const QString&)> done)
+{
+    if (hasCachedLogin()) {
+        ++m_loginsSkipped;
+        if (done)
+            done(true, false, QString());
+        return;
+    }
+    login([done](bool ok, const QString &output) {
+        if (done)
+            done(ok, true, output);
+    });
+}
+
+void RegistryCredentials::login(std::function<void(bool, const QString&)> done)
+{
+    QProcess *process = new QProcess(this);
+    QPointer<QProcess> guard(process);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    QElapsedTimer clock;
+    clock.start();
+
+    connect(process, &QProcess::started, this, [guard, password = m_password]() {
+        if (!guard)
+            return;
+        guard->write(password.toUtf8() + "\n");
+        guard->closeWriteChannel();
+    });
+
+    connect(process, &QProcess::finished, this,
+            [this, guard, done, clock](int exitCode, QProcess::ExitStatus exitStatus) {
+                if (!guard)
+                    return;
+                const QString output = QString::fromUtf8(guard->readAll()).trimmed();
+                const bool ok = exitStatus == QProcess::NormalExit && exitCode == 0;
+                Metrics::global().loginDuration.observe(double(clock.elapsed()) / 1000.0);
+                if (!ok)
+                    Metrics::global().loginFailures.add();
+                guard->deleteLater();
+                ++m_loginsPerformed;
+                if (ok)
+                    m_forceLogin = false;
+                if (done)
+                    done(ok, output);
+            });
+
+    connect(process, &QProcess::errorOccurred, this,
+            [guard, done](QProcess::ProcessError error) {
+                if (!guard || error != QProcess::FailedToStart)
+                    return;
+                Metrics::global().loginFailures.add();
+                guard->deleteLater();
+                if (done)
+                    done(false, QString());
+            });
+
+    // The password goes over stdin so it never shows up in the process list
+    Tracer::traceProcess(process, "docker login");
+    process->start("bash", {"-lc",
+        QString("sg docker -c 'docker login %1 -u %2 --password-stdin'").arg(m_host, m_user)});
+}
+
+QString RegistryCredentials::basicAuthorization() const
+{
+    const QByteArray credentials = (m_user + ":" + m_password).toUtf8();
+    return "Basic " + QString::fromLatin1(credentials.toBase64());
+}
+
+QString RegistryCredentials::cachedToken(const QString &scope) const
+{
+    const auto it = m_tokens.constFind(scope);
+    if (it == m_tokens.constEnd() || QDateTime::currentDateTimeUtc() >= it.value().expiresAt)
+        return QString();
+    return it.value().value;
+}
+
+void RegistryCredentials::fetchToken(const QString &challenge, const QString &scope, std::function<void(const QString&)> done)
+{
+    const QString cached = cachedToken(scope);
+    if (!cached.isEmpty()) {
+        done(cached);
+        return;
+    }
+
+    QUrl tokenUrl(challengeParam(challenge, "realm"));
+    if (!m_api || !tokenUrl.isValid() || tokenUrl.isEmpty()) {
+        done(QString());
+        return;
+    }
+    QUrlQuery query;
+    query.addQueryItem("service", challengeParam(challenge, "service"));
+    query.addQueryItem("scope", scope);
+    tokenUrl.setQuery(query);
+    QNetworkRequest request(tokenUrl);
+    request.setRawHeader("Authorization", basicAuthorization().toUtf8());
+
+    ApiClient::Policy policy;
+    policy.deadlineMs = 30000;
+    m_api->get("registry/token", request, policy, [this, scope, done](const ApiClient::Response &response) {
+        const QJsonObject obj = QJsonDocument::fromJson(response.body).object();
+        const QString token = obj.value("access_token").toString(obj.value("token").toString());
+        if (response.error != QNetworkReply::NoError || token.isEmpty()) {
+            done(QString());
+            return;
+        }
+        const int lifetime = obj.value("expires_in").toInt(DefaultTokenLifetimeSecs);
+        Token entry;
+        entry.value = token;
+        entry.expiresAt = QDateTime::currentDateTimeUtc().addSecs(qMax(0, lifetime - TokenExpiryMarginSecs));
+        m_tokens.insert(scope, entry);
+        done(token);
+    });
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QDateTime>
+#include <functional>
+
+class ApiClient;
+
+// Decides whether a `docker login` is needed before talking to the registry.
+// The docker client config (~/.docker/config.json, or $DOCKER_CONFIG) already
+// holds the credentials from the last login; when they match the configured
+// account, or a credential helper owns the entry, the login is skipped. A
+// pull that fails with an auth error calls invalidate() so the next attempt
+// logs in again. Bearer tokens for our own registry requests are cached until
+// they expire.
+class RegistryCredentials : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RegistryCredentials(QObject* parent = nullptr);
+
+    void setRegistry(const QString& host, const QString& user, const QString& password);
+    void setApiClient(ApiClient* client) { m_api = client; }
+
+    bool hasCachedLogin() const;
+    void invalidate() { m_forceLogin = true; }
+
+    // Logs in only when the cached credentials cannot be used.
+    void ensureLogin(std::function<void(bool ok, bool performed, const QString& output)> done);
+    // Always runs `docker login`.
+    void login(std::function<void(bool ok, const QString& output)> done);
+
+    QString basicAuthorization() const;
+    QString cachedToken(const QString& scope) const;
+    // Exchanges the basic credentials for a bearer token using a registry's
+    // WWW-Authenticate challenge; reuses a cached token while it is valid.
+    void fetchToken(const QString& challenge, const QString& scope, std::function<void(const QString&)> done);
+
+    int loginsSkipped() const { return m_loginsSkipped; }
+    int loginsPerformed() const { return m_loginsPerformed; }
+
+    static QString configPath();
+
+private:
+    struct Token {
+        QString value;
+        QDateTime expiresAt;
+    };
+
+    QString m_host;
+    QString m_user;
+    QString m_password;
+    bool m_forceLogin = false;
+    int m_loginsSkipped = 0;
+    int m_loginsPerformed = 0;
+    QHash<QString, Token> m_tokens;
+    ApiClient* m_api = nullptr;
+};
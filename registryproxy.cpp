@@ -0,0 +1,376 @@
+#include "registryproxy.h"
+#include "bandwidthscheduler.h"
+#include "registrycredentials.h"
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRegularExpression>
+#include <QTcpSocket>
+#include <QTimer>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Requests larger than this are treated as malformed
+constexpr int MaxHeaderBytes = 64 * 1024;
+// Unread upstream data and unsent downstream data are both kept small, so
+// the rate the daemon sees is the rate the registry is read at
+constexpr qint64 ReadBufferBytes = 64 * 1024;
+constexpr qint64 MaxPendingWriteBytes = 64 * 1024;
+constexpr qint64 ChunkBytes = 16 * 1024;
+// Burst allowance of the ceiling: a quarter second, but never below one chunk
+constexpr qint64 MinCeilingBucketBytes = 16 * 1024;
+constexpr int MinWaitMs = 10;
+constexpr int MaxRedirects = 5;
+constexpr int UpstreamInactivityTimeoutMs = 60000;
+
+// Everything a pull looks at; hop-by-hop and encoding headers stay behind
+const char *const ForwardedHeaders[] = {
+    "Content-Type",
+    "Content-Length",
+    "Docker-Content-Digest",
+    "Docker-Distribution-API-Version",
+    "ETag",
+};
+
+QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 502: return "Bad Gateway";
+    default: return "Unknown";
+    }
+}
+
+// Body in the distribution API's error format, which the daemon logs
+QByteArray registryError(const QString &code, const QString &message)
+{
+    const QJsonObject error{{"code", code}, {"message", message}};
+    return QJsonDocument(QJsonObject{{"errors", QJsonArray{error}}}).toJson(QJsonDocument::Compact);
+}
+
+// <repository> of /v2/<repository>/manifests/<reference> or /v2/<repository>/blobs/<digest>
+QString repositoryOf(const QString &path)
+{
+    static const QRegularExpression pattern("^/v2/(.+)/(manifests|blobs)/[^/]+$");
+    const QRegularExpressionMatch match = pattern.match(path);
+    return match.hasMatch() ? match.captured(1) : QString();
+}
+
+QString pullScope(const QString &repository)
+{
+    return QString("repository:%1:pull").arg(repository);
+}
+} // namespace
+
+RegistryProxy::RegistryProxy(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &RegistryProxy::onNewConnection);
+}
+
+RegistryProxy::~RegistryProxy()
+{
+    // Sockets and replies go with the members below; none may call back
+    for (auto it = m_exchanges.begin(); it != m_exchanges.end(); ++it) {
+        it.key()->disconnect(this);
+        if (it->reply) {
+            it->reply->disconnect(this);
+            it->reply->abort();
+        }
+    }
+}
+
+void RegistryProxy::setRateCeiling(qint64 bytesPerSecond)
+{
+    m_ceiling = qMax<qint64>(0, bytesPerSecond);
+    m_ceilingTokens = 0.0;
+    m_ceilingClock.start();
+}
+
+bool RegistryProxy::listen(quint16 port)
+{
+    return m_server.listen(QHostAddress::LocalHost, port);
+}
+
+QString RegistryProxy::localReference(const QString &image) const
+{
+    const int slash = image.indexOf('/');
+    return QString("127.0.0.1:%1/%2").arg(port()).arg(slash > 0 ? image.mid(slash + 1) : image);
+}
+
+void RegistryProxy::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        m_exchanges.insert(socket, Exchange());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onRequestData(socket); });
+        // The daemon took some of what was written; there is room for more
+        connect(socket, &QTcpSocket::bytesWritten, this, [this, socket]() { pump(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { drop(socket); });
+    }
+}
+
+void RegistryProxy::onRequestData(QTcpSocket *socket)
+{
+    auto it = m_exchanges.find(socket);
+    if (it == m_exchanges.end() || !it->method.isEmpty()) {
+        // One request per connection; the response closes it
+        socket->readAll();
+        return;
+    }
+    it->request += socket->readAll();
+    const int end = it->request.indexOf("\r\n\r\n");
+    if (end < 0) {
+        if (it->request.size() > MaxHeaderBytes)
+            respond(socket, 400, registryError("UNSUPPORTED", "Request header too large."));
+        return;
+    }
+
+    const QList<QByteArray> lines = it->request.left(end).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    if (requestLine.size() != 3 || !requestLine.at(2).startsWith("HTTP/1.")) {
+        // Also what a TLS handshake ends up as; the daemon then retries
+        // loopback registries over plain HTTP
+        respond(socket, 400, registryError("UNSUPPORTED", "Not an HTTP/1.x request."));
+        return;
+    }
+    // The daemon sends one Accept header per manifest type it understands
+    QList<QByteArray> accept;
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        const int colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed().toLower() == "accept")
+            accept << line.mid(colon + 1).trimmed();
+    }
+    it->method = requestLine.at(0);
+    it->path = QString::fromLatin1(requestLine.at(1));
+    it->accept = accept.join(", ");
+    it->request.clear();
+
+    if (it->method != "GET" && it->method != "HEAD") {
+        respond(socket, 405, registryError("UNSUPPORTED", "Only pulls go through this proxy."));
+        return;
+    }
+    const QString path = it->path.section('?', 0, 0);
+    if (path == "/v2/" || path == "/v2") {
+        // The daemon's version check; authentication is ours to do upstream
+        respond(socket, 200, "{}", "Docker-Distribution-API-Version: registry/2.0\r\n");
+        return;
+    }
+    const QString repository = repositoryOf(path);
+    if (repository.isEmpty() || !m_upstream.isValid()) {
+        respond(socket, 404, registryError("NAME_UNKNOWN", "Unknown path " + path));
+        return;
+    }
+
+    QString authorization;
+    if (m_credentials) {
+        const QString token = m_credentials->cachedToken(pullScope(repository));
+        authorization = token.isEmpty() ? m_credentials->basicAuthorization() : "Bearer " + token;
+    }
+    forward(socket, m_upstream.resolved(QUrl::fromEncoded(requestLine.at(1))), authorization);
+}
+
+void RegistryProxy::forward(QTcpSocket *socket, const QUrl &url, const QString &authorization)
+{
+    auto it = m_exchanges.find(socket);
+    if (it == m_exchanges.end())
+        return;
+
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::ManualRedirectPolicy);
+    // Layers take many minutes, so only a stalled transfer is aborted
+    request.setTransferTimeout(UpstreamInactivityTimeoutMs);
+    // Bodies are passed on byte for byte, with the upstream Content-Length
+    request.setRawHeader("Accept-Encoding", "identity");
+    if (!it->accept.isEmpty())
+        request.setRawHeader("Accept", it->accept);
+    if (!authorization.isEmpty())
+        request.setRawHeader("Authorization", authorization.toUtf8());
+
+    QNetworkReply *reply = it->method == "HEAD" ? m_net.head(request) : m_net.get(request);
+    reply->setReadBufferSize(ReadBufferBytes);
+    it->reply = reply;
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, socket]() { onUpstreamHeaders(socket); });
+    connect(reply, &QNetworkReply::readyRead, this, [this, socket]() { pump(socket); });
+    connect(reply, &QNetworkReply::finished, this, [this, socket]() { onUpstreamFinished(socket); });
+}
+
+void RegistryProxy::onUpstreamHeaders(QTcpSocket *socket)
+{
+    const auto it = m_exchanges.find(socket);
+    if (it == m_exchanges.end() || !it->reply || it->headerSent)
+        return;
+    const int status = it->reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // Redirects and auth challenges are dealt with once their reply is complete
+    if (status == 0 || (status >= 300 && status < 400) || status == 401)
+        return;
+    sendHeader(socket, it->reply);
+}
+
+void RegistryProxy::onUpstreamFinished(QTcpSocket *socket)
+{
+    auto it = m_exchanges.find(socket);
+    if (it == m_exchanges.end() || !it->reply)
+        return;
+    QNetworkReply *reply = it->reply;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    if (!it->headerSent && status >= 300 && status < 400 && reply->hasRawHeader("Location")
+        && it->redirects < MaxRedirects) {
+        const QUrl target = reply->url().resolved(QUrl::fromEncoded(reply->rawHeader("Location")));
+        ++it->redirects;
+        reply->disconnect(this);
+        reply->deleteLater();
+        // Blob storage URLs are pre-signed; our credentials stay behind
+        forward(socket, target, QString());
+        return;
+    }
+
+    if (!it->headerSent && status == 401 && !it->tokenTried && m_credentials) {
+        const QString challenge = QString::fromLatin1(reply->rawHeader("WWW-Authenticate"));
+        if (challenge.startsWith("Bearer", Qt::CaseInsensitive)) {
+            // Registries that do not take basic auth hand out a bearer token
+            it->tokenTried = true;
+            const QUrl url = reply->url();
+            const QString scope = pullScope(repositoryOf(it->path.section('?', 0, 0)));
+            reply->disconnect(this);
+            reply->deleteLater();
+            it->reply = nullptr;
+            m_credentials->fetchToken(challenge, scope, [this, socket, url](const QString &token) {
+                if (!m_exchanges.contains(socket))
+                    return;
+                if (token.isEmpty()) {
+                    respond(socket, 401, registryError("UNAUTHORIZED", "Registry token exchange failed."));
+                    return;
+                }
+                forward(socket, url, "Bearer " + token);
+            });
+            return;
+        }
+    }
+
+    if (status == 0) {
+        // No HTTP response at all: DNS, TLS or connection failure. Mid-body
+        // the daemon sees the short read and retries the blob.
+        if (it->headerSent)
+            socket->abort();
+        else
+            respond(socket, 502, registryError("UNAVAILABLE", reply->errorString()));
+        return;
+    }
+
+    if (!it->headerSent)
+        sendHeader(socket, reply);
+    it->upstreamDone = true;
+    pump(socket);
+}
+
+void RegistryProxy::sendHeader(QTcpSocket *socket, QNetworkReply *reply)
+{
+    const auto it = m_exchanges.find(socket);
+    if (it == m_exchanges.end())
+        return;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QByteArray header = "HTTP/1.1 " + QByteArray::number(status) + ' '
+                        + reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray() + "\r\n";
+    for (const char *name : ForwardedHeaders) {
+        if (reply->hasRawHeader(name))
+            header += QByteArray(name) + ": " + reply->rawHeader(name) + "\r\n";
+    }
+    header += "Connection: close\r\n\r\n";
+    socket->write(header);
+    it->headerSent = true;
+}
+
+void RegistryProxy::pump(QTcpSocket *socket)
+{
+    const auto it = m_exchanges.find(socket);
+    if (it == m_exchanges.end() || !it->headerSent || it->pumpScheduled)
+        return;
+
+    QNetworkReply *reply = it->reply;
+    while (reply && reply->bytesAvailable() > 0) {
+        // The daemon reads slower than we may send; bytesWritten resumes
+        if (socket->bytesToWrite() >= MaxPendingWriteBytes)
+            return;
+        const qint64 wanted = qMin(reply->bytesAvailable(), ChunkBytes);
+        const qint64 allowed = qMin(wanted, ceilingAllowance());
+        const qint64 granted = m_bandwidth ? m_bandwidth->acquire(allowed) : allowed;
+        if (granted <= 0) {
+            // Budget spent: come back when enough tokens have accumulated.
+            // readyRead will not fire again while the read buffer is full.
+            const int waitMs = qMax(ceilingWaitMs(wanted), m_bandwidth ? m_bandwidth->msUntilAvailable(wanted) : 0);
+            it->pumpScheduled = true;
+            QTimer::singleShot(qMax(MinWaitMs, waitMs), this, [this, socket]() {
+                const auto it = m_exchanges.find(socket);
+                if (it == m_exchanges.end())
+                    return;
+                it->pumpScheduled = false;
+                pump(socket);
+            });
+            return;
+        }
+        if (m_ceiling > 0)
+            m_ceilingTokens -= double(granted);
+        m_bytesServed += granted;
+        socket->write(reply->read(granted));
+    }
+
+    // Closing flushes what is still queued for the daemon first
+    if (it->upstreamDone)
+        socket->disconnectFromHost();
+}
+
+void RegistryProxy::respond(QTcpSocket *socket, int status, const QByteArray &body, const QByteArray &extraHeaders)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n";
+    response += "Content-Type: application/json\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += extraHeaders;
+    response += "Connection: close\r\n\r\n";
+    const auto it = m_exchanges.constFind(socket);
+    if (it == m_exchanges.constEnd() || it->method != "HEAD")
+        response += body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+void RegistryProxy::drop(QTcpSocket *socket)
+{
+    const auto it = m_exchanges.find(socket);
+    if (it == m_exchanges.end())
+        return;
+    // The daemon gave up on this request; so does the upstream transfer
+    if (it->reply) {
+        it->reply->disconnect(this);
+        it->reply->abort();
+        it->reply->deleteLater();
+    }
+    m_exchanges.erase(it);
+    socket->deleteLater();
+}
+
+qint64 RegistryProxy::ceilingAllowance()
+{
+    if (m_ceiling <= 0)
+        return std::numeric_limits<qint64>::max();
+    const double bucket = double(qMax(MinCeilingBucketBytes, m_ceiling / 4));
+    m_ceilingTokens = qMin(bucket, m_ceilingTokens + double(m_ceiling) * double(m_ceilingClock.restart()) / 1000.0);
+    return qint64(m_ceilingTokens);
+}
+
+int RegistryProxy::ceilingWaitMs(qint64 bytes)
+{
+    if (m_ceiling <= 0)
+        return 0;
+    const double needed = double(qMin(bytes, qMax(MinCeilingBucketBytes, m_ceiling / 4))) - m_ceilingTokens;
+    return needed <= 0.0 ? 0 : int(std::ceil(needed * 1000.0 / double(m_ceiling)));
+}
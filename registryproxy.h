@@ -0,0 +1,88 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QString>
+#include <QTcpServer>
+#include <QUrl>
+
+class BandwidthScheduler;
+class QNetworkReply;
+class QTcpSocket;
+class RegistryCredentials;
+
+// A pull-through proxy in front of the image registry, so the docker
+// daemon's pulls draw from the same bandwidth budget as everything else the
+// installer downloads. The daemon pulls `127.0.0.1:<port>/<repository>`
+// (loopback registries may use plain HTTP without any daemon configuration).
+// Every request is forwarded to the upstream registry with our credentials,
+// and response bodies are handed back only as fast as the scheduler grants
+// tokens. Unread upstream data is bounded, so TCP flow control slows the
+// registry down instead of the proxy buffering whole layers.
+//
+// Only what a pull needs is served: GET and HEAD of /v2/, manifests and
+// blobs. Blob redirects to a CDN are followed here, without our
+// Authorization header.
+class RegistryProxy : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RegistryProxy(QObject* parent = nullptr);
+    ~RegistryProxy() override;
+
+    void setUpstream(const QUrl& url) { m_upstream = url; }
+    void setCredentials(RegistryCredentials* credentials) { m_credentials = credentials; }
+    void setBandwidthScheduler(BandwidthScheduler* scheduler) { m_bandwidth = scheduler; }
+    // A limit of this proxy's own on top of the scheduler's; 0 for none
+    void setRateCeiling(qint64 bytesPerSecond);
+    qint64 rateCeiling() const { return m_ceiling; }
+
+    // Listens on loopback only; port 0 picks a free one
+    bool listen(quint16 port = 0);
+    bool isListening() const { return m_server.isListening(); }
+    quint16 port() const { return m_server.serverPort(); }
+    // `image` with its registry host replaced by this proxy
+    QString localReference(const QString& image) const;
+
+    qint64 bytesServed() const { return m_bytesServed; }
+
+private:
+    struct Exchange {
+        QByteArray request;     // until the header is complete
+        QByteArray method;
+        QString path;
+        QByteArray accept;
+        QPointer<QNetworkReply> reply;
+        int redirects = 0;
+        bool tokenTried = false;
+        bool headerSent = false;
+        bool upstreamDone = false;
+        bool pumpScheduled = false;
+    };
+
+    void onNewConnection();
+    void onRequestData(QTcpSocket* socket);
+    void forward(QTcpSocket* socket, const QUrl& url, const QString& authorization);
+    void onUpstreamHeaders(QTcpSocket* socket);
+    void onUpstreamFinished(QTcpSocket* socket);
+    void sendHeader(QTcpSocket* socket, QNetworkReply* reply);
+    void pump(QTcpSocket* socket);
+    void respond(QTcpSocket* socket, int status, const QByteArray& body, const QByteArray& extraHeaders = {});
+    void drop(QTcpSocket* socket);
+    qint64 ceilingAllowance();
+    int ceilingWaitMs(qint64 bytes);
+
+    QTcpServer m_server;
+    QNetworkAccessManager m_net;
+    QUrl m_upstream;
+    RegistryCredentials* m_credentials = nullptr;
+    BandwidthScheduler* m_bandwidth = nullptr;
+    QHash<QTcpSocket*, Exchange> m_exchanges;
+    qint64 m_ceiling = 0;
+    double m_ceilingTokens = 0.0;
+    QElapsedTimer m_ceilingClock;
+    qint64 m_bytesServed = 0;
+};
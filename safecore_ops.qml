@@ -45,7 +45,7 @@ Window {
             return;
         }
 
-        quitDialog.open();
+        quitDialogLoader.open();
     }
     Connections {
         target: AppController
@@ -263,18 +263,21 @@ Window {
 
                                 if (modelData.label === "Upgrade") {
                                     sideDrawer.close()
-                                    if (AppController.dockerOpsRunning) {
-                                        upgradeWarningDialog.open()
+                                    if (AppController.stagedUpgradeReady) {
+                                        // Already downloaded in the background; applying restarts the container
+                                        upgradeDialogLoader.open({stagedMode: true})
+                                    } else if (AppController.dockerOpsRunning) {
+                                        upgradeWarningDialogLoader.open()
                                     } else {
-                                        upgradeDialog.open()
+                                        upgradeDialogLoader.open()
                                         AppController.startUpgrade()
                                     }
                                 } else if (modelData.label === "Repair") {
                                     sideDrawer.close()
                                     if (AppController.dockerOpsRunning) {
-                                        repairDialog.open()
+                                        repairDialogLoader.open()
                                     } else {
-                                        AppController.runDockerOps(false)  // Don't remove volumes on repair
+                                        AppController.runDockerOps(false)  // Reconcile: start, restart or recreate as needed; volumes are kept
                                     }
                                 }
                             }
@@ -603,131 +606,137 @@ Window {
                         }
                     }
                 }
-                Rectangle {
+                // Created while the logs are shown; the text stays in the controller
+                Loader {
                     Layout.fillWidth: true
                     Layout.preferredHeight: opsRoot.showContainerLogs ? opsRoot.consoleHeight : 0
-                    radius: 12
-                    color: "#050811"
-                    border.color: "#2D3B5F"
-                    border.width: 1
                     visible: opsRoot.showContainerLogs
+                    active: opsRoot.showContainerLogs
+                    sourceComponent: Component {
+                        Rectangle {
+                            radius: 12
+                            color: "#050811"
+                            border.color: "#2D3B5F"
+                            border.width: 1
 
-                    property bool autoScrollFollow: true
+                            property bool autoScrollFollow: true
 
-                    // Subtle gradient overlay
-                    Rectangle {
-                        anchors.fill: parent
-                        radius: parent.radius
-                        gradient: Gradient {
-                            GradientStop { position: 0.0; color: "#0A101800" }
-                            GradientStop { position: 1.0; color: "#0A101820" }
-                        }
-                    }
+                            // Subtle gradient overlay
+                            Rectangle {
+                                anchors.fill: parent
+                                radius: parent.radius
+                                gradient: Gradient {
+                                    GradientStop { position: 0.0; color: "#0A101800" }
+                                    GradientStop { position: 1.0; color: "#0A101820" }
+                                }
+                            }
 
-                    // Header bar with label
-                    Rectangle {
-                        anchors.top: parent.top
-                        anchors.left: parent.left
-                        anchors.right: parent.right
-                        height: 32
-                        color: "#0F1623"
-                        radius: 12
-                        Rectangle {
-                            anchors.bottom: parent.bottom
-                            anchors.left: parent.left
-                            anchors.right: parent.right
-                            height: parent.radius
-                            color: parent.color
-                        }
+                            // Header bar with label
+                            Rectangle {
+                                anchors.top: parent.top
+                                anchors.left: parent.left
+                                anchors.right: parent.right
+                                height: 32
+                                color: "#0F1623"
+                                radius: 12
+                                Rectangle {
+                                    anchors.bottom: parent.bottom
+                                    anchors.left: parent.left
+                                    anchors.right: parent.right
+                                    height: parent.radius
+                                    color: parent.color
+                                }
 
-                        RowLayout {
-                            anchors.fill: parent
-                            anchors.leftMargin: 12
-                            anchors.rightMargin: 12
-                            spacing: 8
+                                RowLayout {
+                                    anchors.fill: parent
+                                    anchors.leftMargin: 12
+                                    anchors.rightMargin: 12
+                                    spacing: 8
 
-                            Text {
-                                text: "📡"
-                                color: "#6EE7FF"
-                                font.pixelSize: 14
-                            }
+                                    Text {
+                                        text: "📡"
+                                        color: "#6EE7FF"
+                                        font.pixelSize: 14
+                                    }
 
-                            Text {
-                                text: "Live Container Logs"
-                                color: "#93C5FD"
-                                font.pixelSize: 11
-                                font.weight: Font.Medium
-                            }
+                                    Text {
+                                        text: "Live Container Logs"
+                                        color: "#93C5FD"
+                                        font.pixelSize: 11
+                                        font.weight: Font.Medium
+                                    }
 
-                            Item { Layout.fillWidth: true }
+                                    Item { Layout.fillWidth: true }
 
-                            Rectangle {
-                                width: 6
-                                height: 6
-                                radius: 3
-                                color: "#22C55E"
-                                opacity: 0.8
+                                    Rectangle {
+                                        width: 6
+                                        height: 6
+                                        radius: 3
+                                        color: "#22C55E"
+                                        opacity: 0.8
+
+                                        SequentialAnimation on opacity {
+                                            running: true
+                                            loops: Animation.Infinite
+                                            NumberAnimation { from: 0.3; to: 1.0; duration: 600 }
+                                            NumberAnimation { from: 1.0; to: 0.3; duration: 600 }
+                                        }
+                                    }
 
-                                SequentialAnimation on opacity {
-                                    running: true
-                                    loops: Animation.Infinite
-                                    NumberAnimation { from: 0.3; to: 1.0; duration: 600 }
-                                    NumberAnimation { from: 1.0; to: 0.3; duration: 600 }
+                                    Text {
+                                        text: "STREAMING"
+                                        color: "#22C55E"
+                                        font.pixelSize: 10
+                                        font.weight: Font.Bold
+                                        font.letterSpacing: 0.5
+                                    }
                                 }
                             }
 
-                            Text {
-                                text: "STREAMING"
-                                color: "#22C55E"
-                                font.pixelSize: 10
-                                font.weight: Font.Bold
-                                font.letterSpacing: 0.5
-                            }
-                        }
-                    }
+                            Flickable {
+                                id: opsLogFollowFlickable
+                                anchors.fill: parent
+                                anchors.topMargin: 42
+                                anchors.leftMargin: 12
+                                anchors.rightMargin: 12
+                                anchors.bottomMargin: 12
+                                clip: true
+                                contentWidth: opsLogFollow.implicitWidth
+                                contentHeight: opsLogFollow.implicitHeight
+                                boundsBehavior: Flickable.StopAtBounds
+                                ScrollBar.horizontal: ScrollBar { policy: ScrollBar.AsNeeded }
+                                ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
+
+                                onContentHeightChanged: {
+                                    if (parent.autoScrollFollow) {
+                                        contentY = Math.max(0, contentHeight - height);
+                                    }
+                                }
 
-                    Flickable {
-                        id: opsLogFollowFlickable
-                        anchors.fill: parent
-                        anchors.topMargin: 42
-                        anchors.leftMargin: 12
-                        anchors.rightMargin: 12
-                        anchors.bottomMargin: 12
-                        clip: true
-                        contentWidth: opsLogFollow.implicitWidth
-                        contentHeight: opsLogFollow.implicitHeight
-                        boundsBehavior: Flickable.StopAtBounds
-                        ScrollBar.horizontal: ScrollBar { policy: ScrollBar.AsNeeded }
-                        ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
+                                onContentYChanged: {
+                                    var maxY = Math.max(0, contentHeight - height);
+                                    parent.autoScrollFollow = (contentY >= maxY - 10);
+                                }
 
-                        onContentHeightChanged: {
-                            if (parent.autoScrollFollow) {
-                                contentY = Math.max(0, contentHeight - height);
+                                TextArea {
+                                    id: opsLogFollow
+                                    text: AppController.dockerOpsFollowLog.length
+                                        ? AppController.dockerOpsFollowLog
+                                        : "Waiting for container logs..."
+                                    readOnly: true
+                                    textFormat: TextEdit.PlainText
+                                    wrapMode: TextEdit.NoWrap
+                                    font.family: "JetBrains Mono, Consolas, Monaco, Monospace"
+                                    font.pixelSize: 12
+                                    color: AppController.dockerOpsFollowLog.length ? "#E0E7FF" : "#64748B"
+                                    background: null
+                                    width: implicitWidth
+                                    height: implicitHeight
+                                    bottomPadding: 10
+                                    rightPadding: 10
+                                }
                             }
                         }
-
-                        onContentYChanged: {
-                            var maxY = Math.max(0, contentHeight - height);
-                            parent.autoScrollFollow = (contentY >= maxY - 10);
-                        }
-
-                        TextArea {
-                            id: opsLogFollow
-                            text: AppController.dockerOpsFollowLog.length
-                                ? AppController.dockerOpsFollowLog
-                                : "Waiting for container logs..."
-                            readOnly: true
-                            textFormat: TextEdit.PlainText
-                            wrapMode: TextEdit.NoWrap
-                            font.family: "JetBrains Mono, Consolas, Monaco, Monospace"
-                            font.pixelSize: 12
-                            color: AppController.dockerOpsFollowLog.length ? "#E0E7FF" : "#64748B"
-                            background: null
-                            width: implicitWidth
-                            height: implicitHeight
-                            bottomPadding: 10
-                            rightPadding: 10
-                        }
                     }
                 }
                 Item { height: 3 }
@@ -839,791 +848,854 @@ Window {
         }
     }
 
-    Dialog {
-        id: quitDialog
-        modal: true
-        parent: opsRoot.contentItem
-        closePolicy: Popup.NoAutoClose
-        title: "Quit SafeCore"
-        anchors.centerIn: parent
-        implicitWidth: 650
-        implicitHeight: header.height + contentItem.implicitHeight + 24
-
-        onOpened: opsRoot.activeDialog = quitDialog
-        onClosed: opsRoot.activeDialog = null
-
-        function blinkDialog() {
-            blinkAnimation.start()
-        }
+    DialogLoader {
+        id: quitDialogLoader
+        sourceComponent: Component {
+            Dialog {
+                id: quitDialog
+                modal: true
+                parent: opsRoot.contentItem
+                closePolicy: Popup.NoAutoClose
+                title: "Quit SafeCore"
+                anchors.centerIn: parent
+                implicitWidth: 650
+                implicitHeight: header.height + contentItem.implicitHeight + 24
+
+                onOpened: opsRoot.activeDialog = quitDialog
+                onClosed: opsRoot.activeDialog = null
+
+                function blinkDialog() {
+                    blinkAnimation.start()
+                }
 
-        SequentialAnimation {
-            id: blinkAnimation
-            NumberAnimation {
-                target: quitDialog
-                property: "opacity"
-                from: 1.0
-                to: 0.3
-                duration: 100
-            }
-            NumberAnimation {
-                target: quitDialog
-                property: "opacity"
-                from: 0.3
-                to: 1.0
-                duration: 100
-            }
-        }
+                SequentialAnimation {
+                    id: blinkAnimation
+                    NumberAnimation {
+                        target: quitDialog
+                        property: "opacity"
+                        from: 1.0
+                        to: 0.3
+                        duration: 100
+                    }
+                    NumberAnimation {
+                        target: quitDialog
+                        property: "opacity"
+                        from: 0.3
+                        to: 1.0
+                        duration: 100
+                    }
+                }
 
-        header: Rectangle {
-            height: 44
-            color: "#151B2A"
-            border.color: "#1F2A4A"
-            border.width: 1
-            Row {
-                anchors.verticalCenter: parent.verticalCenter
-                anchors.left: parent.left
-                anchors.leftMargin: 18
-                spacing: 8
-                Image {
-                    anchors.verticalCenter: parent.verticalCenter
-                    source: "qrc:/images/icons/quit_icon.png"
-                    width: 18
-                    height: 18
-                    fillMode: Image.PreserveAspectFit
-                    smooth: true
-                    sourceSize.width: 18
-                    sourceSize.height: 18
+                header: Rectangle {
+                    height: 44
+                    color: "#151B2A"
+                    border.color: "#1F2A4A"
+                    border.width: 1
+                    Row {
+                        anchors.verticalCenter: parent.verticalCenter
+                        anchors.left: parent.left
+                        anchors.leftMargin: 18
+                        spacing: 8
+                        Image {
+                            anchors.verticalCenter: parent.verticalCenter
+                            source: "qrc:/images/icons/quit_icon.png"
+                            width: 18
+                            height: 18
+                            fillMode: Image.PreserveAspectFit
+                            smooth: true
+                            sourceSize.width: 18
+                            sourceSize.height: 18
+                        }
+                        Text {
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: quitDialog.title
+                            color: "#E2E8F0"
+                            font.pixelSize: 16
+                            font.bold: true
+                        }
+                    }
                 }
-                Text {
-                    anchors.verticalCenter: parent.verticalCenter
-                    text: quitDialog.title
-                    color: "#E2E8F0"
-                    font.pixelSize: 16
-                    font.bold: true
+                background: Rectangle {
+                    radius: 14
+                    color: "#151B2A"
+                    border.color: "#1F2A4A"
+                    border.width: 1
                 }
-            }
-        }
-        background: Rectangle {
-            radius: 14
-            color: "#151B2A"
-            border.color: "#1F2A4A"
-            border.width: 1
-        }
 
-        property string messageText: AppController.dockerOpsRunning
-            ? "Do you want to quit SafeCore? The container will keep running."
-            : "Do you want to quit the SafeCore application?"
-        contentItem: Item {
-            implicitHeight: bodyLayout.implicitHeight
-            implicitWidth: bodyLayout.implicitWidth
-            ColumnLayout {
-                id: bodyLayout
-                anchors.fill: parent
-                anchors.margins: 18
-                spacing: 12
+                property string messageText: AppController.dockerOpsRunning
+                    ? "Do you want to quit SafeCore? The container will keep running."
+                    : "Do you want to quit the SafeCore application?"
+                contentItem: Item {
+                    implicitHeight: bodyLayout.implicitHeight
+                    implicitWidth: bodyLayout.implicitWidth
+                    ColumnLayout {
+                        id: bodyLayout
+                        anchors.fill: parent
+                        anchors.margins: 18
+                        spacing: 12
 
-                Text {
-                    Layout.fillWidth: true
-                    wrapMode: Text.WordWrap
-                    color: "#B8C2E0"
-                    text: quitDialog.messageText
-                }
+                        Text {
+                            Layout.fillWidth: true
+                            wrapMode: Text.WordWrap
+                            color: "#B8C2E0"
+                            text: quitDialog.messageText
+                        }
 
-                Item { Layout.fillHeight: true }
+                        Item { Layout.fillHeight: true }
 
-                RowLayout {
-                    Layout.fillWidth: true
-                    spacing: 10
-                    Item { Layout.fillWidth: true }
-                    AppButton {
-                        text: "No"
-                        enabled: true
-                        accent: "#374151"
-                        implicitWidth: 120
-                        implicitHeight: 44
-                        onClicked: quitDialog.close()
-                    }
-                    AppButton {
-                        text: "Yes"
-                        enabled: true
-                        accent: opsRoot.accent
-                        implicitWidth: 120
-                        implicitHeight: 44
-                        onClicked: {
-                            quitDialog.close()
-                            opsRoot.allowClose = true
-                            Qt.quit()
+                        RowLayout {
+                            Layout.fillWidth: true
+                            spacing: 10
+                            Item { Layout.fillWidth: true }
+                            AppButton {
+                                text: "No"
+                                enabled: true
+                                accent: "#374151"
+                                implicitWidth: 120
+                                implicitHeight: 44
+                                onClicked: quitDialog.close()
+                            }
+                            AppButton {
+                                text: "Yes"
+                                enabled: true
+                                accent: opsRoot.accent
+                                implicitWidth: 120
+                                implicitHeight: 44
+                                onClicked: {
+                                    quitDialog.close()
+                                    opsRoot.allowClose = true
+                                    Qt.quit()
+                                }
+                            }
                         }
+                        Item { height: 4 }
                     }
                 }
-                Item { height: 4 }
             }
         }
     }
 
-    Dialog {
-        id: repairDialog
-        modal: true
-        title: "Repair"
-        anchors.centerIn: parent
-        implicitWidth: 650
-        implicitHeight: repairHeader.height + repairContentItem.implicitHeight + 24
-
-        onOpened: opsRoot.activeDialog = repairDialog
-        onClosed: opsRoot.activeDialog = null
-
-        function blinkDialog() {
-            repairBlinkAnimation.start()
-        }
+    DialogLoader {
+        id: repairDialogLoader
+        sourceComponent: Component {
+            Dialog {
+                id: repairDialog
+                modal: true
+                parent: opsRoot.contentItem
+                title: "Repair"
+                anchors.centerIn: parent
+                implicitWidth: 650
+                implicitHeight: repairHeader.height + repairContentItem.implicitHeight + 24
+
+                onOpened: opsRoot.activeDialog = repairDialog
+                onClosed: opsRoot.activeDialog = null
+
+                function blinkDialog() {
+                    repairBlinkAnimation.start()
+                }
 
-        SequentialAnimation {
-            id: repairBlinkAnimation
-            NumberAnimation {
-                target: repairDialog
-                property: "opacity"
-                from: 1.0
-                to: 0.3
-                duration: 100
-            }
-            NumberAnimation {
-                target: repairDialog
-                property: "opacity"
-                from: 0.3
-                to: 1.0
-                duration: 100
-            }
-        }
+                SequentialAnimation {
+                    id: repairBlinkAnimation
+                    NumberAnimation {
+                        target: repairDialog
+                        property: "opacity"
+                        from: 1.0
+                        to: 0.3
+                        duration: 100
+                    }
+                    NumberAnimation {
+                        target: repairDialog
+                        property: "opacity"
+                        from: 0.3
+                        to: 1.0
+                        duration: 100
+                    }
+                }
 
-        header: Rectangle {
-            id: repairHeader
-            height: 44
-            color: "#151B2A"
-            border.color: "#1F2A4A"
-            border.width: 1
-            Row {
-                anchors.verticalCenter: parent.verticalCenter
-                anchors.left: parent.left
-                anchors.leftMargin: 18
-                spacing: 8
-                Image {
-                    anchors.verticalCenter: parent.verticalCenter
-                    source: "qrc:/images/drawer/repair_icon.png"
-                    width: 18
-                    height: 18
-                    fillMode: Image.PreserveAspectFit
-                    smooth: true
-                    sourceSize.width: 18
-                    sourceSize.height: 18
+                header: Rectangle {
+                    id: repairHeader
+                    height: 44
+                    color: "#151B2A"
+                    border.color: "#1F2A4A"
+                    border.width: 1
+                    Row {
+                        anchors.verticalCenter: parent.verticalCenter
+                        anchors.left: parent.left
+                        anchors.leftMargin: 18
+                        spacing: 8
+                        Image {
+                            anchors.verticalCenter: parent.verticalCenter
+                            source: "qrc:/images/drawer/repair_icon.png"
+                            width: 18
+                            height: 18
+                            fillMode: Image.PreserveAspectFit
+                            smooth: true
+                            sourceSize.width: 18
+                            sourceSize.height: 18
+                        }
+                        Text {
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: repairDialog.title
+                            color: "#E2E8F0"
+                            font.pixelSize: 16
+                            font.bold: true
+                        }
+                    }
                 }
-                Text {
-                    anchors.verticalCenter: parent.verticalCenter
-                    text: repairDialog.title
-                    color: "#E2E8F0"
-                    font.pixelSize: 16
-                    font.bold: true
+                background: Rectangle {
+                    radius: 14
+                    color: "#151B2A"
+                    border.color: "#1F2A4A"
+                    border.width: 1
                 }
-            }
-        }
-        background: Rectangle {
-            radius: 14
-            color: "#151B2A"
-            border.color: "#1F2A4A"
-            border.width: 1
-        }
-        contentItem: Item {
-            id: repairContentItem
-            implicitHeight: repairBodyLayout.implicitHeight
-            implicitWidth: repairBodyLayout.implicitWidth
-            ColumnLayout {
-                id: repairBodyLayout
-                anchors.fill: parent
-                anchors.margins: 18
-                spacing: 12
+                contentItem: Item {
+                    id: repairContentItem
+                    implicitHeight: repairBodyLayout.implicitHeight
+                    implicitWidth: repairBodyLayout.implicitWidth
+                    ColumnLayout {
+                        id: repairBodyLayout
+                        anchors.fill: parent
+                        anchors.margins: 18
+                        spacing: 12
 
-                Text {
-                    Layout.fillWidth: true
-                    wrapMode: Text.WordWrap
-                    color: "#B8C2E0"
-                    text: "Before repairing the SafeCore application, please stop the container first."
-                }
+                        Text {
+                            Layout.fillWidth: true
+                            wrapMode: Text.WordWrap
+                            color: "#B8C2E0"
+                            text: "Before repairing the SafeCore application, please stop the container first."
+                        }
 
-                Item { Layout.fillHeight: true }
+                        Item { Layout.fillHeight: true }
 
-                RowLayout {
-                    Layout.fillWidth: true
-                    spacing: 10
-                    Item { Layout.fillWidth: true }
-                    AppButton {
-                        text: "OK"
-                        enabled: true
-                        accent: opsRoot.accent
-                        implicitWidth: 120
-                        implicitHeight: 44
-                        onClicked: repairDialog.close()
+                        RowLayout {
+                            Layout.fillWidth: true
+                            spacing: 10
+                            Item { Layout.fillWidth: true }
+                            AppButton {
+                                text: "OK"
+                                enabled: true
+                                accent: opsRoot.accent
+                                implicitWidth: 120
+                                implicitHeight: 44
+                                onClicked: repairDialog.close()
+                            }
+                        }
+                        Item { height: 6 }
                     }
                 }
-                Item { height: 6 }
             }
         }
     }
-    Dialog {
-        id: upgradeWarningDialog
-        modal: true
-        title: "Container Running"
-        anchors.centerIn: parent
-        implicitWidth: 650
-        implicitHeight: upgradeWarningHeader.height + upgradeWarningContentItem.implicitHeight + 24
-
-        onOpened: opsRoot.activeDialog = upgradeWarningDialog
-        onClosed: opsRoot.activeDialog = null
-
-        function blinkDialog() {
-            upgradeWarningBlinkAnimation.start()
-        }
-
-        SequentialAnimation {
-            id: upgradeWarningBlinkAnimation
-            NumberAnimation {
-                target: upgradeWarningDialog
-                property: "opacity"
-                from: 1.0
-                to: 0.3
-                duration: 100
-            }
-            NumberAnimation {
-                target: upgradeWarningDialog
-                property: "opacity"
-                from: 0.3
-                to: 1.0
-                duration: 100
-            }
-        }
-
-        header: Rectangle {
-            id: upgradeWarningHeader
-            height: 44
-            color: "#151B2A"
-            border.color: "#1F2A4A"
-            border.width: 1
-            Row {
-                anchors.verticalCenter: parent.verticalCenter
-                anchors.left: parent.left
-                anchors.leftMargin: 18
-                spacing: 8
-                Image {
-                    anchors.verticalCenter: parent.verticalCenter
-                    source: "qrc:/images/drawer/upgrade_icon.png"
-                    width: 18
-                    height: 18
-                    fillMode: Image.PreserveAspectFit
-                    smooth: true
-                    sourceSize.width: 18
-                    sourceSize.height: 18
-                }
-                Text {
-                    anchors.verticalCenter: parent.verticalCenter
-                    text: upgradeWarningDialog.title
-                    color: "#E2E8F0"
-                    font.pixelSize: 16
-                    font.bold: true
+    DialogLoader {
+        id: upgradeWarningDialogLoader
+        sourceComponent: Component {
+            Dialog {
+                id: upgradeWarningDialog
+                modal: true
+                parent: opsRoot.contentItem
+                title: "Container Running"
+                anchors.centerIn: parent
+                implicitWidth: 650
+                implicitHeight: upgradeWarningHeader.height + upgradeWarningContentItem.implicitHeight + 24
+
+                onOpened: opsRoot.activeDialog = upgradeWarningDialog
+                onClosed: opsRoot.activeDialog = null
+
+                function blinkDialog() {
+                    upgradeWarningBlinkAnimation.start()
                 }
-            }
-        }
-        background: Rectangle {
-            radius: 14
-            color: "#151B2A"
-            border.color: "#1F2A4A"
-            border.width: 1
-        }
-        contentItem: Item {
-            id: upgradeWarningContentItem
-            implicitHeight: upgradeWarningBodyLayout.implicitHeight
-            implicitWidth: upgradeWarningBodyLayout.implicitWidth
-            ColumnLayout {
-                id: upgradeWarningBodyLayout
-                anchors.fill: parent
-                anchors.margins: 18
-                spacing: 12
 
-                Text {
-                    Layout.fillWidth: true
-                    wrapMode: Text.WordWrap
-                    color: "#B8C2E0"
-                    font.pixelSize: 14
-                    text: "Before upgrading the SafeCore application, stop the container."
+                SequentialAnimation {
+                    id: upgradeWarningBlinkAnimation
+                    NumberAnimation {
+                        target: upgradeWarningDialog
+                        property: "opacity"
+                        from: 1.0
+                        to: 0.3
+                        duration: 100
+                    }
+                    NumberAnimation {
+                        target: upgradeWarningDialog
+                        property: "opacity"
+                        from: 0.3
+                        to: 1.0
+                        duration: 100
+                    }
                 }
 
-                Item { height: 8 }
-
-                RowLayout {
-                    Layout.fillWidth: true
-                    spacing: 12
-                    Item { Layout.fillWidth: true }
-                    AppButton {
-                        text: "OK"
-                        enabled: true
-                        accent: opsRoot.accent
-                        implicitWidth: 120
-                        implicitHeight: 44
-                        onClicked: upgradeWarningDialog.close()
+                header: Rectangle {
+                    id: upgradeWarningHeader
+                    height: 44
+                    color: "#151B2A"
+                    border.color: "#1F2A4A"
+                    border.width: 1
+                    Row {
+                        anchors.verticalCenter: parent.verticalCenter
+                        anchors.left: parent.left
+                        anchors.leftMargin: 18
+                        spacing: 8
+                        Image {
+                            anchors.verticalCenter: parent.verticalCenter
+                            source: "qrc:/images/drawer/upgrade_icon.png"
+                            width: 18
+                            height: 18
+                            fillMode: Image.PreserveAspectFit
+                            smooth: true
+                            sourceSize.width: 18
+                            sourceSize.height: 18
+                        }
+                        Text {
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: upgradeWarningDialog.title
+                            color: "#E2E8F0"
+                            font.pixelSize: 16
+                            font.bold: true
+                        }
                     }
                 }
-                Item { height: 6 }
-            }
-        }
-    }
-
-    Dialog {
-        id: upgradeDialog
-        modal: true
-        title: "Upgrade"
-        anchors.centerIn: parent
-        implicitWidth: 650
-        implicitHeight: upgradeHeader.height + upgradeContentItem.implicitHeight + 24
-        closePolicy: AppController.upgradeRunning ? Popup.NoAutoClose : Popup.CloseOnEscape
-
-        function blinkDialog() {
-            upgradeBlinkAnimation.start()
-        }
-
-        SequentialAnimation {
-            id: upgradeBlinkAnimation
-            NumberAnimation {
-                target: upgradeDialog
-                property: "opacity"
-                from: 1.0
-                to: 0.3
-                duration: 100
-            }
-            NumberAnimation {
-                target: upgradeDialog
-                property: "opacity"
-                from: 0.3
-                to: 1.0
-                duration: 100
-            }
-        }
+                background: Rectangle {
+                    radius: 14
+                    color: "#151B2A"
+                    border.color: "#1F2A4A"
+                    border.width: 1
+                }
+                contentItem: Item {
+                    id: upgradeWarningContentItem
+                    implicitHeight: upgradeWarningBodyLayout.implicitHeight
+                    implicitWidth: upgradeWarningBodyLayout.implicitWidth
+                    ColumnLayout {
+                        id: upgradeWarningBodyLayout
+                        anchors.fill: parent
+                        anchors.margins: 18
+                        spacing: 12
 
-        property bool upgradeAvailable: false
-        property bool upgradeComplete: false
-        property bool upgradeDownloading: false
-        property bool upgradeCanceled: false
-        property string statusMessage: ""
-
-        onOpened: {
-            opsRoot.activeDialog = upgradeDialog
-            upgradeAvailable = false
-            upgradeComplete = false
-            upgradeDownloading = false
-            upgradeCanceled = false
-            statusMessage = ""
-        }
+                        Text {
+                            Layout.fillWidth: true
+                            wrapMode: Text.WordWrap
+                            color: "#B8C2E0"
+                            font.pixelSize: 14
+                            text: "Before upgrading the SafeCore application, stop the container."
+                        }
 
-        onClosed: {
-            opsRoot.activeDialog = null
-        }
+                        Item { height: 8 }
 
-        Connections {
-            target: AppController
-            function onUpgradeFinished(hasUpdate, message) {
-                upgradeDialog.upgradeComplete = true
-                upgradeDialog.statusMessage = message
-                upgradeDialog.upgradeAvailable = hasUpdate
-                upgradeDialog.upgradeCanceled = message.startsWith("Upgrade canceled.")
-            }
-            function onUpgradeLogChanged() {
-                // Detect if download is actually happening (not just "up to date" check)
-                // Only show console when we see actual download activity
-                if (AppController.upgradeRunning && !upgradeDialog.upgradeDownloading) {
-                    const log = AppController.upgradeLog;
-                    // Check for actual download indicators, not just "Pulling from"
-                    if (log.includes("Pulling fs layer") ||
-                        log.includes("Downloading") ||
-                        log.includes("Download complete") ||
-                        log.includes("Pull complete") ||
-                        log.includes("Extracting") ||
-                        log.includes("Verifying Checksum") ||
-                        log.includes("Waiting")) {
-                        upgradeDialog.upgradeDownloading = true;
+                        RowLayout {
+                            Layout.fillWidth: true
+                            spacing: 12
+                            Item { Layout.fillWidth: true }
+                            AppButton {
+                                text: "OK"
+                                enabled: true
+                                accent: opsRoot.accent
+                                implicitWidth: 120
+                                implicitHeight: 44
+                                onClicked: upgradeWarningDialog.close()
+                            }
+                        }
+                        Item { height: 6 }
                     }
                 }
             }
         }
+    }
 
-        header: Rectangle {
-            id: upgradeHeader
-            height: 44
-            color: "#151B2A"
-            border.color: "#1F2A4A"
-            border.width: 1
-            Row {
-                anchors.verticalCenter: parent.verticalCenter
-                anchors.left: parent.left
-                anchors.leftMargin: 18
-                spacing: 8
-                Image {
-                    anchors.verticalCenter: parent.verticalCenter
-                    source: "qrc:/images/drawer/upgrade_icon.png"
-                    width: 18
-                    height: 18
-                    fillMode: Image.PreserveAspectFit
-                    smooth: true
-                    sourceSize.width: 18
-                    sourceSize.height: 18
-                }
-                Text {
-                    anchors.verticalCenter: parent.verticalCenter
-                    text: upgradeDialog.title
-                    color: "#E2E8F0"
-                    font.pixelSize: 16
-                    font.bold: true
+    DialogLoader {
+        id: upgradeDialogLoader
+        sourceComponent: Component {
+            Dialog {
+                id: upgradeDialog
+                modal: true
+                parent: opsRoot.contentItem
+                title: "Upgrade"
+                anchors.centerIn: parent
+                implicitWidth: 650
+                implicitHeight: upgradeHeader.height + upgradeContentItem.implicitHeight + 24
+                closePolicy: AppController.upgradeRunning ? Popup.NoAutoClose : Popup.CloseOnEscape
+
+                function blinkDialog() {
+                    upgradeBlinkAnimation.start()
                 }
-            }
-        }
-        background: Rectangle {
-            radius: 14
-            color: "#151B2A"
-            border.color: "#1F2A4A"
-            border.width: 1
-        }
-        contentItem: Item {
-            id: upgradeContentItem
-            implicitHeight: upgradeBodyLayout.implicitHeight
-            implicitWidth: upgradeBodyLayout.implicitWidth
-            ColumnLayout {
-                id: upgradeBodyLayout
-                anchors.fill: parent
-                anchors.margins: 18
-                spacing: 12
 
-                RowLayout {
-                    Layout.fillWidth: true
-                    spacing: 8
-                    visible: !AppController.upgradeRunning && upgradeDialog.upgradeComplete && !upgradeDialog.upgradeAvailable
-
-                    Rectangle {
-                        width: 24
-                        height: 24
-                        radius: 12
-                        color: upgradeDialog.upgradeCanceled ? "#F59E0B" : "#22C55E"
-                        Text {
-                            anchors.centerIn: parent
-                            text: upgradeDialog.upgradeCanceled ? "\u26A0" : "\u2713"
-                            font.pixelSize: upgradeDialog.upgradeCanceled ? 14 : 16
-                            font.bold: true
-                            color: "#FFFFFF"
-                        }
+                SequentialAnimation {
+                    id: upgradeBlinkAnimation
+                    NumberAnimation {
+                        target: upgradeDialog
+                        property: "opacity"
+                        from: 1.0
+                        to: 0.3
+                        duration: 100
                     }
-
-                    Text {
-                        Layout.fillWidth: true
-                        wrapMode: Text.WordWrap
-                        color: "#B8C2E0"
-                        text: upgradeDialog.statusMessage
+                    NumberAnimation {
+                        target: upgradeDialog
+                        property: "opacity"
+                        from: 0.3
+                        to: 1.0
+                        duration: 100
                     }
                 }
 
-                ColumnLayout {
-                    Layout.fillWidth: true
-                    spacing: 8
-                    visible: AppController.upgradeRunning || (upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable)
-
-                    RowLayout {
-                        Layout.fillWidth: true
-                        spacing: 12
-
-                        // Animated loading spinner (only when checking, not downloading)
-                        Item {
-                            width: 24
-                            height: 24
-                            visible: AppController.upgradeRunning && !upgradeDialog.upgradeDownloading
-
-                            Canvas {
-                                id: spinnerCanvas
-                                anchors.fill: parent
-                                antialiasing: true
-
-                                property real rotation: 0
-
-                                onPaint: {
-                                    var ctx = getContext("2d");
-                                    ctx.clearRect(0, 0, width, height);
-                                    ctx.save();
-                                    ctx.translate(width / 2, height / 2);
-                                    ctx.rotate(rotation * Math.PI / 180);
-
-                                    // Draw circular segments
-                                    for (var i = 0; i < 8; i++) {
-                                        ctx.save();
-                                        ctx.rotate(i * Math.PI / 4);
-                                        ctx.beginPath();
-                                        var opacity = (i + 1) / 8;
-                                        ctx.fillStyle = Qt.rgba(0.38, 0.51, 0.96, opacity);
-                                        ctx.arc(7, 0, 2.5, 0, Math.PI * 2);
-                                        ctx.fill();
-                                        ctx.restore();
-                                    }
-                                    ctx.restore();
-                                }
+                property bool upgradeAvailable: false
+                property bool upgradeComplete: false
+                property bool upgradeDownloading: false
+                property bool upgradeCanceled: false
+                property bool stagedMode: false
+                property string statusMessage: ""
+
+                onOpened: {
+                    opsRoot.activeDialog = upgradeDialog
+                    upgradeAvailable = stagedMode
+                    upgradeComplete = stagedMode
+                    upgradeDownloading = false
+                    upgradeCanceled = false
+                    statusMessage = stagedMode
+                        ? "Upgrade " + AppController.stagedUpgradeDigest.substring(7, 19) + " was downloaded in the background and verified. Click Restart to apply."
+                        : ""
+                }
 
-                                RotationAnimator {
-                                    target: spinnerCanvas
-                                    from: 0
-                                    to: 360
-                                    duration: 1200
-                                    loops: Animation.Infinite
-                                    running: AppController.upgradeRunning && !upgradeDialog.upgradeDownloading
-                                    onToChanged: spinnerCanvas.rotation = to
-                                }
+                onClosed: {
+                    opsRoot.activeDialog = null
+                    stagedMode = false
+                }
 
-                                Timer {
-                                    interval: 16
-                                    running: AppController.upgradeRunning && !upgradeDialog.upgradeDownloading
-                                    repeat: true
-                                    onTriggered: {
-                                        spinnerCanvas.rotation = (spinnerCanvas.rotation + 3) % 360;
-                                        spinnerCanvas.requestPaint();
-                                    }
-                                }
+                Connections {
+                    target: AppController
+                    function onUpgradeFinished(hasUpdate, message) {
+                        upgradeDialog.upgradeComplete = true
+                        upgradeDialog.statusMessage = message
+                        upgradeDialog.upgradeAvailable = hasUpdate
+                        upgradeDialog.upgradeCanceled = message.startsWith("Upgrade canceled.")
+                    }
+                    function onUpgradeLogChanged() {
+                        // Detect if download is actually happening (not just "up to date" check)
+                        // Only show console when we see actual download activity
+                        if (AppController.upgradeRunning && !upgradeDialog.upgradeDownloading) {
+                            const log = AppController.upgradeLog;
+                            // Check for actual download indicators, not just "Pulling from"
+                            if (log.includes("Pulling fs layer") ||
+                                log.includes("Downloading") ||
+                                log.includes("Download complete") ||
+                                log.includes("Pull complete") ||
+                                log.includes("Extracting") ||
+                                log.includes("Verifying Checksum") ||
+                                log.includes("Waiting")) {
+                                upgradeDialog.upgradeDownloading = true;
                             }
                         }
+                    }
+                }
 
+                header: Rectangle {
+                    id: upgradeHeader
+                    height: 44
+                    color: "#151B2A"
+                    border.color: "#1F2A4A"
+                    border.width: 1
+                    Row {
+                        anchors.verticalCenter: parent.verticalCenter
+                        anchors.left: parent.left
+                        anchors.leftMargin: 18
+                        spacing: 8
+                        Image {
+                            anchors.verticalCenter: parent.verticalCenter
+                            source: "qrc:/images/drawer/upgrade_icon.png"
+                            width: 18
+                            height: 18
+                            fillMode: Image.PreserveAspectFit
+                            smooth: true
+                            sourceSize.width: 18
+                            sourceSize.height: 18
+                        }
                         Text {
-                            Layout.fillWidth: true
-                            wrapMode: Text.WordWrap
-                            color: "#B8C2E0"
-                            text: AppController.upgradeRunning
-                                ? (upgradeDialog.upgradeDownloading ? "Downloading new image..." : "Checking for updates...")
-                                : (upgradeDialog.upgradeComplete ? upgradeDialog.statusMessage : "")
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: upgradeDialog.title
+                            color: "#E2E8F0"
+                            font.pixelSize: 16
+                            font.bold: true
                         }
                     }
+                }
+                background: Rectangle {
+                    radius: 14
+                    color: "#151B2A"
+                    border.color: "#1F2A4A"
+                    border.width: 1
+                }
+                contentItem: Item {
+                    id: upgradeContentItem
+                    implicitHeight: upgradeBodyLayout.implicitHeight
+                    implicitWidth: upgradeBodyLayout.implicitWidth
+                    ColumnLayout {
+                        id: upgradeBodyLayout
+                        anchors.fill: parent
+                        anchors.margins: 18
+                        spacing: 12
 
-                    // Progress bar with percentage (shown when downloading)
-                    RowLayout {
-                        Layout.fillWidth: true
-                        spacing: 8
-                        visible: upgradeDialog.upgradeDownloading
-
-                        ModernProgressBar {
+                        RowLayout {
                             Layout.fillWidth: true
-                            value: AppController.upgradeProgress
-                            busy: AppController.upgradeRunning
-                        }
+                            spacing: 8
+                            visible: !AppController.upgradeRunning && upgradeDialog.upgradeComplete && !upgradeDialog.upgradeAvailable
 
-                        Text {
-                            color: "#93C5FD"
-                            font.pixelSize: 13
-                            text: Math.round(AppController.upgradeProgress * 100) + "%"
-                        }
+                            Rectangle {
+                                width: 24
+                                height: 24
+                                radius: 12
+                                color: upgradeDialog.upgradeCanceled ? "#F59E0B" : "#22C55E"
+                                Text {
+                                    anchors.centerIn: parent
+                                    text: upgradeDialog.upgradeCanceled ? "\u26A0" : "\u2713"
+                                    font.pixelSize: upgradeDialog.upgradeCanceled ? 14 : 16
+                                    font.bold: true
+                                    color: "#FFFFFF"
+                                }
+                            }
 
-                        Rectangle {
-                            visible: upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable
-                            width: 20
-                            height: 20
-                            radius: 10
-                            color: "#22C55E"
                             Text {
-                                anchors.centerIn: parent
-                                text: "\u2713"
-                                font.pixelSize: 12
-                                font.bold: true
-                                color: "#FFFFFF"
+                                Layout.fillWidth: true
+                                wrapMode: Text.WordWrap
+                                color: "#B8C2E0"
+                                text: upgradeDialog.statusMessage
                             }
                         }
-                    }
-                }
-
-                Item {
-                    id: upgradeSwapArea
-                    Layout.fillWidth: true
-                    Layout.preferredHeight: 300
-                    implicitHeight: 300
-                    Layout.bottomMargin: 0
-                    visible: !upgradeDialog.upgradeCanceled && (upgradeDialog.upgradeDownloading || (upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable))
 
-                    Rectangle {
-                        id: upgradeLogPanel
-                        anchors.fill: parent
-                        radius: 12
-                        color: "#050811"
-                        border.color: "#2D3B5F"
-                        border.width: 1
-                        clip: true
+                        ColumnLayout {
+                            Layout.fillWidth: true
+                            spacing: 8
+                            visible: AppController.upgradeRunning || (upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable)
 
-                        property bool stickToBottom: true
-                        function updateStickState() {
-                            if (!upgradeLogFlickable)
-                                return;
-                            var maxY = Math.max(0, upgradeLogFlickable.contentHeight - upgradeLogFlickable.height);
-                            stickToBottom = upgradeLogFlickable.contentY >= maxY - 4;
-                        }
-                        function scrollToBottom() {
-                            if (!upgradeLogFlickable)
-                                return;
-                            upgradeLogFlickable.contentY = Math.max(0, upgradeLogFlickable.contentHeight - upgradeLogFlickable.height);
-                        }
+                            RowLayout {
+                                Layout.fillWidth: true
+                                spacing: 12
 
-                        // Subtle gradient overlay
-                        Rectangle {
-                            anchors.fill: parent
-                            radius: parent.radius
-                            gradient: Gradient {
-                                GradientStop { position: 0.0; color: "#0A101800" }
-                                GradientStop { position: 1.0; color: "#0A101820" }
-                            }
-                        }
+                                // Animated loading spinner (only when checking, not downloading)
+                                Item {
+                                    width: 24
+                                    height: 24
+                                    visible: AppController.upgradeRunning && !upgradeDialog.upgradeDownloading
+
+                                    Canvas {
+                                        id: spinnerCanvas
+                                        anchors.fill: parent
+                                        antialiasing: true
+
+                                        property real rotation: 0
+
+                                        onPaint: {
+                                            var ctx = getContext("2d");
+                                            ctx.clearRect(0, 0, width, height);
+                                            ctx.save();
+                                            ctx.translate(width / 2, height / 2);
+                                            ctx.rotate(rotation * Math.PI / 180);
+
+                                            // Draw circular segments
+                                            for (var i = 0; i < 8; i++) {
+                                                ctx.save();
+                                                ctx.rotate(i * Math.PI / 4);
+                                                ctx.beginPath();
+                                                var opacity = (i + 1) / 8;
+                                                ctx.fillStyle = Qt.rgba(0.38, 0.51, 0.96, opacity);
+                                                ctx.arc(7, 0, 2.5, 0, Math.PI * 2);
+                                                ctx.fill();
+                                                ctx.restore();
+                                            }
+                                            ctx.restore();
+                                        }
+
+                                        RotationAnimator {
+                                            target: spinnerCanvas
+                                            from: 0
+                                            to: 360
+                                            duration: 1200
+                                            loops: Animation.Infinite
+                                            running: AppController.upgradeRunning && !upgradeDialog.upgradeDownloading
+                                            onToChanged: spinnerCanvas.rotation = to
+                                        }
+
+                                        Timer {
+                                            interval: 16
+                                            running: AppController.upgradeRunning && !upgradeDialog.upgradeDownloading
+                                            repeat: true
+                                            onTriggered: {
+                                                spinnerCanvas.rotation = (spinnerCanvas.rotation + 3) % 360;
+                                                spinnerCanvas.requestPaint();
+                                            }
+                                        }
+                                    }
+                                }
 
-                        // Header bar with label
-                        Rectangle {
-                            anchors.top: parent.top
-                            anchors.left: parent.left
-                            anchors.right: parent.right
-                            height: 32
-                            color: "#0F1623"
-                            radius: 12
-                            Rectangle {
-                                anchors.bottom: parent.bottom
-                                anchors.left: parent.left
-                                anchors.right: parent.right
-                                height: parent.radius
-                                color: parent.color
+                                Text {
+                                    Layout.fillWidth: true
+                                    wrapMode: Text.WordWrap
+                                    color: "#B8C2E0"
+                                    text: AppController.upgradeRunning
+                                        ? (upgradeDialog.upgradeDownloading ? "Downloading new image..." : "Checking for updates...")
+                                        : (upgradeDialog.upgradeComplete ? upgradeDialog.statusMessage : "")
+                                }
                             }
 
+                            // Progress bar with percentage (shown when downloading)
                             RowLayout {
-                                anchors.fill: parent
-                                anchors.leftMargin: 12
-                                anchors.rightMargin: 12
+                                Layout.fillWidth: true
                                 spacing: 8
+                                visible: upgradeDialog.upgradeDownloading
 
-                                Text {
-                                    text: "⬆"
-                                    color: "#6EE7FF"
-                                    font.pixelSize: 14
+                                ModernProgressBar {
+                                    Layout.fillWidth: true
+                                    value: AppController.upgradeProgress
+                                    busy: AppController.upgradeRunning
                                 }
 
                                 Text {
-                                    text: "Upgrade Log"
                                     color: "#93C5FD"
-                                    font.pixelSize: 11
-                                    font.weight: Font.Medium
+                                    font.pixelSize: 13
+                                    text: Math.round(AppController.upgradeProgress * 100) + "%"
                                 }
 
-                                Item { Layout.fillWidth: true }
-
                                 Rectangle {
-                                    width: 6
-                                    height: 6
-                                    radius: 3
+                                    visible: upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable
+                                    width: 20
+                                    height: 20
+                                    radius: 10
                                     color: "#22C55E"
-                                    opacity: 0.8
-                                    visible: AppController.upgradeRunning
-
-                                    SequentialAnimation on opacity {
-                                        running: AppController.upgradeRunning
-                                        loops: Animation.Infinite
-                                        NumberAnimation { from: 0.3; to: 1.0; duration: 600 }
-                                        NumberAnimation { from: 1.0; to: 0.3; duration: 600 }
+                                    Text {
+                                        anchors.centerIn: parent
+                                        text: "\u2713"
+                                        font.pixelSize: 12
+                                        font.bold: true
+                                        color: "#FFFFFF"
                                     }
                                 }
+                            }
+
+                            // The pull runs through the registry proxy at the cap;
+                            // the operator may lift the cap for this one pull
+                            RowLayout {
+                                Layout.fillWidth: true
+                                spacing: 8
+                                visible: upgradeDialog.upgradeDownloading && AppController.upgradeRunning
 
                                 Text {
-                                    text: AppController.upgradeRunning ? "ACTIVE" : "IDLE"
-                                    color: AppController.upgradeRunning ? "#22C55E" : "#64748B"
-                                    font.pixelSize: 10
-                                    font.weight: Font.Bold
-                                    font.letterSpacing: 0.5
+                                    Layout.fillWidth: true
+                                    color: "#B8C2E0"
+                                    font.pixelSize: 11
+                                    text: {
+                                        if (AppController.upgradeHoldReason.length > 0)
+                                            return "On hold, " + AppController.upgradeHoldReason
+                                        const rate = (AppController.downloadBytesPerSecond / 1000000).toFixed(1) + " MB/s"
+                                        if (AppController.bandwidthOverride)
+                                            return rate + " (cap lifted)"
+                                        if (AppController.downloadCapBytesPerSecond > 0)
+                                            return rate + " of " + (AppController.downloadCapBytesPerSecond / 1000000).toFixed(1) + " MB/s cap"
+                                        return rate + " (no cap)"
+                                    }
+                                }
+
+                                AppButton {
+                                    text: "Pull at full speed"
+                                    visible: AppController.downloadCapBytesPerSecond > 0 && !AppController.bandwidthOverride
+                                    accent: opsRoot.accent
+                                    implicitHeight: 32
+                                    onClicked: AppController.pullAtFullSpeed()
                                 }
                             }
                         }
 
-                        Flickable {
-                            id: upgradeLogFlickable
-                            anchors.fill: parent
-                            anchors.topMargin: 42
-                            anchors.leftMargin: 12
-                            anchors.rightMargin: 12
-                            anchors.bottomMargin: 12
-                            clip: true
-                            contentWidth: upgradeLogText.implicitWidth
-                            contentHeight: upgradeLogText.implicitHeight
-                            boundsBehavior: Flickable.StopAtBounds
-                            ScrollBar.horizontal: ScrollBar { policy: ScrollBar.AsNeeded }
-                            ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
-                            onContentYChanged: upgradeLogPanel.updateStickState()
-                            onContentHeightChanged: {
-                                if (upgradeLogPanel.stickToBottom)
-                                    upgradeLogPanel.scrollToBottom();
-                            }
+                        Item {
+                            id: upgradeSwapArea
+                            Layout.fillWidth: true
+                            Layout.preferredHeight: 300
+                            implicitHeight: 300
+                            Layout.bottomMargin: 0
+                            visible: !upgradeDialog.upgradeCanceled && !upgradeDialog.stagedMode && (upgradeDialog.upgradeDownloading || (upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable))
+
+                            Rectangle {
+                                id: upgradeLogPanel
+                                anchors.fill: parent
+                                radius: 12
+                                color: "#050811"
+                                border.color: "#2D3B5F"
+                                border.width: 1
+                                clip: true
+
+                                property bool stickToBottom: true
+                                function updateStickState() {
+                                    if (!upgradeLogFlickable)
+                                        return;
+                                    var maxY = Math.max(0, upgradeLogFlickable.contentHeight - upgradeLogFlickable.height);
+                                    stickToBottom = upgradeLogFlickable.contentY >= maxY - 4;
+                                }
+                                function scrollToBottom() {
+                                    if (!upgradeLogFlickable)
+                                        return;
+                                    upgradeLogFlickable.contentY = Math.max(0, upgradeLogFlickable.contentHeight - upgradeLogFlickable.height);
+                                }
 
-                            TextArea {
-                                id: upgradeLogText
-                                text: AppController.upgradeLog.length ? AppController.upgradeLog : "Waiting for output..."
-                                readOnly: true
-                                textFormat: TextEdit.PlainText
-                                wrapMode: TextEdit.NoWrap
-                                font.family: "JetBrains Mono, Consolas, Monaco, Monospace"
-                                font.pixelSize: 12
-                                color: AppController.upgradeLog.length ? "#E0E7FF" : "#64748B"
-                                background: null
-                                width: implicitWidth
-                                height: implicitHeight
-                                bottomPadding: 10
-                                rightPadding: 10
-                                onTextChanged: {
-                                    if (upgradeLogPanel.stickToBottom)
-                                        upgradeLogPanel.scrollToBottom();
+                                // Subtle gradient overlay
+                                Rectangle {
+                                    anchors.fill: parent
+                                    radius: parent.radius
+                                    gradient: Gradient {
+                                        GradientStop { position: 0.0; color: "#0A101800" }
+                                        GradientStop { position: 1.0; color: "#0A101820" }
+                                    }
+                                }
+
+                                // Header bar with label
+                                Rectangle {
+                                    anchors.top: parent.top
+                                    anchors.left: parent.left
+                                    anchors.right: parent.right
+                                    height: 32
+                                    color: "#0F1623"
+                                    radius: 12
+                                    Rectangle {
+                                        anchors.bottom: parent.bottom
+                                        anchors.left: parent.left
+                                        anchors.right: parent.right
+                                        height: parent.radius
+                                        color: parent.color
+                                    }
+
+                                    RowLayout {
+                                        anchors.fill: parent
+                                        anchors.leftMargin: 12
+                                        anchors.rightMargin: 12
+                                        spacing: 8
+
+                                        Text {
+                                            text: "⬆"
+                                            color: "#6EE7FF"
+                                            font.pixelSize: 14
+                                        }
+
+                                        Text {
+                                            text: "Upgrade Log"
+                                            color: "#93C5FD"
+                                            font.pixelSize: 11
+                                            font.weight: Font.Medium
+                                        }
+
+                                        Item { Layout.fillWidth: true }
+
+                                        Rectangle {
+                                            width: 6
+                                            height: 6
+                                            radius: 3
+                                            color: "#22C55E"
+                                            opacity: 0.8
+                                            visible: AppController.upgradeRunning
+
+                                            SequentialAnimation on opacity {
+                                                running: AppController.upgradeRunning
+                                                loops: Animation.Infinite
+                                                NumberAnimation { from: 0.3; to: 1.0; duration: 600 }
+                                                NumberAnimation { from: 1.0; to: 0.3; duration: 600 }
+                                            }
+                                        }
+
+                                        Text {
+                                            text: AppController.upgradeRunning ? "ACTIVE" : "IDLE"
+                                            color: AppController.upgradeRunning ? "#22C55E" : "#64748B"
+                                            font.pixelSize: 10
+                                            font.weight: Font.Bold
+                                            font.letterSpacing: 0.5
+                                        }
+                                    }
+                                }
+
+                                Flickable {
+                                    id: upgradeLogFlickable
+                                    anchors.fill: parent
+                                    anchors.topMargin: 42
+                                    anchors.leftMargin: 12
+                                    anchors.rightMargin: 12
+                                    anchors.bottomMargin: 12
+                                    clip: true
+                                    contentWidth: upgradeLogText.implicitWidth
+                                    contentHeight: upgradeLogText.implicitHeight
+                                    boundsBehavior: Flickable.StopAtBounds
+                                    ScrollBar.horizontal: ScrollBar { policy: ScrollBar.AsNeeded }
+                                    ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
+                                    onContentYChanged: upgradeLogPanel.updateStickState()
+                                    onContentHeightChanged: {
+                                        if (upgradeLogPanel.stickToBottom)
+                                            upgradeLogPanel.scrollToBottom();
+                                    }
+
+                                    TextArea {
+                                        id: upgradeLogText
+                                        text: AppController.upgradeLog.length ? AppController.upgradeLog : "Waiting for output..."
+                                        readOnly: true
+                                        textFormat: TextEdit.PlainText
+                                        wrapMode: TextEdit.NoWrap
+                                        font.family: "JetBrains Mono, Consolas, Monaco, Monospace"
+                                        font.pixelSize: 12
+                                        color: AppController.upgradeLog.length ? "#E0E7FF" : "#64748B"
+                                        background: null
+                                        width: implicitWidth
+                                        height: implicitHeight
+                                        bottomPadding: 10
+                                        rightPadding: 10
+                                        onTextChanged: {
+                                            if (upgradeLogPanel.stickToBottom)
+                                                upgradeLogPanel.scrollToBottom();
+                                        }
+                                    }
                                 }
+                                Component.onCompleted: scrollToBottom()
                             }
                         }
-                        Component.onCompleted: scrollToBottom()
-                    }
-                }
 
-                Item { Layout.fillHeight: true }
+                        Item { Layout.fillHeight: true }
 
-                Rectangle {
-                    Layout.fillWidth: true
-                    height: 1
-                    color: "#1F2A4A"
-                    visible: upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable
-                }
+                        Rectangle {
+                            Layout.fillWidth: true
+                            height: 1
+                            color: "#1F2A4A"
+                            visible: upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable
+                        }
 
-                RowLayout {
-                    Layout.fillWidth: true
-                    spacing: 10
-                    Item { Layout.fillWidth: true }
-                    AppButton {
-                        text: "Cancel"
-                        visible: AppController.upgradeRunning
-                        enabled: true
-                        accent: "#F87171"
-                        implicitWidth: 120
-                        implicitHeight: 44
-                        onClicked: AppController.cancelUpgrade()
-                    }
-                    AppButton {
-                        text: "OK"
-                        visible: upgradeDialog.upgradeComplete && !upgradeDialog.upgradeAvailable
-                        enabled: true
-                        accent: opsRoot.accent
-                        implicitWidth: 120
-                        implicitHeight: 44
-                        onClicked: upgradeDialog.close()
-                    }
-                    AppButton {
-                        text: "Restart"
-                        visible: upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable
-                        enabled: true
-                        accent: opsRoot.accent
-                        implicitWidth: 120
-                        implicitHeight: 44
-                        onClicked: {
-                            upgradeDialog.close()
-                            AppController.runDockerOps(true)  // Remove volumes after upgrade
+                        RowLayout {
+                            Layout.fillWidth: true
+                            spacing: 10
+                            Item { Layout.fillWidth: true }
+                            AppButton {
+                                text: "Cancel"
+                                visible: AppController.upgradeRunning
+                                enabled: true
+                                accent: "#F87171"
+                                implicitWidth: 120
+                                implicitHeight: 44
+                                onClicked: AppController.cancelUpgrade()
+                            }
+                            AppButton {
+                                text: "OK"
+                                visible: upgradeDialog.upgradeComplete && !upgradeDialog.upgradeAvailable
+                                enabled: true
+                                accent: opsRoot.accent
+                                implicitWidth: 120
+                                implicitHeight: 44
+                                onClicked: upgradeDialog.close()
+                            }
+                            AppButton {
+                                text: "Restart"
+                                visible: upgradeDialog.upgradeComplete && upgradeDialog.upgradeAvailable
+                                enabled: true
+                                accent: opsRoot.accent
+                                implicitWidth: 120
+                                implicitHeight: 44
+                                onClicked: {
+                                    const staged = upgradeDialog.stagedMode
+                                    upgradeDialog.close()
+                                    if (staged)
+                                        AppController.applyStagedUpgrade()
+                                    else
+                                        AppController.runDockerOps(true)  // Sync weapons models after upgrade
+                                }
+                            }
                         }
+                        Item { height: 10 }
                     }
                 }
-                Item { height: 10 }
             }
         }
     }
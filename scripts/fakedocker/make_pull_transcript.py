@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# Generates a synthetic `docker pull` transcript in docker's TTY format
+# (cursor-up redraws of every layer line), for output volumes larger than a
+# recorded pull:
+#
+#   scripts/fakedocker/make_pull_transcript.py --layers 40 --steps 200 > /tmp/pull.txt
+#   SAFECORE_FAKE_DOCKER_PULL=/tmp/pull.txt scripts/fakedocker/run.sh --speed 100 -- Safecore
+import argparse
+import hashlib
+import json
+import random
+
+ESC = "\x1b"
+
+
+def bar(done, total, width=50):
+    filled = int(width * done / total) if total else width
+    return "[" + "=" * max(filled - 1, 0) + (">" if filled < width else "=") + " " * (width - filled) + "]"
+
+
+def size(n):
+    for unit in ("B", "kB", "MB", "GB"):
+        if n < 1000 or unit == "GB":
+            return ("%.3g%s" % (n, unit)) if unit != "B" else "%dB" % n
+        n /= 1000.0
+    return "%dB" % n
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--image", default="ssaiboxacr.azurecr.io/aibox-prod:latest")
+    parser.add_argument("--layers", type=int, default=12)
+    parser.add_argument("--steps", type=int, default=40, help="progress redraws per layer and phase")
+    parser.add_argument("--interval-ms", type=int, default=50)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--exit", type=int, default=0)
+    args = parser.parse_args()
+    rng = random.Random(args.seed)
+
+    tag = args.image.rsplit(":", 1)[1] if ":" in args.image.rsplit("/", 1)[-1] else "latest"
+    layers = [hashlib.sha256(b"%d" % i).hexdigest()[:12] for i in range(args.layers)]
+    sizes = [rng.randint(2_000_000, 900_000_000) for _ in layers]
+    status = {layer: "Pulling fs layer" for layer in layers}
+
+    def emit(delay, text):
+        print("%d\t%s" % (delay, json.dumps(text)))
+
+    emit(0, "%s: Pulling from %s\r\n" % (tag, args.image.rsplit(":", 1)[0].split("/", 1)[-1]))
+    for layer in layers:
+        emit(5, "%s: Pulling fs layer \r\n" % layer)
+
+    def redraw(index, delay):
+        up = len(layers) - index
+        emit(delay, "%s[%dA%s[2K\r%s: %s\r%s[%dB" % (ESC, up, ESC, layers[index], status[layers[index]], ESC, up))
+
+    for index, layer in enumerate(layers):
+        total = sizes[index]
+        for phase in ("Downloading", "Extracting"):
+            for step in range(1, args.steps + 1):
+                done = total * step // args.steps
+                status[layer] = "%s  %s  %s/%s" % (phase, bar(done, total), size(done), size(total))
+                redraw(index, args.interval_ms)
+            if phase == "Downloading":
+                status[layer] = "Download complete "
+                redraw(index, args.interval_ms)
+        status[layer] = "Pull complete "
+        redraw(index, args.interval_ms)
+
+    digest = hashlib.sha256(args.image.encode()).hexdigest()
+    emit(10, "Digest: sha256:%s\r\n" % digest)
+    emit(5, "Status: Downloaded newer image for %s\r\n" % args.image)
+    emit(5, "%s\r\n" % args.image)
+    print("#exit %d" % args.exit)
+
+
+if __name__ == "__main__":
+    main()
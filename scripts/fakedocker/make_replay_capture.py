@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+# Turns a fake docker transcript into a process recording (.screc) that
+# tools/safecore_replay can feed through the pull log parser, as if the
+# installer had recorded it with SAFECORE_RECORD_DIR set:
+#
+#   scripts/fakedocker/make_replay_capture.py transcripts/pull.txt \
+#       --split-every 13 -o tools/replay/pull.screc
+#
+# --split-every N cuts every Nth layer redraw right after "<layer>: ", the
+# way a pty read lands mid-line on a real pull, so the replay covers the
+# parser carrying the last layer ID over to a bare progress line.
+import argparse
+import json
+import re
+import struct
+
+MAGIC = b"SCPR"
+FORMAT_VERSION = 1
+KIND_OUTPUT = 0
+KIND_EXIT = 1
+REDRAW = re.compile(r"\r([0-9a-f]{12}: )")
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        b = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def read_transcript(path):
+    chunks = []
+    exit_code = 0
+    with open(path, encoding="utf-8") as transcript:
+        for line in transcript:
+            line = line.rstrip("\n")
+            if line.startswith("#exit"):
+                exit_code = int(line.split()[1])
+                continue
+            if not line or line.startswith("#") or "\t" not in line:
+                continue
+            delay, text = line.split("\t", 1)
+            chunks.append((int(delay), json.loads(text)))
+    return chunks, exit_code
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("transcript")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--label", default="docker-pull")
+    parser.add_argument("--split-every", type=int, default=0, help="split every Nth layer redraw, 0 for none")
+    args = parser.parse_args()
+
+    chunks, exit_code = read_transcript(args.transcript)
+    records = bytearray()
+    redraws = 0
+    for delay_ms, text in chunks:
+        pieces = [text]
+        match = REDRAW.search(text)
+        if match:
+            redraws += 1
+            if args.split_every > 0 and redraws % args.split_every == 0:
+                pieces = [text[:match.end()], text[match.end():]]
+        for index, piece in enumerate(pieces):
+            data = piece.encode("utf-8")
+            # The second half of a split read follows right after the first
+            delay_us = delay_ms * 1000 if index == 0 else 200
+            records += bytes([KIND_OUTPUT]) + varint(delay_us) + varint(len(data)) + data
+    records += bytes([KIND_EXIT]) + varint(5000) + varint(max(0, exit_code)) + bytes([0])
+
+    label = args.label.encode("utf-8")
+    with open(args.output, "wb") as out:
+        out.write(MAGIC + struct.pack("B", FORMAT_VERSION) + varint(len(label)) + label + records)
+
+
+if __name__ == "__main__":
+    main()
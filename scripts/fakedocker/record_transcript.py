@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+# Records a command's output, with timing, as a fake docker transcript:
+#
+#   scripts/fakedocker/record_transcript.py -o transcripts/pull.txt -- \
+#       script -q -e -c "docker pull ssaiboxacr.azurecr.io/aibox-prod:latest" /dev/null
+#
+# Run pulls under `script` (as the installer does) so docker emits its TTY
+# progress output rather than the plain line-per-layer form.
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("command", nargs=argparse.REMAINDER)
+    args = parser.parse_args()
+    command = args.command[1:] if args.command[:1] == ["--"] else args.command
+    if not command:
+        parser.error("missing command")
+
+    proc = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    last = time.monotonic()
+    with open(args.output, "w", encoding="utf-8") as out:
+        while True:
+            chunk = os.read(proc.stdout.fileno(), 65536)
+            if not chunk:
+                break
+            now = time.monotonic()
+            text = chunk.decode("utf-8", "surrogateescape")
+            out.write("%d\t%s\n" % (round((now - last) * 1000), json.dumps(text)))
+            last = now
+            sys.stdout.buffer.write(chunk)
+            sys.stdout.flush()
+        code = proc.wait()
+        out.write("#exit %d\n" % code)
+    return code
+
+
+if __name__ == "__main__":
+    sys.exit(main())
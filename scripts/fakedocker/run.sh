@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+# Runs a command with the fake docker and sg first on PATH:
+#
+#   scripts/fakedocker/run.sh [--speed 100] [--transcripts DIR] [--keep-state] -- Safecore --headless provision.json
+#
+# The installer starts most docker commands through `bash -lc`, and a login
+# shell may reset PATH from /etc/profile. The command therefore gets a
+# throwaway HOME whose .bash_profile puts the shims back in front. That also
+# keeps SafeCore's own data files out of the real home directory.
+set -euo pipefail
+
+here="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+speed=1
+transcripts="$here/transcripts"
+keep_state=0
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --speed) speed="$2"; shift 2 ;;
+        --transcripts) transcripts="$2"; shift 2 ;;
+        --keep-state) keep_state=1; shift ;;
+        --) shift; break ;;
+        *) break ;;
+    esac
+done
+[ $# -gt 0 ] || { echo "usage: $0 [--speed N] [--transcripts DIR] [--keep-state] -- command..." >&2; exit 2; }
+
+fake_home="${SAFECORE_FAKE_HOME:-$(mktemp -d -t safecore-fakedocker.XXXXXX)}"
+cat > "$fake_home/.bash_profile" <<PROFILE
+export PATH="$here:\$PATH"
+PROFILE
+[ "$keep_state" = 1 ] || rm -rf "$fake_home/.fakedocker"
+
+export HOME="$fake_home"
+export PATH="$here:$PATH"
+export SAFECORE_FAKE_DOCKER_SPEED="$speed"
+export SAFECORE_FAKE_DOCKER_TRANSCRIPTS="$transcripts"
+export SAFECORE_FAKE_DOCKER_STATE="$fake_home/.fakedocker"
+exec "$@"
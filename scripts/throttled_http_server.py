@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+# Serves a directory over HTTP at a fixed rate, as a stand-in for the artifact
+# server when checking the download cap:
+#
+#   scripts/throttled_http_server.py --dir /tmp/artifacts --rate 4000000 --port 8099
+#   SAFECORE_ARTIFACT_BASE_URL=http://127.0.0.1:8099 Safecore
+#
+# Pair the server rate with a lower cap in SafeCore/bandwidth.json to see the
+# installer hold the cap, or a higher one to see the server be the limit.
+import argparse
+import functools
+import http.server
+import time
+
+CHUNK = 16 * 1024
+
+
+class ThrottledHandler(http.server.SimpleHTTPRequestHandler):
+    rate = 0
+
+    def copyfile(self, source, outputfile):
+        started = time.monotonic()
+        sent = 0
+        while True:
+            data = source.read(CHUNK)
+            if not data:
+                break
+            outputfile.write(data)
+            sent += len(data)
+            if self.rate > 0:
+                ahead = sent / self.rate - (time.monotonic() - started)
+                if ahead > 0:
+                    time.sleep(ahead)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--dir", default=".")
+    parser.add_argument("--port", type=int, default=8099)
+    parser.add_argument("--rate", type=int, default=0, help="bytes per second, 0 for unlimited")
+    args = parser.parse_args()
+
+    ThrottledHandler.rate = args.rate
+    handler = functools.partial(ThrottledHandler, directory=args.dir)
+    server = http.server.ThreadingHTTPServer(("127.0.0.1", args.port), handler)
+    print(f"Serving {args.dir} on http://127.0.0.1:{args.port} at {args.rate or 'unlimited'} B/s")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
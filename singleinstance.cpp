@@ -0,0 +1,119 @@
+#include "singleinstance.h"
+#include "tracer.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QtEndian>
+#include <unistd.h>
+
+namespace {
+// A command line is a few hundred bytes; anything past this is not one
+constexpr quint32 MaxFrameBytes = 64 * 1024;
+constexpr int IdleTimeoutMs = 2000;
+
+QString lockPath(const QString &key)
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (dir.isEmpty())
+        dir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    return dir + "/" + key + ".lock";
+}
+} // namespace
+
+// Abstract socket names are shared by every user on the host, so the name
+// carries the uid; the lock file is per user already
+SingleInstance::SingleInstance(const QString &key, QObject *parent)
+    : QObject(parent)
+    , m_serverName(key + "-" + QString::number(::getuid()))
+    , m_lock(lockPath(key))
+{
+    // Held for the whole run; a lock left by a dead process is still
+    // recognized as stale from its PID
+    m_lock.setStaleLockTime(0);
+    m_server.setSocketOptions(QLocalServer::AbstractNamespaceOption);
+    connect(&m_server, &QLocalServer::newConnection, this, &SingleInstance::onNewConnection);
+}
+
+SingleInstance::~SingleInstance()
+{
+    release();
+}
+
+SingleInstance::Result SingleInstance::claim(const QStringList &arguments)
+{
+    TraceSpan span("startup", "single instance");
+    if (m_lock.tryLock(0)) {
+        if (!m_server.listen(m_serverName))
+            qWarning().noquote() << "Single instance socket unavailable:" << m_server.errorString();
+        return Primary;
+    }
+
+    // A Unix socket connects at once when the peer is listening, so this
+    // never waits; anything short of connected means nobody is answering
+    QLocalSocket socket;
+    socket.setSocketOptions(QLocalSocket::AbstractNamespaceOption);
+    socket.connectToServer(m_serverName);
+    if (socket.state() != QLocalSocket::ConnectedState)
+        return Unreachable;
+
+    const QByteArray payload = QJsonDocument(QJsonObject{
+        {"arguments", QJsonArray::fromStringList(arguments)},
+        {"sentAtMs", QDateTime::currentMSecsSinceEpoch()},
+    }).toJson(QJsonDocument::Compact);
+    QByteArray frame(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(payload.size()), frame.data());
+    frame += payload;
+    // Far below the socket buffer, so the non-blocking write takes all of it
+    socket.write(frame);
+    socket.flush();
+    socket.disconnectFromServer();
+    return Forwarded;
+}
+
+void SingleInstance::release()
+{
+    m_server.close();
+    m_lock.unlock();
+}
+
+void SingleInstance::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        // Drop clients that connect and never finish a frame
+        QTimer::singleShot(IdleTimeoutMs, socket, [socket]() { socket->abort(); });
+        if (socket->bytesAvailable() > 0)
+            onReadyRead(socket);
+    }
+}
+
+void SingleInstance::onReadyRead(QLocalSocket *socket)
+{
+    uchar header[4];
+    if (socket->peek(reinterpret_cast<char*>(header), sizeof(header)) < qint64(sizeof(header)))
+        return;
+    const quint32 length = qFromBigEndian<quint32>(header);
+    if (length > MaxFrameBytes) {
+        socket->abort();
+        return;
+    }
+    if (socket->bytesAvailable() < qint64(sizeof(header) + length))
+        return;
+    socket->skip(sizeof(header));
+    const QJsonObject message = QJsonDocument::fromJson(socket->read(length)).object();
+    socket->disconnectFromServer();
+
+    QStringList arguments;
+    for (const QJsonValue &value : message.value("arguments").toArray())
+        arguments.append(value.toString());
+    const qint64 latencyMs = QDateTime::currentMSecsSinceEpoch() - message.value("sentAtMs").toInteger();
+    Tracer::instant("startup", "forwarded launch",
+                    QJsonObject{{"arguments", QJsonArray::fromStringList(arguments)}, {"latencyMs", latencyMs}});
+    emit argumentsReceived(arguments, latencyMs);
+}
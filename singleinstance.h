@@ -0,0 +1,45 @@
+#pragma once
+#include <QObject>
+#include <QLocalServer>
+#include <QLockFile>
+#include <QStringList>
+
+class QLocalSocket;
+
+// Keeps one GUI instance per user. The first launch takes a lock file under
+// the runtime directory and listens on an abstract-namespace local socket. A
+// later launch finds the lock held, connects without waiting, writes its
+// command line as one frame and exits; the running instance reads the frame
+// from its event loop and emits argumentsReceived().
+//
+// Frame: 4-byte big-endian length, then compact JSON
+// {"arguments": [...], "sentAtMs": <ms since the epoch>}.
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+public:
+    enum Result {
+        Primary,        // this process is the running instance now
+        Forwarded,      // the arguments went to the running instance
+        Unreachable     // another instance holds the lock but is not listening
+    };
+
+    explicit SingleInstance(const QString& key, QObject* parent = nullptr);
+    ~SingleInstance() override;
+
+    Result claim(const QStringList& arguments);
+    // Gives the instance up, e.g. before handing over to a new process
+    void release();
+
+signals:
+    // `latencyMs` is the time from the sender writing the frame until now
+    void argumentsReceived(const QStringList& arguments, qint64 latencyMs);
+
+private:
+    void onNewConnection();
+    void onReadyRead(QLocalSocket* socket);
+
+    QString m_serverName;
+    QLockFile m_lock;
+    QLocalServer m_server;
+};
@@ -0,0 +1,79 @@
+#include "startupprofile.h"
+#include "tracer.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <utility>
+
+namespace {
+struct Profile {
+    QElapsedTimer clock;
+    QList<QPair<QByteArray, double>> marks;
+    QList<QPair<QList<QByteArray>, std::function<void()>>> waiters;
+};
+
+Profile &profile()
+{
+    static Profile instance;
+    return instance;
+}
+
+void notifyWaiters()
+{
+    Profile &p = profile();
+    for (int i = 0; i < p.waiters.size();) {
+        bool ready = true;
+        for (const QByteArray &phase : std::as_const(p.waiters.at(i).first))
+            ready = ready && StartupProfile::has(phase);
+        if (!ready) {
+            ++i;
+            continue;
+        }
+        // Taken out first, the callback may add waiters of its own
+        const std::function<void()> callback = p.waiters.takeAt(i).second;
+        callback();
+    }
+}
+} // namespace
+
+void StartupProfile::start()
+{
+    profile().clock.start();
+}
+
+void StartupProfile::mark(const char *phase)
+{
+    Profile &p = profile();
+    if (!p.clock.isValid() || has(phase))
+        return;
+    p.marks.append({QByteArray(phase), double(p.clock.nsecsElapsed()) / 1e6});
+    Tracer::instant("startup", phase);
+    notifyWaiters();
+}
+
+bool StartupProfile::has(const QByteArray &phase)
+{
+    return elapsedMs(phase) >= 0;
+}
+
+double StartupProfile::elapsedMs(const QByteArray &phase)
+{
+    for (const auto &entry : std::as_const(profile().marks)) {
+        if (entry.first == phase)
+            return entry.second;
+    }
+    return -1;
+}
+
+void StartupProfile::whenMarked(const QList<QByteArray> &phases, std::function<void()> callback)
+{
+    profile().waiters.append({phases, std::move(callback)});
+    notifyWaiters();
+}
+
+QJsonObject StartupProfile::report()
+{
+    QJsonArray phases;
+    for (const auto &entry : std::as_const(profile().marks))
+        phases.append(QJsonObject{{"name", QString::fromLatin1(entry.first)}, {"ms", entry.second}});
+    return QJsonObject{{"phases", phases}};
+}
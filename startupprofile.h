@@ -0,0 +1,30 @@
+#pragma once
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <functional>
+
+// Timestamps of the GUI startup phases, in milliseconds since main() called
+// start(): application, single-instance probe, state load, controller, QML
+// load, first frame and the initial `docker inspect`. Each mark is also a
+// "startup" instant in the trace. `--startup-report` prints the result and
+// tools/safecore_startup_bench checks it against a budget.
+//
+// Marks are only taken on the GUI thread; nothing here locks.
+class StartupProfile
+{
+public:
+    static void start();
+    // Records `phase` the first time it is reached; later marks are ignored
+    static void mark(const char* phase);
+    static bool has(const QByteArray& phase);
+    // When `phase` was reached, or -1 if it has not been
+    static double elapsedMs(const QByteArray& phase);
+
+    // Calls `callback` once, as soon as every phase in `phases` is marked
+    static void whenMarked(const QList<QByteArray>& phases, std::function<void()> callback);
+
+    // {"phases": [{"name": ..., "ms": ...}, ...]} in the order reached
+    static QJsonObject report();
+};
@@ -0,0 +1,350 @@
+#include "statestore.h"
+#include "metrics.h"
+#include "tracer.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSet>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <utility>
+#include <unistd.h>
+
+namespace {
+const char *const FileNames[] = {"setup_state.json", "install_state.json", "data/registration_data.json", "data/tenant_data.json"};
+const char JournalName[] = "state.journal";
+
+bool readObject(const QString &path, QJsonObject *out)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject())
+        return false;
+    *out = doc.object();
+    return true;
+}
+
+// Leaves either the old file or the complete new one at `path`; the caller
+// syncs the directory so the rename itself survives a power cut
+bool writeDurable(const QString &path, const QByteArray &data, QString *error)
+{
+    const QString tempPath = path + ".tmp";
+    QFile file(tempPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = tempPath + ": " + file.errorString();
+        return false;
+    }
+    if (file.write(data) != data.size() || !file.flush()) {
+        *error = tempPath + ": " + file.errorString();
+        file.close();
+        QFile::remove(tempPath);
+        return false;
+    }
+    if (::fsync(file.handle()) != 0) {
+        *error = tempPath + ": " + QString::fromLocal8Bit(std::strerror(errno));
+        file.close();
+        QFile::remove(tempPath);
+        return false;
+    }
+    file.close();
+    if (std::rename(QFile::encodeName(tempPath).constData(), QFile::encodeName(path).constData()) != 0) {
+        *error = path + ": " + QString::fromLocal8Bit(std::strerror(errno));
+        QFile::remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+void syncDirectory(const QString &path)
+{
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+StateStore::Tenant tenantFromData(const QJsonObject &data)
+{
+    StateStore::Tenant tenant;
+    tenant.data = data;
+    tenant.domain = data.value("domain").toString().trimmed().toUpper();
+    const QJsonArray safeCores = data.value("safeCores").toArray();
+    tenant.safeCores.reserve(safeCores.size());
+    for (const QJsonValue &value : safeCores) {
+        const QJsonObject obj = value.toObject();
+        tenant.safeCores.append({obj.value("macId").toString().trimmed().toLower(),
+                                 obj.value("safeCoreBoxId").toString().trimmed()});
+    }
+    return tenant;
+}
+} // namespace
+
+QString StateStore::Tenant::safeCoreBoxId(const QString &macId) const
+{
+    const QString targetMac = macId.trimmed().toLower();
+    for (const auto &entry : safeCores) {
+        if (!entry.first.isEmpty() && entry.first == targetMac)
+            return entry.second;
+    }
+    return safeCores.isEmpty() ? QString() : safeCores.first().second;
+}
+
+StateStore::StateStore(const QString &basePath)
+    : m_basePath(basePath)
+{
+}
+
+QString StateStore::defaultBasePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore";
+}
+
+bool StateStore::writeFile(const QString &path, const QByteArray &data, QString *error)
+{
+    const QString directory = QFileInfo(path).absolutePath();
+    QString message;
+    bool ok = QDir().mkpath(directory);
+    if (!ok)
+        message = "cannot create " + directory;
+    else
+        ok = writeDurable(path, data, &message);
+    if (ok)
+        syncDirectory(directory);
+    else if (error)
+        *error = message;
+    return ok;
+}
+
+void StateStore::load()
+{
+    TraceSpan span("state", "load");
+    QElapsedTimer timer;
+    timer.start();
+
+    clear();
+    replayJournal();
+
+    QJsonObject obj;
+    if (readObject(filePath(SetupFile), &obj)) {
+        m_setupState.registrationOk = obj.value("registrationOk").toBool(false);
+        m_setupState.dockerPullOk = obj.value("dockerPullOk").toBool(false);
+        m_setupState.setupComplete = obj.value("setupComplete").toBool(false);
+        m_setupState.containerCreateMs = obj.value("containerCreateMs").toInteger();
+    }
+    if (readObject(filePath(InstallFile), &obj)) {
+        m_installState.step = obj.value("step").toInt();
+        for (const QJsonValue &value : obj.value("provisioned").toArray())
+            m_installState.provisioned.append(value.toString());
+        m_installState.relayUrl = obj.value("relayUrl").toString();
+        m_installState.vertical = obj.value("vertical").toString();
+        m_installState.prereqsDone = obj.value("prereqsDone").toBool(false);
+        m_installState.pullInFlight = obj.value("pullInFlight").toBool(false);
+        for (const QJsonValue &value : obj.value("pulledLayers").toArray())
+            m_installState.pulledLayers.append(value.toString());
+    }
+    if (readObject(filePath(RegistrationFile), &obj)) {
+        m_hasRegistration = true;
+        m_registration.macId = obj.value("macId").toString().trimmed();
+        m_registration.tenantId = obj.value("tenantId").toString().trimmed();
+        m_registration.registrationKey = obj.value("registrationKey").toString();
+        m_registration.generatedOn = obj.value("generatedOn").toString();
+    }
+    if (readObject(filePath(TenantFile), &obj)) {
+        m_hasTenant = true;
+        m_tenant = tenantFromData(obj.value("data").toObject());
+    }
+
+    m_lastLoadUs = timer.nsecsElapsed() / 1000;
+    Metrics::global().stateLoadSeconds.set(double(m_lastLoadUs) / 1e6);
+}
+
+void StateStore::clear()
+{
+    m_setupState = SetupState();
+    m_installState = InstallState();
+    m_hasRegistration = false;
+    m_registration = Registration();
+    m_hasTenant = false;
+    m_tenant = Tenant();
+    std::fill(std::begin(m_dirty), std::end(m_dirty), false);
+}
+
+void StateStore::setSetupState(const SetupState &state)
+{
+    m_setupState = state;
+    m_dirty[SetupFile] = true;
+}
+
+void StateStore::setInstallState(const InstallState &state)
+{
+    m_installState = state;
+    m_dirty[InstallFile] = true;
+}
+
+void StateStore::setRegistration(const Registration &registration)
+{
+    m_registration = registration;
+    m_hasRegistration = true;
+    m_dirty[RegistrationFile] = true;
+}
+
+void StateStore::setTenant(const QJsonObject &data)
+{
+    m_tenant = tenantFromData(data);
+    m_hasTenant = true;
+    m_dirty[TenantFile] = true;
+}
+
+bool StateStore::commit(QString *error)
+{
+    QList<File> files;
+    for (int i = 0; i < FileCount; ++i) {
+        if (m_dirty[i])
+            files.append(File(i));
+    }
+    if (files.isEmpty())
+        return true;
+
+    TraceSpan span("state", "commit");
+    QElapsedTimer timer;
+    timer.start();
+
+    QString message;
+    QSet<QString> directories;
+    const QString journalPath = m_basePath + "/" + JournalName;
+    const bool journaled = files.size() > 1;
+    bool ok = QDir().mkpath(m_basePath + "/data");
+    if (!ok)
+        message = "cannot create " + m_basePath + "/data";
+
+    QList<QJsonObject> contents;
+    for (File file : files)
+        contents.append(fileContent(file));
+
+    // A single rename is already atomic; the journal is only needed to make
+    // several of them land together
+    if (ok && journaled) {
+        QJsonArray writes;
+        for (int i = 0; i < files.size(); ++i)
+            writes.append(QJsonObject{{"file", FileNames[files.at(i)]}, {"content", contents.at(i)}});
+        ok = writeDurable(journalPath, QJsonDocument(QJsonObject{{"writes", writes}}).toJson(QJsonDocument::Compact),
+                          &message);
+        if (ok)
+            syncDirectory(m_basePath);
+    }
+    for (int i = 0; ok && i < files.size(); ++i) {
+        const QString path = filePath(files.at(i));
+        ok = writeDurable(path, QJsonDocument(contents.at(i)).toJson(QJsonDocument::Indented), &message);
+        directories.insert(QFileInfo(path).absolutePath());
+    }
+    for (const QString &directory : std::as_const(directories))
+        syncDirectory(directory);
+    if (ok && journaled) {
+        QFile::remove(journalPath);
+        syncDirectory(m_basePath);
+    }
+
+    // On failure the files stay dirty, so the next commit retries them
+    if (ok) {
+        for (File file : files)
+            m_dirty[file] = false;
+    }
+    m_lastCommitUs = timer.nsecsElapsed() / 1000;
+    Metrics &metrics = Metrics::global();
+    metrics.stateCommitSeconds.set(double(m_lastCommitUs) / 1e6);
+    metrics.stateCommits.add();
+    if (!ok && error)
+        *error = message;
+    return ok;
+}
+
+QString StateStore::filePath(File file) const
+{
+    return m_basePath + "/" + FileNames[file];
+}
+
+QJsonObject StateStore::fileContent(File file) const
+{
+    // Same layout the installer has always written, so older builds and
+    // support scripts keep reading these files
+    QJsonObject obj;
+    obj.insert("savedAt", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    switch (file) {
+    case SetupFile:
+        obj.insert("setupComplete", m_setupState.setupComplete);
+        obj.insert("registrationOk", m_setupState.registrationOk);
+        obj.insert("dockerPullOk", m_setupState.dockerPullOk);
+        obj.insert("containerCreateMs", m_setupState.containerCreateMs);
+        break;
+    case InstallFile:
+        obj.insert("step", m_installState.step);
+        obj.insert("provisioned", QJsonArray::fromStringList(m_installState.provisioned));
+        obj.insert("relayUrl", m_installState.relayUrl);
+        obj.insert("vertical", m_installState.vertical);
+        obj.insert("prereqsDone", m_installState.prereqsDone);
+        obj.insert("pullInFlight", m_installState.pullInFlight);
+        obj.insert("pulledLayers", QJsonArray::fromStringList(m_installState.pulledLayers));
+        break;
+    case RegistrationFile:
+        obj.insert("macId", m_registration.macId);
+        obj.insert("tenantId", m_registration.tenantId);
+        obj.insert("registrationKey", m_registration.registrationKey);
+        obj.insert("generatedOn", m_registration.generatedOn);
+        break;
+    case TenantFile:
+        obj.insert("data", m_tenant.data);
+        break;
+    case FileCount:
+        break;
+    }
+    return obj;
+}
+
+void StateStore::replayJournal()
+{
+    const QString journalPath = m_basePath + "/" + JournalName;
+    if (!QFile::exists(journalPath))
+        return;
+
+    // The journal is renamed into place only once it is complete, so one
+    // that does not parse means nothing had been renamed yet
+    QJsonObject journal;
+    if (readObject(journalPath, &journal)) {
+        const QJsonArray writes = journal.value("writes").toArray();
+        QSet<QString> directories;
+        QString message;
+        for (const QJsonValue &value : writes) {
+            const QJsonObject write = value.toObject();
+            const QString name = write.value("file").toString();
+            if (!std::count(std::begin(FileNames), std::end(FileNames), name))
+                continue;
+            const QString path = m_basePath + "/" + name;
+            QDir().mkpath(QFileInfo(path).absolutePath());
+            if (!writeDurable(path, QJsonDocument(write.value("content").toObject()).toJson(QJsonDocument::Indented),
+                              &message)) {
+                // Keep the journal for the next start
+                qWarning().noquote() << "Cannot roll state journal forward:" << message;
+                return;
+            }
+            directories.insert(QFileInfo(path).absolutePath());
+        }
+        for (const QString &directory : std::as_const(directories))
+            syncDirectory(directory);
+        Metrics::global().stateJournalReplays.add();
+    }
+    QFile::remove(journalPath);
+    syncDirectory(m_basePath);
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+// The installer's persisted state under SafeCore/: setup_state.json,
+// install_state.json, data/registration_data.json and data/tenant_data.json.
+// load() reads them once at startup and callers are served from memory
+// afterwards.
+//
+// Setters only change the cached copy; commit() writes what changed. Each
+// file is written to a temp file, fsynced and renamed over the old one, so a
+// power cut leaves either the old or the new file, never a torn one. When a
+// commit touches more than one file it first writes a journal holding all of
+// them, and load() rolls an interrupted commit forward from it.
+class StateStore
+{
+public:
+    struct SetupState {
+        bool setupComplete = false;
+        bool registrationOk = false;
+        bool dockerPullOk = false;
+        // How long the container pre-created after the pull took to create;
+        // 0 when it was not pre-created
+        qint64 containerCreateMs = 0;
+    };
+
+    // The install checkpoint. Each wizard phase and sub-step is recorded as it
+    // completes, so a relaunch after a crash resumes where the last run
+    // stopped instead of starting the wizard over.
+    struct InstallState {
+        int step = 0;               // wizard page, 0 welcome .. 3 launch
+        QStringList provisioned;    // inputs register, relay and tenant last succeeded with
+        QString relayUrl;
+        QString vertical;
+        bool prereqsDone = false;
+        // A pull that started and neither finished nor was canceled; the
+        // layers it had completed are still in the daemon's store
+        bool pullInFlight = false;
+        QStringList pulledLayers;
+    };
+
+    struct Registration {
+        QString macId;
+        QString tenantId;
+        QString registrationKey;
+        QString generatedOn;
+
+        bool isComplete() const { return !macId.isEmpty() && !tenantId.isEmpty(); }
+    };
+
+    struct Tenant {
+        QJsonObject data;       // the "data" object of the tenant response
+        QString domain;         // upper-cased
+        QList<QPair<QString, QString>> safeCores;   // lower-cased MAC, SafeCoreBoxId
+
+        // The box registered under this MAC, else the tenant's first box
+        QString safeCoreBoxId(const QString& macId) const;
+    };
+
+    explicit StateStore(const QString& basePath = defaultBasePath());
+
+    static QString defaultBasePath();
+    // One file written the way commit() writes each of its own: temp file,
+    // fsync, rename and a sync of the directory. For the state other parts
+    // of the installer keep outside this store.
+    static bool writeFile(const QString& path, const QByteArray& data, QString* error = nullptr);
+
+    void load();
+    // Forgets the cached state; for after the directory has been removed
+    void clear();
+
+    const SetupState& setupState() const { return m_setupState; }
+    const InstallState& installState() const { return m_installState; }
+    bool hasRegistration() const { return m_hasRegistration; }
+    const Registration& registration() const { return m_registration; }
+    bool hasTenant() const { return m_hasTenant; }
+    const Tenant& tenant() const { return m_tenant; }
+
+    void setSetupState(const SetupState& state);
+    void setInstallState(const InstallState& state);
+    void setRegistration(const Registration& registration);
+    void setTenant(const QJsonObject& data);
+    bool commit(QString* error = nullptr);
+
+    qint64 lastLoadUs() const { return m_lastLoadUs; }
+    qint64 lastCommitUs() const { return m_lastCommitUs; }
+
+private:
+    enum File { SetupFile, InstallFile, RegistrationFile, TenantFile, FileCount };
+
+    QString filePath(File file) const;
+    QJsonObject fileContent(File file) const;
+    void replayJournal();
+
+    QString m_basePath;
+    SetupState m_setupState;
+    InstallState m_installState;
+    bool m_hasRegistration = false;
+    Registration m_registration;
+    bool m_hasTenant = false;
+    Tenant m_tenant;
+    bool m_dirty[FileCount] = {};
+    qint64 m_lastLoadUs = 0;
+    qint64 m_lastCommitUs = 0;
+};
@@ -0,0 +1,266 @@
+#include "mockapiserver.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <cstdio>
+
+namespace {
+// Requests larger than this are treated as malformed
+constexpr int MaxRequestBytes = 1024 * 1024;
+
+QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 500: return "Internal Server Error";
+    default: return "Unknown";
+    }
+}
+
+QJsonObject envelope(int statusCode, const QString &message, const QJsonObject &data = QJsonObject())
+{
+    QJsonObject root;
+    root.insert("statusCode", statusCode);
+    root.insert("status", statusCode >= 200 && statusCode < 300 ? "Success" : "Failed");
+    root.insert("message", message);
+    if (!data.isEmpty())
+        root.insert("data", data);
+    return root;
+}
+
+// Stable per device, in the GUID form the real service uses
+QString boxId(const QString &macId, const QString &tenantId)
+{
+    const QByteArray hex = QCryptographicHash::hash((tenantId + '|' + macId + "|box").toUtf8(),
+                                                    QCryptographicHash::Sha256).toHex().left(32);
+    return QString::fromLatin1(hex.left(8) + '-' + hex.mid(8, 4) + '-' + hex.mid(12, 4) + '-'
+                               + hex.mid(16, 4) + '-' + hex.mid(20, 12));
+}
+
+bool chance(double rate)
+{
+    return rate > 0.0 && QRandomGenerator::global()->generateDouble() < rate;
+}
+} // namespace
+
+MockApiServer::MockApiServer(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &MockApiServer::onNewConnection);
+}
+
+bool MockApiServer::listen(const QHostAddress &address, quint16 port)
+{
+    return m_server.listen(address, port);
+}
+
+void MockApiServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        m_connections.insert(socket, Connection());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            auto it = m_connections.find(socket);
+            if (it == m_connections.end())
+                return;
+            it->buffer.append(socket->readAll());
+            processNext(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockApiServer::processNext(QTcpSocket *socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end() || it->busy)
+        return;
+
+    Request request;
+    bool malformed = false;
+    if (!takeRequest(*it, &request, &malformed)) {
+        if (malformed)
+            socket->disconnectFromHost();
+        return;
+    }
+
+    ++m_stats.requests;
+    ++m_stats.perPath[QString::fromLatin1(request.path)];
+    if (chance(m_options.dropRate)) {
+        ++m_stats.drops;
+        socket->abort();
+        return;
+    }
+
+    it->busy = true;
+    QTimer::singleShot(nextDelayMs(), socket, [this, socket, request]() {
+        respond(socket, request);
+    });
+}
+
+bool MockApiServer::takeRequest(Connection &connection, Request *request, bool *malformed)
+{
+    const int headerEnd = connection.buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        *malformed = connection.buffer.size() > MaxRequestBytes;
+        return false;
+    }
+
+    const QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    if (requestLine.size() < 3) {
+        *malformed = true;
+        return false;
+    }
+
+    int contentLength = 0;
+    bool keepAlive = requestLine.at(2) != "HTTP/1.0";
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        const int colon = line.indexOf(':');
+        if (colon <= 0)
+            continue;
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        if (name == "content-length")
+            contentLength = value.toInt();
+        else if (name == "connection")
+            keepAlive = value.toLower() != "close";
+    }
+    if (contentLength < 0 || contentLength > MaxRequestBytes) {
+        *malformed = true;
+        return false;
+    }
+
+    const int total = headerEnd + 4 + contentLength;
+    if (connection.buffer.size() < total)
+        return false;
+
+    request->method = requestLine.at(0);
+    request->path = requestLine.at(1);
+    const int query = request->path.indexOf('?');
+    if (query >= 0)
+        request->path.truncate(query);
+    request->body = connection.buffer.mid(headerEnd + 4, contentLength);
+    request->keepAlive = keepAlive;
+    connection.buffer.remove(0, total);
+    return true;
+}
+
+void MockApiServer::respond(QTcpSocket *socket, const Request &request)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end())
+        return;
+
+    int status = 200;
+    QByteArray body;
+    if (chance(m_options.errorRate)) {
+        ++m_stats.errors;
+        status = 500;
+        body = QJsonDocument(envelope(500, "Internal Server Error")).toJson(QJsonDocument::Compact);
+    } else {
+        body = handle(request, &status);
+    }
+    if (request.method == "HEAD")
+        body.clear();
+
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n";
+    response += "Content-Type: application/json\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += request.keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    response += "\r\n";
+    response += body;
+    socket->write(response);
+
+    if (m_options.verbose) {
+        QTextStream(stderr) << request.method << ' ' << request.path << " -> " << status << '\n';
+    }
+
+    it->busy = false;
+    if (!request.keepAlive) {
+        socket->disconnectFromHost();
+        return;
+    }
+    processNext(socket);
+}
+
+QByteArray MockApiServer::handle(const Request &request, int *status)
+{
+    const QJsonObject payload = QJsonDocument::fromJson(request.body).object();
+    const QString macId = payload.value("macId").toString();
+    const QString tenantId = payload.value("tenantId").toString();
+    QJsonObject reply;
+
+    if (request.method != "POST" && request.method != "HEAD") {
+        *status = 405;
+        reply = envelope(405, "Method not allowed.");
+    } else if (request.path == "/api/registration/generate") {
+        if (macId.isEmpty() || tenantId.isEmpty() || payload.value("accessKey").toString().isEmpty()) {
+            *status = 400;
+            reply = envelope(400, "macId, tenantId and accessKey are required.");
+        } else {
+            // The same device always gets the same key, like the real service
+            QString &key = m_registrations[macId];
+            if (key.isEmpty()) {
+                key = QString::fromLatin1(QCryptographicHash::hash((macId + '|' + tenantId).toUtf8(),
+                                                                   QCryptographicHash::Sha256).toHex().left(32));
+            }
+            QJsonObject data;
+            data.insert("registrationKey", key);
+            data.insert("generatedOn", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+            reply = envelope(200, "Registration Succeeded.", data);
+        }
+    } else if (request.path == "/api/registration/syncdevice") {
+        if (!m_registrations.contains(macId)) {
+            *status = 400;
+            reply = envelope(400, "DEVICE_NOT_AVAILABLE");
+        } else {
+            reply = envelope(200, "Sync completed.");
+        }
+    } else if (request.path == "/api/tenant/GetTenantDataById") {
+        if (!m_registrations.contains(macId)) {
+            *status = 400;
+            reply = envelope(400, "DEVICE_NOT_AVAILABLE");
+        } else {
+            // Shaped like the real tenant record: ContainerSpec::resolve needs
+            // the domain and the box registered for this MAC, next to the
+            // tenant's other boxes
+            QJsonArray safeCores;
+            safeCores.append(QJsonObject{{"macId", macId}, {"safeCoreBoxId", boxId(macId, tenantId)}});
+            safeCores.append(QJsonObject{{"macId", "02:00:00:00:00:01"},
+                                         {"safeCoreBoxId", boxId("02:00:00:00:00:01", tenantId)}});
+            QJsonObject data;
+            data.insert("tenantId", tenantId);
+            data.insert("tenantName", "Mock Tenant");
+            data.insert("vertical", payload.value("vertical").toString());
+            data.insert("domain", payload.value("vertical").toString().trimmed().toUpper());
+            data.insert("safeCores", safeCores);
+            data.insert("blob", QString(m_options.payloadBytes, QLatin1Char('x')));
+            reply = envelope(200, "Tenant data retrieved successfully.", data);
+        }
+    } else {
+        *status = 404;
+        reply = envelope(404, "Not found.");
+    }
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+int MockApiServer::nextDelayMs() const
+{
+    if (m_options.jitterMs <= 0)
+        return m_options.latencyMs;
+    return m_options.latencyMs + int(QRandomGenerator::global()->bounded(m_options.jitterMs + 1));
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <QObject>
+#include <QTcpServer>
+#include <QHash>
+#include <QByteArray>
+#include <QString>
+
+class QTcpSocket;
+
+// Minimal HTTP/1.1 stand-in for the admin API the installer talks to:
+//
+//   POST /api/registration/generate
+//   POST /api/registration/syncdevice
+//   POST /api/tenant/GetTenantDataById
+//
+// Replies use the same envelope as the real service (statusCode, status,
+// message, data). Latency, error rates and the tenant payload size can be
+// set so the client paths can be load-tested offline. Connections are kept
+// alive and requests on one connection are answered in order.
+class MockApiServer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        int latencyMs = 0;
+        int jitterMs = 0;
+        double errorRate = 0.0;     // fraction answered with HTTP 500
+        double dropRate = 0.0;      // fraction closed without any reply
+        int payloadBytes = 256;     // size of the tenant data blob
+        bool verbose = false;
+    };
+
+    struct Stats {
+        quint64 requests = 0;
+        quint64 errors = 0;
+        quint64 drops = 0;
+        QHash<QString, quint64> perPath;
+    };
+
+    explicit MockApiServer(const Options& options, QObject* parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+    quint16 port() const { return m_server.serverPort(); }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Connection {
+        QByteArray buffer;
+        bool busy = false;
+    };
+
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QByteArray body;
+        bool keepAlive = true;
+    };
+
+    void onNewConnection();
+    void processNext(QTcpSocket* socket);
+    bool takeRequest(Connection& connection, Request* request, bool* malformed);
+    void respond(QTcpSocket* socket, const Request& request);
+    QByteArray handle(const Request& request, int* status);
+    int nextDelayMs() const;
+
+    Options m_options;
+    QTcpServer m_server;
+    QHash<QTcpSocket*, Connection> m_connections;
+    QHash<QString, QString> m_registrations;    // macId -> registration key
+    Stats m_stats;
+};
@@ -0,0 +1,394 @@
+#include <cstdlib>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include "pulllogparser.h"
+
+// Measures the per-chunk cost of the docker pull log hot paths, for example
+//
+//   safecore_bench                      print ns and heap allocations per op
+//   safecore_bench --write-baseline     record the numbers for this machine
+//   safecore_bench --check              exit 1 if any case regressed
+//   safecore_bench --corpus pull.txt    also run a fake docker transcript
+//
+// Timings only compare on the machine that recorded the baseline; the
+// allocation counts are deterministic and travel between machines. The
+// committed bench_baseline.json therefore holds allocsPerOp only, as a
+// ceiling per case, and --check compares time only for cases that also
+// carry nsPerOp, i.e. after --write-baseline on the gating machine.
+
+namespace {
+std::atomic<qint64> g_allocations{0};
+} // namespace
+
+#if defined(__GLIBC__)
+// Qt's containers allocate with malloc rather than operator new, so count at
+// the allocator. operator new ends up here as well.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+namespace {
+constexpr double DefaultTolerance = 0.25;
+constexpr double DefaultAllocTolerance = 0.05;
+
+struct Corpus {
+    QString name;
+    QStringList chunks;
+};
+
+struct Result {
+    QString name;
+    qint64 ops = 0;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+};
+
+// Keeps the compiler from discarding work whose result is otherwise unused
+volatile qint64 g_sink = 0;
+
+QString progressBar(qint64 done, qint64 total)
+{
+    const int width = 50;
+    const int filled = total > 0 ? int(width * done / total) : width;
+    QString bar(QStringLiteral("["));
+    bar += QString(qMax(filled - 1, 0), QLatin1Char('='));
+    bar += QLatin1Char(filled < width ? '>' : '=');
+    bar += QString(width - filled, QLatin1Char(' '));
+    bar += QLatin1Char(']');
+    return bar;
+}
+
+QString humanSize(qint64 bytes)
+{
+    static const char *units[] = {"B", "kB", "MB", "GB"};
+    double value = double(bytes);
+    int unit = 0;
+    while (value >= 1000.0 && unit < 3) {
+        value /= 1000.0;
+        ++unit;
+    }
+    if (unit == 0)
+        return QString::number(bytes) + "B";
+    return QString::number(value, 'g', 3) + units[unit];
+}
+
+// Same shape as scripts/fakedocker/make_pull_transcript.py: every progress
+// update redraws one layer line with cursor-up/down escapes.
+Corpus makePullCorpus(const QString &name, int layers, int steps, qint64 minLayerBytes, qint64 maxLayerBytes)
+{
+    QRandomGenerator rng(1);
+    QStringList ids;
+    QList<qint64> sizes;
+    for (int i = 0; i < layers; ++i) {
+        ids.append(QString::number(rng.generate64(), 16).rightJustified(16, QLatin1Char('0')).left(12));
+        sizes.append(minLayerBytes + qint64(rng.bounded(double(maxLayerBytes - minLayerBytes))));
+    }
+
+    Corpus corpus;
+    corpus.name = name;
+    corpus.chunks.append("latest: Pulling from aibox-prod\r\n");
+    for (const QString &id : ids)
+        corpus.chunks.append(id + ": Pulling fs layer \r\n");
+
+    const QString esc(QChar(0x1B));
+    auto redraw = [&](int index, const QString &status) {
+        const int up = layers - index;
+        corpus.chunks.append(QString("%1[%2A%1[2K\r%3: %4\r%1[%2B").arg(esc).arg(up).arg(ids.at(index), status));
+    };
+    for (int i = 0; i < layers; ++i) {
+        const qint64 total = sizes.at(i);
+        for (const char *phase : {"Downloading", "Extracting"}) {
+            for (int step = 1; step <= steps; ++step) {
+                const qint64 done = total * step / steps;
+                redraw(i, QString("%1  %2  %3/%4").arg(QLatin1String(phase), progressBar(done, total),
+                                                       humanSize(done), humanSize(total)));
+            }
+            if (qstrcmp(phase, "Downloading") == 0)
+                redraw(i, "Download complete ");
+        }
+        redraw(i, "Pull complete ");
+    }
+    corpus.chunks.append("Digest: sha256:3f0a7d2c9b1e4f5a6b7c8d9e0f1a2b3c4d5e6f708192a3b4c5d6e7f8091a2b3c\r\n");
+    corpus.chunks.append("Status: Downloaded newer image for ssaiboxacr.azurecr.io/aibox-prod:latest\r\n");
+    return corpus;
+}
+
+// Reads a fake docker transcript: "<delay_ms>\t<JSON string>" per chunk
+bool loadTranscript(const QString &path, Corpus *corpus, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    corpus->name = QFileInfo(path).completeBaseName();
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        const int tab = line.indexOf('\t');
+        if (tab < 0)
+            continue;
+        const QJsonArray wrapped = QJsonDocument::fromJson('[' + line.mid(tab + 1) + ']').array();
+        if (!wrapped.isEmpty())
+            corpus->chunks.append(wrapped.at(0).toString());
+    }
+    if (corpus->chunks.isEmpty()) {
+        *error = "no chunks found";
+        return false;
+    }
+    return true;
+}
+
+// Runs body over a fresh state `repeat` times and keeps the fastest run
+Result measure(const QString &name, int repeat, qint64 ops,
+               const std::function<std::function<void()>()> &prepare)
+{
+    Result result;
+    result.name = name;
+    result.ops = ops;
+    qint64 bestNs = -1;
+    for (int i = 0; i < repeat; ++i) {
+        const std::function<void()> body = prepare();
+        QElapsedTimer timer;
+        const qint64 allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+        timer.start();
+        body();
+        const qint64 elapsedNs = timer.nsecsElapsed();
+        const qint64 allocations = g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+        if (bestNs < 0 || elapsedNs < bestNs) {
+            bestNs = elapsedNs;
+            result.allocsPerOp = double(allocations) / double(qMax<qint64>(ops, 1));
+        }
+    }
+    result.nsPerOp = double(bestNs) / double(qMax<qint64>(ops, 1));
+    return result;
+}
+
+QList<Result> runCorpus(const Corpus &corpus, int repeat)
+{
+    QStringList normalized;
+    QStringList lines;
+    for (const QString &chunk : corpus.chunks) {
+        normalized.append(PullLogParser::normalize(chunk));
+        for (const QString &line : normalized.last().split(QLatin1Char('\n'), Qt::SkipEmptyParts))
+            lines.append(line.trimmed());
+    }
+    const qint64 chunkCount = corpus.chunks.size();
+    const QString prefix = corpus.name + QLatin1Char('/');
+
+    QList<Result> results;
+    results.append(measure(prefix + "appendDockerPullLog", repeat, chunkCount, [&corpus]() {
+        auto parser = std::make_shared<PullLogParser>(true);
+        return [&corpus, parser]() {
+            for (const QString &chunk : corpus.chunks) {
+                parser->append(chunk);
+                g_sink = g_sink + parser->text().size();
+            }
+        };
+    }));
+    results.append(measure(prefix + "updateDockerPullProgressFromChunk", repeat, chunkCount, [&normalized]() {
+        auto parser = std::make_shared<PullLogParser>(true);
+        return [&normalized, parser]() {
+            for (const QString &chunk : normalized) {
+                parser->updateProgress(chunk);
+                g_sink = g_sink + qint64(parser->progress() * 1000.0);
+            }
+        };
+    }));
+    results.append(measure(prefix + "appendUpgradeLog", repeat, chunkCount, [&corpus]() {
+        auto parser = std::make_shared<PullLogParser>(false);
+        return [&corpus, parser]() {
+            for (const QString &chunk : corpus.chunks) {
+                parser->append(chunk);
+                g_sink = g_sink + parser->text().size();
+            }
+        };
+    }));
+    results.append(measure(prefix + "stripAnsiSequences", repeat, chunkCount, [&corpus]() {
+        return [&corpus]() {
+            for (const QString &chunk : corpus.chunks)
+                g_sink = g_sink + PullLogParser::stripAnsiSequences(chunk).size();
+        };
+    }));
+    results.append(measure(prefix + "extractLayerId", repeat, lines.size(), [&lines]() {
+        return [&lines]() {
+            for (const QString &line : lines)
+                g_sink = g_sink + PullLogParser::extractLayerId(line).size();
+        };
+    }));
+    return results;
+}
+
+QJsonObject toJson(const QList<Result> &results, double tolerance, double allocTolerance)
+{
+    QJsonObject cases;
+    for (const Result &result : results) {
+        QJsonObject entry;
+        entry.insert("nsPerOp", result.nsPerOp);
+        entry.insert("allocsPerOp", result.allocsPerOp);
+        cases.insert(result.name, entry);
+    }
+    QJsonObject root;
+    root.insert("tolerance", tolerance);
+    root.insert("allocTolerance", allocTolerance);
+    root.insert("cases", cases);
+    return root;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("safecore_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks for the docker pull log and progress parsing.");
+    parser.addHelpOption();
+    const QCommandLineOption corpusOption("corpus", "Extra fake docker transcript to run (repeatable).", "file");
+    const QCommandLineOption repeatOption("repeat", "Runs per case; the fastest is kept.", "count", "5");
+    const QCommandLineOption filterOption("filter", "Only run cases whose name contains this.", "text");
+    const QCommandLineOption baselineOption("baseline", "Baseline file.", "file", SAFECORE_BENCH_BASELINE);
+    const QCommandLineOption checkOption("check", "Compare against the baseline and fail on regressions.");
+    const QCommandLineOption writeOption("write-baseline", "Write the results as the new baseline.");
+    const QCommandLineOption toleranceOption("tolerance",
+                                             "Allowed slowdown as a fraction (default from baseline, else 0.25).",
+                                             "fraction");
+    const QCommandLineOption allocToleranceOption("alloc-tolerance",
+                                                  "Allowed allocation growth as a fraction (default 0.05).",
+                                                  "fraction");
+    parser.addOptions({corpusOption, repeatOption, filterOption, baselineOption, checkOption, writeOption,
+                       toleranceOption, allocToleranceOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QList<Corpus> corpora;
+    // A typical image, a multi-gigabyte image with many redraws per layer,
+    // and an image with an unusually large number of small layers
+    corpora.append(makePullCorpus("small", 8, 25, 2'000'000, 150'000'000));
+    corpora.append(makePullCorpus("8gb", 16, 400, 400'000'000, 600'000'000));
+    corpora.append(makePullCorpus("200layer", 200, 10, 100'000, 40'000'000));
+    for (const QString &path : parser.values(corpusOption)) {
+        Corpus corpus;
+        QString error;
+        if (!loadTranscript(path, &corpus, &error)) {
+            err << "Cannot read corpus " << path << ": " << error << '\n';
+            return 2;
+        }
+        corpora.append(corpus);
+    }
+
+    const int repeat = qMax(1, parser.value(repeatOption).toInt());
+    const QString filter = parser.value(filterOption);
+    QList<Result> results;
+    for (const Corpus &corpus : corpora) {
+        for (const Result &result : runCorpus(corpus, repeat)) {
+            if (filter.isEmpty() || result.name.contains(filter))
+                results.append(result);
+        }
+    }
+
+    QJsonObject baseline;
+    QFile baselineFile(parser.value(baselineOption));
+    if (baselineFile.open(QIODevice::ReadOnly))
+        baseline = QJsonDocument::fromJson(baselineFile.readAll()).object();
+    baselineFile.close();
+
+    const double tolerance = parser.isSet(toleranceOption)
+        ? parser.value(toleranceOption).toDouble()
+        : baseline.value("tolerance").toDouble(DefaultTolerance);
+    const double allocTolerance = parser.isSet(allocToleranceOption)
+        ? parser.value(allocToleranceOption).toDouble()
+        : baseline.value("allocTolerance").toDouble(DefaultAllocTolerance);
+    const QJsonObject baselineCases = baseline.value("cases").toObject();
+
+    if (parser.isSet(checkOption) && baselineCases.isEmpty()) {
+        err << "No baseline at " << baselineFile.fileName() << "; record one with --write-baseline\n";
+        return 2;
+    }
+
+    int regressions = 0;
+    out << QString("%1 %2 %3 %4 %5\n")
+               .arg(QString("case"), -50).arg("ops", 8).arg("ns/op", 10).arg("allocs/op", 10).arg("vs baseline");
+    for (const Result &result : results) {
+        QString verdict;
+        const QJsonObject reference = baselineCases.value(result.name).toObject();
+        if (!reference.isEmpty()) {
+            const bool timed = reference.contains("nsPerOp");
+            const double refNs = reference.value("nsPerOp").toDouble();
+            const double refAllocs = reference.value("allocsPerOp").toDouble();
+            const QString allocRatio = QString::number(refAllocs > 0.0 ? result.allocsPerOp / refAllocs : 0.0, 'f', 2);
+            verdict = timed ? QString("%1x time, %2x allocs")
+                                  .arg(refNs > 0.0 ? result.nsPerOp / refNs : 0.0, 0, 'f', 2)
+                                  .arg(allocRatio)
+                            : QString("%1x allocs").arg(allocRatio);
+            // Half an allocation of slack keeps near-zero counts from flapping
+            const bool slower = timed && result.nsPerOp > refNs * (1.0 + tolerance);
+            const bool heavier = result.allocsPerOp > refAllocs * (1.0 + allocTolerance) + 0.5;
+            if (slower || heavier) {
+                verdict += "  REGRESSION";
+                ++regressions;
+            }
+        } else if (!baselineCases.isEmpty()) {
+            verdict = "not in baseline";
+        }
+        out << QString("%1 %2 %3 %4 %5\n")
+                   .arg(result.name, -50)
+                   .arg(result.ops, 8)
+                   .arg(result.nsPerOp, 10, 'f', 1)
+                   .arg(result.allocsPerOp, 10, 'f', 2)
+                   .arg(verdict);
+    }
+    out.flush();
+
+    if (parser.isSet(writeOption)) {
+        QFile file(baselineFile.fileName());
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "Cannot write " << file.fileName() << ": " << file.errorString() << '\n';
+            return 2;
+        }
+        file.write(QJsonDocument(toJson(results, tolerance, allocTolerance)).toJson());
+        err << "Baseline written to " << file.fileName() << '\n';
+    }
+
+    if (parser.isSet(checkOption) && regressions > 0) {
+        err << regressions << " case(s) regressed beyond the baseline tolerance\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QTextStream>
+#include <cstdio>
+#include "mockapiserver.h"
+
+// Runs the mock admin API until interrupted, for example
+//
+//   safecore_mock_api --port 8098 --latency-ms 80 --jitter-ms 40 --error-rate 0.05
+//   SAFECORE_SERVICE_BASE_URL=http://127.0.0.1:8098 Safecore --headless provision.json
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("safecore_mock_api");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for the SafeCore admin API.");
+    parser.addHelpOption();
+    const QCommandLineOption hostOption("host", "Address to listen on.", "address", "127.0.0.1");
+    const QCommandLineOption portOption("port", "Port to listen on (0 picks one).", "port", "8098");
+    const QCommandLineOption latencyOption("latency-ms", "Delay before every reply.", "ms", "0");
+    const QCommandLineOption jitterOption("jitter-ms", "Extra random delay, 0..ms.", "ms", "0");
+    const QCommandLineOption errorOption("error-rate", "Fraction of requests answered with HTTP 500.", "rate", "0");
+    const QCommandLineOption dropOption("drop-rate", "Fraction of connections closed without a reply.", "rate", "0");
+    const QCommandLineOption payloadOption("payload-bytes", "Size of the tenant data blob.", "bytes", "256");
+    const QCommandLineOption verboseOption("verbose", "Log every request to stderr.");
+    parser.addOptions({hostOption, portOption, latencyOption, jitterOption, errorOption, dropOption,
+                       payloadOption, verboseOption});
+    parser.process(app);
+
+    MockApiServer::Options options;
+    options.latencyMs = parser.value(latencyOption).toInt();
+    options.jitterMs = parser.value(jitterOption).toInt();
+    options.errorRate = parser.value(errorOption).toDouble();
+    options.dropRate = parser.value(dropOption).toDouble();
+    options.payloadBytes = parser.value(payloadOption).toInt();
+    options.verbose = parser.isSet(verboseOption);
+
+    MockApiServer server(options);
+    if (!server.listen(QHostAddress(parser.value(hostOption)), quint16(parser.value(portOption).toUInt()))) {
+        QTextStream(stderr) << "Cannot listen on " << parser.value(hostOption) << ':' << parser.value(portOption) << '\n';
+        return 1;
+    }
+    // The chosen port goes to stdout so scripts can start it with --port 0
+    QTextStream(stdout) << "http://" << parser.value(hostOption) << ':' << server.port() << Qt::endl;
+    return app.exec();
+}
@@ -0,0 +1,237 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+#include <ctime>
+#include "processrecorder.h"
+#include "pulllogparser.h"
+#include "pullstalldetector.h"
+
+// Feeds a recording made with SAFECORE_RECORD_DIR back through the pull log
+// parser exactly as the controller chunked it, then checks the result:
+//
+//   safecore_replay docker-pull.screc --speed 0 --write-expected golden/pull
+//   safecore_replay docker-pull.screc --speed 0 --expect golden/pull --max-cpu-ms 40
+//   safecore_replay docker-pull.screc --speed 10     replay at 10x real time
+//
+// The parser only sees the chunk sequence, so the final log and the progress
+// curve are the same at any speed; --speed only changes the wall-clock pacing.
+// Exit codes: 0 pass, 1 an expectation failed, 2 bad input.
+
+namespace {
+qint64 threadCpuNs()
+{
+    timespec ts {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+struct ProgressPoint {
+    int chunk = 0;
+    double progress = 0.0;
+};
+
+class Replayer
+{
+public:
+    Replayer(const ProcessRecording &recording, bool upgradeMode)
+        : m_recording(recording)
+        , m_parser(!upgradeMode)
+    {
+        // Mirrors the pull path's observer so the measured cost matches
+        if (!upgradeMode) {
+            m_parser.setLayerObserver([this](const QString &layerId, const QString &line) {
+                m_stallDetector.observe(layerId, line);
+            });
+        }
+    }
+
+    void feed(int index)
+    {
+        const qint64 start = threadCpuNs();
+        // Same decoding as the controller: each chunk converted on its own
+        m_parser.append(QString::fromUtf8(m_recording.chunks.at(index).data));
+        m_cpuNs += threadCpuNs() - start;
+        if (m_parser.layerCount() > 0) {
+            const double progress = m_parser.progress();
+            if (m_curve.isEmpty() || !qFuzzyCompare(m_curve.last().progress, progress))
+                m_curve.append({index, progress});
+        }
+    }
+
+    const QString &log() const { return m_parser.text(); }
+    const QVector<ProgressPoint> &curve() const { return m_curve; }
+    qint64 cpuNs() const { return m_cpuNs; }
+
+private:
+    const ProcessRecording &m_recording;
+    PullLogParser m_parser;
+    PullStallDetector m_stallDetector;
+    QVector<ProgressPoint> m_curve;
+    qint64 m_cpuNs = 0;
+};
+
+QByteArray curveText(const QVector<ProgressPoint> &curve)
+{
+    QByteArray out;
+    for (const ProgressPoint &point : curve)
+        out += QByteArray::number(point.chunk) + ' ' + QByteArray::number(point.progress, 'f', 6) + '\n';
+    return out;
+}
+
+QVector<ProgressPoint> parseCurve(const QByteArray &text)
+{
+    QVector<ProgressPoint> curve;
+    for (const QByteArray &line : text.split('\n')) {
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.size() == 2)
+            curve.append({fields.at(0).toInt(), fields.at(1).toDouble()});
+    }
+    return curve;
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return file.write(data) == data.size();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("safecore_replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a recorded docker pull through the pull log parser.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("recording", "A .screc file written with SAFECORE_RECORD_DIR set.");
+    const QCommandLineOption speedOption("speed", "Replay speed factor; 0 feeds chunks back to back.", "factor", "0");
+    const QCommandLineOption upgradeOption("upgrade", "Parse as the upgrade log (no column alignment).");
+    const QCommandLineOption expectOption("expect", "Compare with <prefix>.log and <prefix>.progress.", "prefix");
+    const QCommandLineOption writeOption("write-expected", "Write <prefix>.log and <prefix>.progress.", "prefix");
+    const QCommandLineOption toleranceOption("progress-tolerance", "Allowed progress difference per point.",
+                                             "delta", "0.000001");
+    const QCommandLineOption cpuOption("max-cpu-ms", "Fail when parsing takes more CPU time than this.", "ms");
+    parser.addOptions({speedOption, upgradeOption, expectOption, writeOption, toleranceOption, cpuOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (parser.positionalArguments().size() != 1) {
+        err << "Expected exactly one recording.\n";
+        return 2;
+    }
+
+    ProcessRecording recording;
+    QString error;
+    if (!recording.load(parser.positionalArguments().constFirst(), &error)) {
+        err << "Cannot load recording: " << error << '\n';
+        return 2;
+    }
+
+    Replayer replayer(recording, parser.isSet(upgradeOption));
+    const double speed = parser.value(speedOption).toDouble();
+    QElapsedTimer wall;
+    wall.start();
+    if (speed <= 0.0) {
+        for (int i = 0; i < recording.chunks.size(); ++i)
+            replayer.feed(i);
+    } else {
+        // Each chunk is due at its recorded offset scaled by the speed
+        int next = 0;
+        QTimer timer;
+        timer.setSingleShot(true);
+        QObject::connect(&timer, &QTimer::timeout, &app, [&]() {
+            const qint64 nowUs = wall.nsecsElapsed() / 1000;
+            while (next < recording.chunks.size() && recording.chunks.at(next).offsetUs / speed <= nowUs)
+                replayer.feed(next++);
+            if (next >= recording.chunks.size()) {
+                QCoreApplication::quit();
+                return;
+            }
+            const qint64 dueUs = qint64(recording.chunks.at(next).offsetUs / speed);
+            timer.start(int(qMax<qint64>(0, (dueUs - nowUs) / 1000)));
+        });
+        timer.start(0);
+        if (!recording.chunks.isEmpty())
+            app.exec();
+    }
+
+    const double cpuMs = double(replayer.cpuNs()) / 1e6;
+    const double megabytes = double(recording.totalBytes()) / 1e6;
+    out << recording.label << ": " << recording.chunks.size() << " chunks, "
+        << QString::number(megabytes, 'f', 2) << " MB, recorded over "
+        << QString::number(double(recording.durationUs) / 1e6, 'f', 1) << " s\n";
+    out << "parser cpu " << QString::number(cpuMs, 'f', 2) << " ms ("
+        << QString::number(cpuMs > 0.0 ? megabytes / (cpuMs / 1000.0) : 0.0, 'f', 1) << " MB/s, "
+        << QString::number(recording.chunks.isEmpty() ? 0.0 : replayer.cpuNs() / double(recording.chunks.size()), 'f', 0)
+        << " ns/chunk), wall " << wall.elapsed() << " ms, final progress "
+        << QString::number(replayer.curve().isEmpty() ? 0.0 : replayer.curve().last().progress, 'f', 4) << '\n';
+    out.flush();
+
+    if (parser.isSet(writeOption)) {
+        const QString prefix = parser.value(writeOption);
+        if (!writeFile(prefix + ".log", replayer.log().toUtf8())
+            || !writeFile(prefix + ".progress", curveText(replayer.curve()))) {
+            err << "Cannot write expectations to " << prefix << ".*\n";
+            return 2;
+        }
+    }
+
+    int failures = 0;
+    if (parser.isSet(expectOption)) {
+        const QString prefix = parser.value(expectOption);
+        QFile logFile(prefix + ".log");
+        QFile curveFile(prefix + ".progress");
+        if (!logFile.open(QIODevice::ReadOnly) || !curveFile.open(QIODevice::ReadOnly)) {
+            err << "Cannot read expectations " << prefix << ".*\n";
+            return 2;
+        }
+
+        const QStringList expectedLines = QString::fromUtf8(logFile.readAll()).split('\n');
+        const QStringList actualLines = replayer.log().split('\n');
+        if (expectedLines != actualLines) {
+            ++failures;
+            int line = 0;
+            while (line < expectedLines.size() && line < actualLines.size()
+                   && expectedLines.at(line) == actualLines.at(line)) {
+                ++line;
+            }
+            err << "Final log differs at line " << line + 1 << ":\n"
+                << "  expected: " << expectedLines.value(line) << '\n'
+                << "  actual:   " << actualLines.value(line) << '\n';
+        }
+
+        const QVector<ProgressPoint> expectedCurve = parseCurve(curveFile.readAll());
+        const QVector<ProgressPoint> &actualCurve = replayer.curve();
+        const double tolerance = parser.value(toleranceOption).toDouble();
+        bool curveMatches = expectedCurve.size() == actualCurve.size();
+        int point = 0;
+        for (; curveMatches && point < actualCurve.size(); ++point) {
+            curveMatches = expectedCurve.at(point).chunk == actualCurve.at(point).chunk
+                && qAbs(expectedCurve.at(point).progress - actualCurve.at(point).progress) <= tolerance;
+        }
+        if (!curveMatches) {
+            ++failures;
+            err << "Progress curve differs (" << actualCurve.size() << " points, expected "
+                << expectedCurve.size() << ")";
+            if (point > 0 && point <= actualCurve.size() && point <= expectedCurve.size()) {
+                err << " at point " << point << ": chunk " << actualCurve.at(point - 1).chunk << " progress "
+                    << actualCurve.at(point - 1).progress << ", expected chunk " << expectedCurve.at(point - 1).chunk
+                    << " progress " << expectedCurve.at(point - 1).progress;
+            }
+            err << '\n';
+        }
+    }
+
+    if (parser.isSet(cpuOption) && cpuMs > parser.value(cpuOption).toDouble()) {
+        ++failures;
+        err << "Parser CPU time " << cpuMs << " ms exceeds the limit of " << parser.value(cpuOption) << " ms\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
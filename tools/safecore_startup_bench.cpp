@@ -0,0 +1,207 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <vector>
+
+// Measures cold start to the first rendered frame, for example
+//
+//   safecore_startup_bench                          both modes, 10 runs each
+//   safecore_startup_bench --mode ops --runs 30
+//   safecore_startup_bench --platform offscreen     no display needed
+//   safecore_startup_bench --check                  exit 1 if over budget
+//
+// Every run gets an empty XDG_DATA_HOME, so no saved state is picked up. The
+// first run of each mode is kept: a cold page cache is part of what users see.
+// Close a running SafeCore first, launches would be handed over to it.
+//
+// Besides the wall time the app's --startup-report phases are collected. The
+// budget file holds a limit in ms per mode for "wall" and for any phase, and
+// --check compares the medians with it. A budgeted phase that a run did not
+// report counts as over budget. The limits are for the SafeCore box, not a
+// developer workstation.
+
+namespace {
+struct Sample {
+    double wallMs = 0;              // spawn to the `first-frame` line
+    QMap<QString, double> phases;   // from the app's startup report
+};
+
+bool runOnce(const QString &binary, const QString &modeArg, const QString &platform, int timeoutMs,
+             Sample *sample, QString *error)
+{
+    QTemporaryDir dataHome;
+    if (!dataHome.isValid()) {
+        *error = "cannot create a temporary data directory";
+        return false;
+    }
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("XDG_DATA_HOME", dataHome.path());
+    if (!platform.isEmpty())
+        env.insert("QT_QPA_PLATFORM", platform);
+
+    QProcess process;
+    process.setProcessEnvironment(env);
+    process.setProcessChannelMode(QProcess::SeparateChannels);
+    QElapsedTimer wall;
+    wall.start();
+    process.start(binary, {modeArg, "--exit-after-first-frame", "--startup-report"});
+    if (!process.waitForStarted(timeoutMs)) {
+        *error = process.errorString();
+        return false;
+    }
+
+    // The report follows the first frame once the initial docker inspect is
+    // back, so the wall time is taken when the first-frame line arrives
+    QByteArray output;
+    while (wall.elapsed() < timeoutMs) {
+        if (!process.waitForReadyRead(100) && process.state() == QProcess::NotRunning)
+            break;
+        output += process.readAllStandardOutput();
+        if (sample->wallMs == 0 && output.contains("first-frame "))
+            sample->wallMs = double(wall.nsecsElapsed()) / 1e6;
+        const int at = output.indexOf("startup-report ");
+        const int end = at < 0 ? -1 : output.indexOf('\n', at);
+        if (sample->wallMs == 0 || end < 0)
+            continue;
+        const QJsonObject report = QJsonDocument::fromJson(output.mid(at + 15, end - at - 15)).object();
+        for (const QJsonValue &value : report.value("phases").toArray()) {
+            const QJsonObject phase = value.toObject();
+            sample->phases.insert(phase.value("name").toString(), phase.value("ms").toDouble());
+        }
+        process.waitForFinished(timeoutMs);
+        return true;
+    }
+    process.kill();
+    process.waitForFinished();
+    *error = "no startup report within " + QString::number(timeoutMs) + " ms: "
+             + QString::fromLocal8Bit(process.readAllStandardError()).trimmed();
+    return false;
+}
+
+double percentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    return values.at(std::min(values.size() - 1, size_t(p * double(values.size()))));
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("safecore_startup_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures process start to first frame of the installer and ops windows.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("binary", "The ai_box_installer binary; defaults to the one from this build.");
+    const QCommandLineOption runsOption("runs", "Launches per mode.", "n", "10");
+    const QCommandLineOption modeOption("mode", "installer, ops or both.", "mode", "both");
+    const QCommandLineOption platformOption("platform", "QT_QPA_PLATFORM for the launched app.", "name");
+    const QCommandLineOption timeoutOption("timeout-ms", "Give up on a launch after this long.", "ms", "30000");
+    const QCommandLineOption budgetOption("budget", "Budget file.", "file", SAFECORE_STARTUP_BUDGET);
+    const QCommandLineOption checkOption("check", "Fail when a median is over its budget.");
+    parser.addOptions({runsOption, modeOption, platformOption, timeoutOption, budgetOption, checkOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    const QStringList positional = parser.positionalArguments();
+    const QString binary = positional.isEmpty() ? QStringLiteral(SAFECORE_BINARY) : positional.constFirst();
+    const int runs = parser.value(runsOption).toInt();
+    const int timeoutMs = parser.value(timeoutOption).toInt();
+    const QString mode = parser.value(modeOption);
+    if (runs < 1 || timeoutMs < 1 || !QStringList{"installer", "ops", "both"}.contains(mode)) {
+        err << "Invalid --runs, --timeout-ms or --mode.\n";
+        return 2;
+    }
+
+    QJsonObject budget;
+    QFile budgetFile(parser.value(budgetOption));
+    if (budgetFile.open(QIODevice::ReadOnly))
+        budget = QJsonDocument::fromJson(budgetFile.readAll()).object();
+    if (parser.isSet(checkOption) && budget.isEmpty()) {
+        err << "No budget at " << budgetFile.fileName() << '\n';
+        return 2;
+    }
+
+    QList<QPair<QString, QString>> modes;
+    if (mode != "ops")
+        modes.append({"installer", "--installer"});
+    if (mode != "installer")
+        modes.append({"ops", "--docker-ops"});
+
+    int overBudget = 0;
+    for (const auto &entry : modes) {
+        std::vector<double> wall;
+        QMap<QString, std::vector<double>> phases;
+        QStringList order;
+        for (int i = 0; i < runs; ++i) {
+            Sample sample;
+            QString error;
+            if (!runOnce(binary, entry.second, parser.value(platformOption), timeoutMs, &sample, &error)) {
+                err << entry.first << " run " << i + 1 << ": " << error << '\n';
+                return 2;
+            }
+            wall.push_back(sample.wallMs);
+            for (auto it = sample.phases.constBegin(); it != sample.phases.constEnd(); ++it)
+                phases[it.key()].push_back(it.value());
+        }
+
+        // Phases in the order they were reached, by their median
+        QList<QPair<double, QString>> rows;
+        for (auto it = phases.constBegin(); it != phases.constEnd(); ++it)
+            rows.append({percentile(it.value(), 0.5), it.key()});
+        std::sort(rows.begin(), rows.end());
+        rows.prepend({percentile(wall, 0.5), QStringLiteral("wall")});
+
+        const QJsonObject limits = budget.value(entry.first).toObject();
+        out << entry.first << " (" << runs << " runs)\n"
+            << QString("  %1 %2 %3 %4 %5\n").arg(QString("phase"), -16).arg("median", 10).arg("p90", 10)
+                   .arg("max", 10).arg("budget", 10);
+        for (const auto &row : std::as_const(rows)) {
+            const std::vector<double> &values = row.second == "wall" ? wall : phases.value(row.second);
+            const double limit = limits.value(row.second).toDouble(0);
+            // A budgeted phase some runs never reported cannot be shown to fit
+            const int missing = runs - int(values.size());
+            const bool over = limit > 0 && (row.first > limit || missing > 0);
+            overBudget += over ? 1 : 0;
+            out << QString("  %1 %2 %3 %4 %5%6%7\n")
+                       .arg(row.second, -16)
+                       .arg(row.first, 10, 'f', 1)
+                       .arg(percentile(values, 0.9), 10, 'f', 1)
+                       .arg(*std::max_element(values.begin(), values.end()), 10, 'f', 1)
+                       .arg(limit > 0 ? QString::number(limit, 'f', 0) : QString("-"), 10)
+                       .arg(over ? QStringLiteral("  OVER") : QString())
+                       .arg(missing > 0 ? QString("  (missing in %1 runs)").arg(missing) : QString());
+        }
+        // Budgeted phases no run reported at all, e.g. after a rename
+        for (auto it = limits.constBegin(); it != limits.constEnd(); ++it) {
+            if (it.key() == "wall" || phases.contains(it.key()) || it.value().toDouble(0) <= 0)
+                continue;
+            ++overBudget;
+            out << QString("  %1 %2 %3 %4 %5  OVER\n")
+                       .arg(it.key(), -16)
+                       .arg("missing", 10)
+                       .arg("-", 10)
+                       .arg("-", 10)
+                       .arg(QString::number(it.value().toDouble(), 'f', 0), 10);
+        }
+    }
+    out.flush();
+
+    if (parser.isSet(checkOption) && overBudget > 0) {
+        err << overBudget << " phase(s) over the startup budget\n";
+        return 1;
+    }
+    return 0;
+}
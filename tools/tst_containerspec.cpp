@@ -0,0 +1,246 @@
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+#include "containerspec.h"
+
+// ContainerSpec::plan() against canned `docker inspect` output: one
+// container that matches the spec below, edited per case.
+class ContainerSpecTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void emptyInspectCreates();
+    void matchingContainerIsKept();
+    void hashLabelSkipsTheDiff();
+    void staleHashLabelGetsTheDiff();
+    void imageChangeRecreates();
+    void envDiffRecreates();
+    void imageOwnEnvIsIgnored();
+    void portsDiffRecreates();
+    void mountsDiffRecreates();
+    void stoppedContainerStarts();
+    void createdContainerStarts();
+    void unhealthyContainerRestarts();
+    void deadContainerRecreates();
+    void diffWinsOverState();
+
+private:
+    void setState(const QJsonObject& state);
+    void editConfig(const QString& key, const QJsonValue& value);
+    void editHostConfig(const QString& key, const QJsonValue& value);
+
+    ContainerSpec m_spec;
+    QJsonObject m_inspected;
+};
+
+namespace {
+const QString ImageId = "sha256:4f53cda18c2baa0c0354bb5f9a3ecbe5ed12ab4d8e11ba873c2f11161202b945";
+
+// Trimmed from `docker inspect safecore`; only what plan() reads, plus the
+// image's own PATH, which the spec does not set
+const char *const InspectJson = R"([{
+    "Id": "9c1e5b0b7d4f3a2e8f6d1c0b9a8e7f6d5c4b3a2e1f0d9c8b7a6e5f4d3c2b1a0e",
+    "Image": "sha256:4f53cda18c2baa0c0354bb5f9a3ecbe5ed12ab4d8e11ba873c2f11161202b945",
+    "State": {
+        "Status": "running",
+        "Running": true,
+        "Restarting": false,
+        "Health": { "Status": "healthy" }
+    },
+    "Config": {
+        "Env": [
+            "PATH=/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin",
+            "SAFECORE_TENANT_ID=8c1d2f0e-0000-4000-8000-000000000000",
+            "SAFECORE_RELAY_URL=https://relay.example.com"
+        ],
+        "Labels": {}
+    },
+    "HostConfig": {
+        "Binds": [ "aibox_weapons:/models", "/opt/safecore/data:/data" ],
+        "PortBindings": {
+            "8080/tcp": [ { "HostIp": "", "HostPort": "8080" } ],
+            "8554/tcp": [ { "HostIp": "", "HostPort": "8554" } ]
+        },
+        "RestartPolicy": { "Name": "unless-stopped", "MaximumRetryCount": 0 },
+        "DeviceRequests": [ { "Driver": "", "Count": -1, "Capabilities": [ [ "gpu" ] ] } ]
+    }
+}])";
+} // namespace
+
+void ContainerSpecTest::init()
+{
+    m_spec = ContainerSpec();
+    m_spec.name = "safecore";
+    m_spec.image = "ssaiboxacr.azurecr.io/aibox-prod:latest";
+    m_spec.restartPolicy = "unless-stopped";
+    m_spec.allGpus = true;
+    m_spec.ports = {"8080:8080", "8554:8554"};
+    m_spec.volumes = {"aibox_weapons:/models", "/opt/safecore/data:/data"};
+    m_spec.env = {{"SAFECORE_TENANT_ID", "8c1d2f0e-0000-4000-8000-000000000000"},
+                  {"SAFECORE_RELAY_URL", "https://relay.example.com"}};
+    m_inspected = QJsonDocument::fromJson(InspectJson).array().first().toObject();
+    QVERIFY(!m_inspected.isEmpty());
+}
+
+void ContainerSpecTest::setState(const QJsonObject& state)
+{
+    m_inspected.insert("State", state);
+}
+
+void ContainerSpecTest::editConfig(const QString& key, const QJsonValue& value)
+{
+    QJsonObject config = m_inspected.value("Config").toObject();
+    config.insert(key, value);
+    m_inspected.insert("Config", config);
+}
+
+void ContainerSpecTest::editHostConfig(const QString& key, const QJsonValue& value)
+{
+    QJsonObject hostConfig = m_inspected.value("HostConfig").toObject();
+    hostConfig.insert(key, value);
+    m_inspected.insert("HostConfig", hostConfig);
+}
+
+void ContainerSpecTest::emptyInspectCreates()
+{
+    const ContainerSpec::Plan plan = m_spec.plan(QJsonObject(), ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Create);
+    QCOMPARE(plan.reasons, QStringList{"no container"});
+    QVERIFY(plan.containerId.isEmpty());
+}
+
+void ContainerSpecTest::matchingContainerIsKept()
+{
+    // No label: a container from an older version gets the full diff
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::None);
+    QVERIFY2(plan.reasons.isEmpty(), qPrintable(plan.reasons.join(", ")));
+    QCOMPARE(plan.containerId, m_inspected.value("Id").toString());
+}
+
+void ContainerSpecTest::hashLabelSkipsTheDiff()
+{
+    editConfig("Labels", QJsonObject{{ContainerSpec::HashLabel, m_spec.hash()}});
+    // Would be a diff; the label with an unchanged image settles it first
+    editHostConfig("Binds", QJsonArray{"aibox_weapons:/models"});
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::None);
+    QVERIFY(plan.reasons.isEmpty());
+}
+
+void ContainerSpecTest::staleHashLabelGetsTheDiff()
+{
+    editConfig("Labels", QJsonObject{{ContainerSpec::HashLabel, QString(64, QLatin1Char('0'))}});
+    editHostConfig("Binds", QJsonArray{"aibox_weapons:/models"});
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Recreate);
+    QCOMPARE(plan.reasons, QStringList{"mounts"});
+}
+
+void ContainerSpecTest::imageChangeRecreates()
+{
+    editConfig("Labels", QJsonObject{{ContainerSpec::HashLabel, m_spec.hash()}});
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, "sha256:" + QString(64, QLatin1Char('1')));
+    QCOMPARE(plan.action, ContainerSpec::Action::Recreate);
+    QCOMPARE(plan.reasons, QStringList{"image"});
+
+    // An image that cannot be inspected is not taken as unchanged
+    QCOMPARE(m_spec.plan(m_inspected, QString()).action, ContainerSpec::Action::Recreate);
+}
+
+void ContainerSpecTest::envDiffRecreates()
+{
+    editConfig("Env", QJsonArray{"PATH=/usr/bin:/bin",
+                                 "SAFECORE_TENANT_ID=00000000-0000-4000-8000-000000000000",
+                                 "SAFECORE_RELAY_URL=https://relay.example.com"});
+    ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Recreate);
+    QCOMPARE(plan.reasons, QStringList{"env SAFECORE_TENANT_ID"});
+
+    editConfig("Env", QJsonArray{"SAFECORE_TENANT_ID=8c1d2f0e-0000-4000-8000-000000000000"});
+    plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Recreate);
+    QCOMPARE(plan.reasons, QStringList{"env SAFECORE_RELAY_URL"});
+}
+
+void ContainerSpecTest::imageOwnEnvIsIgnored()
+{
+    QJsonArray env = m_inspected.value("Config").toObject().value("Env").toArray();
+    env.append("NVIDIA_VISIBLE_DEVICES=all");
+    editConfig("Env", env);
+    QCOMPARE(m_spec.plan(m_inspected, ImageId).action, ContainerSpec::Action::None);
+}
+
+void ContainerSpecTest::portsDiffRecreates()
+{
+    editHostConfig("PortBindings", QJsonObject{
+        {"8080/tcp", QJsonArray{QJsonObject{{"HostIp", ""}, {"HostPort", "8081"}}}},
+        {"8554/tcp", QJsonArray{QJsonObject{{"HostIp", ""}, {"HostPort", "8554"}}}},
+    });
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Recreate);
+    QCOMPARE(plan.reasons, QStringList{"ports"});
+}
+
+void ContainerSpecTest::mountsDiffRecreates()
+{
+    editHostConfig("Binds", QJsonArray{"aibox_weapons:/models", "/opt/safecore/data:/data", "/tmp:/tmp"});
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Recreate);
+    QCOMPARE(plan.reasons, QStringList{"mounts"});
+}
+
+void ContainerSpecTest::stoppedContainerStarts()
+{
+    setState(QJsonObject{{"Status", "exited"}, {"Running", false}, {"ExitCode", 137}});
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Start);
+    QCOMPARE(plan.reasons, QStringList{"container exited"});
+}
+
+void ContainerSpecTest::createdContainerStarts()
+{
+    // Pre-created after the pull and never started
+    editConfig("Labels", QJsonObject{{ContainerSpec::HashLabel, m_spec.hash()}});
+    setState(QJsonObject{{"Status", "created"}, {"Running", false}});
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Start);
+    QCOMPARE(plan.status, QString("created"));
+}
+
+void ContainerSpecTest::unhealthyContainerRestarts()
+{
+    setState(QJsonObject{{"Status", "running"}, {"Running", true},
+                         {"Health", QJsonObject{{"Status", "unhealthy"}}}});
+    ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Restart);
+    QCOMPARE(plan.reasons, QStringList{"container unhealthy"});
+
+    setState(QJsonObject{{"Status", "restarting"}, {"Running", true}, {"Restarting", true}});
+    QCOMPARE(m_spec.plan(m_inspected, ImageId).action, ContainerSpec::Action::Restart);
+}
+
+void ContainerSpecTest::deadContainerRecreates()
+{
+    editConfig("Labels", QJsonObject{{ContainerSpec::HashLabel, m_spec.hash()}});
+    setState(QJsonObject{{"Status", "dead"}, {"Running", false}, {"Dead", true}});
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Recreate);
+    QCOMPARE(plan.reasons, QStringList{"container dead"});
+}
+
+void ContainerSpecTest::diffWinsOverState()
+{
+    // A stopped container with a stale config is rebuilt, not started
+    setState(QJsonObject{{"Status", "exited"}, {"Running", false}});
+    editHostConfig("RestartPolicy", QJsonObject{{"Name", "no"}});
+    const ContainerSpec::Plan plan = m_spec.plan(m_inspected, ImageId);
+    QCOMPARE(plan.action, ContainerSpec::Action::Recreate);
+    QCOMPARE(plan.reasons, QStringList{"restart policy"});
+}
+
+QTEST_GUILESS_MAIN(ContainerSpecTest)
+#include "tst_containerspec.moc"
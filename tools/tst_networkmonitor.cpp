@@ -0,0 +1,135 @@
+#include <QSignalSpy>
+#include <QTest>
+#include <cstring>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "networkmonitor.h"
+
+// Feeds hand-built rtnetlink messages through NetworkMonitor::attach() from a
+// socketpair, with the /proc lookup replaced by setRouteProbe().
+class NetworkMonitorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void defaultRouteLostAndRestored();
+    void ignoresNonDefaultRoutes();
+    void linkEventRechecksRoute();
+    void burstIsOneTransition();
+
+private:
+    void send(const QList<QPair<quint16, quint8>>& messages);
+
+    NetworkMonitor* m_monitor = nullptr;
+    int m_writeFd = -1;
+    bool m_online = true;
+};
+
+void NetworkMonitorTest::init()
+{
+    int fds[2];
+    QVERIFY(::socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds) == 0);
+    m_online = true;
+    m_monitor = new NetworkMonitor;
+    m_monitor->setRouteProbe([this]() { return m_online; });
+    // The monitor owns and closes the read end
+    QVERIFY(m_monitor->attach(fds[0], true));
+    m_writeFd = fds[1];
+    QVERIFY(m_monitor->hasDefaultRoute());
+}
+
+void NetworkMonitorTest::cleanup()
+{
+    delete m_monitor;
+    m_monitor = nullptr;
+    ::close(m_writeFd);
+    m_writeFd = -1;
+}
+
+// One datagram holding a message per (type, rtm_dst_len) pair, like a
+// kernel burst
+void NetworkMonitorTest::send(const QList<QPair<quint16, quint8>>& messages)
+{
+    QByteArray datagram;
+    for (const auto &message : messages) {
+        const bool isRoute = message.first == RTM_NEWROUTE || message.first == RTM_DELROUTE;
+        const int payload = isRoute ? int(sizeof(rtmsg)) : int(sizeof(ifinfomsg));
+        QByteArray buffer(NLMSG_SPACE(payload), '\0');
+        auto *header = reinterpret_cast<nlmsghdr *>(buffer.data());
+        header->nlmsg_len = NLMSG_LENGTH(payload);
+        header->nlmsg_type = message.first;
+        if (isRoute) {
+            auto *route = static_cast<rtmsg *>(NLMSG_DATA(header));
+            route->rtm_family = AF_INET;
+            route->rtm_dst_len = message.second;
+            route->rtm_table = RT_TABLE_MAIN;
+        }
+        datagram += buffer;
+    }
+    QCOMPARE(::send(m_writeFd, datagram.constData(), size_t(datagram.size()), 0), ssize_t(datagram.size()));
+}
+
+void NetworkMonitorTest::defaultRouteLostAndRestored()
+{
+    QSignalSpy lost(m_monitor, &NetworkMonitor::defaultRouteLost);
+    QSignalSpy restored(m_monitor, &NetworkMonitor::defaultRouteRestored);
+
+    m_online = false;
+    send({{RTM_DELROUTE, 0}});
+    QVERIFY(lost.wait(2000));
+    QVERIFY(!m_monitor->hasDefaultRoute());
+    QCOMPARE(restored.count(), 0);
+
+    m_online = true;
+    send({{RTM_NEWROUTE, 0}});
+    QVERIFY(restored.wait(2000));
+    QVERIFY(m_monitor->hasDefaultRoute());
+    QCOMPARE(lost.count(), 1);
+    QVERIFY(restored.at(0).at(0).toLongLong() >= 0);
+}
+
+void NetworkMonitorTest::ignoresNonDefaultRoutes()
+{
+    QSignalSpy lost(m_monitor, &NetworkMonitor::defaultRouteLost);
+
+    // A /24 going away does not make the monitor look at the routes again
+    m_online = false;
+    send({{RTM_DELROUTE, 24}});
+    QVERIFY(!lost.wait(300));
+    QVERIFY(m_monitor->hasDefaultRoute());
+
+    send({{RTM_DELROUTE, 0}});
+    QVERIFY(lost.wait(2000));
+}
+
+void NetworkMonitorTest::linkEventRechecksRoute()
+{
+    QSignalSpy lost(m_monitor, &NetworkMonitor::defaultRouteLost);
+    QSignalSpy link(m_monitor, &NetworkMonitor::linkChanged);
+
+    m_online = false;
+    send({{RTM_DELLINK, 0}});
+    QVERIFY(lost.wait(2000));
+    QCOMPARE(link.count(), 1);
+}
+
+void NetworkMonitorTest::burstIsOneTransition()
+{
+    QSignalSpy lost(m_monitor, &NetworkMonitor::defaultRouteLost);
+    QSignalSpy restored(m_monitor, &NetworkMonitor::defaultRouteRestored);
+
+    // The state is re-read once per burst, so a flap inside it is not seen
+    m_online = false;
+    send({{RTM_DELROUTE, 0}, {RTM_NEWROUTE, 0}, {RTM_DELROUTE, 0}});
+    QVERIFY(lost.wait(2000));
+    QTest::qWait(100);
+    QCOMPARE(lost.count(), 1);
+    QCOMPARE(restored.count(), 0);
+}
+
+QTEST_GUILESS_MAIN(NetworkMonitorTest)
+#include "tst_networkmonitor.moc"
@@ -0,0 +1,216 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTemporaryDir>
+#include <QTest>
+#include "bandwidthscheduler.h"
+#include "registryproxy.h"
+
+// Pulls a blob through RegistryProxy from scripts/throttled_http_server.py
+// standing in for the registry. The server serves faster than the caps set
+// here, so the time a fetch takes is the cap the proxy holds.
+class RegistryProxyTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+    void answersVersionCheck();
+    void rejectsWhatIsNotAPull();
+    void forwardsBlobIntact();
+    void holdsSchedulerCap();
+    void overrideLiftsCap();
+    void holdsRateCeiling();
+
+private:
+    struct Fetch {
+        int status = 0;
+        QByteArray body;
+        QByteArray contentLength;
+        qint64 elapsedMs = 0;
+    };
+    Fetch fetch(const QByteArray& method, const QString& path);
+
+    QTemporaryDir m_dir;
+    QProcess m_server;
+    quint16 m_serverPort = 0;
+    QString m_blobPath;
+    QByteArray m_blob;
+    QNetworkAccessManager m_net;
+    BandwidthScheduler* m_bandwidth = nullptr;
+    RegistryProxy* m_proxy = nullptr;
+};
+
+namespace {
+constexpr qint64 BlobBytes = 512 * 1024;
+constexpr qint64 CapBytesPerSecond = 256 * 1000;
+// Well above the caps, so the proxy is the limit and not the server
+constexpr qint64 ServerBytesPerSecond = 8 * 1000 * 1000;
+
+// Time the cap must stretch a blob download to, less the burst allowance
+// granted up front
+qint64 cappedMs(qint64 bytes, qint64 cap)
+{
+    return (bytes - cap / 4) * 1000 / cap;
+}
+} // namespace
+
+void RegistryProxyTest::initTestCase()
+{
+    // bandwidth.json and friends stay out of the real data directory
+    QStandardPaths::setTestModeEnabled(true);
+    if (QStandardPaths::findExecutable("python3").isEmpty())
+        QSKIP("python3 is needed to run the throttled registry stand-in");
+    QVERIFY(m_dir.isValid());
+
+    m_blob.resize(BlobBytes);
+    QRandomGenerator gen(42);
+    for (qsizetype i = 0; i < m_blob.size(); ++i)
+        m_blob[i] = char(gen.bounded(256));
+    const QByteArray digest = QCryptographicHash::hash(m_blob, QCryptographicHash::Sha256).toHex();
+    m_blobPath = "/v2/safecore/test/blobs/sha256:" + QString::fromLatin1(digest);
+    QVERIFY(QDir(m_dir.path()).mkpath("v2/safecore/test/blobs"));
+    QFile blobFile(m_dir.path() + m_blobPath);
+    QVERIFY(blobFile.open(QIODevice::WriteOnly));
+    QCOMPARE(blobFile.write(m_blob), qint64(m_blob.size()));
+    blobFile.close();
+
+    // A port that was free a moment ago; the server binds it right away
+    QTcpServer probe;
+    QVERIFY(probe.listen(QHostAddress::LocalHost));
+    m_serverPort = probe.serverPort();
+    probe.close();
+
+    m_server.setProcessChannelMode(QProcess::MergedChannels);
+    m_server.start("python3", {"-u", SAFECORE_THROTTLED_SERVER, "--dir", m_dir.path(),
+                               "--port", QString::number(m_serverPort),
+                               "--rate", QString::number(ServerBytesPerSecond)});
+    QVERIFY(m_server.waitForStarted(5000));
+    // It prints its banner once it listens
+    QVERIFY(m_server.waitForReadyRead(10000));
+    QVERIFY(m_server.readAll().contains("Serving"));
+}
+
+void RegistryProxyTest::cleanupTestCase()
+{
+    if (m_server.state() != QProcess::NotRunning) {
+        m_server.kill();
+        m_server.waitForFinished(2000);
+    }
+}
+
+void RegistryProxyTest::init()
+{
+    m_bandwidth = new BandwidthScheduler;
+    m_proxy = new RegistryProxy;
+    m_proxy->setUpstream(QUrl(QString("http://127.0.0.1:%1").arg(m_serverPort)));
+    m_proxy->setBandwidthScheduler(m_bandwidth);
+    QVERIFY(m_proxy->listen());
+}
+
+void RegistryProxyTest::cleanup()
+{
+    delete m_proxy;
+    m_proxy = nullptr;
+    delete m_bandwidth;
+    m_bandwidth = nullptr;
+}
+
+RegistryProxyTest::Fetch RegistryProxyTest::fetch(const QByteArray& method, const QString& path)
+{
+    QNetworkRequest request(QUrl(QString("http://127.0.0.1:%1%2").arg(m_proxy->port()).arg(path)));
+    request.setRawHeader("Accept-Encoding", "identity");
+    QElapsedTimer clock;
+    clock.start();
+    QNetworkReply* reply = m_net.sendCustomRequest(request, method);
+    QSignalSpy finished(reply, &QNetworkReply::finished);
+    Fetch result;
+    if (!finished.wait(30000)) {
+        reply->abort();
+        reply->deleteLater();
+        return result;
+    }
+    result.elapsedMs = clock.elapsed();
+    result.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    result.contentLength = reply->rawHeader("Content-Length");
+    result.body = reply->readAll();
+    reply->deleteLater();
+    return result;
+}
+
+void RegistryProxyTest::answersVersionCheck()
+{
+    const Fetch result = fetch("GET", "/v2/");
+    QCOMPARE(result.status, 200);
+}
+
+void RegistryProxyTest::rejectsWhatIsNotAPull()
+{
+    QCOMPARE(fetch("POST", m_blobPath).status, 405);
+    QCOMPARE(fetch("GET", "/v2/_catalog").status, 404);
+    QCOMPARE(fetch("GET", "/v2/safecore/test/blobs/sha256:missing").status, 404);
+}
+
+void RegistryProxyTest::forwardsBlobIntact()
+{
+    const Fetch head = fetch("HEAD", m_blobPath);
+    QCOMPARE(head.status, 200);
+    QCOMPARE(head.contentLength, QByteArray::number(BlobBytes));
+    QVERIFY(head.body.isEmpty());
+
+    const Fetch get = fetch("GET", m_blobPath);
+    QCOMPARE(get.status, 200);
+    QCOMPARE(get.body, m_blob);
+    QCOMPARE(m_proxy->bytesServed(), BlobBytes);
+}
+
+void RegistryProxyTest::holdsSchedulerCap()
+{
+    m_bandwidth->setDefaultCap(CapBytesPerSecond);
+    const Fetch result = fetch("GET", m_blobPath);
+    QCOMPARE(result.status, 200);
+    QCOMPARE(result.body, m_blob);
+    const qint64 expectedMs = cappedMs(BlobBytes, CapBytesPerSecond);
+    QVERIFY2(result.elapsedMs >= expectedMs * 9 / 10,
+             qPrintable(QString("took %1 ms, cap allows no less than %2 ms").arg(result.elapsedMs).arg(expectedMs)));
+    // Not held back by more than the pacing granularity
+    QVERIFY2(result.elapsedMs <= expectedMs * 2 + 1000, qPrintable(QString("took %1 ms").arg(result.elapsedMs)));
+}
+
+void RegistryProxyTest::overrideLiftsCap()
+{
+    m_bandwidth->setDefaultCap(CapBytesPerSecond);
+    m_bandwidth->setOverride(true);
+    QCOMPARE(m_bandwidth->currentCap(), qint64(0));
+    const Fetch result = fetch("GET", m_blobPath);
+    QCOMPARE(result.status, 200);
+    QCOMPARE(result.body, m_blob);
+    QVERIFY2(result.elapsedMs < cappedMs(BlobBytes, CapBytesPerSecond) / 2,
+             qPrintable(QString("took %1 ms with the cap lifted").arg(result.elapsedMs)));
+}
+
+void RegistryProxyTest::holdsRateCeiling()
+{
+    // No scheduler cap at all; the proxy's own ceiling is the limit
+    m_proxy->setRateCeiling(CapBytesPerSecond);
+    const Fetch result = fetch("GET", m_blobPath);
+    QCOMPARE(result.status, 200);
+    QCOMPARE(result.body, m_blob);
+    const qint64 expectedMs = cappedMs(BlobBytes, CapBytesPerSecond);
+    QVERIFY2(result.elapsedMs >= expectedMs * 9 / 10,
+             qPrintable(QString("took %1 ms, ceiling allows no less than %2 ms").arg(result.elapsedMs).arg(expectedMs)));
+}
+
+QTEST_GUILESS_MAIN(RegistryProxyTest)
+#include "tst_registryproxy.moc"
@@ -0,0 +1,303 @@
+#include "tracer.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QSaveFile>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+constexpr int BlockCapacity = 1024;
+constexpr int MaxBlocksPerThread = Tracer::MaxEventsPerThread / BlockCapacity;
+
+struct Event {
+    const char *category = nullptr;
+    QByteArray name;
+    char phase = 'X';
+    qint64 startNs = 0;
+    qint64 durationNs = 0;
+    quint64 id = 0;
+    QJsonObject args;
+};
+
+// Only the owning thread writes to a block. An event becomes visible to the
+// exporter once `count` is published past it, and is never modified after.
+struct Block {
+    Event events[BlockCapacity];
+    std::atomic<int> count{0};
+    std::atomic<Block*> next{nullptr};
+};
+
+struct ThreadBuffer {
+    qint64 tid = 0;
+    Block *head = nullptr;
+    Block *tail = nullptr;
+    int blocks = 0;
+    std::atomic<qint64> dropped{0};
+    ThreadBuffer *nextBuffer = nullptr;
+};
+
+// Buffers are registered once per thread and intentionally never freed, so
+// the exporter can walk them while threads come and go.
+std::atomic<ThreadBuffer*> g_buffers{nullptr};
+std::atomic<bool> g_enabled{qEnvironmentVariable("SAFECORE_TRACE") != QLatin1String("0")};
+std::atomic<quint64> g_nextAsyncId{1};
+thread_local ThreadBuffer *t_buffer = nullptr;
+
+const std::chrono::steady_clock::time_point &origin()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return start;
+}
+
+ThreadBuffer *threadBuffer()
+{
+    if (t_buffer)
+        return t_buffer;
+    auto *buffer = new ThreadBuffer;
+    buffer->tid = qint64(::syscall(SYS_gettid));
+    buffer->head = buffer->tail = new Block;
+    buffer->blocks = 1;
+    ThreadBuffer *head = g_buffers.load(std::memory_order_relaxed);
+    do {
+        buffer->nextBuffer = head;
+    } while (!g_buffers.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+    t_buffer = buffer;
+    return buffer;
+}
+
+void record(Event &&event)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    Block *block = buffer->tail;
+    int count = block->count.load(std::memory_order_relaxed);
+    if (count == BlockCapacity) {
+        if (buffer->blocks >= MaxBlocksPerThread) {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        auto *next = new Block;
+        ++buffer->blocks;
+        block->next.store(next, std::memory_order_release);
+        buffer->tail = block = next;
+        count = 0;
+    }
+    block->events[count] = std::move(event);
+    block->count.store(count + 1, std::memory_order_release);
+}
+
+QJsonObject toJson(const Event &event, qint64 pid, qint64 tid)
+{
+    QJsonObject obj;
+    obj.insert("name", QString::fromUtf8(event.name));
+    obj.insert("cat", QString::fromLatin1(event.category));
+    obj.insert("ph", QString(QLatin1Char(event.phase)));
+    // Chrome trace timestamps are in microseconds
+    obj.insert("ts", double(event.startNs) / 1000.0);
+    obj.insert("pid", double(pid));
+    obj.insert("tid", double(tid));
+    if (event.phase == 'X')
+        obj.insert("dur", double(event.durationNs) / 1000.0);
+    else if (event.phase == 'i')
+        obj.insert("s", "t");
+    else
+        obj.insert("id", QString::number(event.id, 16).prepend("0x"));
+    if (!event.args.isEmpty())
+        obj.insert("args", event.args);
+    return obj;
+}
+
+QJsonObject metadata(const char *name, qint64 pid, qint64 tid, const QString &value)
+{
+    QJsonObject args;
+    args.insert("name", value);
+    QJsonObject obj;
+    obj.insert("name", name);
+    obj.insert("ph", "M");
+    obj.insert("pid", double(pid));
+    obj.insert("tid", double(tid));
+    obj.insert("args", args);
+    return obj;
+}
+} // namespace
+
+bool Tracer::enabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin()).count();
+}
+
+void Tracer::complete(const char *category, const QByteArray &name, qint64 startNs, qint64 durationNs,
+                      const QJsonObject &args)
+{
+    if (!enabled())
+        return;
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.phase = 'X';
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    event.args = args;
+    record(std::move(event));
+}
+
+void Tracer::instant(const char *category, const QByteArray &name, const QJsonObject &args)
+{
+    if (!enabled())
+        return;
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.phase = 'i';
+    event.startNs = now();
+    event.args = args;
+    record(std::move(event));
+}
+
+quint64 Tracer::beginAsync(const char *category, const QByteArray &name, const QJsonObject &args)
+{
+    if (!enabled())
+        return 0;
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.phase = 'b';
+    event.startNs = now();
+    event.id = g_nextAsyncId.fetch_add(1, std::memory_order_relaxed);
+    event.args = args;
+    const quint64 id = event.id;
+    record(std::move(event));
+    return id;
+}
+
+void Tracer::endAsync(const char *category, const QByteArray &name, quint64 id, const QJsonObject &args)
+{
+    if (id == 0 || !enabled())
+        return;
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.phase = 'e';
+    event.startNs = now();
+    event.id = id;
+    event.args = args;
+    record(std::move(event));
+}
+
+void Tracer::traceProcess(QProcess *process, const char *name)
+{
+    if (!process || !enabled())
+        return;
+    const QByteArray label = QByteArray::fromRawData(name, int(qstrlen(name)));
+    auto id = std::make_shared<quint64>(0);
+    QObject::connect(process, &QProcess::started, process, [process, label, id]() {
+        QJsonObject args;
+        args.insert("program", process->program());
+        args.insert("arguments", QJsonArray::fromStringList(process->arguments()));
+        *id = beginAsync("process", label, args);
+    });
+    QObject::connect(process, &QProcess::finished, process,
+                     [label, id](int exitCode, QProcess::ExitStatus exitStatus) {
+        QJsonObject args;
+        args.insert("exitCode", exitCode);
+        args.insert("crashed", exitStatus == QProcess::CrashExit);
+        endAsync("process", label, *id, args);
+        *id = 0;
+    });
+    QObject::connect(process, &QProcess::errorOccurred, process, [label, id](QProcess::ProcessError error) {
+        // A process that never started gets no finished() signal
+        if (error != QProcess::FailedToStart)
+            return;
+        QJsonObject args;
+        args.insert("error", "failed to start");
+        instant("process", label, args);
+    });
+}
+
+bool Tracer::writeChromeTrace(const QString &path, QString *error)
+{
+    const qint64 pid = qint64(::getpid());
+    QJsonArray events;
+    events.append(metadata("process_name", pid, pid, "SafeCore installer"));
+
+    qint64 dropped = 0;
+    for (ThreadBuffer *buffer = g_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->nextBuffer) {
+        events.append(metadata("thread_name", pid, buffer->tid,
+                               buffer->tid == pid ? QStringLiteral("main") : QString("thread %1").arg(buffer->tid)));
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+        for (Block *block = buffer->head; block; block = block->next.load(std::memory_order_acquire)) {
+            const int count = block->count.load(std::memory_order_acquire);
+            for (int i = 0; i < count; ++i)
+                events.append(toJson(block->events[i], pid, buffer->tid));
+        }
+    }
+
+    QJsonObject otherData;
+    otherData.insert("exportedAt", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    otherData.insert("droppedEvents", double(dropped));
+    QJsonObject root;
+    root.insert("traceEvents", events);
+    root.insert("displayTimeUnit", "ms");
+    root.insert("otherData", otherData);
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+qint64 Tracer::droppedEvents()
+{
+    qint64 dropped = 0;
+    for (ThreadBuffer *buffer = g_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->nextBuffer)
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    return dropped;
+}
+
+TraceSpan::TraceSpan(const char *category, const char *name)
+    : m_category(category)
+    , m_name(QByteArray::fromRawData(name, int(qstrlen(name))))
+{
+    if (Tracer::enabled())
+        m_startNs = Tracer::now();
+}
+
+TraceSpan::TraceSpan(const char *category, const QByteArray &name)
+    : m_category(category)
+    , m_name(name)
+{
+    if (Tracer::enabled())
+        m_startNs = Tracer::now();
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_startNs >= 0)
+        Tracer::complete(m_category, m_name, m_startNs, Tracer::now() - m_startNs, m_args);
+}
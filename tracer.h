@@ -0,0 +1,62 @@
+#pragma once
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+class QProcess;
+
+// Records a timeline of what the installer spent its time on and exports it
+// in the Chrome trace format (chrome://tracing, ui.perfetto.dev). Each thread
+// appends to its own buffer without locking; the export reads whatever has
+// been published so far. Recording is on unless SAFECORE_TRACE=0, and stops
+// quietly once a thread has buffered MaxEventsPerThread events.
+//
+// Category and name pointers passed as `const char*` must be string literals;
+// they are stored without copying.
+class Tracer
+{
+public:
+    static constexpr int MaxEventsPerThread = 1 << 16;
+
+    static bool enabled();
+    static void setEnabled(bool enabled);
+
+    // Nanoseconds on the monotonic clock since the first trace call.
+    static qint64 now();
+
+    static void complete(const char* category, const QByteArray& name, qint64 startNs, qint64 durationNs,
+                         const QJsonObject& args = QJsonObject());
+    static void instant(const char* category, const QByteArray& name, const QJsonObject& args = QJsonObject());
+
+    // Spans that start and end in different callbacks, e.g. a child process
+    // or a network request. Returns 0 when tracing is off.
+    static quint64 beginAsync(const char* category, const QByteArray& name, const QJsonObject& args = QJsonObject());
+    static void endAsync(const char* category, const QByteArray& name, quint64 id,
+                         const QJsonObject& args = QJsonObject());
+
+    // Spans the process from start to exit, with the command line and exit code.
+    static void traceProcess(QProcess* process, const char* name);
+
+    static bool writeChromeTrace(const QString& path, QString* error = nullptr);
+    static qint64 droppedEvents();
+};
+
+// Times the enclosing scope.
+class TraceSpan
+{
+public:
+    TraceSpan(const char* category, const char* name);
+    TraceSpan(const char* category, const QByteArray& name);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void setArgs(const QJsonObject& args) { m_args = args; }
+
+private:
+    const char* m_category;
+    QByteArray m_name;
+    QJsonObject m_args;
+    qint64 m_startNs = -1;
+};
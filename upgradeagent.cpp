@@ -0,0 +1,455 @@
+#include "upgradeagent.h"
+#include "tracer.h"
+#include "apiclient.h"
+#include "appconstants.h"
+#include "bandwidthscheduler.h"
+#include "dockerscript.h"
+#include "registrycredentials.h"
+#include "statestore.h"
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace {
+constexpr int InitialCheckDelayMs = 2 * 60 * 1000;
+constexpr int DeferredRecheckMs = 30 * 60 * 1000;
+
+const char *ManifestAccept =
+    "application/vnd.docker.distribution.manifest.list.v2+json, "
+    "application/vnd.oci.image.index.v1+json, "
+    "application/vnd.docker.distribution.manifest.v2+json, "
+    "application/vnd.oci.image.manifest.v1+json";
+
+QString statePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/SafeCore/staged_upgrade.json";
+}
+
+struct ImageRef {
+    QString host;
+    QString repository;
+    QString tag = "latest";
+};
+
+ImageRef parseImageRef(const QString &image)
+{
+    ImageRef ref;
+    QString rest = image;
+    const int slashIdx = rest.indexOf('/');
+    if (slashIdx > 0) {
+        ref.host = rest.left(slashIdx);
+        rest = rest.mid(slashIdx + 1);
+    }
+    const int tagIdx = rest.lastIndexOf(':');
+    if (tagIdx > rest.lastIndexOf('/')) {
+        ref.tag = rest.mid(tagIdx + 1);
+        rest = rest.left(tagIdx);
+    }
+    ref.repository = rest;
+    return ref;
+}
+
+QString repositoryOf(const QString &image)
+{
+    const ImageRef ref = parseImageRef(image);
+    return ref.host.isEmpty() ? ref.repository : ref.host + "/" + ref.repository;
+}
+
+QString shortDigest(const QString &digest)
+{
+    return digest.section(':', 1).left(12);
+}
+
+QString pullScope(const QString &image)
+{
+    return QString("repository:%1:pull").arg(parseImageRef(image).repository);
+}
+} // namespace
+
+UpgradeAgent::UpgradeAgent(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(false);
+    connect(&m_timer, &QTimer::timeout, this, [this]() { checkNow(); });
+    m_deferTimer.setSingleShot(true);
+    connect(&m_deferTimer, &QTimer::timeout, this, [this]() { checkNow(); });
+    loadState();
+    if (hasStagedUpgrade())
+        m_status = "staged";
+}
+
+UpgradeAgent::~UpgradeAgent()
+{
+    if (m_process) {
+        m_process->disconnect(this);
+        if (m_process->state() != QProcess::NotRunning) {
+            m_process->kill();
+            m_process->waitForFinished(1000);
+        }
+        m_process->deleteLater();
+        m_process = nullptr;
+    }
+}
+
+void UpgradeAgent::start(int intervalMs)
+{
+    m_timer.setInterval(intervalMs);
+    m_timer.start();
+    m_deferTimer.start(InitialCheckDelayMs);
+}
+
+void UpgradeAgent::stop()
+{
+    m_timer.stop();
+    m_deferTimer.stop();
+}
+
+void UpgradeAgent::checkNow(bool force)
+{
+    if (m_checking || m_process || m_status == "staging" || m_status == "paused" || m_status == "applying")
+        return;
+    if (!m_networkAvailable) {
+        m_deferTimer.start(DeferredRecheckMs);
+        return;
+    }
+    if (!force && m_foregroundBusy && m_foregroundBusy()) {
+        // The foreground pull already fetches the same layers
+        m_deferTimer.start(DeferredRecheckMs);
+        return;
+    }
+
+    m_checking = true;
+    setStatus("checking");
+    fetchRemoteDigest([this](const QString &digest) {
+        m_lastCheckAt = QDateTime::currentDateTimeUtc();
+        if (digest.isEmpty()) {
+            m_checking = false;
+            saveState();
+            emit logLine("Upgrade check: registry did not return a digest.");
+            setStatus(hasStagedUpgrade() ? "staged" : "idle");
+            return;
+        }
+
+        const QString script = QString("docker image inspect -f '{{join .RepoDigests \"\\n\"}}' '%1' 2>/dev/null\nexit 0\n").arg(m_image);
+        runDockerScript(script.toUtf8(), [this, digest](bool, const QString &output) {
+            m_checking = false;
+            saveState();
+
+            // Pulls made through the registry proxy are recorded under its name
+            const QStringList repoDigests = output.split('\n', Qt::SkipEmptyParts);
+            const bool running = std::any_of(repoDigests.begin(), repoDigests.end(), [&digest](const QString &line) {
+                return line.trimmed().endsWith("@" + digest);
+            });
+            if (running) {
+                // Already running this digest (e.g. upgraded from the dialog)
+                if (!m_staged.digest.isEmpty())
+                    clearStaged();
+                setStatus("idle");
+                return;
+            }
+            if (m_staged.digest == digest && m_staged.verification == "verified") {
+                setStatus("staged");
+                return;
+            }
+            stage(digest);
+        });
+    });
+}
+
+void UpgradeAgent::setBandwidthScheduler(BandwidthScheduler *scheduler)
+{
+    m_bandwidth = scheduler;
+    m_proxy.setBandwidthScheduler(scheduler);
+}
+
+void UpgradeAgent::setCredentials(RegistryCredentials *credentials)
+{
+    m_credentials = credentials;
+    m_proxy.setCredentials(credentials);
+}
+
+void UpgradeAgent::setNetworkAvailable(bool available)
+{
+    if (m_networkAvailable == available)
+        return;
+    m_networkAvailable = available;
+    updatePause();
+}
+
+QString UpgradeAgent::holdReason() const
+{
+    if (!m_networkAvailable)
+        return "the network is down";
+    return QString();
+}
+
+void UpgradeAgent::updatePause()
+{
+    const QString reason = holdReason();
+    if (!reason.isEmpty()) {
+        if (m_status != "staging" || !m_process)
+            return;
+        // Dropped without its callback, so the pull is not recorded as failed
+        m_pausedDigest = m_staged.digest;
+        m_process->disconnect(this);
+        m_process->kill();
+        m_process->waitForFinished(1000);
+        m_process->deleteLater();
+        m_process = nullptr;
+        emit logLine(QString("Staging upgrade %1 paused; %2.").arg(shortDigest(m_pausedDigest), reason));
+        setStatus("paused");
+        return;
+    }
+
+    if (m_pausedDigest.isEmpty() || m_staged.digest != m_pausedDigest) {
+        m_pausedDigest.clear();
+        return;
+    }
+    const QString digest = m_pausedDigest;
+    m_pausedDigest.clear();
+    emit logLine(QString("Resuming staging of upgrade %1.").arg(shortDigest(digest)));
+    setStatus("staging");
+    pullStaged(digest);
+}
+
+void UpgradeAgent::fetchRemoteDigest(std::function<void(const QString&)> done)
+{
+    if (!m_credentials || !m_api) {
+        done(QString());
+        return;
+    }
+    const QString token = m_credentials->cachedToken(pullScope(m_image));
+    requestManifest(token.isEmpty() ? m_credentials->basicAuthorization() : "Bearer " + token,
+                    true, std::move(done));
+}
+
+void UpgradeAgent::requestManifest(const QString &authorization, bool allowTokenExchange,
+                                   std::function<void(const QString&)> done)
+{
+    const ImageRef ref = parseImageRef(m_image);
+    QNetworkRequest request(QUrl(QString("https://%1/v2/%2/manifests/%3").arg(ref.host, ref.repository, ref.tag)));
+    request.setRawHeader("Accept", ManifestAccept);
+    request.setRawHeader("Authorization", authorization.toUtf8());
+
+    ApiClient::Policy policy;
+    policy.deadlineMs = 30000;
+    m_api->head("registry/manifest", request, policy, [this, allowTokenExchange, done](const ApiClient::Response &response) {
+        const int status = response.httpStatus;
+        if (status == 200) {
+            done(QString::fromLatin1(response.headers.value("docker-content-digest")).trimmed());
+            return;
+        }
+
+        // Registries that do not take basic auth on /v2 hand out a bearer token
+        const QString challenge = QString::fromLatin1(response.headers.value("www-authenticate"));
+        if (status != 401 || !allowTokenExchange || !challenge.startsWith("Bearer", Qt::CaseInsensitive)) {
+            done(QString());
+            return;
+        }
+        m_credentials->fetchToken(challenge, pullScope(m_image), [this, done](const QString &token) {
+            if (token.isEmpty()) {
+                done(QString());
+                return;
+            }
+            requestManifest("Bearer " + token, false, done);
+        });
+    });
+}
+
+void UpgradeAgent::stage(const QString &digest)
+{
+    m_staged = StagedUpgrade();
+    m_staged.digest = digest;
+    m_staged.verification = "pending";
+    m_staged.stagedAt = QDateTime::currentDateTimeUtc();
+    saveState();
+    emit stagedChanged();
+    setStatus("staging");
+    emit logLine(QString("Upgrade %1 available; downloading in the background.").arg(shortDigest(digest)));
+
+    m_credentials->ensureLogin([this, digest](bool ok, bool, const QString &) {
+        if (m_staged.digest != digest)
+            return;
+        if (!ok) {
+            m_staged.verification = "failed";
+            saveState();
+            emit stagedChanged();
+            emit logLine("Staging upgrade failed: registry login failed.");
+            setStatus("failed");
+            return;
+        }
+        if (!holdReason().isEmpty()) {
+            m_pausedDigest = digest;
+            setStatus("paused");
+            return;
+        }
+        pullStaged(digest);
+    });
+}
+
+QString UpgradeAgent::pullReference(const QString &repoDigest)
+{
+    if (m_proxy.rateCeiling() <= 0 && (!m_bandwidth || !m_bandwidth->isLimited()))
+        return repoDigest;
+    if (!m_proxy.isListening()) {
+        m_proxy.setUpstream(QUrl("https://" + parseImageRef(m_image).host));
+        if (!m_proxy.listen(AppConstants::StagingProxyPort) && !m_proxy.listen()) {
+            qWarning().noquote() << "Staging proxy cannot listen; staging without a bandwidth cap.";
+            return repoDigest;
+        }
+    }
+    return m_proxy.localReference(repoDigest);
+}
+
+void UpgradeAgent::pullStaged(const QString &digest)
+{
+    const QString repoDigest = repositoryOf(m_image) + "@" + digest;
+    m_proxy.setRateCeiling(m_bandwidth ? m_bandwidth->stagingCap() : 0);
+    const QString reference = pullReference(repoDigest);
+    if (reference == repoDigest)
+        emit logLine("Staging pull runs at full line rate: no bandwidth cap or staging cap applies.");
+    else if (m_proxy.rateCeiling() > 0)
+        emit logLine(QString("Staging pull limited to %1 MB/s (stagingBytesPerSecond in SafeCore/bandwidth.json).")
+                         .arg(double(m_proxy.rateCeiling()) / 1000000.0, 0, 'f', 1));
+
+    // Pulling by digest fetches the new layers without moving the running tag
+    QString script;
+    script += QString("docker pull -q '%1' >/dev/null || exit 3\n").arg(reference);
+    script += QString("docker image inspect -f '{{.Id}} {{join .RepoDigests \",\"}}' '%1'\n").arg(reference);
+
+    runDockerScript(script.toUtf8(), [this, digest, reference](bool ok, const QString &output) {
+        if (m_staged.digest != digest)
+            return;
+        const QStringList parts = output.trimmed().section('\n', -1).split(' ', Qt::SkipEmptyParts);
+        const QString imageId = parts.value(0);
+        const bool verified = ok && imageId.startsWith("sha256:")
+            && parts.value(1).split(',', Qt::SkipEmptyParts).contains(reference);
+
+        m_staged.imageId = imageId;
+        m_staged.reference = reference;
+        m_staged.verification = verified ? "verified" : "failed";
+        m_staged.verifiedAt = QDateTime::currentDateTimeUtc();
+        saveState();
+        emit stagedChanged();
+        if (verified) {
+            emit logLine(QString("Upgrade %1 staged and verified; ready to apply.").arg(shortDigest(digest)));
+            setStatus("staged");
+        } else {
+            emit logLine(QString("Staging upgrade %1 failed; will retry at the next check.").arg(shortDigest(digest)));
+            setStatus("failed");
+        }
+    });
+}
+
+void UpgradeAgent::apply(std::function<void(bool, const QString&)> done)
+{
+    if (!hasStagedUpgrade()) {
+        if (done)
+            done(false, "No verified upgrade is staged.");
+        return;
+    }
+    if (m_process) {
+        if (done)
+            done(false, "Upgrade agent is busy; try again shortly.");
+        return;
+    }
+
+    const StagedUpgrade staged = m_staged;
+    const QString reference = staged.reference.isEmpty() ? repositoryOf(m_image) + "@" + staged.digest
+                                                         : staged.reference;
+    setStatus("applying");
+
+    // Re-check the staged image before moving the tag onto it
+    QString script;
+    script += QString("id=$(docker image inspect -f '{{.Id}}' '%1') || exit 2\n").arg(reference);
+    script += QString("[ \"$id\" = '%1' ] || exit 3\n").arg(staged.imageId);
+    script += QString("docker tag \"$id\" '%1'\n").arg(m_image);
+
+    runDockerScript(script.toUtf8(), [this, staged, done](bool ok, const QString &) {
+        if (!ok) {
+            m_staged.verification = "failed";
+            m_staged.verifiedAt = QDateTime::currentDateTimeUtc();
+            saveState();
+            emit stagedChanged();
+            setStatus("failed");
+            if (done)
+                done(false, QString("Staged upgrade %1 no longer verifies; run a full upgrade instead.")
+                                .arg(shortDigest(staged.digest)));
+            return;
+        }
+        m_appliedDigest = staged.digest;
+        clearStaged();
+        setStatus("idle");
+        if (done)
+            done(true, QString("Applied staged upgrade %1.").arg(shortDigest(staged.digest)));
+    });
+}
+
+void UpgradeAgent::runDockerScript(const QByteArray &script, std::function<void(bool, const QString&)> done)
+{
+    m_process = DockerScript::run(this, "upgrade agent script", script,
+                                  [this, done](bool ok, const QByteArray &output, const QString &) {
+                                      m_process = nullptr;
+                                      if (done)
+                                          done(ok, QString::fromUtf8(output));
+                                  });
+}
+
+void UpgradeAgent::setStatus(const QString &status)
+{
+    if (m_status == status)
+        return;
+    m_status = status;
+    emit statusChanged();
+}
+
+void UpgradeAgent::clearStaged()
+{
+    m_staged = StagedUpgrade();
+    saveState();
+    emit stagedChanged();
+}
+
+void UpgradeAgent::loadState()
+{
+    QFile inFile(statePath());
+    if (!inFile.open(QIODevice::ReadOnly))
+        return;
+    const QJsonDocument doc = QJsonDocument::fromJson(inFile.readAll());
+    if (!doc.isObject())
+        return;
+    const QJsonObject obj = doc.object();
+    m_staged.digest = obj.value("digest").toString();
+    m_staged.imageId = obj.value("imageId").toString();
+    m_staged.reference = obj.value("reference").toString();
+    m_staged.verification = obj.value("verification").toString();
+    m_staged.stagedAt = QDateTime::fromString(obj.value("stagedAt").toString(), Qt::ISODate);
+    m_staged.verifiedAt = QDateTime::fromString(obj.value("verifiedAt").toString(), Qt::ISODate);
+    m_appliedDigest = obj.value("appliedDigest").toString();
+    m_lastCheckAt = QDateTime::fromString(obj.value("lastCheckAt").toString(), Qt::ISODate);
+    // A staging pull interrupted by shutdown is simply redone
+    if (m_staged.verification == "pending")
+        m_staged = StagedUpgrade();
+}
+
+void UpgradeAgent::saveState() const
+{
+    QJsonObject obj;
+    obj.insert("image", m_image);
+    obj.insert("digest", m_staged.digest);
+    obj.insert("imageId", m_staged.imageId);
+    obj.insert("reference", m_staged.reference);
+    obj.insert("verification", m_staged.verification);
+    obj.insert("stagedAt", m_staged.stagedAt.toString(Qt::ISODate));
+    obj.insert("verifiedAt", m_staged.verifiedAt.toString(Qt::ISODate));
+    obj.insert("appliedDigest", m_appliedDigest);
+    obj.insert("lastCheckAt", m_lastCheckAt.toString(Qt::ISODate));
+    // The record of what was verified must never be left torn
+    QString error;
+    if (!StateStore::writeFile(statePath(), QJsonDocument(obj).toJson(QJsonDocument::Indented), &error))
+        qWarning().noquote() << "Cannot save upgrade state:" << error;
+}
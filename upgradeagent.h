@@ -0,0 +1,96 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QDateTime>
+#include <QTimer>
+#include <QProcess>
+#include <functional>
+#include "registryproxy.h"
+
+class ApiClient;
+class BandwidthScheduler;
+class RegistryCredentials;
+
+// Checks the registry on a schedule and pre-stages new image digests in the
+// background, so an upgrade becomes a quick apply instead of a long download
+// in front of the operator. The remote digest comes from a manifest HEAD
+// request; a new digest is pulled by digest (which leaves the running tag
+// alone), verified against the daemon's RepoDigests and recorded in
+// SafeCore/staged_upgrade.json. While a bandwidth cap is set the pull goes
+// through a RegistryProxy, so it keeps to the cap instead of waiting for it. Applying retags the staged image ID and
+// leaves the container restart to the caller.
+class UpgradeAgent : public QObject
+{
+    Q_OBJECT
+public:
+    struct StagedUpgrade {
+        QString digest;
+        QString imageId;
+        QString reference;      // what it was pulled by: repository@digest, via the proxy or not
+        QString verification;   // "pending", "verified" or "failed"
+        QDateTime stagedAt;
+        QDateTime verifiedAt;
+    };
+
+    explicit UpgradeAgent(QObject* parent = nullptr);
+    ~UpgradeAgent() override;
+
+    void setImage(const QString& image) { m_image = image; }
+    // Staging pulls keep to the scheduler's cap and its staging cap
+    void setBandwidthScheduler(BandwidthScheduler* scheduler);
+    void setCredentials(RegistryCredentials* credentials);
+    void setApiClient(ApiClient* client) { m_api = client; }
+    // Returns true while a foreground pull or upgrade owns the registry link.
+    void setForegroundBusy(std::function<bool()> busy) { m_foregroundBusy = std::move(busy); }
+
+    void start(int intervalMs);
+    void stop();
+    void checkNow(bool force = false);
+    // Offline, a staging pull is stopped and checks are held; coming back
+    // online resumes the pull by the same digest
+    void setNetworkAvailable(bool available);
+    void apply(std::function<void(bool, const QString&)> done);
+
+    QString status() const { return m_status; }
+    bool hasStagedUpgrade() const { return !m_staged.digest.isEmpty() && m_staged.verification == "verified"; }
+    StagedUpgrade stagedUpgrade() const { return m_staged; }
+
+signals:
+    void statusChanged();
+    void stagedChanged();
+    void logLine(const QString& line);
+
+private:
+    void fetchRemoteDigest(std::function<void(const QString&)> done);
+    void requestManifest(const QString& authorization, bool allowTokenExchange,
+                         std::function<void(const QString&)> done);
+    void pullStaged(const QString& digest);
+    void stage(const QString& digest);
+    // `repoDigest`, or its name on the proxy while staging is capped
+    QString pullReference(const QString& repoDigest);
+    void runDockerScript(const QByteArray& script, std::function<void(bool, const QString&)> done);
+    // Why staging may not download right now; empty when it may
+    QString holdReason() const;
+    void updatePause();
+    void setStatus(const QString& status);
+    void clearStaged();
+    void loadState();
+    void saveState() const;
+
+    QString m_image;
+    BandwidthScheduler* m_bandwidth = nullptr;
+    RegistryCredentials* m_credentials = nullptr;
+    ApiClient* m_api = nullptr;
+    std::function<bool()> m_foregroundBusy;
+    RegistryProxy m_proxy;
+    QTimer m_timer;
+    QTimer m_deferTimer;
+    QProcess* m_process = nullptr;
+    QString m_status = "idle";
+    StagedUpgrade m_staged;
+    QString m_appliedDigest;
+    QDateTime m_lastCheckAt;
+    bool m_checking = false;
+    bool m_networkAvailable = true;
+    QString m_pausedDigest;
+};